@@ -0,0 +1,379 @@
+#include "mysqlwrapper/columnar.hpp"
+#include "mysqlwrapper/json.hpp"
+#include "mysqlwrapper/mysql_wrapper.hpp"
+#include "mysqlwrapper/operators.hpp"
+
+#include "codec.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace mysqlw;
+
+namespace {
+
+struct BenchOptions {
+    std::string filter;
+    std::chrono::duration<double> min_time{0.2};
+};
+
+struct BenchResult {
+    std::string name;
+    std::uint64_t iterations = 0;
+    std::size_t items_per_iteration = 1;
+    double ns_per_iteration = 0.0;
+};
+
+template <typename T>
+void do_not_optimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+template <typename Fn>
+double time_iterations(std::uint64_t iterations, Fn& fn) {
+    const auto started = std::chrono::steady_clock::now();
+    for (std::uint64_t iteration = 0; iteration < iterations; ++iteration) {
+        fn();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+class BenchRunner {
+public:
+    explicit BenchRunner(BenchOptions options) : options_(std::move(options)) {}
+
+    // Runs `fn` with a doubling iteration count until one batch lasts at least min_time.
+    template <typename Fn>
+    void run(std::string_view name, std::size_t items_per_iteration, Fn fn) {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string_view::npos) {
+            return;
+        }
+
+        (void)time_iterations(1, fn);
+        std::uint64_t iterations = 1;
+        double elapsed = 0.0;
+        while (true) {
+            elapsed = time_iterations(iterations, fn);
+            if (elapsed >= options_.min_time.count() || iterations >= (std::uint64_t{1} << 40)) {
+                break;
+            }
+            iterations *= 2;
+        }
+
+        results_.push_back(BenchResult{
+            .name = std::string(name),
+            .iterations = iterations,
+            .items_per_iteration = items_per_iteration,
+            .ns_per_iteration = elapsed * 1e9 / static_cast<double>(iterations)
+        });
+    }
+
+    void write_json(std::ostream& out) const {
+        out << std::fixed << std::setprecision(2);
+        out << "{\n  \"library\": \"mysqlwrapper\",\n  \"benchmarks\": [";
+        for (std::size_t index = 0; index < results_.size(); ++index) {
+            const auto& result = results_[index];
+            out << (index == 0 ? "\n" : ",\n")
+                << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+                << ", \"items_per_iteration\": " << result.items_per_iteration
+                << ", \"ns_per_iteration\": " << result.ns_per_iteration
+                << ", \"ns_per_item\": "
+                << result.ns_per_iteration / static_cast<double>(result.items_per_iteration) << '}';
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+    BenchOptions options_;
+    std::vector<BenchResult> results_;
+};
+
+constexpr std::size_t row_count = 1000;
+
+MYSQL_FIELD make_field(const char* name, enum_field_types type, unsigned int flags) {
+    MYSQL_FIELD field;
+    std::memset(&field, 0, sizeof(field));
+    field.name = const_cast<char*>(name);
+    field.name_length = static_cast<unsigned int>(std::strlen(name));
+    field.type = type;
+    field.flags = flags;
+    return field;
+}
+
+// A representative five-column row: id, quantity, price, name, payload.
+std::vector<MYSQL_FIELD> synthetic_fields() {
+    return {
+        make_field("id", MYSQL_TYPE_LONGLONG, NOT_NULL_FLAG | UNSIGNED_FLAG),
+        make_field("quantity", MYSQL_TYPE_LONG, NOT_NULL_FLAG),
+        make_field("price", MYSQL_TYPE_DOUBLE, NOT_NULL_FLAG),
+        make_field("name", MYSQL_TYPE_VAR_STRING, NOT_NULL_FLAG),
+        make_field("payload", MYSQL_TYPE_BLOB, BINARY_FLAG)
+    };
+}
+
+std::vector<detail::FieldDecode> decode_kinds_for(const std::vector<MYSQL_FIELD>& fields) {
+    std::vector<detail::FieldDecode> kinds;
+    for (const auto& field : fields) {
+        kinds.push_back(detail::decode_kind(field));
+    }
+    return kinds;
+}
+
+std::vector<Column> columns_for(const std::vector<MYSQL_FIELD>& fields) {
+    std::vector<Column> columns;
+    for (const auto& field : fields) {
+        columns.push_back(detail::make_column(field));
+    }
+    return columns;
+}
+
+std::vector<Result::RowStorage> synthetic_rows() {
+    std::vector<Result::RowStorage> rows;
+    rows.reserve(row_count);
+    for (std::size_t index = 0; index < row_count; ++index) {
+        rows.push_back(Result::RowStorage{
+            std::uint64_t{index},
+            std::int64_t(index % 97),
+            static_cast<double>(index) * 0.25,
+            std::string("customer-name-") + std::to_string(index),
+            Blob(16, std::byte{0x5a})
+        });
+    }
+    return rows;
+}
+
+void bench_text_decode(BenchRunner& runner) {
+    const auto fields = synthetic_fields();
+    const auto kinds = decode_kinds_for(fields);
+
+    std::vector<std::vector<std::string>> cells;
+    for (std::size_t index = 0; index < row_count; ++index) {
+        cells.push_back({
+            std::to_string(index),
+            std::to_string(index % 97),
+            std::to_string(static_cast<double>(index) * 0.25),
+            std::string("customer-name-") + std::to_string(index),
+            std::string(16, 'Z')
+        });
+    }
+    std::vector<std::vector<char*>> row_pointers;
+    std::vector<std::vector<unsigned long>> row_lengths;
+    for (auto& row : cells) {
+        auto& pointers = row_pointers.emplace_back();
+        auto& lengths = row_lengths.emplace_back();
+        for (auto& cell : row) {
+            pointers.push_back(cell.data());
+            lengths.push_back(static_cast<unsigned long>(cell.size()));
+        }
+    }
+
+    runner.run("decode/text_rows", row_count, [&] {
+        std::vector<Result::RowStorage> rows;
+        rows.reserve(row_count);
+        for (std::size_t index = 0; index < row_count; ++index) {
+            Result::RowStorage row;
+            detail::decode_text_row(kinds, row_pointers[index].data(), row_lengths[index].data(), row);
+            rows.push_back(std::move(row));
+        }
+        do_not_optimize(rows);
+    });
+}
+
+void bench_binary_decode(BenchRunner& runner) {
+    const auto fields = synthetic_fields();
+    const auto kinds = decode_kinds_for(fields);
+
+    struct BinaryCell {
+        std::vector<unsigned char> buffer;
+        unsigned long length = 0;
+    };
+    std::vector<std::vector<BinaryCell>> cells;
+    for (std::size_t index = 0; index < row_count; ++index) {
+        auto& row = cells.emplace_back(fields.size());
+        const auto id = std::uint64_t{index};
+        const auto quantity = std::int64_t(index % 97);
+        const auto price = static_cast<double>(index) * 0.25;
+        const auto name = std::string("customer-name-") + std::to_string(index);
+        row[0].buffer.resize(sizeof(id));
+        std::memcpy(row[0].buffer.data(), &id, sizeof(id));
+        row[1].buffer.resize(sizeof(quantity));
+        std::memcpy(row[1].buffer.data(), &quantity, sizeof(quantity));
+        row[2].buffer.resize(sizeof(price));
+        std::memcpy(row[2].buffer.data(), &price, sizeof(price));
+        row[3].buffer.assign(name.begin(), name.end());
+        row[4].buffer.assign(16, 0x5a);
+        for (auto& cell : row) {
+            cell.length = static_cast<unsigned long>(cell.buffer.size());
+        }
+    }
+
+    runner.run("decode/binary_rows", row_count, [&] {
+        std::vector<Result::RowStorage> rows;
+        rows.reserve(row_count);
+        for (const auto& source : cells) {
+            Result::RowStorage row;
+            row.reserve(source.size());
+            for (std::size_t index = 0; index < source.size(); ++index) {
+                row.push_back(detail::decode_binary_value(kinds[index], source[index].buffer.data(),
+                                                          source[index].length));
+            }
+            rows.push_back(std::move(row));
+        }
+        do_not_optimize(rows);
+    });
+}
+
+void bench_bind(BenchRunner& runner) {
+    const std::vector<Value> template_values{
+        std::int64_t{42}, std::uint64_t{7}, 12.5, std::string("customer-name-42"), Blob(16, std::byte{1}), true, nullptr};
+
+    runner.run("bind/bound_params", template_values.size(), [&] {
+        std::vector<Value> values = template_values;
+        std::vector<detail::BoundParam> params;
+        std::vector<MYSQL_BIND> binds;
+        params.reserve(values.size());
+        binds.reserve(values.size());
+        for (auto& value : values) {
+            params.emplace_back(std::move(value));
+        }
+        for (auto& param : params) {
+            binds.push_back(param.bind);
+        }
+        do_not_optimize(binds);
+    });
+}
+
+void bench_make_values(BenchRunner& runner) {
+    const std::string name = "customer-name-42";
+    runner.run("make_values/mixed_6", 6, [&] {
+        auto values = detail::make_values(42, 7U, 12.5, name, "literal", true);
+        do_not_optimize(values);
+    });
+    runner.run("make_values/ints_4", 4, [&] {
+        auto values = detail::make_values(1, 2, 3, 4);
+        do_not_optimize(values);
+    });
+}
+
+void bench_result(BenchRunner& runner) {
+    const auto columns = columns_for(synthetic_fields());
+    const auto rows = synthetic_rows();
+
+    runner.run("result/construct", row_count, [&] {
+        Result result(columns, rows);
+        do_not_optimize(result);
+    });
+
+    const Result result(columns, rows);
+    runner.run("row_view/by_index", row_count, [&] {
+        std::uint64_t sum = 0;
+        for (std::size_t index = 0; index < result.row_count(); ++index) {
+            sum += std::get<std::uint64_t>(result[index].at(std::size_t{0}));
+        }
+        do_not_optimize(sum);
+    });
+    runner.run("row_view/by_name", row_count, [&] {
+        std::uint64_t sum = 0;
+        for (std::size_t index = 0; index < result.row_count(); ++index) {
+            sum += std::get<std::uint64_t>(result[index]["id"]);
+        }
+        do_not_optimize(sum);
+    });
+}
+
+void bench_json(BenchRunner& runner) {
+    const Result result(columns_for(synthetic_fields()), synthetic_rows());
+    auto columnar = ColumnarResult::from_result(result);
+    if (!columnar) {
+        std::cerr << "columnar conversion failed: " << columnar.error().message << '\n';
+        std::exit(1);
+    }
+
+    std::string out;
+    runner.run("json/rows_objects", row_count, [&] {
+        write_json(out, result);
+        do_not_optimize(out);
+    });
+    runner.run("json/rows_arrays", row_count, [&] {
+        write_json(out, result, JsonOptions{.shape = JsonRowShape::arrays});
+        do_not_optimize(out);
+    });
+    runner.run("json/columnar_objects", row_count, [&] {
+        write_json(out, *columnar);
+        do_not_optimize(out);
+    });
+}
+
+void bench_operators(BenchRunner& runner) {
+    const Result result(columns_for(synthetic_fields()), synthetic_rows());
+    const std::vector<Predicate> predicates{
+        Predicate{.column = "quantity", .op = CompareOp::less, .value = std::int64_t{10}},
+        Predicate{.column = "price", .op = CompareOp::greater_equal, .value = 100.0}
+    };
+    runner.run("operators/filter", row_count, [&] {
+        auto filtered = filter(result, predicates);
+        do_not_optimize(filtered);
+    });
+    runner.run("operators/sort_two_keys", row_count, [&] {
+        auto sorted = sort_by(result, {SortKey{.column = "quantity"}, SortKey{.column = "price", .descending = true}});
+        do_not_optimize(sorted);
+    });
+    runner.run("operators/group_by", row_count, [&] {
+        auto grouped = group_by(result, {"quantity"},
+                                {Aggregate{}, Aggregate{.function = AggregateFunction::sum, .column = ColumnRef("price")},
+                                 Aggregate{.function = AggregateFunction::max, .column = ColumnRef("name")}});
+        do_not_optimize(grouped);
+    });
+
+    auto lookup = group_by(result, {"quantity"}, {Aggregate{}});
+    if (!lookup) {
+        std::cerr << "group_by failed: " << lookup.error().message << '\n';
+        std::exit(1);
+    }
+    runner.run("operators/hash_join", row_count, [&] {
+        auto joined = hash_join(result, *lookup, {"quantity"}, {"quantity"});
+        do_not_optimize(joined);
+    });
+}
+
+BenchOptions parse_options(int argc, char** argv) {
+    BenchOptions options;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view argument(argv[index]);
+        if (argument.starts_with("--filter=")) {
+            options.filter = std::string(argument.substr(9));
+        } else if (argument.starts_with("--min-time=")) {
+            options.min_time = std::chrono::duration<double>(std::strtod(argv[index] + 11, nullptr));
+        } else {
+            std::cerr << "usage: mysqlwrapper_bench [--filter=substring] [--min-time=seconds]\n";
+            std::exit(2);
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchRunner runner(parse_options(argc, argv));
+    bench_text_decode(runner);
+    bench_binary_decode(runner);
+    bench_bind(runner);
+    bench_make_values(runner);
+    bench_result(runner);
+    bench_json(runner);
+    bench_operators(runner);
+    runner.write_json(std::cout);
+}
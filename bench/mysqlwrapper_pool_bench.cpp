@@ -0,0 +1,146 @@
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include "support/fake_connection.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace mysqlw;
+
+namespace {
+
+enum class Mode {
+    sync,
+    async
+};
+
+struct BenchOptions {
+    std::chrono::duration<double> duration{0.5};
+    std::chrono::microseconds latency{100};
+};
+
+struct SweepPoint {
+    Mode mode = Mode::sync;
+    std::size_t threads = 1;
+    std::size_t pool_size = 1;
+    std::size_t workers = 1;
+};
+
+struct SweepResult {
+    SweepPoint point;
+    std::uint64_t operations = 0;
+    std::uint64_t errors = 0;
+    double seconds = 0.0;
+    double acquire_p50 = 0.0;
+    double acquire_p99 = 0.0;
+};
+
+SweepResult run_point(const BenchOptions& options, const SweepPoint& point) {
+    auto backend = std::make_shared<testing::FakeBackend>(testing::FakeBackendOptions{.query_latency = options.latency});
+
+    ConnectionConfig config;
+    config.initial_pool_size = point.pool_size;
+    config.max_pool_size = point.pool_size;
+    config.worker_count = point.workers;
+    config.acquire_timeout = std::chrono::seconds{30};
+    Database db(config, testing::make_fake_connection_factory(backend));
+
+    std::atomic<std::uint64_t> operations{0};
+    std::atomic<std::uint64_t> errors{0};
+    std::atomic_bool stop{false};
+    const auto started = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(point.threads);
+        for (std::size_t index = 0; index < point.threads; ++index) {
+            threads.emplace_back([&] {
+                std::uint64_t local_operations = 0;
+                std::uint64_t local_errors = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const auto result = point.mode == Mode::sync ? db.query("SELECT 1") : db.query_async("SELECT 1").get();
+                    ++(result ? local_operations : local_errors);
+                }
+                operations.fetch_add(local_operations, std::memory_order_relaxed);
+                errors.fetch_add(local_errors, std::memory_order_relaxed);
+            });
+        }
+        std::this_thread::sleep_for(options.duration);
+        stop.store(true, std::memory_order_relaxed);
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    const auto metrics = db.metrics();
+    return SweepResult{
+        .point = point,
+        .operations = operations.load(),
+        .errors = errors.load(),
+        .seconds = elapsed,
+        .acquire_p50 = metrics.acquire_latency.quantile(0.50),
+        .acquire_p99 = metrics.acquire_latency.quantile(0.99)
+    };
+}
+
+std::vector<SweepPoint> sweep() {
+    constexpr std::size_t thread_counts[] = {1, 4, 16, 64};
+    constexpr std::size_t pool_sizes[] = {1, 4, 16};
+    constexpr std::size_t worker_counts[] = {1, 4, 16};
+
+    std::vector<SweepPoint> points;
+    for (const auto threads : thread_counts) {
+        for (const auto pool_size : pool_sizes) {
+            points.push_back(SweepPoint{.mode = Mode::sync, .threads = threads, .pool_size = pool_size, .workers = 1});
+            for (const auto workers : worker_counts) {
+                points.push_back(SweepPoint{
+                    .mode = Mode::async, .threads = threads, .pool_size = pool_size, .workers = workers});
+            }
+        }
+    }
+    return points;
+}
+
+BenchOptions parse_options(int argc, char** argv) {
+    BenchOptions options;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view argument(argv[index]);
+        if (argument.starts_with("--duration=")) {
+            options.duration = std::chrono::duration<double>(std::strtod(argv[index] + 11, nullptr));
+        } else if (argument.starts_with("--latency-us=")) {
+            options.latency = std::chrono::microseconds(std::strtoll(argv[index] + 13, nullptr, 10));
+        } else {
+            std::cerr << "usage: mysqlwrapper_pool_bench [--duration=seconds] [--latency-us=microseconds]\n";
+            std::exit(2);
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto options = parse_options(argc, argv);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "{\n  \"library\": \"mysqlwrapper\",\n  \"backend_latency_us\": " << options.latency.count()
+              << ",\n  \"benchmarks\": [";
+    bool first = true;
+    for (const auto& point : sweep()) {
+        const auto result = run_point(options, point);
+        std::cout << (first ? "\n" : ",\n") << "    {\"mode\": \""
+                  << (point.mode == Mode::sync ? "sync" : "async") << "\", \"threads\": " << point.threads
+                  << ", \"pool_size\": " << point.pool_size << ", \"workers\": " << point.workers
+                  << ", \"operations\": " << result.operations << ", \"errors\": " << result.errors
+                  << ", \"ops_per_second\": " << static_cast<double>(result.operations) / result.seconds
+                  << ", \"acquire_p50_us\": " << result.acquire_p50 * 1e6
+                  << ", \"acquire_p99_us\": " << result.acquire_p99 * 1e6 << '}' << std::flush;
+        first = false;
+    }
+    std::cout << "\n  ]\n}\n";
+}
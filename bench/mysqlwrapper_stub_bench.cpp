@@ -0,0 +1,149 @@
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include "support/mysql_stub_server.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace mysqlw;
+
+namespace {
+
+struct BenchOptions {
+    std::chrono::duration<double> duration{0.5};
+    std::chrono::microseconds latency{0};
+    std::size_t rows = 100;
+    std::string unix_socket_path;
+};
+
+struct Workload {
+    std::string_view name;
+    std::function<bool(Database&)> run;
+};
+
+struct WorkloadResult {
+    std::uint64_t operations = 0;
+    std::uint64_t errors = 0;
+    double seconds = 0.0;
+    double query_p50 = 0.0;
+    double query_p99 = 0.0;
+    testing::StubServerStats server;
+};
+
+Result scripted_rows(std::size_t rows) {
+    std::vector<Result::RowStorage> storage;
+    storage.reserve(rows);
+    for (std::size_t index = 0; index < rows; ++index) {
+        storage.push_back(Result::RowStorage{
+            static_cast<std::int64_t>(index), std::string("user-") + std::to_string(index), static_cast<double>(index) * 0.5});
+    }
+    return Result(
+        {
+            Column{.name = "id", .type = ColumnType::signed_integer, .nullable = false},
+            Column{.name = "name", .type = ColumnType::text},
+            Column{.name = "score", .type = ColumnType::floating}
+        },
+        std::move(storage));
+}
+
+std::vector<Workload> workloads() {
+    return {
+        Workload{"text/select_rows", [](Database& db) { return db.query("SELECT id, name, score FROM users").has_value(); }},
+        Workload{"prepared/select_rows", [](Database& db) {
+            return db.query("SELECT id, name, score FROM users WHERE id > ?", 0).has_value();
+        }},
+        Workload{"text/execute", [](Database& db) { return db.execute("UPDATE users SET score = 0").has_value(); }},
+        Workload{"prepared/execute", [](Database& db) {
+            return db.execute("UPDATE users SET score = ? WHERE id = ?", 1.5, 7).has_value();
+        }},
+        Workload{"transaction/execute", [](Database& db) {
+            return db.transaction([](Transaction& tx) { return tx.execute("UPDATE users SET score = 0"); }).has_value();
+        }}
+    };
+}
+
+WorkloadResult run_workload(const BenchOptions& options, const Workload& workload) {
+    testing::StubServer server(testing::StubServerOptions{
+        .unix_socket_path = options.unix_socket_path, .default_delay = options.latency});
+    const auto rows = scripted_rows(options.rows);
+    server.script("SELECT id, name, score FROM users", testing::StubResponse{.body = rows});
+    server.script("SELECT id, name, score FROM users WHERE id > ?", testing::StubResponse{.body = rows});
+    server.script("UPDATE users SET score = 0", testing::StubResponse{.body = ExecuteResult{.affected_rows = 1}});
+
+    auto config = server.connection_config();
+    config.initial_pool_size = 1;
+    config.max_pool_size = 1;
+    config.worker_count = 1;
+    Database db(config);
+
+    // Warm up so connection setup and the first prepare are not in the measurement.
+    (void)workload.run(db);
+    server.reset_stats();
+
+    WorkloadResult result;
+    const auto started = std::chrono::steady_clock::now();
+    const auto deadline = started + options.duration;
+    while (std::chrono::steady_clock::now() < deadline) {
+        ++(workload.run(db) ? result.operations : result.errors);
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    const auto metrics = db.metrics();
+    const auto& latency = workload.name.ends_with("select_rows") ? metrics.query_latency : metrics.execute_latency;
+    result.query_p50 = latency.quantile(0.50);
+    result.query_p99 = latency.quantile(0.99);
+    result.server = server.stats();
+    return result;
+}
+
+BenchOptions parse_options(int argc, char** argv) {
+    BenchOptions options;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view argument(argv[index]);
+        if (argument.starts_with("--duration=")) {
+            options.duration = std::chrono::duration<double>(std::strtod(argv[index] + 11, nullptr));
+        } else if (argument.starts_with("--latency-us=")) {
+            options.latency = std::chrono::microseconds(std::strtoll(argv[index] + 13, nullptr, 10));
+        } else if (argument.starts_with("--rows=")) {
+            options.rows = static_cast<std::size_t>(std::strtoull(argv[index] + 7, nullptr, 10));
+        } else if (argument.starts_with("--unix-socket=")) {
+            options.unix_socket_path = std::string(argument.substr(14));
+        } else {
+            std::cerr << "usage: mysqlwrapper_stub_bench [--duration=seconds] [--latency-us=microseconds] "
+                         "[--rows=count] [--unix-socket=path]\n";
+            std::exit(2);
+        }
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto options = parse_options(argc, argv);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "{\n  \"library\": \"mysqlwrapper\",\n  \"transport\": \""
+              << (options.unix_socket_path.empty() ? "tcp" : "unix") << "\",\n  \"server_latency_us\": "
+              << options.latency.count() << ",\n  \"rows\": " << options.rows << ",\n  \"benchmarks\": [";
+    bool first = true;
+    for (const auto& workload : workloads()) {
+        const auto result = run_workload(options, workload);
+        const auto operations = static_cast<double>(result.operations == 0 ? 1 : result.operations);
+        std::cout << (first ? "\n" : ",\n") << "    {\"name\": \"" << workload.name << "\", \"operations\": "
+                  << result.operations << ", \"errors\": " << result.errors
+                  << ", \"ops_per_second\": " << static_cast<double>(result.operations) / result.seconds
+                  << ", \"round_trips_per_op\": " << static_cast<double>(result.server.round_trips()) / operations
+                  << ", \"p50_us\": " << result.query_p50 * 1e6 << ", \"p99_us\": " << result.query_p99 * 1e6 << '}'
+                  << std::flush;
+        first = false;
+    }
+    std::cout << "\n  ]\n}\n";
+}
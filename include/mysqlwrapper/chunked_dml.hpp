@@ -0,0 +1,99 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mysqlw {
+
+enum class DmlKind {
+    delete_rows,
+    update
+};
+
+struct ChunkedDmlOptions {
+    // Table and integer primary-key column; both are quoted as identifiers, and the table may be
+    // qualified as "schema.table".
+    std::string table;
+    std::string key;
+    DmlKind kind = DmlKind::delete_rows;
+    // Raw SQL for the SET clause of an update, such as "archived = 1", and its parameters.
+    std::string assignments;
+    std::vector<Value> assignment_params;
+    // Raw SQL condition selecting the rows to change, such as "created < ?", and its parameters.
+    std::string where;
+    std::vector<Value> where_params;
+
+    // Rows per chunk. After every chunk the size is recomputed from the measured row rate so a
+    // chunk takes about target_chunk_time, within [min_chunk_size, max_chunk_size].
+    std::size_t chunk_size = 1000;
+    std::size_t min_chunk_size = 10;
+    std::size_t max_chunk_size = 100000;
+    std::chrono::milliseconds target_chunk_time{500};
+
+    // Before each chunk the runner waits, checking every throttle_interval, while the server has
+    // more than max_threads_running running threads or any replica is more than max_replica_lag
+    // behind. 0 and an empty replica list disable the checks. A replica whose SQL thread is
+    // stopped counts as lagging.
+    std::size_t max_threads_running = 0;
+    std::vector<Database*> replicas;
+    std::chrono::seconds max_replica_lag{5};
+    std::chrono::milliseconds throttle_interval{1000};
+
+    // Resume after a key reported by an earlier, interrupted run.
+    std::optional<std::int64_t> start_after;
+};
+
+enum class DmlEvent {
+    chunk,
+    throttle
+};
+
+enum class ThrottleReason {
+    threads_running,
+    replica_lag
+};
+
+struct DmlProgress {
+    DmlEvent event = DmlEvent::chunk;
+    std::size_t chunks = 0;
+    std::uint64_t affected_rows = 0;
+    // Highest key covered so far; pass it as start_after to resume.
+    std::optional<std::int64_t> last_key;
+    std::size_t next_chunk_size = 0;
+    // Smoothed rate of rows examined per second.
+    double rows_per_second = 0.0;
+    std::chrono::nanoseconds elapsed{0};
+    // For throttle events: the check that failed and the value it saw, in running threads or
+    // seconds of lag (-1 when a replica is not replicating).
+    std::optional<ThrottleReason> throttle;
+    std::int64_t observed = 0;
+};
+
+struct DmlStats {
+    std::size_t chunks = 0;
+    std::uint64_t affected_rows = 0;
+    std::optional<std::int64_t> last_key;
+    std::size_t throttle_events = 0;
+    std::chrono::nanoseconds throttled{0};
+    std::chrono::nanoseconds elapsed{0};
+};
+
+// Called on the calling thread after every chunk and every throttle check that waits. Returning
+// an error stops the run before the next chunk.
+using DmlProgressCallback = std::function<Expected<void>(const DmlProgress& progress)>;
+
+// Runs a DELETE or UPDATE over the rows matching options.where in primary-key order, one chunk
+// per short transaction, so no statement holds row locks for long or floods the replicas. Keys
+// above the maximum matching key at the start are left alone. On error, the chunks already
+// committed stay committed and the error is returned.
+[[nodiscard]] Expected<DmlStats> run_chunked_dml(Database& database, const ChunkedDmlOptions& options,
+                                                 const DmlProgressCallback& on_progress = {});
+
+} // namespace mysqlw
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Apache Arrow C data interface (https://arrow.apache.org/docs/format/CDataInterface.html). The
+// guard is the one used by Arrow's own abi.h, so either header may be included first.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+} // extern "C"
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace mysqlw {
+
+// One column in Arrow memory layout. The validity bitmap is LSB-first with a set bit for every
+// non-NULL row; exactly one value buffer is used, chosen by column.type. Text and blob columns
+// keep row_count + 1 int32 offsets into bytes.
+struct ColumnBuffer {
+    Column column;
+    std::size_t null_count = 0;
+    std::vector<std::uint8_t> validity;
+    std::vector<std::int64_t> int64_values;
+    std::vector<std::uint64_t> uint64_values;
+    std::vector<double> double_values;
+    std::vector<std::uint8_t> bool_bits;
+    std::vector<std::int32_t> offsets;
+    std::string bytes;
+
+    [[nodiscard]] bool is_null(std::size_t row) const noexcept;
+    [[nodiscard]] ValueView value(std::size_t row) const noexcept;
+};
+
+class ColumnarResult {
+public:
+    ColumnarResult() = default;
+
+    [[nodiscard]] static Expected<ColumnarResult> from_result(const Result& result);
+
+    [[nodiscard]] std::size_t row_count() const noexcept;
+    [[nodiscard]] std::size_t column_count() const noexcept;
+    [[nodiscard]] std::span<const ColumnBuffer> columns() const noexcept;
+    [[nodiscard]] const ColumnBuffer& column(std::size_t index) const;
+    [[nodiscard]] const ColumnBuffer& column(std::string_view name) const;
+
+    // Hands the buffers to an Arrow consumer as a struct array with one child per column, without
+    // copying them. The consumer owns schema and array and must call their release callbacks;
+    // this object is left empty.
+    [[nodiscard]] Expected<void> export_arrow(ArrowSchema* schema, ArrowArray* array) &&;
+
+private:
+    friend class ColumnarBuilder;
+
+    std::vector<ColumnBuffer> columns_;
+    std::size_t row_count_ = 0;
+};
+
+// A RowSink that appends each streamed row straight into column buffers. A cell whose type does
+// not fit its column (other than a lossless integer or integer-to-double conversion) fails the
+// row with ErrorCode::type_mismatch.
+class ColumnarBuilder final : public RowSink {
+public:
+    [[nodiscard]] Expected<void> begin(std::span<const Column> columns) override;
+    [[nodiscard]] Expected<void> row(std::span<const ValueView> values) override;
+
+    // Returns the columns built so far and resets the builder.
+    [[nodiscard]] ColumnarResult finish();
+
+private:
+    ColumnarResult result_;
+};
+
+template <typename... Args>
+[[nodiscard]] Expected<ColumnarResult> query_columnar(Database& database, std::string_view sql, Args&&... args) {
+    ColumnarBuilder builder;
+    if (auto streamed = database.stream(sql, builder, std::forward<Args>(args)...); !streamed) {
+        return std::unexpected(streamed.error());
+    }
+    return builder.finish();
+}
+
+} // namespace mysqlw
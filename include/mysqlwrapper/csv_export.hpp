@@ -0,0 +1,79 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace mysqlw {
+
+enum class CsvFormat {
+    // RFC 4180 quoting; NULL is an empty unquoted field and an empty string is "".
+    csv,
+    // Tab-separated with backslash escapes; NULL is \N (the MySQL and PostgreSQL text format).
+    tsv
+};
+
+struct CsvOptions {
+    CsvFormat format = CsvFormat::csv;
+    // Field separator for CsvFormat::csv; TSV always uses a tab.
+    char delimiter = ',';
+    bool header = true;
+    // Rows are formatted into blocks of about block_size bytes, and every blocks_per_write full
+    // blocks go out in one writev call.
+    std::size_t block_size = 256 * 1024;
+    std::size_t blocks_per_write = 8;
+    // With format_threads > 0, fetched rows are copied into batches of batch_rows that worker
+    // threads format while the fetching thread keeps reading. Output order is preserved.
+    std::size_t format_threads = 0;
+    std::size_t batch_rows = 4096;
+};
+
+struct ExportStats {
+    std::uint64_t rows = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t write_calls = 0;
+    std::chrono::nanoseconds elapsed{0};
+
+    [[nodiscard]] double megabytes_per_second() const noexcept;
+};
+
+// A RowSink that formats rows as CSV or TSV and writes them to a file descriptor, which it does
+// not close. Blobs are written as 0x-prefixed hex and booleans as 1 or 0.
+class CsvWriter final : public RowSink {
+public:
+    explicit CsvWriter(int fd, CsvOptions options = {});
+    ~CsvWriter() override;
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    [[nodiscard]] Expected<void> begin(std::span<const Column> columns) override;
+    [[nodiscard]] Expected<void> row(std::span<const ValueView> values) override;
+
+    // Formats and writes everything still buffered. Call once after the last row.
+    [[nodiscard]] Expected<ExportStats> finish();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+template <typename... Args>
+[[nodiscard]] Expected<ExportStats> export_csv(Database& database, int fd, const CsvOptions& options,
+                                               std::string_view sql, Args&&... args) {
+    CsvWriter writer(fd, options);
+    auto streamed = database.stream(sql, writer, std::forward<Args>(args)...);
+    auto finished = writer.finish();
+    if (!streamed) {
+        return std::unexpected(streamed.error());
+    }
+    return finished;
+}
+
+} // namespace mysqlw
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "mysqlwrapper/columnar.hpp"
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace mysqlw {
+
+enum class JsonRowShape {
+    // [{"id":1,"name":"Ada"},...]
+    objects,
+    // [[1,"Ada"],...]; column names are not written.
+    arrays
+};
+
+// Blobs are written as base64 strings and non-finite doubles as null. Text is copied through as
+// UTF-8 with only the escapes JSON requires.
+struct JsonOptions {
+    JsonRowShape shape = JsonRowShape::objects;
+};
+
+// A RowSink that appends rows as one JSON array to a caller-owned buffer. Object keys are escaped
+// once in begin() and copied for every row. A row whose value count differs from the columns
+// passed to begin() fails with ErrorCode::invalid_argument.
+class JsonWriter final : public RowSink {
+public:
+    explicit JsonWriter(std::string& out, JsonOptions options = {});
+
+    [[nodiscard]] Expected<void> begin(std::span<const Column> columns) override;
+    [[nodiscard]] Expected<void> row(std::span<const ValueView> values) override;
+
+    // Closes the array; call once after the last row.
+    void finish();
+
+private:
+    std::string* out_;
+    JsonOptions options_;
+    std::vector<std::string> keys_;
+    std::size_t column_count_ = 0;
+    bool first_row_ = true;
+};
+
+// Render a whole result as a JSON array. `out` is cleared first and keeps its capacity. The
+// escaped keys of the last column set are kept per thread, so a buffer reused across responses of
+// one shape stops allocating once it has grown to the largest one.
+void write_json(std::string& out, const Result& result, JsonOptions options = {});
+void write_json(std::string& out, const ColumnarResult& result, JsonOptions options = {});
+
+} // namespace mysqlw
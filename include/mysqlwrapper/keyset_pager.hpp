@@ -0,0 +1,93 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace mysqlw {
+
+struct KeysetOptions {
+    // A SELECT with no WHERE, ORDER BY or LIMIT, such as "SELECT id, name FROM users". The pager
+    // appends those clauses itself.
+    std::string query;
+    // Unique sort column. It is quoted as an identifier and must appear in the select list under
+    // the same name.
+    std::string key;
+    // Raw SQL condition ANDed onto every page.
+    std::string where;
+    std::size_t page_size = 1000;
+    // Start after this key instead of at the beginning.
+    std::optional<Value> after;
+    // Fetch the next page on a worker while the caller reads the current one.
+    bool prefetch = true;
+};
+
+// Pages through a query with "WHERE key > ? ORDER BY key LIMIT n", so every page costs the same
+// index range scan however deep it is, unlike LIMIT/OFFSET. Both page statements stay prepared on
+// the pooled connections through the per-connection statement cache.
+//
+// Iterating yields one RowView per row. A RowView refers to the current page and is invalidated
+// when iteration moves past that page. An error ends the iteration early and is kept in error().
+class KeysetPager {
+public:
+    class iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = RowView;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        [[nodiscard]] RowView operator*() const;
+        iterator& operator++();
+        void operator++(int);
+
+        [[nodiscard]] friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept {
+            return it.pager_ == nullptr;
+        }
+
+    private:
+        friend class KeysetPager;
+
+        explicit iterator(KeysetPager* pager);
+
+        KeysetPager* pager_ = nullptr;
+        std::size_t row_ = 0;
+    };
+
+    [[nodiscard]] static Expected<KeysetPager> open(Database& database, KeysetOptions options);
+
+    KeysetPager(KeysetPager&&) noexcept;
+    KeysetPager& operator=(KeysetPager&&) noexcept;
+    ~KeysetPager();
+
+    // Fetches the first page. A pager is a single pass: begin() continues from wherever
+    // next_page() or an earlier iteration stopped.
+    [[nodiscard]] iterator begin();
+    [[nodiscard]] std::default_sentinel_t end() const noexcept {
+        return {};
+    }
+
+    // The next page, or nullopt after the last one. A short page is the last.
+    [[nodiscard]] Expected<std::optional<Result>> next_page();
+
+    [[nodiscard]] const std::optional<DbError>& error() const noexcept;
+    [[nodiscard]] std::size_t pages() const noexcept;
+
+private:
+    struct Impl;
+
+    explicit KeysetPager(std::unique_ptr<Impl> impl);
+
+    // Replaces the current page; false at the end or on error.
+    bool advance();
+
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace mysqlw
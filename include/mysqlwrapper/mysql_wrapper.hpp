@@ -1,17 +1,21 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <expected>
+#include <functional>
 #include <future>
 #include <memory>
+#include <optional>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -23,6 +27,11 @@ namespace mysqlw {
 using Blob = std::vector<std::byte>;
 using Value = std::variant<std::nullptr_t, std::int64_t, std::uint64_t, double, std::string, Blob, bool>;
 
+// Non-owning counterpart of Value. Text and blob views handed to a RowSink point into the fetch
+// buffers and are valid only until the row() call that received them returns.
+using ValueView = std::variant<std::nullptr_t, std::int64_t, std::uint64_t, double, std::string_view,
+                               std::span<const std::byte>, bool>;
+
 enum class ErrorCode {
     ok = 0,
     mysql_init_failed,
@@ -42,7 +51,8 @@ enum class ErrorCode {
     async_cancelled,
     invalid_argument,
     type_mismatch,
-    transaction_failed
+    transaction_failed,
+    io_failed
 };
 
 enum class Operation {
@@ -58,7 +68,15 @@ enum class Operation {
     commit,
     rollback,
     async_submit,
-    async_cancelled
+    async_cancelled,
+    traffic_log,
+    export_data,
+    snapshot,
+    shared_cache,
+    transform,
+    scan,
+    paginate,
+    chunked_dml
 };
 
 struct DbError {
@@ -84,6 +102,34 @@ private:
 template <typename T>
 using Expected = std::expected<T, DbError>;
 
+// How the client reaches the server; automatic lets the client library choose, which for the
+// host "localhost" on Unix means the default socket.
+enum class Transport {
+    automatic,
+    tcp,
+    unix_socket,
+    named_pipe,
+    shared_memory
+};
+
+// Mirrors the client's --ssl-mode. preferred, the library default, uses TLS when the server offers
+// it; verify_ca and verify_identity also check the server certificate and, for verify_identity,
+// that it names the host.
+enum class TlsMode {
+    disabled,
+    preferred,
+    required,
+    verify_ca,
+    verify_identity
+};
+
+// Protocol compression negotiated with the server; zstd needs MySQL 8.0.18 or later on both ends.
+enum class Compression {
+    none,
+    zlib,
+    zstd
+};
+
 struct ConnectionConfig {
     std::string host = "localhost";
     std::uint16_t port = 3306;
@@ -98,6 +144,55 @@ struct ConnectionConfig {
     std::chrono::seconds read_timeout{30};
     std::chrono::seconds write_timeout{30};
     std::chrono::milliseconds acquire_timeout{30000};
+    // Prepared statements kept per connection and reused when the same SQL is prepared again.
+    std::size_t statement_cache_size = 16;
+    // Return from the Database constructor at once and open initial_pool_size connections on a
+    // background thread, retrying failed connects with a delay that doubles from
+    // warmup_retry_delay up to warmup_retry_max_delay. Calls made meanwhile open their own
+    // connection when none is idle, and a failed connect fails only that call.
+    bool lazy_connect = false;
+    std::chrono::milliseconds warmup_retry_delay{100};
+    std::chrono::milliseconds warmup_retry_max_delay{5000};
+    // Run once on every new physical connection, such as "SET SESSION time_zone = '+00:00'". The
+    // MySQL connection sends them as one multi-statement round trip. A failure fails the connect.
+    std::vector<std::string> init_statements;
+
+    Transport transport = Transport::automatic;
+    // Socket file (or pipe name on Windows) for a local server; used with Transport::unix_socket,
+    // or with automatic and the host "localhost".
+    std::string unix_socket;
+    // Initial size of the client's network buffer (MYSQL_OPT_NET_BUFFER_LENGTH); 0 keeps the
+    // library default of 16 KiB.
+    std::size_t net_buffer_length = 0;
+    // SO_SNDBUF and SO_RCVBUF for the session socket; 0 keeps the OS default.
+    int socket_send_buffer = 0;
+    int socket_receive_buffer = 0;
+    // Confirm that Nagle's algorithm is off on TCP sessions, enabling TCP_NODELAY if it is not.
+    bool verify_tcp_nodelay = false;
+
+    // Compress the protocol on every pooled connection, or, when compressed_pool_size is non-zero,
+    // only on a separate pool of up to that many connections. Queries whose last result reached
+    // compress_result_threshold bytes are routed to that pool; other queries, executes and
+    // transactions stay on the uncompressed pool.
+    Compression compression = Compression::none;
+    // 1 (fastest) to 22; 0 keeps the library default of 3.
+    unsigned int zstd_compression_level = 0;
+    std::size_t compressed_pool_size = 0;
+    std::size_t compress_result_threshold = 256 * 1024;
+
+    TlsMode tls_mode = TlsMode::preferred;
+    // PEM files; empty leaves each unset. tls_ca_path names a directory of CA certificates.
+    std::string tls_ca;
+    std::string tls_ca_path;
+    std::string tls_cert;
+    std::string tls_key;
+    // Cipher lists for TLS 1.2 and for TLS 1.3, and the allowed protocols, such as "TLSv1.3".
+    std::string tls_cipher;
+    std::string tls_ciphersuites;
+    std::string tls_version;
+    // Offer the pool's most recent TLS session on every new connection so a server that still
+    // holds it skips the full handshake. Needs a MySQL 8.0.29 or later client and server.
+    bool tls_session_reuse = true;
 };
 
 enum class ColumnType {
@@ -118,6 +213,11 @@ struct Column {
 };
 
 class RowView;
+class RowSink;
+
+namespace detail {
+class ResultSnapshot;
+} // namespace detail
 
 class Result {
 public:
@@ -134,13 +234,27 @@ public:
     [[nodiscard]] RowView operator[](std::size_t index) const;
     [[nodiscard]] std::size_t column_index(std::string_view name) const;
 
+    // Writes a versioned, column-oriented snapshot to path, replacing any existing file
+    // atomically. Cells are stored in their column's type, as in ColumnarResult::from_result().
+    [[nodiscard]] Expected<void> save(const std::string& path) const;
+
+    // Maps a snapshot written by save() read-only. RowView::view() reads cells in place; at() and
+    // values() need owned Values and decode all rows once, on first use.
+    [[nodiscard]] static Expected<Result> map(const std::string& path);
+
 private:
     friend class RowView;
+    friend class SharedResultCache;
+    friend Expected<void> stream_result(const Result& result, RowSink& sink);
 
     std::vector<Column> columns_;
     std::vector<RowStorage> rows_;
     std::unordered_map<std::string, std::size_t> column_index_;
+    std::shared_ptr<const detail::ResultSnapshot> snapshot_;
+
+    explicit Result(std::shared_ptr<const detail::ResultSnapshot> snapshot);
 
+    [[nodiscard]] const std::vector<RowStorage>& row_storage() const;
     void rebuild_index();
 };
 
@@ -153,6 +267,10 @@ public:
     [[nodiscard]] const Value& operator[](std::string_view column_name) const;
     [[nodiscard]] std::span<const Value> values() const;
 
+    // Non-owning access that reads mapped snapshots in place.
+    [[nodiscard]] ValueView view(std::size_t column_index) const;
+    [[nodiscard]] ValueView view(std::string_view column_name) const;
+
 private:
     const Result* result_ = nullptr;
     std::size_t row_index_ = 0;
@@ -171,7 +289,496 @@ struct PoolStats {
     std::size_t queued_tasks = 0;
 };
 
-class PreparedStatement;
+struct ExecutorStats {
+    std::size_t worker_count = 0;
+    std::size_t queued_tasks = 0;
+    std::uint64_t submitted_tasks = 0;
+    std::uint64_t completed_tasks = 0;
+    std::uint64_t cancelled_tasks = 0;
+};
+
+struct StatementStats {
+    std::uint64_t prepared_statements = 0;
+    std::uint64_t prepare_failures = 0;
+    // Statements registered with Database::register_statement, pooled connections that have all
+    // of them prepared, and registry prepares that failed on some connection.
+    std::size_t registered_statements = 0;
+    std::size_t covered_connections = 0;
+    std::uint64_t registry_prepare_failures = 0;
+    // SET statements skipped because the session already had those values.
+    std::uint64_t skipped_session_sets = 0;
+};
+
+// Counted only when ConnectionConfig::compression is set. Result bytes are the decoded payload
+// (string and blob lengths, eight bytes per other value), not the bytes on the wire.
+struct CompressionStats {
+    std::uint64_t compressed_queries = 0;
+    std::uint64_t uncompressed_queries = 0;
+    std::uint64_t compressed_result_bytes = 0;
+    std::uint64_t uncompressed_result_bytes = 0;
+};
+
+// Connections opened over TLS by the built-in MySQL connection, split by whether the server
+// resumed an earlier session.
+struct TlsStats {
+    std::uint64_t full_handshakes = 0;
+    std::uint64_t resumed_sessions = 0;
+};
+
+struct LatencyHistogram {
+    static constexpr std::array<double, 18> bucket_bounds{
+        0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+        0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0};
+
+    // Per-bucket (non-cumulative) counts; the last slot counts samples above the largest bound.
+    std::array<std::uint64_t, bucket_bounds.size() + 1> bucket_counts{};
+    std::uint64_t count = 0;
+    double sum_seconds = 0.0;
+
+    // Estimates the q-quantile (0..1) in seconds by linear interpolation inside its bucket.
+    [[nodiscard]] double quantile(double q) const noexcept;
+};
+
+struct Metrics {
+    PoolStats pool;
+    ExecutorStats executor;
+    StatementStats statements;
+    CompressionStats compression;
+    TlsStats tls;
+    LatencyHistogram acquire_latency;
+    LatencyHistogram query_latency;
+    LatencyHistogram execute_latency;
+};
+
+struct MetricsSource {
+    std::string_view database;
+    std::string_view endpoint;
+    Metrics metrics;
+};
+
+// Receives a result set row by row while it is fetched, without materializing a Result. An error
+// returned from begin() or row() stops the fetch and is returned to the caller.
+class RowSink {
+public:
+    virtual ~RowSink() = default;
+
+    [[nodiscard]] virtual Expected<void> begin(std::span<const Column> columns) = 0;
+    [[nodiscard]] virtual Expected<void> row(std::span<const ValueView> values) = 0;
+};
+
+// SQL text usable as a template argument, such as StatementDescriptor<"SELECT ...">.
+template <std::size_t N>
+struct FixedString {
+    char text[N]{};
+
+    constexpr FixedString(const char (&value)[N]) noexcept {
+        for (std::size_t index = 0; index < N; ++index) {
+            text[index] = value[index];
+        }
+    }
+
+    [[nodiscard]] constexpr std::string_view view() const noexcept {
+        return std::string_view(text, N - 1);
+    }
+};
+
+// SQL with the hash the statement caches look it up by, so a caller that knows both at compile
+// time does not hash on every call.
+struct StatementKey {
+    std::string_view sql;
+    std::size_t hash = 0;
+};
+
+namespace detail {
+
+// FNV-1a; the statement caches hash SQL text with this whether or not it came from a descriptor.
+[[nodiscard]] constexpr std::size_t sql_hash(std::string_view sql) noexcept {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const char c : sql) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
+    return static_cast<std::size_t>(hash);
+}
+
+// Counts ? placeholders the way the server does, skipping quoted strings, quoted identifiers
+// and comments. As in the server's lexer, "--" starts a comment only before whitespace, a control
+// character or the end of the text, and the body of a /*! executable comment is live SQL,
+// whatever version it names.
+[[nodiscard]] constexpr std::size_t count_placeholders(std::string_view sql) noexcept {
+    std::size_t count = 0;
+    bool executable = false;
+    for (std::size_t pos = 0; pos < sql.size(); ++pos) {
+        const char c = sql[pos];
+        if (c == '?') {
+            ++count;
+        } else if (c == '\'' || c == '"' || c == '`') {
+            while (++pos < sql.size() && sql[pos] != c) {
+                if (sql[pos] == '\\' && c != '`') {
+                    ++pos;
+                }
+            }
+        } else if (c == '#' || (c == '-' && sql.substr(pos).starts_with("--") &&
+                                (pos + 2 == sql.size() || static_cast<unsigned char>(sql[pos + 2]) <= ' ' ||
+                                 sql[pos + 2] == '\x7f'))) {
+            while (pos < sql.size() && sql[pos] != '\n') {
+                ++pos;
+            }
+        } else if (c == '/' && sql.substr(pos).starts_with("/*!") && !executable) {
+            executable = true;
+            pos += 2;
+            while (pos + 1 < sql.size() && sql[pos + 1] >= '0' && sql[pos + 1] <= '9') {
+                ++pos;
+            }
+        } else if (c == '/' && sql.substr(pos).starts_with("/*")) {
+            const auto end = sql.find("*/", pos + 2);
+            pos = end == std::string_view::npos ? sql.size() : end + 1;
+        } else if (c == '*' && executable && sql.substr(pos).starts_with("*/")) {
+            executable = false;
+            ++pos;
+        }
+    }
+    return count;
+}
+
+template <typename T>
+struct optional_traits {
+    static constexpr bool is_optional = false;
+    using value_type = T;
+};
+
+template <typename T>
+struct optional_traits<std::optional<T>> {
+    static constexpr bool is_optional = true;
+    using value_type = T;
+};
+
+template <typename T>
+concept view_param = std::same_as<T, bool> || std::integral<T> || std::floating_point<T> ||
+                     std::same_as<T, std::string_view> || std::same_as<T, std::span<const std::byte>>;
+
+// A descriptor parameter type: one of the above, or std::optional of one for a nullable value.
+template <typename T>
+concept descriptor_param = view_param<T> ||
+                           (optional_traits<T>::is_optional && view_param<typename optional_traits<T>::value_type>);
+
+template <typename T>
+[[nodiscard]] constexpr ValueView param_view(const T& value) noexcept {
+    if constexpr (optional_traits<T>::is_optional) {
+        return value ? param_view(*value) : ValueView{nullptr};
+    } else if constexpr (std::same_as<T, bool>) {
+        return value;
+    } else if constexpr (std::signed_integral<T>) {
+        return static_cast<std::int64_t>(value);
+    } else if constexpr (std::unsigned_integral<T>) {
+        return static_cast<std::uint64_t>(value);
+    } else if constexpr (std::floating_point<T>) {
+        return static_cast<double>(value);
+    } else {
+        return value;
+    }
+}
+
+} // namespace detail
+
+// A prepared statement known at compile time: the SQL, its placeholder count and its hash are
+// constants, and the parameter types are checked against the placeholders when the descriptor
+// is instantiated. Arguments are converted to the declared types at the call site and bound
+// from there without building Values or copying strings.
+//
+//     using FindUser = StatementDescriptor<"SELECT name FROM users WHERE id = ?", std::int64_t>;
+//     auto users = database.query(FindUser{}, 42);
+template <FixedString Sql, detail::descriptor_param... Params>
+struct StatementDescriptor {
+    static constexpr std::string_view sql = Sql.view();
+    static constexpr std::size_t parameter_count = sizeof...(Params);
+    static constexpr StatementKey key{.sql = sql, .hash = detail::sql_hash(sql)};
+
+    static_assert(detail::count_placeholders(sql) == parameter_count,
+                  "the statement's ? placeholders and its parameter types differ in number");
+
+    // String and span parameters refer to the caller's arguments, which outlive the call.
+    [[nodiscard]] static std::array<ValueView, parameter_count> views(const Params&... params) noexcept {
+        return {detail::param_view(params)...};
+    }
+};
+
+namespace detail {
+
+template <typename T>
+concept statement_descriptor = requires {
+    { T::key } -> std::convertible_to<StatementKey>;
+    { T::parameter_count } -> std::convertible_to<std::size_t>;
+};
+
+} // namespace detail
+
+// query_into() support: an aggregate row type is taken apart into its members with structured
+// bindings, and each member is described to the fetch code by a MemberBinding.
+namespace detail {
+
+enum class MemberKind {
+    signed_integer,
+    unsigned_integer,
+    floating,
+    boolean,
+    text,
+    blob
+};
+
+// One row member. storage() returns the member's value inside a row, first emplacing it when the
+// member is a std::optional; clear() resets such a member for a NULL and is null otherwise.
+struct MemberBinding {
+    MemberKind kind = MemberKind::text;
+    std::size_t size = 0;
+    void* (*storage)(void* row) = nullptr;
+    void (*clear)(void* row) = nullptr;
+};
+
+// Rows of one aggregate type being filled by a fetch. type identifies the row layout, which a
+// statement checks against its result metadata once. names is empty when columns map to
+// members by position.
+struct RowTarget {
+    const void* type = nullptr;
+    std::span<const MemberBinding> members;
+    std::span<const std::string_view> names;
+    void* rows = nullptr;
+    void* (*append)(void* rows) = nullptr;
+    void (*discard)(void* rows) = nullptr;
+    // When set, the fetch adds the payload bytes of the columns it maps, counted as for query().
+    std::uint64_t* fetched_bytes = nullptr;
+};
+
+inline constexpr std::size_t max_row_members = 16;
+
+struct any_member {
+    template <typename T>
+    operator T() const;
+};
+
+template <typename T, typename... Members>
+consteval std::size_t member_count() {
+    if constexpr (sizeof...(Members) < max_row_members && requires { T{Members{}..., any_member{}}; }) {
+        return member_count<T, Members..., any_member>();
+    } else {
+        return sizeof...(Members);
+    }
+}
+
+template <typename T>
+auto tie_members(T& row) {
+    constexpr auto count = member_count<T>();
+    if constexpr (count == 1) {
+        auto& [m0] = row;
+        return std::tie(m0);
+    } else if constexpr (count == 2) {
+        auto& [m0, m1] = row;
+        return std::tie(m0, m1);
+    } else if constexpr (count == 3) {
+        auto& [m0, m1, m2] = row;
+        return std::tie(m0, m1, m2);
+    } else if constexpr (count == 4) {
+        auto& [m0, m1, m2, m3] = row;
+        return std::tie(m0, m1, m2, m3);
+    } else if constexpr (count == 5) {
+        auto& [m0, m1, m2, m3, m4] = row;
+        return std::tie(m0, m1, m2, m3, m4);
+    } else if constexpr (count == 6) {
+        auto& [m0, m1, m2, m3, m4, m5] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5);
+    } else if constexpr (count == 7) {
+        auto& [m0, m1, m2, m3, m4, m5, m6] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6);
+    } else if constexpr (count == 8) {
+        auto& [m0, m1, m2, m3, m4, m5, m6, m7] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7);
+    } else if constexpr (count == 9) {
+        auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8);
+    } else if constexpr (count == 10) {
+        auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9);
+    } else if constexpr (count == 11) {
+        auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10);
+    } else if constexpr (count == 12) {
+        auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11);
+    } else if constexpr (count == 13) {
+        auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12);
+    } else if constexpr (count == 14) {
+        auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13);
+    } else if constexpr (count == 15) {
+        auto& [m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14] = row;
+        return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14);
+    }
+}
+
+template <typename T, std::size_t I>
+using member_type = std::remove_cvref_t<std::tuple_element_t<I, decltype(tie_members(std::declval<T&>()))>>;
+
+template <typename T>
+concept row_value = std::integral<T> || std::same_as<T, float> || std::same_as<T, double> ||
+                    std::same_as<T, std::string> || std::same_as<T, Blob>;
+
+// A query_into() member type: one of the above, or std::optional of one for a nullable column.
+template <typename T>
+concept row_member = row_value<T> || (optional_traits<T>::is_optional && row_value<typename optional_traits<T>::value_type>);
+
+template <typename T>
+consteval MemberKind member_kind() {
+    if constexpr (std::same_as<T, bool>) {
+        return MemberKind::boolean;
+    } else if constexpr (std::signed_integral<T>) {
+        return MemberKind::signed_integer;
+    } else if constexpr (std::unsigned_integral<T>) {
+        return MemberKind::unsigned_integer;
+    } else if constexpr (std::floating_point<T>) {
+        return MemberKind::floating;
+    } else if constexpr (std::same_as<T, std::string>) {
+        return MemberKind::text;
+    } else {
+        return MemberKind::blob;
+    }
+}
+
+template <typename T, std::size_t I>
+void* member_storage(void* row) {
+    auto& member = std::get<I>(tie_members(*static_cast<T*>(row)));
+    if constexpr (optional_traits<member_type<T, I>>::is_optional) {
+        return &member.emplace();
+    } else {
+        return &member;
+    }
+}
+
+template <typename T, std::size_t I>
+void clear_member(void* row) {
+    std::get<I>(tie_members(*static_cast<T*>(row))).reset();
+}
+
+template <typename T, std::size_t I>
+constexpr MemberBinding member_binding() {
+    using Member = member_type<T, I>;
+    static_assert(row_member<Member>, "query_into() members must be bool, integers, float, double, std::string, Blob "
+                                      "or std::optional of one of them");
+    using Stored = typename optional_traits<Member>::value_type;
+    MemberBinding binding{.kind = member_kind<Stored>(), .size = sizeof(Stored), .storage = &member_storage<T, I>};
+    if constexpr (optional_traits<Member>::is_optional) {
+        binding.clear = &clear_member<T, I>;
+    }
+    return binding;
+}
+
+template <typename T>
+concept named_row = requires {
+    { std::span<const std::string_view>(T::column_names) };
+};
+
+template <typename T>
+struct RowLayout {
+    static_assert(std::is_aggregate_v<T> && std::is_default_constructible_v<T>,
+                  "query_into() rows must be default-constructible aggregates");
+    static constexpr std::size_t count = member_count<T>();
+    static_assert(count > 0 && count < max_row_members, "query_into() rows have 1 to 15 members");
+
+    static constexpr auto members = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<MemberBinding, count>{member_binding<T, I>()...};
+    }(std::make_index_sequence<count>{});
+};
+
+// Members map to the columns of the same name when T has a static column_names array, and by
+// position otherwise.
+template <typename T>
+RowTarget row_target(std::vector<T>& rows) {
+    std::span<const std::string_view> names;
+    if constexpr (named_row<T>) {
+        static_assert(std::size(T::column_names) == RowLayout<T>::count, "column_names must name every member");
+        names = T::column_names;
+    }
+    return RowTarget{
+        .type = &RowLayout<T>::members,
+        .members = RowLayout<T>::members,
+        .names = names,
+        .rows = &rows,
+        .append = [](void* target) -> void* { return &static_cast<std::vector<T>*>(target)->emplace_back(); },
+        .discard = [](void* target) { static_cast<std::vector<T>*>(target)->pop_back(); },
+        .fetched_bytes = nullptr
+    };
+}
+
+} // namespace detail
+
+class PreparedStatement {
+public:
+    virtual ~PreparedStatement() = default;
+
+    [[nodiscard]] virtual Expected<Result> query(std::vector<Value> values) = 0;
+    [[nodiscard]] virtual Expected<ExecuteResult> execute(std::vector<Value> values) = 0;
+
+    // Bind the views in place instead of copying them into Values; they must stay valid for the
+    // call. The defaults copy them and call query() or execute().
+    [[nodiscard]] virtual Expected<Result> query_views(std::span<const ValueView> values);
+    [[nodiscard]] virtual Expected<ExecuteResult> execute_views(std::span<const ValueView> values);
+
+    // Appends the result rows to target. The MySQL statement checks the columns against the row
+    // layout once and fetches straight into the members; the default maps query()'s Result.
+    [[nodiscard]] virtual Expected<void> query_into(std::span<const ValueView> values, const detail::RowTarget& target);
+
+    // Defaults to query() followed by stream_result(); the MySQL statement fetches row by row.
+    [[nodiscard]] virtual Expected<void> stream(std::vector<Value> values, RowSink& sink);
+};
+
+// One server session owned by the pool. The MySQL client is the default implementation; a
+// ConnectionFactory can substitute another, such as an in-process fake for tests and benchmarks.
+class Connection {
+public:
+    virtual ~Connection() = default;
+
+    [[nodiscard]] virtual Expected<void> connect() = 0;
+    [[nodiscard]] virtual Expected<void> ping() = 0;
+    [[nodiscard]] virtual Expected<Result> query(std::string_view sql) = 0;
+    [[nodiscard]] virtual Expected<ExecuteResult> execute(std::string_view sql) = 0;
+    [[nodiscard]] virtual Expected<void> stream(std::string_view sql, RowSink& sink);
+
+    // The statement is owned by the connection and stays valid until the next prepare(), which
+    // may return the same statement again for the same SQL.
+    [[nodiscard]] virtual Expected<PreparedStatement*> prepare(std::string_view sql) = 0;
+    // prepare() for SQL whose detail::sql_hash() the caller already has. The default ignores the
+    // hash.
+    [[nodiscard]] virtual Expected<PreparedStatement*> prepare_with_hash(std::string_view sql, std::size_t hash);
+    // prepare() for a statement registered with Database::register_statement. It stays cached for
+    // the life of the session, and other prepares never evict it. The default is prepare().
+    [[nodiscard]] virtual Expected<PreparedStatement*> prepare_pinned(std::string_view sql);
+    [[nodiscard]] virtual Expected<std::string> escape(std::string_view value) = 0;
+
+    // Runs ConnectionConfig::init_statements after connect(). The default executes them one at a
+    // time through execute().
+    [[nodiscard]] virtual Expected<void> initialize_session(std::span<const std::string> statements);
+
+    [[nodiscard]] Expected<void> begin_transaction();
+    [[nodiscard]] Expected<void> commit();
+    [[nodiscard]] Expected<void> rollback();
+    [[nodiscard]] bool in_transaction() const noexcept;
+
+    // Session variables this connection has given literal values with "SET [SESSION] name =
+    // value, ..." through the wrapper. A text SET that would change none of them is redundant and
+    // the wrapper skips it. Other SETs forget the variables they name, and a SET the wrapper does
+    // not follow, such as SET NAMES, forgets all of them. Changes made by stored programs are not
+    // seen. Only variables that keep their value until the next SET, such as sql_mode and
+    // time_zone, are followed; a one-shot one such as insert_id is always sent.
+    [[nodiscard]] bool redundant_session_set(std::string_view sql) const;
+    // Records a SET statement after it ran; applied is false when it failed or took parameters.
+    void track_session_set(std::string_view sql, bool applied);
+
+private:
+    std::atomic_bool in_transaction_{false};
+    std::unordered_map<std::string, std::string> session_variables_;
+};
+
+using ConnectionFactory = std::function<std::unique_ptr<Connection>(const ConnectionConfig&)>;
+
 class Transaction;
 
 class ConnectionPool;
@@ -180,6 +787,7 @@ class Database;
 
 Expected<Result> query_with_values(Database& database, std::string_view sql, std::vector<Value> values);
 Expected<ExecuteResult> execute_with_values(Database& database, std::string_view sql, std::vector<Value> values);
+Expected<void> stream_with_values(Database& database, std::string_view sql, RowSink& sink, std::vector<Value> values);
 std::future<Expected<Result>> submit_query_with_values(Database& database, std::string sql, std::vector<Value> values);
 std::future<Expected<ExecuteResult>> submit_execute_with_values(
     Database& database,
@@ -187,6 +795,10 @@ std::future<Expected<ExecuteResult>> submit_execute_with_values(
     std::vector<Value> values);
 Expected<Result> transaction_query_with_values(Transaction& tx, std::string_view sql, std::vector<Value> values);
 Expected<ExecuteResult> transaction_execute_with_values(Transaction& tx, std::string_view sql, std::vector<Value> values);
+Expected<Result> query_with_views(Database& database, StatementKey key, std::span<const ValueView> values);
+Expected<ExecuteResult> execute_with_views(Database& database, StatementKey key, std::span<const ValueView> values);
+Expected<void> query_into_with_views(Database& database, std::string_view sql, std::span<const ValueView> values,
+                                     const detail::RowTarget& target);
 
 namespace detail {
 
@@ -207,6 +819,7 @@ struct expected_traits<std::expected<T, E>> {
 class Database {
 public:
     explicit Database(ConnectionConfig config);
+    Database(ConnectionConfig config, ConnectionFactory connection_factory);
     ~Database();
 
     Database(const Database&) = delete;
@@ -224,6 +837,28 @@ public:
     template <typename... Args>
     [[nodiscard]] Expected<ExecuteResult> execute(std::string_view sql, Args&&... args);
 
+    // Always prepared, even without parameters. See StatementDescriptor.
+    template <detail::statement_descriptor Descriptor, typename... Args>
+    [[nodiscard]] Expected<Result> query(Descriptor descriptor, Args&&... args);
+
+    template <detail::statement_descriptor Descriptor, typename... Args>
+    [[nodiscard]] Expected<ExecuteResult> execute(Descriptor descriptor, Args&&... args);
+
+    // Runs a prepared query and returns its rows as T, an aggregate whose members are filled
+    // from the columns by position, or by name when T declares
+    //     static constexpr std::array<std::string_view, N> column_names{...};
+    // Members may be bool, integers, float, double, std::string, Blob or std::optional of one of
+    // them; only an optional member takes NULL. No Result or Values are built.
+    template <typename T, typename... Args>
+    [[nodiscard]] Expected<std::vector<T>> query_into(std::string_view sql, Args&&... args);
+
+    // Feeds the result set to sink as it is read instead of building a Result. Text queries use an
+    // unbuffered fetch, so the connection stays leased until the last row has been consumed.
+    [[nodiscard]] Expected<void> stream(std::string_view sql, RowSink& sink);
+
+    template <typename... Args>
+    [[nodiscard]] Expected<void> stream(std::string_view sql, RowSink& sink, Args&&... args);
+
     [[nodiscard]] std::future<Expected<Result>> query_async(std::string sql);
 
     template <typename... Args>
@@ -240,7 +875,23 @@ public:
     [[nodiscard]] auto transaction(Fn&& fn);
 
     [[nodiscard]] Expected<std::string> escape(std::string_view value);
+
+    // Registers hot SQL to keep prepared on every pooled connection. The statement is prepared
+    // once to validate it, then on each idle connection, and from then on on every connection
+    // the background warm-up opens, so requests do not pay for the prepare. Connections opened
+    // on the request path catch up when they are released. Registered statements are pinned in
+    // each connection's statement cache, so at most statement_cache_size - 1 can be registered;
+    // registering one again does nothing.
+    [[nodiscard]] Expected<void> register_statement(std::string sql);
+
     [[nodiscard]] PoolStats stats() const;
+    [[nodiscard]] Metrics metrics() const;
+    [[nodiscard]] MetricsSource metrics_source() const;
+
+    // Appends every call made through this Database to a binary traffic log at path until
+    // stop_recording(). See mysqlwrapper/traffic_log.hpp for the record layout.
+    [[nodiscard]] Expected<void> start_recording(const std::string& path);
+    [[nodiscard]] Expected<void> stop_recording();
 
     [[nodiscard]] Result query_or_throw(std::string_view sql);
 
@@ -255,6 +906,8 @@ public:
 private:
     friend Expected<Result> query_with_values(Database& database, std::string_view sql, std::vector<Value> values);
     friend Expected<ExecuteResult> execute_with_values(Database& database, std::string_view sql, std::vector<Value> values);
+    friend Expected<void> stream_with_values(Database& database, std::string_view sql, RowSink& sink,
+                                             std::vector<Value> values);
     friend std::future<Expected<Result>> submit_query_with_values(
         Database& database,
         std::string sql,
@@ -263,6 +916,11 @@ private:
         Database& database,
         std::string sql,
         std::vector<Value> values);
+    friend Expected<Result> query_with_views(Database& database, StatementKey key, std::span<const ValueView> values);
+    friend Expected<ExecuteResult> execute_with_views(Database& database, StatementKey key,
+                                                      std::span<const ValueView> values);
+    friend Expected<void> query_into_with_views(Database& database, std::string_view sql,
+                                                std::span<const ValueView> values, const detail::RowTarget& target);
 
     class Impl;
     std::unique_ptr<Impl> impl_;
@@ -312,6 +970,12 @@ template <typename T>
 template <typename T>
 [[nodiscard]] T get_or_throw(const Value& value);
 
+[[nodiscard]] ValueView view_of(const Value& value) noexcept;
+[[nodiscard]] Value to_value(const ValueView& view);
+
+// Replays an already materialized Result into sink.
+[[nodiscard]] Expected<void> stream_result(const Result& result, RowSink& sink);
+
 [[nodiscard]] std::string_view to_string(ErrorCode code) noexcept;
 [[nodiscard]] std::string_view to_string(Operation operation) noexcept;
 
@@ -414,6 +1078,27 @@ std::vector<Value> make_values(Args&&... args) {
     return values;
 }
 
+// A query_into() argument as a view of the caller's value.
+template <typename T>
+ValueView arg_view(const T& value) {
+    if constexpr (std::same_as<T, std::nullptr_t>) {
+        return nullptr;
+    } else if constexpr (std::same_as<T, Value>) {
+        return view_of(value);
+    } else if constexpr (std::same_as<T, Blob>) {
+        return std::span<const std::byte>(value);
+    } else if constexpr (std::same_as<std::decay_t<T>, const char*> || std::same_as<std::decay_t<T>, char*>) {
+        return value == nullptr ? ValueView{nullptr} : ValueView{std::string_view(value)};
+    } else if constexpr (std::convertible_to<const T&, std::string_view>) {
+        return std::string_view(value);
+    } else if constexpr (std::convertible_to<const T&, std::span<const std::byte>>) {
+        return std::span<const std::byte>(value);
+    } else {
+        static_assert(descriptor_param<T>, "unsupported query_into() argument type");
+        return param_view(value);
+    }
+}
+
 } // namespace detail
 
 template <typename... Args>
@@ -426,6 +1111,35 @@ Expected<ExecuteResult> Database::execute(std::string_view sql, Args&&... args)
     return execute_with_values(*this, sql, detail::make_values(std::forward<Args>(args)...));
 }
 
+template <detail::statement_descriptor Descriptor, typename... Args>
+Expected<Result> Database::query(Descriptor, Args&&... args) {
+    static_assert(sizeof...(Args) == Descriptor::parameter_count, "wrong number of statement arguments");
+    const auto views = Descriptor::views(std::forward<Args>(args)...);
+    return query_with_views(*this, Descriptor::key, views);
+}
+
+template <detail::statement_descriptor Descriptor, typename... Args>
+Expected<ExecuteResult> Database::execute(Descriptor, Args&&... args) {
+    static_assert(sizeof...(Args) == Descriptor::parameter_count, "wrong number of statement arguments");
+    const auto views = Descriptor::views(std::forward<Args>(args)...);
+    return execute_with_views(*this, Descriptor::key, views);
+}
+
+template <typename T, typename... Args>
+Expected<std::vector<T>> Database::query_into(std::string_view sql, Args&&... args) {
+    const std::array<ValueView, sizeof...(Args)> views{detail::arg_view(args)...};
+    std::vector<T> rows;
+    if (auto fetched = query_into_with_views(*this, sql, views, detail::row_target(rows)); !fetched) {
+        return std::unexpected(fetched.error());
+    }
+    return rows;
+}
+
+template <typename... Args>
+Expected<void> Database::stream(std::string_view sql, RowSink& sink, Args&&... args) {
+    return stream_with_values(*this, sql, sink, detail::make_values(std::forward<Args>(args)...));
+}
+
 template <typename... Args>
 std::future<Expected<Result>> Database::query_async(std::string sql, Args&&... args) {
     auto values = detail::make_values(std::forward<Args>(args)...);
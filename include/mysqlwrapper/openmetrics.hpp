@@ -0,0 +1,20 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace mysqlw {
+
+inline constexpr std::string_view openmetrics_content_type =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+// Renders every source as one OpenMetrics exposition, grouped by metric family and terminated
+// by "# EOF". `out` is cleared first and keeps its capacity, so a buffer reused across scrapes
+// stops allocating once it has grown to the exposition size.
+void write_openmetrics(std::string& out, std::span<const MetricsSource> sources);
+void write_openmetrics(std::string& out, const MetricsSource& source);
+
+} // namespace mysqlw
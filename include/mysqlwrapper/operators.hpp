@@ -0,0 +1,108 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace mysqlw {
+
+// A column of a Result, by name or by position.
+class ColumnRef {
+public:
+    ColumnRef(std::string name) : ref_(std::move(name)) {}
+    ColumnRef(std::string_view name) : ref_(std::string(name)) {}
+    ColumnRef(const char* name) : ref_(std::string(name)) {}
+
+    template <std::integral Index>
+    ColumnRef(Index index) : ref_(static_cast<std::size_t>(index)) {}
+
+    [[nodiscard]] Expected<std::size_t> resolve(std::span<const Column> columns) const;
+
+private:
+    std::variant<std::string, std::size_t> ref_;
+};
+
+enum class CompareOp {
+    equal,
+    not_equal,
+    less,
+    less_equal,
+    greater,
+    greater_equal,
+    is_null,
+    is_not_null
+};
+
+// Compares a column with a constant. As in SQL, a NULL cell or a NULL constant never satisfies a
+// comparison; use is_null and is_not_null to test for NULL. Numbers compare across signed,
+// unsigned and floating types, and text and blobs compare byte-wise.
+struct Predicate {
+    ColumnRef column;
+    CompareOp op = CompareOp::equal;
+    Value value = nullptr;
+};
+
+// NULL sorts before every value, so it comes first ascending and last descending, as in MySQL.
+struct SortKey {
+    ColumnRef column;
+    bool descending = false;
+};
+
+enum class AggregateFunction {
+    count,
+    sum,
+    min,
+    max
+};
+
+// count without a column counts rows, like COUNT(*); every other aggregate ignores NULL cells and
+// is NULL for a group with no values. sum keeps the column's integer or floating type and fails
+// on overflow. An empty name defaults to "sum(price)", "count(*)" and so on.
+struct Aggregate {
+    AggregateFunction function = AggregateFunction::count;
+    std::optional<ColumnRef> column;
+    std::string name;
+};
+
+// Keeps the rows that satisfy every predicate, in their original order.
+[[nodiscard]] Expected<Result> filter(const Result& input, const std::vector<Predicate>& predicates);
+
+// Stable multi-key sort.
+[[nodiscard]] Expected<Result> sort_by(const Result& input, const std::vector<SortKey>& keys);
+
+// One row per distinct combination of keys, in order of first appearance, holding the keys
+// followed by the aggregates. NULL keys form a group of their own. Without keys the whole input
+// is one group, so the result always has exactly one row.
+[[nodiscard]] Expected<Result> group_by(const Result& input, const std::vector<ColumnRef>& keys,
+                                        const std::vector<Aggregate>& aggregates);
+
+enum class JoinKind {
+    inner,
+    // Every left row appears at least once; right columns are NULL where nothing matched.
+    left
+};
+
+struct JoinOptions {
+    JoinKind kind = JoinKind::inner;
+    // Prepended to the names of right columns that collide with a left column.
+    std::string right_prefix = "right.";
+};
+
+// Equi-join on one or more key pairs. The output has the left columns followed by the right
+// ones. As in SQL, NULL keys never match. Integer keys match across signed, unsigned and boolean
+// columns, text matches blobs, and floating keys match only floating keys.
+//
+// The hash table is built over the smaller input and the other one is probed row by row, so
+// inner join rows follow the probe side. Left join rows always follow the left input, with each
+// unmatched left row in its place and the matches for one left row in right-input order.
+[[nodiscard]] Expected<Result> hash_join(const Result& left, const Result& right, const std::vector<ColumnRef>& left_keys,
+                                         const std::vector<ColumnRef>& right_keys, const JoinOptions& options = {});
+
+} // namespace mysqlw
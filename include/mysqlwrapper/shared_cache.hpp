@@ -0,0 +1,99 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mysqlw {
+
+struct SharedCacheOptions {
+    // POSIX shared-memory name of the index, e.g. "/myapp-results". Each entry lives in its own
+    // object named "<name>.<id>".
+    std::string name;
+    // The geometry below applies only to the process that creates the index; later processes
+    // attach with whatever it was created with.
+    std::size_t capacity_bytes = 64 * 1024 * 1024;
+    std::size_t slots = 4096;
+    std::chrono::milliseconds ttl{std::chrono::seconds(60)};
+};
+
+struct SharedCacheStats {
+    // Counted by this process only.
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t inserts = 0;
+    std::uint64_t evictions = 0;
+    // Shared by every attached process.
+    std::uint64_t used_bytes = 0;
+    std::uint64_t capacity_bytes = 0;
+};
+
+// A cache of immutable query results shared by the processes on one host. A result is encoded
+// once, in the Result::save() snapshot format, into its own shared-memory object. Every process
+// maps that object and reads it in place through RowView::view().
+//
+// The index is a fixed table of slots that processes update with atomic compare-and-swap, so
+// no lock is held across processes and a crashed process cannot wedge the others. An entry that
+// expires or is evicted is unlinked straight away, but processes that still hold it keep a
+// valid mapping until they release the Result. The capacity counts the entries the index holds,
+// including ones still being written.
+class SharedResultCache {
+public:
+    // Creates the index or attaches to an existing one.
+    [[nodiscard]] static Expected<std::unique_ptr<SharedResultCache>> open(SharedCacheOptions options);
+
+    // Unlinks the index and every entry it references. Attached processes keep working on their
+    // existing mappings; the next open() starts a fresh index.
+    [[nodiscard]] static Expected<void> remove(const std::string& name);
+
+    ~SharedResultCache();
+
+    SharedResultCache(const SharedResultCache&) = delete;
+    SharedResultCache& operator=(const SharedResultCache&) = delete;
+
+    // The cached result for sql and params, if one is live. The returned Result reads shared
+    // memory in place.
+    [[nodiscard]] std::optional<Result> find(std::string_view sql, std::span<const Value> params = {});
+
+    // Publishes result under sql and params, evicting expired and then least-recently-expiring
+    // entries to stay within capacity. A zero ttl uses SharedCacheOptions::ttl.
+    [[nodiscard]] Expected<void> insert(std::string_view sql, std::span<const Value> params, const Result& result,
+                                        std::chrono::milliseconds ttl = std::chrono::milliseconds::zero());
+
+    [[nodiscard]] SharedCacheStats stats() const;
+
+    // Returns the cached result or runs the query and publishes it. A result that cannot be
+    // cached is still returned.
+    template <typename... Args>
+    [[nodiscard]] Expected<Result> query(Database& database, std::string_view sql, Args&&... args);
+
+private:
+    class Impl;
+    explicit SharedResultCache(std::unique_ptr<Impl> impl) noexcept;
+
+    std::unique_ptr<Impl> impl_;
+};
+
+template <typename... Args>
+Expected<Result> SharedResultCache::query(Database& database, std::string_view sql, Args&&... args) {
+    const auto params = detail::make_values(std::forward<Args>(args)...);
+    if (auto cached = find(sql, params)) {
+        return std::move(*cached);
+    }
+    auto result = query_with_values(database, sql, params);
+    if (result) {
+        (void)insert(sql, params, *result);
+    }
+    return result;
+}
+
+} // namespace mysqlw
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace mysqlw {
+
+struct ScanOptions {
+    // Table and integer primary-key column; both are quoted as identifiers, and the table may be
+    // qualified as "schema.table".
+    std::string table;
+    std::string key;
+    // Raw SQL for the select list and an optional extra condition, ANDed onto every range.
+    std::string columns = "*";
+    std::string where;
+    // Range queries in flight at once. Each holds one pooled connection while it runs.
+    std::size_t parallelism = 4;
+    // Number of ranges; 0 means four per unit of parallelism, which evens out skew the sample
+    // missed.
+    std::size_t chunks = 0;
+    // Points at which the key density is sampled, each reading up to sample_rows index entries.
+    std::size_t sample_points = 32;
+    std::size_t sample_rows = 1000;
+    // Deliver chunks in key order, or as soon as each one completes.
+    bool ordered = true;
+};
+
+struct ScanChunk {
+    std::size_t index = 0;
+    // Inclusive key range of the chunk.
+    std::int64_t first_key = 0;
+    std::int64_t last_key = 0;
+    Result rows;
+};
+
+struct ScanStats {
+    std::size_t chunks = 0;
+    std::uint64_t rows = 0;
+    std::size_t sample_queries = 0;
+    std::chrono::nanoseconds elapsed{0};
+};
+
+// Called on the thread that called scan_table(), one chunk at a time. Returning an error stops
+// the scan, and scan_table() returns that error.
+using ChunkConsumer = std::function<Expected<void>(ScanChunk& chunk)>;
+
+// Reads a whole table as concurrent primary-key range queries. The key density is sampled first
+// so ranges hold similar row counts even when keys are clustered. At most 2 * parallelism
+// chunks are fetched ahead of the consumer, so memory stays bounded when it falls behind.
+[[nodiscard]] Expected<ScanStats> scan_table(Database& database, const ScanOptions& options, const ChunkConsumer& consumer);
+
+} // namespace mysqlw
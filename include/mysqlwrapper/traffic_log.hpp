@@ -0,0 +1,98 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mysqlw {
+
+// Which public call produced a traffic record.
+enum class TrafficApi : std::uint8_t {
+    query,
+    execute,
+    query_async,
+    execute_async,
+    transaction_begin,
+    transaction_query,
+    transaction_execute,
+    transaction_commit,
+    transaction_rollback,
+    stream
+};
+
+struct TrafficRecord {
+    // Offset from the start of the recording to when the call was issued.
+    std::chrono::nanoseconds timestamp{0};
+    std::chrono::nanoseconds duration{0};
+    TrafficApi api = TrafficApi::query;
+    bool ok = true;
+    // Groups the calls of one transaction; 0 for calls outside a transaction.
+    std::uint64_t session = 0;
+    std::string sql;
+    std::vector<Value> params;
+};
+
+// Appends TrafficRecords to a binary log. Integers are varints, timestamps are deltas from the
+// previous record, and each distinct SQL text is written once and then referred to by index.
+// append() is thread-safe.
+class TrafficRecorder {
+public:
+    [[nodiscard]] static Expected<std::unique_ptr<TrafficRecorder>> open(const std::string& path);
+
+    ~TrafficRecorder();
+
+    TrafficRecorder(const TrafficRecorder&) = delete;
+    TrafficRecorder& operator=(const TrafficRecorder&) = delete;
+
+    [[nodiscard]] std::chrono::steady_clock::time_point started() const noexcept { return started_; }
+
+    void append(const TrafficRecord& record);
+    [[nodiscard]] Expected<void> flush();
+
+private:
+    explicit TrafficRecorder(std::FILE* file) noexcept;
+
+    std::FILE* file_;
+    std::chrono::steady_clock::time_point started_;
+    std::mutex mutex_;
+    std::string buffer_;
+    std::unordered_map<std::string, std::uint64_t> statement_ids_;
+    std::chrono::nanoseconds last_timestamp_{0};
+    bool failed_ = false;
+};
+
+// Reads a log written by TrafficRecorder, one record at a time.
+class TrafficLogReader {
+public:
+    [[nodiscard]] static Expected<TrafficLogReader> open(const std::string& path);
+
+    ~TrafficLogReader();
+
+    TrafficLogReader(TrafficLogReader&& other) noexcept;
+    TrafficLogReader& operator=(TrafficLogReader&& other) noexcept;
+    TrafficLogReader(const TrafficLogReader&) = delete;
+    TrafficLogReader& operator=(const TrafficLogReader&) = delete;
+
+    // std::nullopt at the end of the log.
+    [[nodiscard]] Expected<std::optional<TrafficRecord>> next();
+
+private:
+    explicit TrafficLogReader(std::FILE* file) noexcept : file_(file) {}
+
+    std::FILE* file_ = nullptr;
+    std::vector<std::string> statements_;
+    std::chrono::nanoseconds last_timestamp_{0};
+};
+
+[[nodiscard]] std::string_view to_string(TrafficApi api) noexcept;
+
+} // namespace mysqlw
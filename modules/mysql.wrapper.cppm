@@ -1,33 +1,117 @@
 module;
 
+#include "mysqlwrapper/chunked_dml.hpp"
+#include "mysqlwrapper/columnar.hpp"
+#include "mysqlwrapper/csv_export.hpp"
+#include "mysqlwrapper/json.hpp"
+#include "mysqlwrapper/keyset_pager.hpp"
 #include "mysqlwrapper/mysql_wrapper.hpp"
+#include "mysqlwrapper/openmetrics.hpp"
+#include "mysqlwrapper/operators.hpp"
+#include "mysqlwrapper/shared_cache.hpp"
+#include "mysqlwrapper/table_scan.hpp"
+#include "mysqlwrapper/traffic_log.hpp"
 
 export module mysql.wrapper;
 
 export namespace mysqlw {
+using ::mysqlw::Aggregate;
+using ::mysqlw::AggregateFunction;
 using ::mysqlw::Blob;
+using ::mysqlw::ChunkConsumer;
+using ::mysqlw::ChunkedDmlOptions;
 using ::mysqlw::Column;
+using ::mysqlw::ColumnBuffer;
+using ::mysqlw::ColumnRef;
 using ::mysqlw::ColumnType;
+using ::mysqlw::ColumnarBuilder;
+using ::mysqlw::ColumnarResult;
+using ::mysqlw::CompareOp;
+using ::mysqlw::Compression;
+using ::mysqlw::CompressionStats;
+using ::mysqlw::Connection;
 using ::mysqlw::ConnectionConfig;
+using ::mysqlw::ConnectionFactory;
+using ::mysqlw::CsvFormat;
+using ::mysqlw::CsvOptions;
+using ::mysqlw::CsvWriter;
 using ::mysqlw::Database;
 using ::mysqlw::DbError;
 using ::mysqlw::DbException;
+using ::mysqlw::DmlEvent;
+using ::mysqlw::DmlKind;
+using ::mysqlw::DmlProgress;
+using ::mysqlw::DmlProgressCallback;
+using ::mysqlw::DmlStats;
 using ::mysqlw::ErrorCode;
 using ::mysqlw::ExecuteResult;
+using ::mysqlw::ExecutorStats;
 using ::mysqlw::Expected;
+using ::mysqlw::ExportStats;
+using ::mysqlw::FixedString;
+using ::mysqlw::JoinKind;
+using ::mysqlw::JoinOptions;
+using ::mysqlw::JsonOptions;
+using ::mysqlw::JsonRowShape;
+using ::mysqlw::JsonWriter;
+using ::mysqlw::KeysetOptions;
+using ::mysqlw::KeysetPager;
+using ::mysqlw::LatencyHistogram;
+using ::mysqlw::Metrics;
+using ::mysqlw::MetricsSource;
 using ::mysqlw::Operation;
 using ::mysqlw::PoolStats;
+using ::mysqlw::Predicate;
+using ::mysqlw::PreparedStatement;
 using ::mysqlw::Result;
+using ::mysqlw::RowSink;
 using ::mysqlw::RowView;
+using ::mysqlw::ScanChunk;
+using ::mysqlw::ScanOptions;
+using ::mysqlw::ScanStats;
+using ::mysqlw::SharedCacheOptions;
+using ::mysqlw::SharedCacheStats;
+using ::mysqlw::SharedResultCache;
+using ::mysqlw::SortKey;
+using ::mysqlw::StatementDescriptor;
+using ::mysqlw::StatementKey;
+using ::mysqlw::StatementStats;
+using ::mysqlw::ThrottleReason;
+using ::mysqlw::TlsMode;
+using ::mysqlw::TlsStats;
+using ::mysqlw::TrafficApi;
+using ::mysqlw::TrafficLogReader;
+using ::mysqlw::TrafficRecord;
+using ::mysqlw::TrafficRecorder;
 using ::mysqlw::Transaction;
+using ::mysqlw::Transport;
 using ::mysqlw::Value;
+using ::mysqlw::ValueView;
 using ::mysqlw::execute_with_values;
+using ::mysqlw::execute_with_views;
+using ::mysqlw::export_csv;
+using ::mysqlw::filter;
 using ::mysqlw::get_as;
 using ::mysqlw::get_or_throw;
+using ::mysqlw::group_by;
+using ::mysqlw::hash_join;
+using ::mysqlw::openmetrics_content_type;
+using ::mysqlw::query_columnar;
+using ::mysqlw::query_into_with_views;
 using ::mysqlw::query_with_values;
+using ::mysqlw::query_with_views;
+using ::mysqlw::run_chunked_dml;
+using ::mysqlw::scan_table;
+using ::mysqlw::sort_by;
+using ::mysqlw::stream_result;
+using ::mysqlw::stream_with_values;
 using ::mysqlw::submit_execute_with_values;
 using ::mysqlw::submit_query_with_values;
 using ::mysqlw::to_string;
+using ::mysqlw::to_value;
 using ::mysqlw::transaction_execute_with_values;
 using ::mysqlw::transaction_query_with_values;
+using ::mysqlw::view_of;
+using ::mysqlw::write_json;
+using ::mysqlw::write_openmetrics;
 }
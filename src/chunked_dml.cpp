@@ -0,0 +1,253 @@
+#include "mysqlwrapper/chunked_dml.hpp"
+
+#include "identifier.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace mysqlw {
+namespace {
+
+DbError dml_error(ErrorCode code, std::string message) {
+    return DbError{
+        .code = code,
+        .operation = Operation::chunked_dml,
+        .message = std::move(message)
+    };
+}
+
+// Integer cells arrive typed from key columns and as text from SHOW statements.
+std::optional<std::int64_t> integer_cell(const Value& value) {
+    if (const auto* signed_value = std::get_if<std::int64_t>(&value)) {
+        return *signed_value;
+    }
+    if (const auto* unsigned_value = std::get_if<std::uint64_t>(&value);
+        unsigned_value != nullptr && *unsigned_value <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+        return static_cast<std::int64_t>(*unsigned_value);
+    }
+    if (const auto* text = std::get_if<std::string>(&value)) {
+        std::int64_t parsed = 0;
+        const auto [end, error] = std::from_chars(text->data(), text->data() + text->size(), parsed);
+        if (error == std::errc{} && end == text->data() + text->size()) {
+            return parsed;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::size_t> find_column(const Result& result, std::string_view name) {
+    const auto columns = result.columns();
+    for (std::size_t index = 0; index < columns.size(); ++index) {
+        if (columns[index].name == name) {
+            return index;
+        }
+    }
+    return std::nullopt;
+}
+
+Expected<std::int64_t> threads_running(Database& database) {
+    auto status = database.query("SHOW GLOBAL STATUS LIKE 'Threads_running'");
+    if (!status) {
+        return std::unexpected(status.error());
+    }
+    const auto value = status->empty() || status->column_count() < 2
+        ? std::nullopt
+        : integer_cell(status->row(0).at(std::size_t{1}));
+    if (!value) {
+        return std::unexpected(dml_error(ErrorCode::result_fetch_failed, "server did not report Threads_running"));
+    }
+    return *value;
+}
+
+// Seconds behind the source, -1 when replication is stopped, and 0 for a server that is not a
+// replica at all.
+Expected<std::int64_t> replica_lag(Database& replica) {
+    auto status = replica.query("SHOW REPLICA STATUS");
+    if (!status && status.error().code == ErrorCode::execute_failed) {
+        // Servers before 8.0.22 only know the old spelling.
+        status = replica.query("SHOW SLAVE STATUS");
+    }
+    if (!status) {
+        return std::unexpected(status.error());
+    }
+    if (status->empty()) {
+        return 0;
+    }
+    auto column = find_column(*status, "Seconds_Behind_Source");
+    if (!column) {
+        column = find_column(*status, "Seconds_Behind_Master");
+    }
+    if (!column) {
+        return std::unexpected(dml_error(ErrorCode::result_fetch_failed, "replica status has no Seconds_Behind_Source"));
+    }
+    return integer_cell(status->row(0).at(*column)).value_or(-1);
+}
+
+struct Throttle {
+    ThrottleReason reason;
+    std::int64_t observed;
+};
+
+Expected<std::optional<Throttle>> check_throttle(Database& database, const ChunkedDmlOptions& options) {
+    if (options.max_threads_running != 0) {
+        auto running = threads_running(database);
+        if (!running) {
+            return std::unexpected(running.error());
+        }
+        if (*running > static_cast<std::int64_t>(options.max_threads_running)) {
+            return Throttle{.reason = ThrottleReason::threads_running, .observed = *running};
+        }
+    }
+    for (Database* replica : options.replicas) {
+        auto lag = replica_lag(*replica);
+        if (!lag) {
+            return std::unexpected(lag.error());
+        }
+        if (*lag < 0 || *lag > options.max_replica_lag.count()) {
+            return Throttle{.reason = ThrottleReason::replica_lag, .observed = *lag};
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+Expected<DmlStats> run_chunked_dml(Database& database, const ChunkedDmlOptions& options,
+                                   const DmlProgressCallback& on_progress) {
+    if (options.table.empty() || options.key.empty() || options.min_chunk_size == 0 ||
+        options.min_chunk_size > options.max_chunk_size || options.target_chunk_time.count() <= 0) {
+        return std::unexpected(dml_error(ErrorCode::invalid_argument,
+            "chunked DML needs a table, a key, a valid chunk size range and a positive target chunk time"));
+    }
+    if ((options.kind == DmlKind::update) == options.assignments.empty()) {
+        return std::unexpected(dml_error(ErrorCode::invalid_argument,
+            "an update needs assignments and a delete takes none"));
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto table = detail::quote_qualified(options.table);
+    const auto key = detail::quote_identifier(options.key);
+    const auto filter = options.where.empty() ? std::string() : " AND (" + options.where + ")";
+    DmlStats stats;
+    stats.last_key = options.start_after;
+
+    // Rows written after the run starts are left alone: the last chunk ends at the maximum key seen now.
+    auto ceiling_result = query_with_values(database,
+        "SELECT MAX(" + key + ") FROM " + table + (options.where.empty() ? std::string() : " WHERE (" + options.where + ")"),
+        options.where_params);
+    if (!ceiling_result) {
+        return std::unexpected(ceiling_result.error());
+    }
+    const auto ceiling = ceiling_result->empty() ? std::nullopt : integer_cell(ceiling_result->row(0).at(std::size_t{0}));
+    if (!ceiling || (stats.last_key && *stats.last_key >= *ceiling)) {
+        stats.elapsed = std::chrono::steady_clock::now() - started;
+        return stats;
+    }
+
+    // Each statement has a variant for the first chunk, which has no lower bound.
+    const auto range = [&](bool bounded) {
+        return " WHERE " + (bounded ? key + " > ? AND " : std::string()) + key + " <= ?" + filter;
+    };
+    const auto boundary_sql = [&](bool bounded) {
+        return "SELECT " + key + " FROM " + table + range(bounded) + " ORDER BY " + key + " LIMIT 1 OFFSET ?";
+    };
+    const auto dml_sql = [&](bool bounded) {
+        return (options.kind == DmlKind::delete_rows ? "DELETE FROM " + table : "UPDATE " + table + " SET " + options.assignments) +
+               range(bounded);
+    };
+    const std::string boundary[] = {boundary_sql(false), boundary_sql(true)};
+    const std::string statement[] = {dml_sql(false), dml_sql(true)};
+
+    auto chunk_size = std::clamp(options.chunk_size, options.min_chunk_size, options.max_chunk_size);
+    double rate = 0.0;
+    const auto report = [&](DmlEvent event, std::optional<Throttle> throttle) -> Expected<void> {
+        if (!on_progress) {
+            return {};
+        }
+        return on_progress(DmlProgress{
+            .event = event,
+            .chunks = stats.chunks,
+            .affected_rows = stats.affected_rows,
+            .last_key = stats.last_key,
+            .next_chunk_size = chunk_size,
+            .rows_per_second = rate,
+            .elapsed = std::chrono::steady_clock::now() - started,
+            .throttle = throttle ? std::optional(throttle->reason) : std::nullopt,
+            .observed = throttle ? throttle->observed : 0
+        });
+    };
+
+    while (!stats.last_key || *stats.last_key < *ceiling) {
+        while (true) {
+            auto throttle = check_throttle(database, options);
+            if (!throttle) {
+                return std::unexpected(throttle.error());
+            }
+            if (!*throttle) {
+                break;
+            }
+            ++stats.throttle_events;
+            if (auto reported = report(DmlEvent::throttle, *throttle); !reported) {
+                return std::unexpected(reported.error());
+            }
+            std::this_thread::sleep_for(options.throttle_interval);
+            stats.throttled += options.throttle_interval;
+        }
+
+        const auto chunk_started = std::chrono::steady_clock::now();
+        const bool bounded = stats.last_key.has_value();
+        const auto with_range = [&](std::vector<Value> values, std::int64_t last) {
+            if (bounded) {
+                values.emplace_back(*stats.last_key);
+            }
+            values.emplace_back(last);
+            values.insert(values.end(), options.where_params.begin(), options.where_params.end());
+            return values;
+        };
+
+        // The chunk ends at the chunk_size-th matching key, or at the ceiling when fewer remain.
+        auto boundary_params = with_range({}, *ceiling);
+        boundary_params.emplace_back(static_cast<std::int64_t>(chunk_size - 1));
+        auto boundary_row = query_with_values(database, boundary[bounded], std::move(boundary_params));
+        if (!boundary_row) {
+            return std::unexpected(boundary_row.error());
+        }
+        std::int64_t last = *ceiling;
+        if (!boundary_row->empty()) {
+            const auto found = integer_cell(boundary_row->row(0).at(std::size_t{0}));
+            if (!found) {
+                return std::unexpected(dml_error(ErrorCode::type_mismatch, options.key + " is not a 64-bit integer key"));
+            }
+            last = *found;
+        }
+
+        auto changed = database.transaction([&](Transaction& tx) {
+            return transaction_execute_with_values(tx, statement[bounded], with_range(options.assignment_params, last));
+        });
+        if (!changed) {
+            return std::unexpected(changed.error());
+        }
+        ++stats.chunks;
+        stats.affected_rows += changed->affected_rows;
+        stats.last_key = last;
+
+        // Smooth the row rate over recent chunks, then size the next chunk to the target time.
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - chunk_started).count();
+        const auto chunk_rate = static_cast<double>(chunk_size) / std::max(seconds, 1e-6);
+        rate = stats.chunks == 1 ? chunk_rate : 0.75 * rate + 0.25 * chunk_rate;
+        const auto target = rate * std::chrono::duration<double>(options.target_chunk_time).count();
+        chunk_size = static_cast<std::size_t>(std::clamp(target, static_cast<double>(options.min_chunk_size),
+                                                         static_cast<double>(options.max_chunk_size)));
+        if (auto reported = report(DmlEvent::chunk, std::nullopt); !reported) {
+            return std::unexpected(reported.error());
+        }
+    }
+    stats.elapsed = std::chrono::steady_clock::now() - started;
+    return stats;
+}
+
+} // namespace mysqlw
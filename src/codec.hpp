@@ -0,0 +1,328 @@
+#pragma once
+
+// Conversions between MySQL C API buffers and wrapper values. Shared by the library and the
+// benchmarks, which drive these routines with synthetic rows instead of a live server.
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <mysql.h>
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace mysqlw::detail {
+
+inline ColumnType column_type_from_field(const MYSQL_FIELD& field) {
+    switch (field.type) {
+        case MYSQL_TYPE_TINY:
+            return (field.flags & UNSIGNED_FLAG) != 0 ? ColumnType::unsigned_integer : ColumnType::signed_integer;
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONGLONG:
+        case MYSQL_TYPE_YEAR:
+            return (field.flags & UNSIGNED_FLAG) != 0 ? ColumnType::unsigned_integer : ColumnType::signed_integer;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+            return ColumnType::floating;
+        case MYSQL_TYPE_BIT:
+            return ColumnType::blob;
+        case MYSQL_TYPE_BLOB:
+        case MYSQL_TYPE_TINY_BLOB:
+        case MYSQL_TYPE_MEDIUM_BLOB:
+        case MYSQL_TYPE_LONG_BLOB:
+        case MYSQL_TYPE_GEOMETRY:
+            return (field.flags & BINARY_FLAG) != 0 ? ColumnType::blob : ColumnType::text;
+        case MYSQL_TYPE_VARCHAR:
+        case MYSQL_TYPE_VAR_STRING:
+        case MYSQL_TYPE_STRING:
+            return (field.flags & BINARY_FLAG) != 0 ? ColumnType::blob : ColumnType::text;
+        default:
+            return ColumnType::text;
+    }
+}
+
+enum class FieldDecode {
+    signed_integer,
+    unsigned_integer,
+    floating,
+    text,
+    blob
+};
+
+inline FieldDecode decode_kind(const MYSQL_FIELD& field) {
+    switch (field.type) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONGLONG:
+        case MYSQL_TYPE_YEAR:
+            return (field.flags & UNSIGNED_FLAG) != 0 ? FieldDecode::unsigned_integer : FieldDecode::signed_integer;
+        case MYSQL_TYPE_FLOAT:
+        case MYSQL_TYPE_DOUBLE:
+            return FieldDecode::floating;
+        case MYSQL_TYPE_BLOB:
+        case MYSQL_TYPE_TINY_BLOB:
+        case MYSQL_TYPE_MEDIUM_BLOB:
+        case MYSQL_TYPE_LONG_BLOB:
+        case MYSQL_TYPE_GEOMETRY:
+        case MYSQL_TYPE_BIT:
+            return (field.flags & BINARY_FLAG) != 0 ? FieldDecode::blob : FieldDecode::text;
+        case MYSQL_TYPE_VARCHAR:
+        case MYSQL_TYPE_VAR_STRING:
+        case MYSQL_TYPE_STRING:
+            return (field.flags & BINARY_FLAG) != 0 ? FieldDecode::blob : FieldDecode::text;
+        default:
+            return FieldDecode::text;
+    }
+}
+
+inline std::string field_name(const MYSQL_FIELD& field) {
+    if (field.name == nullptr) {
+        return {};
+    }
+    return std::string(field.name, field.name_length);
+}
+
+inline Column make_column(const MYSQL_FIELD& field) {
+    return Column{
+        .name = field_name(field),
+        .type = column_type_from_field(field),
+        .nullable = (field.flags & NOT_NULL_FLAG) == 0,
+        .unsigned_value = (field.flags & UNSIGNED_FLAG) != 0
+    };
+}
+
+// Decodes one text-protocol row as returned by mysql_fetch_row/mysql_fetch_lengths.
+// Throws std::invalid_argument or std::out_of_range for malformed numeric cells.
+inline void decode_text_row(std::span<const FieldDecode> decode_kinds, MYSQL_ROW mysql_row,
+                            const unsigned long* lengths, Result::RowStorage& row) {
+    row.reserve(decode_kinds.size());
+    for (std::size_t index = 0; index < decode_kinds.size(); ++index) {
+        if (mysql_row[index] == nullptr) {
+            row.emplace_back(nullptr);
+            continue;
+        }
+
+        const std::string_view cell(mysql_row[index], lengths[index]);
+        switch (decode_kinds[index]) {
+            case FieldDecode::signed_integer:
+                row.emplace_back(static_cast<std::int64_t>(std::stoll(std::string(cell))));
+                break;
+            case FieldDecode::unsigned_integer:
+                row.emplace_back(static_cast<std::uint64_t>(std::stoull(std::string(cell))));
+                break;
+            case FieldDecode::floating:
+                row.emplace_back(std::stod(std::string(cell)));
+                break;
+            case FieldDecode::blob: {
+                Blob blob;
+                blob.reserve(cell.size());
+                for (unsigned char byte : cell) {
+                    blob.push_back(static_cast<std::byte>(byte));
+                }
+                row.emplace_back(std::move(blob));
+                break;
+            }
+            case FieldDecode::text:
+                row.emplace_back(std::string(cell));
+                break;
+        }
+    }
+}
+
+// Streaming counterpart of decode_text_row for one non-NULL cell; text and blobs view the row
+// buffer. Throws std::invalid_argument for a malformed numeric cell.
+inline ValueView decode_text_view(FieldDecode kind, std::string_view cell) {
+    const auto parse = [cell](auto value) {
+        const auto [end, error] = std::from_chars(cell.data(), cell.data() + cell.size(), value);
+        if (error != std::errc{} || end != cell.data() + cell.size()) {
+            throw std::invalid_argument("malformed numeric cell: " + std::string(cell));
+        }
+        return value;
+    };
+    switch (kind) {
+        case FieldDecode::signed_integer:
+            return parse(std::int64_t{0});
+        case FieldDecode::unsigned_integer:
+            return parse(std::uint64_t{0});
+        case FieldDecode::floating:
+            return parse(0.0);
+        case FieldDecode::blob:
+            return std::span<const std::byte>(reinterpret_cast<const std::byte*>(cell.data()), cell.size());
+        case FieldDecode::text:
+            return cell;
+    }
+    return nullptr;
+}
+
+// Decodes one binary-protocol cell from the buffer bound with mysql_stmt_bind_result.
+inline Value decode_binary_value(FieldDecode kind, const unsigned char* buffer, unsigned long length) {
+    switch (kind) {
+        case FieldDecode::signed_integer: {
+            std::int64_t value = 0;
+            std::memcpy(&value, buffer, sizeof(value));
+            return value;
+        }
+        case FieldDecode::unsigned_integer: {
+            std::uint64_t value = 0;
+            std::memcpy(&value, buffer, sizeof(value));
+            return value;
+        }
+        case FieldDecode::floating: {
+            double value = 0;
+            std::memcpy(&value, buffer, sizeof(value));
+            return value;
+        }
+        case FieldDecode::blob: {
+            Blob blob;
+            blob.reserve(length);
+            for (unsigned long byte_index = 0; byte_index < length; ++byte_index) {
+                blob.push_back(static_cast<std::byte>(buffer[byte_index]));
+            }
+            return blob;
+        }
+        case FieldDecode::text:
+            return std::string(reinterpret_cast<const char*>(buffer), length);
+    }
+    return nullptr;
+}
+
+// View counterpart of decode_binary_value; text and blobs point into buffer.
+inline ValueView decode_binary_view(FieldDecode kind, const unsigned char* buffer, unsigned long length) noexcept {
+    switch (kind) {
+        case FieldDecode::signed_integer: {
+            std::int64_t value = 0;
+            std::memcpy(&value, buffer, sizeof(value));
+            return value;
+        }
+        case FieldDecode::unsigned_integer: {
+            std::uint64_t value = 0;
+            std::memcpy(&value, buffer, sizeof(value));
+            return value;
+        }
+        case FieldDecode::floating: {
+            double value = 0;
+            std::memcpy(&value, buffer, sizeof(value));
+            return value;
+        }
+        case FieldDecode::blob:
+            return std::span<const std::byte>(reinterpret_cast<const std::byte*>(buffer), length);
+        case FieldDecode::text:
+            return std::string_view(reinterpret_cast<const char*>(buffer), length);
+    }
+    return nullptr;
+}
+
+struct BoundParam {
+    MYSQL_BIND bind{};
+    Value value;
+    unsigned long length = 0;
+    bool is_null = false;
+    bool error = false;
+
+    explicit BoundParam(Value input) : value(std::move(input)) {
+        rebuild_bind();
+    }
+
+    BoundParam(const BoundParam&) = delete;
+    BoundParam& operator=(const BoundParam&) = delete;
+
+    BoundParam(BoundParam&& other) noexcept
+        : value(std::move(other.value)), length(other.length), is_null(other.is_null), error(other.error) {
+        rebuild_bind();
+    }
+
+    BoundParam& operator=(BoundParam&& other) noexcept {
+        if (this != &other) {
+            value = std::move(other.value);
+            length = other.length;
+            is_null = other.is_null;
+            error = other.error;
+            rebuild_bind();
+        }
+        return *this;
+    }
+
+    void rebuild_bind() noexcept {
+        std::memset(&bind, 0, sizeof(bind));
+        bind.length = &length;
+        bind.error = &error;
+
+        std::visit([this](auto& stored) {
+            using T = std::decay_t<decltype(stored)>;
+            if constexpr (std::same_as<T, std::nullptr_t>) {
+                is_null = true;
+                bind.buffer_type = MYSQL_TYPE_NULL;
+                bind.is_null = &is_null;
+            } else if constexpr (std::same_as<T, std::int64_t>) {
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                bind.buffer = &stored;
+                bind.is_unsigned = false;
+                length = sizeof(stored);
+            } else if constexpr (std::same_as<T, std::uint64_t>) {
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                bind.buffer = &stored;
+                bind.is_unsigned = true;
+                length = sizeof(stored);
+            } else if constexpr (std::same_as<T, double>) {
+                bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                bind.buffer = &stored;
+                length = sizeof(stored);
+            } else if constexpr (std::same_as<T, std::string>) {
+                bind.buffer_type = MYSQL_TYPE_STRING;
+                bind.buffer = stored.empty() ? nullptr : stored.data();
+                length = static_cast<unsigned long>(stored.size());
+                bind.buffer_length = length;
+            } else if constexpr (std::same_as<T, Blob>) {
+                bind.buffer_type = MYSQL_TYPE_BLOB;
+                bind.buffer = stored.empty() ? nullptr : stored.data();
+                length = static_cast<unsigned long>(stored.size());
+                bind.buffer_length = length;
+            } else if constexpr (std::same_as<T, bool>) {
+                bind.buffer_type = MYSQL_TYPE_TINY;
+                bind.buffer = &stored;
+                length = sizeof(stored);
+            }
+        }, value);
+    }
+};
+
+// Binds a parameter straight from its view. The view and length must outlive the execute.
+inline void bind_view(MYSQL_BIND& bind, const ValueView& value, unsigned long& length) noexcept {
+    std::memset(&bind, 0, sizeof(bind));
+    bind.length = &length;
+    std::visit([&](const auto& stored) {
+        using T = std::decay_t<decltype(stored)>;
+        // The client only reads parameter buffers.
+        auto* buffer = const_cast<void*>(static_cast<const void*>(&stored));
+        if constexpr (std::same_as<T, std::nullptr_t>) {
+            bind.buffer_type = MYSQL_TYPE_NULL;
+        } else if constexpr (std::same_as<T, std::int64_t> || std::same_as<T, std::uint64_t>) {
+            bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            bind.buffer = buffer;
+            bind.is_unsigned = std::same_as<T, std::uint64_t>;
+            length = sizeof(stored);
+        } else if constexpr (std::same_as<T, double>) {
+            bind.buffer_type = MYSQL_TYPE_DOUBLE;
+            bind.buffer = buffer;
+            length = sizeof(stored);
+        } else if constexpr (std::same_as<T, bool>) {
+            bind.buffer_type = MYSQL_TYPE_TINY;
+            bind.buffer = buffer;
+            length = sizeof(stored);
+        } else {
+            bind.buffer_type = std::same_as<T, std::string_view> ? MYSQL_TYPE_STRING : MYSQL_TYPE_BLOB;
+            bind.buffer = stored.empty() ? nullptr : const_cast<void*>(static_cast<const void*>(stored.data()));
+            length = static_cast<unsigned long>(stored.size());
+            bind.buffer_length = length;
+        }
+    }, value);
+}
+
+} // namespace mysqlw::detail
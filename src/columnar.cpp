@@ -0,0 +1,400 @@
+#include "mysqlwrapper/columnar.hpp"
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace mysqlw {
+namespace {
+
+DbError mismatch_error(const Column& column, std::string_view expected) {
+    return DbError{
+        .code = ErrorCode::type_mismatch,
+        .operation = Operation::fetch,
+        .message = "column '" + column.name + "' expects " + std::string(expected)
+    };
+}
+
+bool is_variable_width(ColumnType type) noexcept {
+    return type == ColumnType::text || type == ColumnType::blob;
+}
+
+std::string_view bytes_of(const ValueView& value) noexcept {
+    if (const auto* text = std::get_if<std::string_view>(&value)) {
+        return *text;
+    }
+    const auto& blob = std::get<std::span<const std::byte>>(value);
+    return std::string_view(reinterpret_cast<const char*>(blob.data()), blob.size());
+}
+
+// Checks a cell against its column before anything is appended, so a rejected row leaves every
+// column at the same length.
+Expected<void> check_cell(const ColumnBuffer& buffer, const ValueView& value) {
+    if (std::holds_alternative<std::nullptr_t>(value)) {
+        return {};
+    }
+    const auto& column = buffer.column;
+    switch (column.type) {
+        case ColumnType::null:
+            return std::unexpected(mismatch_error(column, "NULL"));
+        case ColumnType::signed_integer:
+            if (std::holds_alternative<std::int64_t>(value)) {
+                return {};
+            }
+            if (const auto* unsigned_value = std::get_if<std::uint64_t>(&value);
+                unsigned_value != nullptr && *unsigned_value <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+                return {};
+            }
+            return std::unexpected(mismatch_error(column, "a signed integer"));
+        case ColumnType::unsigned_integer:
+            if (std::holds_alternative<std::uint64_t>(value)) {
+                return {};
+            }
+            if (const auto* signed_value = std::get_if<std::int64_t>(&value); signed_value != nullptr && *signed_value >= 0) {
+                return {};
+            }
+            return std::unexpected(mismatch_error(column, "an unsigned integer"));
+        case ColumnType::floating:
+            if (std::holds_alternative<double>(value) || std::holds_alternative<std::int64_t>(value) ||
+                std::holds_alternative<std::uint64_t>(value)) {
+                return {};
+            }
+            return std::unexpected(mismatch_error(column, "a number"));
+        case ColumnType::text:
+        case ColumnType::blob: {
+            const bool fits = std::holds_alternative<std::string_view>(value) ||
+                              (column.type == ColumnType::blob && std::holds_alternative<std::span<const std::byte>>(value));
+            if (!fits) {
+                return std::unexpected(mismatch_error(column, column.type == ColumnType::text ? "text" : "bytes"));
+            }
+            if (buffer.bytes.size() + bytes_of(value).size() > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) {
+                return std::unexpected(DbError{
+                    .code = ErrorCode::result_truncated,
+                    .operation = Operation::fetch,
+                    .message = "column '" + column.name + "' exceeds the 2 GiB Arrow offset range"
+                });
+            }
+            return {};
+        }
+        case ColumnType::boolean:
+            if (std::holds_alternative<bool>(value)) {
+                return {};
+            }
+            return std::unexpected(mismatch_error(column, "a boolean"));
+    }
+    return {};
+}
+
+void set_bit(std::vector<std::uint8_t>& bits, std::size_t index, bool value) {
+    if (index % 8 == 0) {
+        bits.push_back(0);
+    }
+    if (value) {
+        bits.back() = static_cast<std::uint8_t>(bits.back() | (1U << (index % 8)));
+    }
+}
+
+bool get_bit(const std::vector<std::uint8_t>& bits, std::size_t index) noexcept {
+    return (bits[index / 8] >> (index % 8) & 1U) != 0;
+}
+
+void append_cell(ColumnBuffer& buffer, std::size_t row, const ValueView& value) {
+    const bool is_null = std::holds_alternative<std::nullptr_t>(value);
+    set_bit(buffer.validity, row, !is_null);
+    buffer.null_count += is_null ? 1 : 0;
+
+    switch (buffer.column.type) {
+        case ColumnType::null:
+            break;
+        case ColumnType::signed_integer:
+            buffer.int64_values.push_back(is_null ? 0 : std::visit([](auto stored) -> std::int64_t {
+                if constexpr (std::is_arithmetic_v<decltype(stored)>) {
+                    return static_cast<std::int64_t>(stored);
+                } else {
+                    return 0;
+                }
+            }, value));
+            break;
+        case ColumnType::unsigned_integer:
+            buffer.uint64_values.push_back(is_null ? 0 : std::visit([](auto stored) -> std::uint64_t {
+                if constexpr (std::is_arithmetic_v<decltype(stored)>) {
+                    return static_cast<std::uint64_t>(stored);
+                } else {
+                    return 0;
+                }
+            }, value));
+            break;
+        case ColumnType::floating:
+            buffer.double_values.push_back(is_null ? 0.0 : std::visit([](auto stored) -> double {
+                if constexpr (std::is_arithmetic_v<decltype(stored)>) {
+                    return static_cast<double>(stored);
+                } else {
+                    return 0.0;
+                }
+            }, value));
+            break;
+        case ColumnType::text:
+        case ColumnType::blob:
+            if (!is_null) {
+                buffer.bytes.append(bytes_of(value));
+            }
+            buffer.offsets.push_back(static_cast<std::int32_t>(buffer.bytes.size()));
+            break;
+        case ColumnType::boolean:
+            set_bit(buffer.bool_bits, row, !is_null && std::get<bool>(value));
+            break;
+    }
+}
+
+const char* arrow_format(ColumnType type) noexcept {
+    switch (type) {
+        case ColumnType::null: return "n";
+        case ColumnType::signed_integer: return "l";
+        case ColumnType::unsigned_integer: return "L";
+        case ColumnType::floating: return "g";
+        case ColumnType::text: return "u";
+        case ColumnType::blob: return "z";
+        case ColumnType::boolean: return "b";
+    }
+    return "n";
+}
+
+struct SchemaOwner {
+    std::string name;
+    std::vector<ArrowSchema> children;
+    std::vector<ArrowSchema*> child_pointers;
+};
+
+struct ArrayOwner {
+    // Shared by the struct array and every child, so a child moved out by the consumer keeps its
+    // buffers alive after the parent is released.
+    std::shared_ptr<const std::vector<ColumnBuffer>> columns;
+    std::array<const void*, 3> buffers{};
+    std::vector<ArrowArray> children;
+    std::vector<ArrowArray*> child_pointers;
+};
+
+void release_schema(ArrowSchema* schema) {
+    auto* owner = static_cast<SchemaOwner*>(schema->private_data);
+    for (auto* child : owner->child_pointers) {
+        if (child->release != nullptr) {
+            child->release(child);
+        }
+    }
+    delete owner;
+    schema->release = nullptr;
+}
+
+void release_array(ArrowArray* array) {
+    auto* owner = static_cast<ArrayOwner*>(array->private_data);
+    for (auto* child : owner->child_pointers) {
+        if (child->release != nullptr) {
+            child->release(child);
+        }
+    }
+    delete owner;
+    array->release = nullptr;
+}
+
+void fill_schema(ArrowSchema& schema, const char* format, std::unique_ptr<SchemaOwner> owner, std::int64_t flags) {
+    schema.format = format;
+    schema.name = owner->name.c_str();
+    schema.metadata = nullptr;
+    schema.flags = flags;
+    schema.n_children = static_cast<std::int64_t>(owner->child_pointers.size());
+    schema.children = owner->child_pointers.empty() ? nullptr : owner->child_pointers.data();
+    schema.dictionary = nullptr;
+    schema.release = &release_schema;
+    schema.private_data = owner.release();
+}
+
+void fill_array(ArrowArray& array, std::size_t length, std::size_t null_count, std::size_t buffer_count,
+                std::unique_ptr<ArrayOwner> owner) {
+    array.length = static_cast<std::int64_t>(length);
+    array.null_count = static_cast<std::int64_t>(null_count);
+    array.offset = 0;
+    array.n_buffers = static_cast<std::int64_t>(buffer_count);
+    array.n_children = static_cast<std::int64_t>(owner->child_pointers.size());
+    array.buffers = buffer_count == 0 ? nullptr : owner->buffers.data();
+    array.children = owner->child_pointers.empty() ? nullptr : owner->child_pointers.data();
+    array.dictionary = nullptr;
+    array.release = &release_array;
+    array.private_data = owner.release();
+}
+
+void export_column(const std::shared_ptr<const std::vector<ColumnBuffer>>& columns, const ColumnBuffer& buffer,
+                   std::size_t row_count, ArrowSchema& schema, ArrowArray& array) {
+    auto schema_owner = std::make_unique<SchemaOwner>();
+    schema_owner->name = buffer.column.name;
+    fill_schema(schema, arrow_format(buffer.column.type), std::move(schema_owner),
+                buffer.column.nullable || buffer.null_count > 0 ? ARROW_FLAG_NULLABLE : 0);
+
+    auto array_owner = std::make_unique<ArrayOwner>();
+    array_owner->columns = columns;
+    auto& buffers = array_owner->buffers;
+    // Arrow allows a missing validity bitmap when nothing is NULL.
+    buffers[0] = buffer.null_count == 0 ? nullptr : buffer.validity.data();
+    std::size_t buffer_count = 2;
+    switch (buffer.column.type) {
+        case ColumnType::null:
+            fill_array(array, row_count, row_count, 0, std::move(array_owner));
+            return;
+        case ColumnType::signed_integer:
+            buffers[1] = buffer.int64_values.data();
+            break;
+        case ColumnType::unsigned_integer:
+            buffers[1] = buffer.uint64_values.data();
+            break;
+        case ColumnType::floating:
+            buffers[1] = buffer.double_values.data();
+            break;
+        case ColumnType::text:
+        case ColumnType::blob:
+            buffers[1] = buffer.offsets.data();
+            buffers[2] = buffer.bytes.data();
+            buffer_count = 3;
+            break;
+        case ColumnType::boolean:
+            buffers[1] = buffer.bool_bits.data();
+            break;
+    }
+    fill_array(array, row_count, buffer.null_count, buffer_count, std::move(array_owner));
+}
+
+} // namespace
+
+bool ColumnBuffer::is_null(std::size_t row) const noexcept {
+    return null_count != 0 && !get_bit(validity, row);
+}
+
+ValueView ColumnBuffer::value(std::size_t row) const noexcept {
+    if (is_null(row)) {
+        return nullptr;
+    }
+    switch (column.type) {
+        case ColumnType::null:
+            return nullptr;
+        case ColumnType::signed_integer:
+            return int64_values[row];
+        case ColumnType::unsigned_integer:
+            return uint64_values[row];
+        case ColumnType::floating:
+            return double_values[row];
+        case ColumnType::text:
+            return std::string_view(bytes).substr(static_cast<std::size_t>(offsets[row]),
+                                                  static_cast<std::size_t>(offsets[row + 1] - offsets[row]));
+        case ColumnType::blob:
+            return std::span<const std::byte>(reinterpret_cast<const std::byte*>(bytes.data()) + offsets[row],
+                                              static_cast<std::size_t>(offsets[row + 1] - offsets[row]));
+        case ColumnType::boolean:
+            return get_bit(bool_bits, row);
+    }
+    return nullptr;
+}
+
+Expected<ColumnarResult> ColumnarResult::from_result(const Result& result) {
+    ColumnarBuilder builder;
+    if (auto streamed = stream_result(result, builder); !streamed) {
+        return std::unexpected(streamed.error());
+    }
+    return builder.finish();
+}
+
+std::size_t ColumnarResult::row_count() const noexcept {
+    return row_count_;
+}
+
+std::size_t ColumnarResult::column_count() const noexcept {
+    return columns_.size();
+}
+
+std::span<const ColumnBuffer> ColumnarResult::columns() const noexcept {
+    return columns_;
+}
+
+const ColumnBuffer& ColumnarResult::column(std::size_t index) const {
+    if (index >= columns_.size()) {
+        throw std::out_of_range("column index out of range");
+    }
+    return columns_[index];
+}
+
+const ColumnBuffer& ColumnarResult::column(std::string_view name) const {
+    for (const auto& buffer : columns_) {
+        if (buffer.column.name == name) {
+            return buffer;
+        }
+    }
+    throw std::out_of_range("column not found");
+}
+
+Expected<void> ColumnarResult::export_arrow(ArrowSchema* schema, ArrowArray* array) && {
+    if (schema == nullptr || array == nullptr) {
+        return std::unexpected(DbError{
+            .code = ErrorCode::invalid_argument,
+            .operation = Operation::fetch,
+            .message = "Arrow export needs a schema and an array to fill"
+        });
+    }
+
+    const auto row_count = std::exchange(row_count_, 0);
+    const auto columns = std::make_shared<const std::vector<ColumnBuffer>>(std::move(columns_));
+    columns_.clear();
+
+    auto schema_owner = std::make_unique<SchemaOwner>();
+    auto array_owner = std::make_unique<ArrayOwner>();
+    schema_owner->children.resize(columns->size());
+    array_owner->children.resize(columns->size());
+    array_owner->columns = columns;
+    for (std::size_t index = 0; index < columns->size(); ++index) {
+        export_column(columns, (*columns)[index], row_count, schema_owner->children[index], array_owner->children[index]);
+        schema_owner->child_pointers.push_back(&schema_owner->children[index]);
+        array_owner->child_pointers.push_back(&array_owner->children[index]);
+    }
+
+    fill_schema(*schema, "+s", std::move(schema_owner), 0);
+    fill_array(*array, row_count, 0, 1, std::move(array_owner));
+    return {};
+}
+
+Expected<void> ColumnarBuilder::begin(std::span<const Column> columns) {
+    result_ = ColumnarResult{};
+    result_.columns_.reserve(columns.size());
+    for (const auto& column : columns) {
+        auto& buffer = result_.columns_.emplace_back();
+        buffer.column = column;
+        if (is_variable_width(column.type)) {
+            buffer.offsets.push_back(0);
+        }
+    }
+    return {};
+}
+
+Expected<void> ColumnarBuilder::row(std::span<const ValueView> values) {
+    auto& columns = result_.columns_;
+    if (values.size() != columns.size()) {
+        return std::unexpected(DbError{
+            .code = ErrorCode::invalid_argument,
+            .operation = Operation::fetch,
+            .message = "row has " + std::to_string(values.size()) + " values for " + std::to_string(columns.size()) +
+                       " columns"
+        });
+    }
+    for (std::size_t index = 0; index < values.size(); ++index) {
+        if (auto fits = check_cell(columns[index], values[index]); !fits) {
+            return fits;
+        }
+    }
+    for (std::size_t index = 0; index < values.size(); ++index) {
+        append_cell(columns[index], result_.row_count_, values[index]);
+    }
+    ++result_.row_count_;
+    return {};
+}
+
+ColumnarResult ColumnarBuilder::finish() {
+    return std::exchange(result_, ColumnarResult{});
+}
+
+} // namespace mysqlw
@@ -0,0 +1,512 @@
+#include "mysqlwrapper/csv_export.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mysqlw {
+namespace {
+
+#ifdef _WIN32
+constexpr std::size_t max_iovecs = 16;
+
+struct iovec {
+    void* iov_base;
+    std::size_t iov_len;
+};
+
+// No gather write on Windows: write the first buffer and let the caller's short-write loop go on.
+long long write_vector(int fd, const iovec* buffers, int) {
+    return ::_write(fd, buffers[0].iov_base, static_cast<unsigned>(std::min<std::size_t>(buffers[0].iov_len, INT_MAX)));
+}
+#else
+constexpr std::size_t max_iovecs = IOV_MAX;
+
+long long write_vector(int fd, const iovec* buffers, int count) {
+    return ::writev(fd, buffers, count);
+}
+#endif
+
+DbError export_error(std::string message) {
+    return DbError{
+        .code = ErrorCode::io_failed,
+        .operation = Operation::export_data,
+        .message = std::move(message)
+    };
+}
+
+template <typename T>
+void append_number(std::string& out, T value) {
+    char digits[32];
+    const auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, error == std::errc{} ? end : digits);
+}
+
+void append_csv_text(std::string& out, std::string_view text, char delimiter) {
+    const char specials[] = {delimiter, '"', '\n', '\r'};
+    if (!text.empty() && text.find_first_of(std::string_view(specials, sizeof(specials))) == std::string_view::npos) {
+        out.append(text);
+        return;
+    }
+    // Empty strings are quoted so they stay distinct from NULL.
+    out.push_back('"');
+    std::size_t start = 0;
+    for (auto quote = text.find('"'); quote != std::string_view::npos; quote = text.find('"', start)) {
+        out.append(text.substr(start, quote + 1 - start));
+        out.push_back('"');
+        start = quote + 1;
+    }
+    out.append(text.substr(start));
+    out.push_back('"');
+}
+
+void append_tsv_text(std::string& out, std::string_view text) {
+    std::size_t start = 0;
+    for (auto special = text.find_first_of("\\\t\n\r"); special != std::string_view::npos;
+         special = text.find_first_of("\\\t\n\r", start)) {
+        out.append(text.substr(start, special - start));
+        out.push_back('\\');
+        switch (text[special]) {
+            case '\t': out.push_back('t'); break;
+            case '\n': out.push_back('n'); break;
+            case '\r': out.push_back('r'); break;
+            default: out.push_back('\\'); break;
+        }
+        start = special + 1;
+    }
+    out.append(text.substr(start));
+}
+
+void append_hex(std::string& out, std::span<const std::byte> bytes) {
+    static constexpr char digits[] = "0123456789abcdef";
+    out.append("0x");
+    const auto offset = out.size();
+    out.resize(offset + bytes.size() * 2);
+    for (std::size_t index = 0; index < bytes.size(); ++index) {
+        const auto byte = static_cast<unsigned char>(bytes[index]);
+        out[offset + index * 2] = digits[byte >> 4];
+        out[offset + index * 2 + 1] = digits[byte & 0x0f];
+    }
+}
+
+void append_field(std::string& out, const ValueView& value, const CsvOptions& options) {
+    std::visit([&](const auto& stored) {
+        using T = std::decay_t<decltype(stored)>;
+        if constexpr (std::same_as<T, std::nullptr_t>) {
+            if (options.format == CsvFormat::tsv) {
+                out.append("\\N");
+            }
+        } else if constexpr (std::same_as<T, std::string_view>) {
+            if (options.format == CsvFormat::tsv) {
+                append_tsv_text(out, stored);
+            } else {
+                append_csv_text(out, stored, options.delimiter);
+            }
+        } else if constexpr (std::same_as<T, std::span<const std::byte>>) {
+            append_hex(out, stored);
+        } else if constexpr (std::same_as<T, bool>) {
+            out.push_back(stored ? '1' : '0');
+        } else {
+            append_number(out, stored);
+        }
+    }, value);
+}
+
+void append_row(std::string& out, std::span<const ValueView> values, const CsvOptions& options) {
+    const char separator = options.format == CsvFormat::tsv ? '\t' : options.delimiter;
+    for (std::size_t index = 0; index < values.size(); ++index) {
+        if (index != 0) {
+            out.push_back(separator);
+        }
+        append_field(out, values[index], options);
+    }
+    out.push_back('\n');
+}
+
+// Collects formatted output in blocks and writes them with writev, reusing drained blocks.
+class BlockWriter {
+public:
+    BlockWriter(int fd, std::size_t block_size, std::size_t blocks_per_write)
+        : fd_(fd), block_size_(std::max<std::size_t>(block_size, 4096)),
+          blocks_per_write_(std::clamp<std::size_t>(blocks_per_write, 1, max_iovecs)) {
+        current_.reserve(block_size_ + block_size_ / 4);
+    }
+
+    [[nodiscard]] std::string& current() noexcept { return current_; }
+
+    [[nodiscard]] Expected<void> commit() {
+        if (current_.size() < block_size_) {
+            return {};
+        }
+        pending_.push_back(std::move(current_));
+        current_ = take_spare();
+        return pending_.size() >= blocks_per_write_ ? write_pending() : Expected<void>{};
+    }
+
+    // Queues an already formatted block after whatever is in the current one.
+    [[nodiscard]] Expected<void> append_block(std::string block) {
+        if (!current_.empty()) {
+            pending_.push_back(std::move(current_));
+            current_ = take_spare();
+        }
+        pending_.push_back(std::move(block));
+        return pending_.size() >= blocks_per_write_ ? write_pending() : Expected<void>{};
+    }
+
+    [[nodiscard]] Expected<void> flush() {
+        if (!current_.empty()) {
+            pending_.push_back(std::move(current_));
+            current_ = take_spare();
+        }
+        return write_pending();
+    }
+
+    [[nodiscard]] std::uint64_t bytes() const noexcept { return bytes_; }
+    [[nodiscard]] std::uint64_t write_calls() const noexcept { return write_calls_; }
+
+private:
+    int fd_;
+    std::size_t block_size_;
+    std::size_t blocks_per_write_;
+    std::string current_;
+    std::vector<std::string> pending_;
+    std::vector<std::string> spare_;
+    std::vector<iovec> iov_;
+    std::uint64_t bytes_ = 0;
+    std::uint64_t write_calls_ = 0;
+
+    std::string take_spare() {
+        if (spare_.empty()) {
+            std::string block;
+            block.reserve(block_size_ + block_size_ / 4);
+            return block;
+        }
+        auto block = std::move(spare_.back());
+        spare_.pop_back();
+        return block;
+    }
+
+    [[nodiscard]] Expected<void> write_pending() {
+        iov_.clear();
+        for (auto& block : pending_) {
+            if (!block.empty()) {
+                iov_.push_back(iovec{.iov_base = block.data(), .iov_len = block.size()});
+            }
+        }
+
+        std::size_t first = 0;
+        while (first < iov_.size()) {
+            const auto count = static_cast<int>(std::min<std::size_t>(iov_.size() - first, max_iovecs));
+            const auto written = write_vector(fd_, iov_.data() + first, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return std::unexpected(export_error(std::string("export write failed: ") + std::strerror(errno)));
+            }
+            ++write_calls_;
+            bytes_ += static_cast<std::uint64_t>(written);
+            // Skip what a short write consumed and retry from the first unwritten byte.
+            auto remaining = static_cast<std::size_t>(written);
+            while (first < iov_.size() && remaining >= iov_[first].iov_len) {
+                remaining -= iov_[first].iov_len;
+                ++first;
+            }
+            if (remaining > 0) {
+                iov_[first].iov_base = static_cast<char*>(iov_[first].iov_base) + remaining;
+                iov_[first].iov_len -= remaining;
+            }
+        }
+
+        for (auto& block : pending_) {
+            // Only blocks of the writer's own size are worth keeping.
+            if (block.capacity() >= block_size_ && spare_.size() < blocks_per_write_) {
+                block.clear();
+                spare_.push_back(std::move(block));
+            }
+        }
+        pending_.clear();
+        return {};
+    }
+};
+
+// Rows copied out of the fetch buffers for a formatting thread. Text and blob cells keep their
+// bytes in arena and hold only an empty view of the right type plus an offset and size.
+struct Batch {
+    struct Cell {
+        ValueView value;
+        std::size_t offset = 0;
+        std::size_t size = 0;
+    };
+
+    std::uint64_t sequence = 0;
+    std::size_t columns = 0;
+    std::vector<Cell> cells;
+    std::string arena;
+    std::string output;
+
+    void add_row(std::span<const ValueView> values) {
+        for (const auto& value : values) {
+            Cell cell{.value = value};
+            if (const auto* text = std::get_if<std::string_view>(&value)) {
+                cell = Cell{.value = std::string_view{}, .offset = arena.size(), .size = text->size()};
+                arena.append(*text);
+            } else if (const auto* blob = std::get_if<std::span<const std::byte>>(&value)) {
+                cell = Cell{.value = std::span<const std::byte>{}, .offset = arena.size(), .size = blob->size()};
+                arena.append(reinterpret_cast<const char*>(blob->data()), blob->size());
+            }
+            cells.push_back(cell);
+        }
+    }
+
+    [[nodiscard]] std::size_t row_count() const noexcept {
+        return columns == 0 ? 0 : cells.size() / columns;
+    }
+
+    void format(const CsvOptions& options, std::vector<ValueView>& row) {
+        row.resize(columns);
+        for (std::size_t first = 0; first + columns <= cells.size(); first += columns) {
+            for (std::size_t index = 0; index < columns; ++index) {
+                const auto& cell = cells[first + index];
+                if (std::holds_alternative<std::string_view>(cell.value)) {
+                    row[index] = std::string_view(arena.data() + cell.offset, cell.size);
+                } else if (std::holds_alternative<std::span<const std::byte>>(cell.value)) {
+                    row[index] = std::span<const std::byte>(reinterpret_cast<const std::byte*>(arena.data()) + cell.offset,
+                                                            cell.size);
+                } else {
+                    row[index] = cell.value;
+                }
+            }
+            append_row(output, row, options);
+        }
+    }
+};
+
+} // namespace
+
+double ExportStats::megabytes_per_second() const noexcept {
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0.0 ? static_cast<double>(bytes) / 1e6 / seconds : 0.0;
+}
+
+class CsvWriter::Impl {
+public:
+    Impl(int fd, CsvOptions options)
+        : options_(std::move(options)), output_(fd, options_.block_size, options_.blocks_per_write),
+          started_(std::chrono::steady_clock::now()) {
+        options_.batch_rows = std::max<std::size_t>(options_.batch_rows, 1);
+        for (std::size_t index = 0; index < options_.format_threads; ++index) {
+            workers_.emplace_back([this](std::stop_token stop_token) { format_batches(stop_token); });
+        }
+    }
+
+    ~Impl() {
+        for (auto& worker : workers_) {
+            worker.request_stop();
+        }
+        work_cv_.notify_all();
+    }
+
+    Impl(const Impl&) = delete;
+    Impl& operator=(const Impl&) = delete;
+
+    [[nodiscard]] Expected<void> begin(std::span<const Column> columns) {
+        started_ = std::chrono::steady_clock::now();
+        columns_ = columns.size();
+        if (!options_.header) {
+            return {};
+        }
+        std::vector<ValueView> names;
+        names.reserve(columns.size());
+        for (const auto& column : columns) {
+            names.emplace_back(std::string_view(column.name));
+        }
+        append_row(output_.current(), names, options_);
+        return remember(output_.commit());
+    }
+
+    [[nodiscard]] Expected<void> row(std::span<const ValueView> values) {
+        if (error_) {
+            return std::unexpected(*error_);
+        }
+        ++rows_;
+        if (workers_.empty()) {
+            append_row(output_.current(), values, options_);
+            return remember(output_.commit());
+        }
+
+        if (!batch_) {
+            batch_ = take_batch();
+        }
+        batch_->add_row(values);
+        if (batch_->row_count() < options_.batch_rows) {
+            return {};
+        }
+        submit(std::move(batch_));
+        // Keep at most two batches per thread in flight so memory stays bounded.
+        return remember(drain(workers_.size() * 2));
+    }
+
+    [[nodiscard]] Expected<ExportStats> finish() {
+        if (!error_ && batch_ && !batch_->cells.empty()) {
+            submit(std::move(batch_));
+        }
+        if (!error_) {
+            (void)remember(drain(0));
+        }
+        if (!error_) {
+            (void)remember(output_.flush());
+        }
+        if (error_) {
+            return std::unexpected(*error_);
+        }
+        return ExportStats{
+            .rows = rows_,
+            .bytes = output_.bytes(),
+            .write_calls = output_.write_calls(),
+            .elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started_)
+        };
+    }
+
+private:
+    CsvOptions options_;
+    BlockWriter output_;
+    std::chrono::steady_clock::time_point started_;
+    std::size_t columns_ = 0;
+    std::uint64_t rows_ = 0;
+    std::optional<DbError> error_;
+
+    std::unique_ptr<Batch> batch_;
+    std::uint64_t next_sequence_ = 0;
+    std::uint64_t next_write_ = 0;
+    std::size_t in_flight_ = 0;
+    std::deque<std::unique_ptr<Batch>> queued_;
+    std::map<std::uint64_t, std::unique_ptr<Batch>> formatted_;
+    std::vector<std::unique_ptr<Batch>> free_batches_;
+    std::mutex mutex_;
+    std::condition_variable_any work_cv_;
+    std::condition_variable formatted_cv_;
+    // Declared last so the threads stop before the state they use is destroyed.
+    std::vector<std::jthread> workers_;
+
+    [[nodiscard]] Expected<void> remember(Expected<void> result) {
+        if (!result && !error_) {
+            error_ = result.error();
+        }
+        return result;
+    }
+
+    std::unique_ptr<Batch> take_batch() {
+        std::unique_ptr<Batch> batch;
+        {
+            std::lock_guard lock(mutex_);
+            if (!free_batches_.empty()) {
+                batch = std::move(free_batches_.back());
+                free_batches_.pop_back();
+            }
+        }
+        if (!batch) {
+            batch = std::make_unique<Batch>();
+            batch->cells.reserve(options_.batch_rows * columns_);
+        }
+        batch->columns = columns_;
+        return batch;
+    }
+
+    void submit(std::unique_ptr<Batch> batch) {
+        {
+            std::lock_guard lock(mutex_);
+            batch->sequence = next_sequence_++;
+            queued_.push_back(std::move(batch));
+            ++in_flight_;
+        }
+        work_cv_.notify_one();
+    }
+
+    // Writes formatted batches in sequence order until no more than max_in_flight remain.
+    [[nodiscard]] Expected<void> drain(std::size_t max_in_flight) {
+        while (true) {
+            std::unique_ptr<Batch> ready;
+            {
+                std::unique_lock lock(mutex_);
+                formatted_cv_.wait(lock, [&] { return in_flight_ <= max_in_flight || formatted_.contains(next_write_); });
+                const auto found = formatted_.find(next_write_);
+                if (found == formatted_.end()) {
+                    return {};
+                }
+                ready = std::move(found->second);
+                formatted_.erase(found);
+                ++next_write_;
+                --in_flight_;
+            }
+
+            auto written = output_.append_block(std::move(ready->output));
+            ready->cells.clear();
+            ready->arena.clear();
+            ready->output = std::string{};
+            {
+                std::lock_guard lock(mutex_);
+                free_batches_.push_back(std::move(ready));
+            }
+            if (!written) {
+                return written;
+            }
+        }
+    }
+
+    void format_batches(std::stop_token stop_token) {
+        std::vector<ValueView> row;
+        while (true) {
+            std::unique_ptr<Batch> batch;
+            {
+                std::unique_lock lock(mutex_);
+                if (!work_cv_.wait(lock, stop_token, [this] { return !queued_.empty(); })) {
+                    return;
+                }
+                batch = std::move(queued_.front());
+                queued_.pop_front();
+            }
+            batch->output.reserve(batch->arena.size() + batch->cells.size() * 8);
+            batch->format(options_, row);
+            {
+                std::lock_guard lock(mutex_);
+                formatted_.emplace(batch->sequence, std::move(batch));
+            }
+            formatted_cv_.notify_all();
+        }
+    }
+};
+
+CsvWriter::CsvWriter(int fd, CsvOptions options) : impl_(std::make_unique<Impl>(fd, std::move(options))) {}
+
+CsvWriter::~CsvWriter() = default;
+
+Expected<void> CsvWriter::begin(std::span<const Column> columns) {
+    return impl_->begin(columns);
+}
+
+Expected<void> CsvWriter::row(std::span<const ValueView> values) {
+    return impl_->row(values);
+}
+
+Expected<ExportStats> CsvWriter::finish() {
+    return impl_->finish();
+}
+
+} // namespace mysqlw
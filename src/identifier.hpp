@@ -0,0 +1,32 @@
+#pragma once
+
+// Quoting for table and column names that the library splices into generated SQL.
+
+#include <string>
+#include <string_view>
+
+namespace mysqlw::detail {
+
+// Backtick-quotes a single identifier, doubling embedded backticks.
+inline std::string quote_identifier(std::string_view name) {
+    std::string quoted = "`";
+    for (const char character : name) {
+        quoted.push_back(character);
+        if (character == '`') {
+            quoted.push_back('`');
+        }
+    }
+    quoted.push_back('`');
+    return quoted;
+}
+
+// Quotes "name" or "qualifier.name", such as a schema-qualified table.
+inline std::string quote_qualified(std::string_view name) {
+    const auto dot = name.find('.');
+    if (dot == std::string_view::npos) {
+        return quote_identifier(name);
+    }
+    return quote_identifier(name.substr(0, dot)) + "." + quote_identifier(name.substr(dot + 1));
+}
+
+} // namespace mysqlw::detail
@@ -0,0 +1,281 @@
+#include "mysqlwrapper/json.hpp"
+
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MYSQLWRAPPER_JSON_SSE2 1
+#endif
+
+namespace mysqlw {
+namespace {
+
+DbError json_error(std::string message) {
+    return DbError{
+        .code = ErrorCode::invalid_argument,
+        .operation = Operation::export_data,
+        .message = std::move(message)
+    };
+}
+
+bool needs_escape(unsigned char character) noexcept {
+    return character < 0x20 || character == '"' || character == '\\';
+}
+
+// Length of the leading run of text that can be copied without escaping.
+std::size_t plain_prefix(const char* data, std::size_t size) noexcept {
+    std::size_t index = 0;
+#ifdef MYSQLWRAPPER_JSON_SSE2
+    // Sixteen bytes per step: flag quotes, backslashes and control characters (< 0x20, tested
+    // as a signed compare after flipping the sign bit so bytes >= 0x80 stay unflagged).
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i control_limit = _mm_set1_epi8(static_cast<char>(0x20 ^ 0x80));
+    for (; index + 16 <= size; index += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmplt_epi8(_mm_xor_si128(chunk, sign), control_limit));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask != 0) {
+            return index + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+    }
+#endif
+    while (index < size && !needs_escape(static_cast<unsigned char>(data[index]))) {
+        ++index;
+    }
+    return index;
+}
+
+void append_escaped(std::string& out, std::string_view text) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    const char* data = text.data();
+    std::size_t remaining = text.size();
+    while (remaining > 0) {
+        const auto plain = plain_prefix(data, remaining);
+        out.append(data, plain);
+        data += plain;
+        remaining -= plain;
+        if (remaining == 0) {
+            break;
+        }
+        const auto character = static_cast<unsigned char>(*data);
+        switch (character) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            default: {
+                const char escape[] = {'\\', 'u', '0', '0', hex[character >> 4], hex[character & 0x0f]};
+                out.append(escape, sizeof(escape));
+                break;
+            }
+        }
+        ++data;
+        --remaining;
+    }
+    out.push_back('"');
+}
+
+void append_base64(std::string& out, std::span<const std::byte> bytes) {
+    static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    out.push_back('"');
+    const auto offset = out.size();
+    out.resize(offset + (bytes.size() + 2) / 3 * 4);
+    char* cursor = out.data() + offset;
+    std::size_t index = 0;
+    for (; index + 3 <= bytes.size(); index += 3) {
+        const auto triple = static_cast<std::uint32_t>(bytes[index]) << 16 |
+                            static_cast<std::uint32_t>(bytes[index + 1]) << 8 | static_cast<std::uint32_t>(bytes[index + 2]);
+        *cursor++ = alphabet[triple >> 18 & 0x3f];
+        *cursor++ = alphabet[triple >> 12 & 0x3f];
+        *cursor++ = alphabet[triple >> 6 & 0x3f];
+        *cursor++ = alphabet[triple & 0x3f];
+    }
+    if (const auto tail = bytes.size() - index; tail > 0) {
+        auto triple = static_cast<std::uint32_t>(bytes[index]) << 16;
+        if (tail == 2) {
+            triple |= static_cast<std::uint32_t>(bytes[index + 1]) << 8;
+        }
+        *cursor++ = alphabet[triple >> 18 & 0x3f];
+        *cursor++ = alphabet[triple >> 12 & 0x3f];
+        *cursor++ = tail == 2 ? alphabet[triple >> 6 & 0x3f] : '=';
+        *cursor++ = '=';
+    }
+    out.push_back('"');
+}
+
+template <typename T>
+void append_number(std::string& out, T value) {
+    char buffer[32];
+    const auto converted = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, converted.ptr);
+}
+
+void append_value(std::string& out, const ValueView& value) {
+    std::visit([&out](const auto& stored) {
+        using T = std::decay_t<decltype(stored)>;
+        if constexpr (std::same_as<T, std::nullptr_t>) {
+            out.append("null");
+        } else if constexpr (std::same_as<T, std::string_view>) {
+            append_escaped(out, stored);
+        } else if constexpr (std::same_as<T, std::span<const std::byte>>) {
+            append_base64(out, stored);
+        } else if constexpr (std::same_as<T, bool>) {
+            out.append(stored ? "true" : "false");
+        } else if constexpr (std::same_as<T, double>) {
+            if (std::isfinite(stored)) {
+                append_number(out, stored);
+            } else {
+                out.append("null");
+            }
+        } else {
+            append_number(out, stored);
+        }
+    }, value);
+}
+
+// Escaped "name": prefixes, one per column. Strings already in keys are reused.
+template <typename NameOf>
+void build_keys(std::vector<std::string>& keys, std::size_t count, NameOf name_of) {
+    keys.resize(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        keys[index].clear();
+        append_escaped(keys[index], name_of(index));
+        keys[index].push_back(':');
+    }
+}
+
+void append_row(std::string& out, std::span<const std::string> keys, std::span<const ValueView> values, bool objects) {
+    out.push_back(objects ? '{' : '[');
+    for (std::size_t index = 0; index < values.size(); ++index) {
+        if (index != 0) {
+            out.push_back(',');
+        }
+        if (objects) {
+            out.append(keys[index]);
+        }
+        append_value(out, values[index]);
+    }
+    out.push_back(objects ? '}' : ']');
+}
+
+// What write_json() keeps between calls on one thread: the keys of the last column set it wrote
+// and a row of views, so responses of one shape reuse both.
+struct JsonScratch {
+    std::vector<std::string> names;
+    std::vector<std::string> keys;
+    std::vector<ValueView> row;
+
+    template <typename NameOf>
+    void use_columns(std::size_t count, NameOf name_of) {
+        row.resize(count);
+        bool same = names.size() == count;
+        for (std::size_t index = 0; same && index < count; ++index) {
+            same = names[index] == name_of(index);
+        }
+        if (same) {
+            return;
+        }
+        names.resize(count);
+        for (std::size_t index = 0; index < count; ++index) {
+            names[index].assign(name_of(index));
+        }
+        build_keys(keys, count, name_of);
+    }
+};
+
+JsonScratch& json_scratch() {
+    thread_local JsonScratch scratch;
+    return scratch;
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(std::string& out, JsonOptions options) : out_(&out), options_(options) {}
+
+Expected<void> JsonWriter::begin(std::span<const Column> columns) {
+    column_count_ = columns.size();
+    if (options_.shape == JsonRowShape::objects) {
+        build_keys(keys_, columns.size(), [columns](std::size_t index) -> std::string_view { return columns[index].name; });
+    }
+    first_row_ = true;
+    out_->push_back('[');
+    return {};
+}
+
+Expected<void> JsonWriter::row(std::span<const ValueView> values) {
+    if (values.size() != column_count_) {
+        return std::unexpected(json_error("JSON row has " + std::to_string(values.size()) + " values for " +
+                                          std::to_string(column_count_) + " columns"));
+    }
+    auto& out = *out_;
+    if (!first_row_) {
+        out.push_back(',');
+    }
+    first_row_ = false;
+    append_row(out, keys_, values, options_.shape == JsonRowShape::objects);
+    return {};
+}
+
+void JsonWriter::finish() {
+    out_->push_back(']');
+}
+
+void write_json(std::string& out, const Result& result, JsonOptions options) {
+    const auto columns = result.columns();
+    auto& scratch = json_scratch();
+    scratch.use_columns(columns.size(), [columns](std::size_t index) -> std::string_view { return columns[index].name; });
+
+    const bool objects = options.shape == JsonRowShape::objects;
+    out.clear();
+    out.push_back('[');
+    for (std::size_t row_index = 0; row_index < result.row_count(); ++row_index) {
+        const auto row = result.row(row_index);
+        for (std::size_t column = 0; column < scratch.row.size(); ++column) {
+            scratch.row[column] = row.view(column);
+        }
+        if (row_index != 0) {
+            out.push_back(',');
+        }
+        append_row(out, scratch.keys, scratch.row, objects);
+    }
+    out.push_back(']');
+}
+
+void write_json(std::string& out, const ColumnarResult& result, JsonOptions options) {
+    const auto columns = result.columns();
+    auto& scratch = json_scratch();
+    scratch.use_columns(columns.size(), [columns](std::size_t index) -> std::string_view {
+        return columns[index].column.name;
+    });
+
+    // Rows are emitted in order, reading each column's typed buffer at the row offset.
+    const bool objects = options.shape == JsonRowShape::objects;
+    out.clear();
+    out.push_back('[');
+    for (std::size_t row_index = 0; row_index < result.row_count(); ++row_index) {
+        for (std::size_t column = 0; column < scratch.row.size(); ++column) {
+            scratch.row[column] = columns[column].value(row_index);
+        }
+        if (row_index != 0) {
+            out.push_back(',');
+        }
+        append_row(out, scratch.keys, scratch.row, objects);
+    }
+    out.push_back(']');
+}
+
+} // namespace mysqlw
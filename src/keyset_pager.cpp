@@ -0,0 +1,164 @@
+#include "mysqlwrapper/keyset_pager.hpp"
+
+#include "identifier.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace mysqlw {
+namespace {
+
+DbError paginate_error(ErrorCode code, std::string message) {
+    return DbError{
+        .code = code,
+        .operation = Operation::paginate,
+        .message = std::move(message)
+    };
+}
+
+} // namespace
+
+struct KeysetPager::Impl {
+    Impl(Database& database, KeysetOptions options) : database(database), options(std::move(options)) {}
+
+    Database& database;
+    KeysetOptions options;
+    // The first page has no lower bound unless options.after is set; every later page does.
+    std::string first_sql;
+    std::string next_sql;
+    std::optional<Value> after;
+    std::optional<std::size_t> key_index;
+    std::future<Expected<Result>> pending;
+    Result page;
+    std::optional<DbError> error;
+    std::size_t pages = 0;
+    bool done = false;
+
+    Expected<Result> fetch() {
+        if (pending.valid()) {
+            return pending.get();
+        }
+        return after ? query_with_values(database, next_sql, {*after}) : query_with_values(database, first_sql, {});
+    }
+
+    Expected<std::optional<Result>> fail(DbError failure) {
+        done = true;
+        error = failure;
+        return std::unexpected(std::move(failure));
+    }
+};
+
+KeysetPager::KeysetPager(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+KeysetPager::KeysetPager(KeysetPager&&) noexcept = default;
+
+KeysetPager& KeysetPager::operator=(KeysetPager&&) noexcept = default;
+
+KeysetPager::~KeysetPager() = default;
+
+Expected<KeysetPager> KeysetPager::open(Database& database, KeysetOptions options) {
+    if (options.query.empty() || options.key.empty() || options.page_size == 0) {
+        return std::unexpected(paginate_error(ErrorCode::invalid_argument,
+            "keyset pagination needs a query, a key and a non-zero page size"));
+    }
+    if (options.after && std::holds_alternative<std::nullptr_t>(*options.after)) {
+        return std::unexpected(paginate_error(ErrorCode::invalid_argument, "keyset pagination cannot start after NULL"));
+    }
+
+    const auto key = detail::quote_identifier(options.key);
+    const auto tail = " ORDER BY " + key + " LIMIT " + std::to_string(options.page_size);
+    auto impl = std::make_unique<Impl>(database, std::move(options));
+    const auto& where = impl->options.where;
+    impl->first_sql = impl->options.query + (where.empty() ? std::string() : " WHERE (" + where + ")") + tail;
+    impl->next_sql = impl->options.query + " WHERE " + key + " > ?" + (where.empty() ? std::string() : " AND (" + where + ")") +
+                     tail;
+    impl->after = impl->options.after;
+    return KeysetPager(std::move(impl));
+}
+
+Expected<std::optional<Result>> KeysetPager::next_page() {
+    auto& state = *impl_;
+    if (state.done) {
+        return std::nullopt;
+    }
+    auto page = state.fetch();
+    if (!page) {
+        return state.fail(std::move(page.error()));
+    }
+    if (page->empty()) {
+        state.done = true;
+        return std::nullopt;
+    }
+    ++state.pages;
+    if (page->row_count() < state.options.page_size) {
+        state.done = true;
+        return std::optional<Result>(std::move(*page));
+    }
+
+    if (!state.key_index) {
+        const auto columns = page->columns();
+        for (std::size_t index = 0; index < columns.size(); ++index) {
+            if (columns[index].name == state.options.key) {
+                state.key_index = index;
+                break;
+            }
+        }
+        if (!state.key_index) {
+            return state.fail(paginate_error(ErrorCode::invalid_argument,
+                "key column '" + state.options.key + "' is not in the select list"));
+        }
+    }
+    const auto& last = page->row(page->row_count() - 1).at(*state.key_index);
+    if (std::holds_alternative<std::nullptr_t>(last)) {
+        return state.fail(paginate_error(ErrorCode::type_mismatch, "key column '" + state.options.key + "' is NULL"));
+    }
+    state.after = last;
+    if (state.options.prefetch) {
+        state.pending = submit_query_with_values(state.database, state.next_sql, {*state.after});
+    }
+    return std::optional<Result>(std::move(*page));
+}
+
+bool KeysetPager::advance() {
+    auto page = next_page();
+    if (!page || !*page) {
+        impl_->page = Result{};
+        return false;
+    }
+    impl_->page = std::move(**page);
+    return true;
+}
+
+KeysetPager::iterator KeysetPager::begin() {
+    return iterator(this);
+}
+
+const std::optional<DbError>& KeysetPager::error() const noexcept {
+    return impl_->error;
+}
+
+std::size_t KeysetPager::pages() const noexcept {
+    return impl_->pages;
+}
+
+KeysetPager::iterator::iterator(KeysetPager* pager) : pager_(pager->advance() ? pager : nullptr) {}
+
+RowView KeysetPager::iterator::operator*() const {
+    return pager_->impl_->page.row(row_);
+}
+
+KeysetPager::iterator& KeysetPager::iterator::operator++() {
+    if (++row_ == pager_->impl_->page.row_count()) {
+        row_ = 0;
+        if (!pager_->advance()) {
+            pager_ = nullptr;
+        }
+    }
+    return *this;
+}
+
+void KeysetPager::iterator::operator++(int) {
+    ++*this;
+}
+
+} // namespace mysqlw
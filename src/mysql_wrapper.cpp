@@ -1,18 +1,46 @@
 #include "mysqlwrapper/mysql_wrapper.hpp"
+#include "mysqlwrapper/traffic_log.hpp"
+
+#include "codec.hpp"
+#include "snapshot.hpp"
 
 #include <mysql.h>
 
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+// MySQL 8.0.18 replaced the on/off MYSQL_OPT_COMPRESS with named algorithms. MariaDB's client
+// reports a higher version number but only has the old option.
+#if defined(MYSQL_VERSION_ID) && MYSQL_VERSION_ID >= 80018 && !defined(MARIADB_PACKAGE_VERSION)
+#define MYSQLW_HAS_COMPRESSION_ALGORITHMS 1
+#endif
+// TLS session export and resumption arrived in 8.0.29.
+#if defined(MYSQL_VERSION_ID) && MYSQL_VERSION_ID >= 80029 && !defined(MARIADB_PACKAGE_VERSION)
+#define MYSQLW_HAS_TLS_SESSION_REUSE 1
+#endif
+
 #include <algorithm>
+#include <array>
 #include <condition_variable>
 #include <cstring>
 #include <deque>
 #include <functional>
+#include <iterator>
 #include <limits>
+#include <list>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace mysqlw {
@@ -96,78 +124,8 @@ using MysqlHandle = std::unique_ptr<MYSQL, MysqlDeleter>;
 using StmtHandle = std::unique_ptr<MYSQL_STMT, StmtDeleter>;
 using MetadataHandle = std::unique_ptr<MYSQL_RES, ResultDeleter>;
 
-ColumnType column_type_from_field(const MYSQL_FIELD& field) {
-    switch (field.type) {
-        case MYSQL_TYPE_TINY:
-            return (field.flags & UNSIGNED_FLAG) != 0 ? ColumnType::unsigned_integer : ColumnType::signed_integer;
-        case MYSQL_TYPE_SHORT:
-        case MYSQL_TYPE_LONG:
-        case MYSQL_TYPE_INT24:
-        case MYSQL_TYPE_LONGLONG:
-        case MYSQL_TYPE_YEAR:
-            return (field.flags & UNSIGNED_FLAG) != 0 ? ColumnType::unsigned_integer : ColumnType::signed_integer;
-        case MYSQL_TYPE_FLOAT:
-        case MYSQL_TYPE_DOUBLE:
-            return ColumnType::floating;
-        case MYSQL_TYPE_BIT:
-            return ColumnType::blob;
-        case MYSQL_TYPE_BLOB:
-        case MYSQL_TYPE_TINY_BLOB:
-        case MYSQL_TYPE_MEDIUM_BLOB:
-        case MYSQL_TYPE_LONG_BLOB:
-        case MYSQL_TYPE_GEOMETRY:
-            return (field.flags & BINARY_FLAG) != 0 ? ColumnType::blob : ColumnType::text;
-        case MYSQL_TYPE_VARCHAR:
-        case MYSQL_TYPE_VAR_STRING:
-        case MYSQL_TYPE_STRING:
-            return (field.flags & BINARY_FLAG) != 0 ? ColumnType::blob : ColumnType::text;
-        default:
-            return ColumnType::text;
-    }
-}
-
-enum class FieldDecode {
-    signed_integer,
-    unsigned_integer,
-    floating,
-    text,
-    blob
-};
-
-FieldDecode decode_kind(const MYSQL_FIELD& field) {
-    switch (field.type) {
-        case MYSQL_TYPE_TINY:
-        case MYSQL_TYPE_SHORT:
-        case MYSQL_TYPE_LONG:
-        case MYSQL_TYPE_INT24:
-        case MYSQL_TYPE_LONGLONG:
-        case MYSQL_TYPE_YEAR:
-            return (field.flags & UNSIGNED_FLAG) != 0 ? FieldDecode::unsigned_integer : FieldDecode::signed_integer;
-        case MYSQL_TYPE_FLOAT:
-        case MYSQL_TYPE_DOUBLE:
-            return FieldDecode::floating;
-        case MYSQL_TYPE_BLOB:
-        case MYSQL_TYPE_TINY_BLOB:
-        case MYSQL_TYPE_MEDIUM_BLOB:
-        case MYSQL_TYPE_LONG_BLOB:
-        case MYSQL_TYPE_GEOMETRY:
-        case MYSQL_TYPE_BIT:
-            return (field.flags & BINARY_FLAG) != 0 ? FieldDecode::blob : FieldDecode::text;
-        case MYSQL_TYPE_VARCHAR:
-        case MYSQL_TYPE_VAR_STRING:
-        case MYSQL_TYPE_STRING:
-            return (field.flags & BINARY_FLAG) != 0 ? FieldDecode::blob : FieldDecode::text;
-        default:
-            return FieldDecode::text;
-    }
-}
-
-std::string field_name(const MYSQL_FIELD& field) {
-    if (field.name == nullptr) {
-        return {};
-    }
-    return std::string(field.name, field.name_length);
-}
+using detail::BoundParam;
+using detail::FieldDecode;
 
 std::uint64_t mysql_affected_to_u64(my_ulonglong value) {
     if (value == static_cast<my_ulonglong>(-1)) {
@@ -176,8 +134,6 @@ std::uint64_t mysql_affected_to_u64(my_ulonglong value) {
     return static_cast<std::uint64_t>(value);
 }
 
-class Connection;
-
 class ConnectionLease {
 public:
     ConnectionLease() noexcept = default;
@@ -212,109 +168,603 @@ private:
     class ConnectionPoolImpl* pool_ = nullptr;
 };
 
-struct BoundParam {
-    MYSQL_BIND bind{};
-    Value value;
-    unsigned long length = 0;
-    bool is_null = false;
-    bool error = false;
+class LatencyRecorder {
+public:
+    void record(std::chrono::steady_clock::duration elapsed) noexcept {
+        const auto nanos = std::max<std::int64_t>(
+            0, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        const auto seconds = static_cast<double>(nanos) / 1e9;
+        std::size_t bucket = 0;
+        while (bucket < LatencyHistogram::bucket_bounds.size() && seconds > LatencyHistogram::bucket_bounds[bucket]) {
+            ++bucket;
+        }
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        sum_nanos_.fetch_add(static_cast<std::uint64_t>(nanos), std::memory_order_relaxed);
+    }
 
-    explicit BoundParam(Value input) : value(std::move(input)) {
-        rebuild_bind();
+    [[nodiscard]] LatencyHistogram snapshot() const noexcept {
+        LatencyHistogram histogram;
+        for (std::size_t index = 0; index < buckets_.size(); ++index) {
+            histogram.bucket_counts[index] = buckets_[index].load(std::memory_order_relaxed);
+            histogram.count += histogram.bucket_counts[index];
+        }
+        histogram.sum_seconds = static_cast<double>(sum_nanos_.load(std::memory_order_relaxed)) / 1e9;
+        return histogram;
     }
 
-    BoundParam(const BoundParam&) = delete;
-    BoundParam& operator=(const BoundParam&) = delete;
+private:
+    std::array<std::atomic<std::uint64_t>, LatencyHistogram::bucket_bounds.size() + 1> buckets_{};
+    std::atomic<std::uint64_t> sum_nanos_{0};
+};
+
+struct ClientMetrics {
+    LatencyRecorder acquire_latency;
+    LatencyRecorder query_latency;
+    LatencyRecorder execute_latency;
+    std::atomic<std::uint64_t> prepared_statements{0};
+    std::atomic<std::uint64_t> prepare_failures{0};
+    std::atomic<std::uint64_t> submitted_tasks{0};
+    std::atomic<std::uint64_t> completed_tasks{0};
+    std::atomic<std::uint64_t> cancelled_tasks{0};
+    std::atomic<std::uint64_t> skipped_session_sets{0};
+    std::atomic<std::uint64_t> compressed_queries{0};
+    std::atomic<std::uint64_t> uncompressed_queries{0};
+    std::atomic<std::uint64_t> compressed_result_bytes{0};
+    std::atomic<std::uint64_t> uncompressed_result_bytes{0};
+};
+
+std::uint64_t payload_bytes(const ValueView& value) noexcept {
+    return std::visit([](const auto& stored) -> std::uint64_t {
+        using Stored = std::decay_t<decltype(stored)>;
+        if constexpr (std::is_same_v<Stored, std::nullptr_t>) {
+            return 0;
+        } else if constexpr (requires { stored.size(); }) {
+            return stored.size();
+        } else {
+            return 8;
+        }
+    }, value);
+}
 
-    BoundParam(BoundParam&& other) noexcept
-        : value(std::move(other.value)), length(other.length), is_null(other.is_null), error(other.error) {
-        rebuild_bind();
+std::uint64_t payload_bytes(const Result& result) {
+    std::uint64_t bytes = 0;
+    for (std::size_t row = 0; row < result.row_count(); ++row) {
+        const auto view = result.row(row);
+        for (std::size_t column = 0; column < result.column_count(); ++column) {
+            bytes += payload_bytes(view.view(column));
+        }
     }
+    return bytes;
+}
 
-    BoundParam& operator=(BoundParam&& other) noexcept {
-        if (this != &other) {
-            value = std::move(other.value);
-            length = other.length;
-            is_null = other.is_null;
-            error = other.error;
-            rebuild_bind();
+// Passes rows through while adding up their payload bytes.
+class CountingSink final : public RowSink {
+public:
+    explicit CountingSink(RowSink& sink) noexcept : sink_(sink) {}
+
+    [[nodiscard]] Expected<void> begin(std::span<const Column> columns) override {
+        return sink_.begin(columns);
+    }
+
+    [[nodiscard]] Expected<void> row(std::span<const ValueView> values) override {
+        for (const auto& value : values) {
+            bytes_ += payload_bytes(value);
         }
-        return *this;
+        return sink_.row(values);
+    }
+
+    [[nodiscard]] std::uint64_t bytes() const noexcept {
+        return bytes_;
+    }
+
+private:
+    RowSink& sink_;
+    std::uint64_t bytes_ = 0;
+};
+
+// Transparent over SQL text and StatementKey, whose precomputed hash it uses as is.
+struct StringHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view value) const noexcept {
+        return detail::sql_hash(value);
+    }
+
+    std::size_t operator()(const StatementKey& key) const noexcept {
+        return key.hash;
+    }
+};
+
+struct StringEqual {
+    using is_transparent = void;
+
+    static std::string_view text(std::string_view value) noexcept {
+        return value;
+    }
+
+    static std::string_view text(const StatementKey& key) noexcept {
+        return key.sql;
     }
 
-    void rebuild_bind() noexcept {
-        std::memset(&bind, 0, sizeof(bind));
-        bind.length = &length;
-        bind.error = &error;
-
-        std::visit([this](auto& stored) {
-            using T = std::decay_t<decltype(stored)>;
-            if constexpr (std::same_as<T, std::nullptr_t>) {
-                is_null = true;
-                bind.buffer_type = MYSQL_TYPE_NULL;
-                bind.is_null = &is_null;
-            } else if constexpr (std::same_as<T, std::int64_t>) {
-                bind.buffer_type = MYSQL_TYPE_LONGLONG;
-                bind.buffer = &stored;
-                bind.is_unsigned = false;
-                length = sizeof(stored);
-            } else if constexpr (std::same_as<T, std::uint64_t>) {
-                bind.buffer_type = MYSQL_TYPE_LONGLONG;
-                bind.buffer = &stored;
-                bind.is_unsigned = true;
-                length = sizeof(stored);
-            } else if constexpr (std::same_as<T, double>) {
-                bind.buffer_type = MYSQL_TYPE_DOUBLE;
-                bind.buffer = &stored;
-                length = sizeof(stored);
-            } else if constexpr (std::same_as<T, std::string>) {
-                bind.buffer_type = MYSQL_TYPE_STRING;
-                bind.buffer = stored.empty() ? nullptr : stored.data();
-                length = static_cast<unsigned long>(stored.size());
-                bind.buffer_length = length;
-            } else if constexpr (std::same_as<T, Blob>) {
-                bind.buffer_type = MYSQL_TYPE_BLOB;
-                bind.buffer = stored.empty() ? nullptr : stored.data();
-                length = static_cast<unsigned long>(stored.size());
-                bind.buffer_length = length;
-            } else if constexpr (std::same_as<T, bool>) {
-                bind.buffer_type = MYSQL_TYPE_TINY;
-                bind.buffer = &stored;
-                length = sizeof(stored);
-            }
-        }, value);
+    template <typename L, typename R>
+    bool operator()(const L& left, const R& right) const noexcept {
+        return text(left) == text(right);
     }
 };
 
+std::vector<Value> to_values(std::span<const ValueView> views) {
+    std::vector<Value> values;
+    values.reserve(views.size());
+    std::ranges::transform(views, std::back_inserter(values), to_value);
+    return values;
+}
+
 struct BoolSlot {
     bool value = false;
 };
 
-class Statement {
-public:
-    Statement(StmtHandle stmt, std::string sql) : stmt_(std::move(stmt)), sql_(std::move(sql)) {}
+// Largest initial buffer for a streamed column; longer values are re-fetched into a grown buffer.
+constexpr unsigned long stream_buffer_limit = 64 * 1024;
 
-    [[nodiscard]] Expected<Result> query(std::vector<Value> values) {
-        if (auto bound = bind(std::move(values)); !bound) {
-            return std::unexpected(bound.error());
+// Output buffers bound with mysql_stmt_bind_result for one result set. The lengths belong to the
+// statement: the client keeps the bound length pointers and writes through them when the
+// statement is next executed, before anything is bound again.
+struct ResultBuffers {
+    explicit ResultBuffers(std::vector<unsigned long>& lengths) noexcept : lengths(lengths) {}
+
+    std::vector<Column> columns;
+    std::vector<FieldDecode> decode_kinds;
+    std::vector<MYSQL_BIND> binds;
+    std::vector<std::vector<unsigned char>> buffers;
+    std::vector<unsigned long>& lengths;
+    std::vector<BoolSlot> null_storage;
+    std::vector<BoolSlot> error_storage;
+
+    // Buffered results are sized from max_length; streamed ones start at most stream_buffer_limit.
+    [[nodiscard]] Expected<void> bind(MYSQL_STMT* stmt, MYSQL_RES* metadata, bool buffered) {
+        const auto field_count = mysql_num_fields(metadata);
+        MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+
+        columns.reserve(field_count);
+        decode_kinds.reserve(field_count);
+        for (unsigned int index = 0; index < field_count; ++index) {
+            columns.push_back(detail::make_column(fields[index]));
+            decode_kinds.push_back(detail::decode_kind(fields[index]));
         }
 
-        if (mysql_stmt_execute(stmt_.get()) != mysql_success) {
-            return std::unexpected(make_stmt_error(ErrorCode::execute_failed, Operation::execute, stmt_.get(),
-                                                  "failed to execute statement"));
+        binds.resize(field_count);
+        buffers.resize(field_count);
+        lengths.resize(field_count);
+        null_storage.resize(field_count);
+        error_storage.resize(field_count);
+
+        for (unsigned int index = 0; index < field_count; ++index) {
+            std::memset(&binds[index], 0, sizeof(MYSQL_BIND));
+
+            auto buffer_size = buffered ? std::max<unsigned long>(fields[index].max_length, fields[index].length)
+                                        : std::min<unsigned long>(fields[index].length, stream_buffer_limit);
+            buffer_size = std::max<unsigned long>(buffer_size, 1);
+            if (decode_kinds[index] == FieldDecode::signed_integer || decode_kinds[index] == FieldDecode::unsigned_integer) {
+                buffer_size = sizeof(std::uint64_t);
+                binds[index].buffer_type = MYSQL_TYPE_LONGLONG;
+                binds[index].is_unsigned = decode_kinds[index] == FieldDecode::unsigned_integer;
+            } else if (decode_kinds[index] == FieldDecode::floating) {
+                buffer_size = sizeof(double);
+                binds[index].buffer_type = MYSQL_TYPE_DOUBLE;
+            } else {
+                binds[index].buffer_type = MYSQL_TYPE_STRING;
+            }
+
+            buffers[index].resize(buffer_size);
+            binds[index].buffer = buffers[index].data();
+            binds[index].buffer_length = static_cast<unsigned long>(buffers[index].size());
+            binds[index].length = &lengths[index];
+            binds[index].is_null = &null_storage[index].value;
+            binds[index].error = &error_storage[index].value;
+        }
+
+        if (field_count > 0 && mysql_stmt_bind_result(stmt, binds.data()) != mysql_success) {
+            return std::unexpected(make_stmt_error(ErrorCode::result_bind_failed, Operation::fetch, stmt,
+                                                  "failed to bind result buffers"));
+        }
+        return {};
+    }
+
+    // Returns false once the result set is exhausted.
+    [[nodiscard]] Expected<bool> fetch(MYSQL_STMT* stmt) {
+        const auto fetch_status = mysql_stmt_fetch(stmt);
+        if (fetch_status == MYSQL_NO_DATA) {
+            return false;
+        }
+        if (fetch_status == 1) {
+            return std::unexpected(make_stmt_error(ErrorCode::result_fetch_failed, Operation::fetch, stmt,
+                                                  "failed to fetch result row"));
+        }
+        if (fetch_status == MYSQL_DATA_TRUNCATED) {
+            bool grown = false;
+            for (unsigned int index = 0; index < binds.size(); ++index) {
+                if (error_storage[index].value && lengths[index] > buffers[index].size()) {
+                    buffers[index].resize(lengths[index]);
+                    binds[index].buffer = buffers[index].data();
+                    binds[index].buffer_length = static_cast<unsigned long>(buffers[index].size());
+                    grown = true;
+                    if (mysql_stmt_fetch_column(stmt, &binds[index], index, 0) != mysql_success) {
+                        return std::unexpected(make_stmt_error(ErrorCode::result_fetch_failed, Operation::fetch,
+                                                              stmt, "failed to fetch truncated column"));
+                    }
+                }
+            }
+            // The client keeps its own copy of the binds, which still points at the old buffers.
+            if (grown && mysql_stmt_bind_result(stmt, binds.data()) != mysql_success) {
+                return std::unexpected(make_stmt_error(ErrorCode::result_bind_failed, Operation::fetch, stmt,
+                                                      "failed to bind result buffers"));
+            }
+        }
+        return true;
+    }
+};
+
+// Column index for every member of a query_into() row: by name when the row names its columns,
+// by position otherwise.
+template <typename NameOf>
+Expected<std::vector<std::size_t>> map_members(const detail::RowTarget& target, std::size_t column_count,
+                                               NameOf&& name_of) {
+    std::vector<std::size_t> columns;
+    columns.reserve(target.members.size());
+    if (target.names.empty()) {
+        if (column_count != target.members.size()) {
+            return std::unexpected(make_error(ErrorCode::type_mismatch, Operation::fetch,
+                "result has " + std::to_string(column_count) + " columns for " +
+                std::to_string(target.members.size()) + " row members"));
+        }
+        for (std::size_t index = 0; index < column_count; ++index) {
+            columns.push_back(index);
+        }
+        return columns;
+    }
+    for (const auto name : target.names) {
+        std::size_t index = 0;
+        while (index < column_count && name_of(index) != name) {
+            ++index;
         }
+        if (index == column_count) {
+            return std::unexpected(make_error(ErrorCode::type_mismatch, Operation::fetch,
+                                             "result has no column '" + std::string(name) + "'"));
+        }
+        columns.push_back(index);
+    }
+    return columns;
+}
+
+DbError member_error(std::string_view column, std::string_view problem) {
+    return make_error(ErrorCode::type_mismatch, Operation::fetch, "column '" + std::string(column) + "' " + std::string(problem));
+}
+
+// Stores an integer in a member of the given size and signedness, failing when it does not fit.
+template <typename T>
+bool store_integer(void* storage, std::size_t size, bool is_signed, T value) noexcept {
+    const auto store = [&]<typename Member>(std::type_identity<Member>) {
+        if (!std::in_range<Member>(value)) {
+            return false;
+        }
+        const auto narrowed = static_cast<Member>(value);
+        std::memcpy(storage, &narrowed, sizeof(narrowed));
+        return true;
+    };
+    switch (size) {
+        case 1:
+            return is_signed ? store(std::type_identity<std::int8_t>{}) : store(std::type_identity<std::uint8_t>{});
+        case 2:
+            return is_signed ? store(std::type_identity<std::int16_t>{}) : store(std::type_identity<std::uint16_t>{});
+        case 4:
+            return is_signed ? store(std::type_identity<std::int32_t>{}) : store(std::type_identity<std::uint32_t>{});
+        default:
+            return is_signed ? store(std::type_identity<std::int64_t>{}) : store(std::type_identity<std::uint64_t>{});
+    }
+}
+
+// Assigns one cell of a materialized Result to a row member, for connections without a direct
+// fetch.
+Expected<void> assign_member(const detail::MemberBinding& member, void* row, const Value& value, std::string_view column) {
+    using detail::MemberKind;
+    if (std::holds_alternative<std::nullptr_t>(value)) {
+        if (member.clear == nullptr) {
+            return std::unexpected(member_error(column, "is NULL; use a std::optional member"));
+        }
+        member.clear(row);
+        return {};
+    }
+    void* storage = member.storage(row);
+    const auto* signed_value = std::get_if<std::int64_t>(&value);
+    const auto* unsigned_value = std::get_if<std::uint64_t>(&value);
+    const auto* bool_value = std::get_if<bool>(&value);
+    bool stored = false;
+    switch (member.kind) {
+        case MemberKind::signed_integer:
+        case MemberKind::unsigned_integer: {
+            const bool is_signed = member.kind == MemberKind::signed_integer;
+            stored = signed_value != nullptr     ? store_integer(storage, member.size, is_signed, *signed_value)
+                     : unsigned_value != nullptr ? store_integer(storage, member.size, is_signed, *unsigned_value)
+                     : bool_value != nullptr     ? store_integer(storage, member.size, is_signed, int{*bool_value})
+                                                 : false;
+            break;
+        }
+        case MemberKind::boolean:
+            if (signed_value != nullptr || unsigned_value != nullptr || bool_value != nullptr) {
+                *static_cast<bool*>(storage) = signed_value != nullptr ? *signed_value != 0
+                                               : unsigned_value != nullptr ? *unsigned_value != 0
+                                                                           : *bool_value;
+                stored = true;
+            }
+            break;
+        case MemberKind::floating: {
+            std::optional<double> number;
+            if (const auto* floating = std::get_if<double>(&value)) {
+                number = *floating;
+            } else if (signed_value != nullptr) {
+                number = static_cast<double>(*signed_value);
+            } else if (unsigned_value != nullptr) {
+                number = static_cast<double>(*unsigned_value);
+            }
+            if (number && member.size == sizeof(float)) {
+                *static_cast<float*>(storage) = static_cast<float>(*number);
+            } else if (number) {
+                *static_cast<double*>(storage) = *number;
+            }
+            stored = number.has_value();
+            break;
+        }
+        case MemberKind::text:
+            if (const auto* text = std::get_if<std::string>(&value)) {
+                *static_cast<std::string*>(storage) = *text;
+                stored = true;
+            }
+            break;
+        case MemberKind::blob:
+            if (const auto* blob = std::get_if<Blob>(&value)) {
+                *static_cast<Blob*>(storage) = *blob;
+                stored = true;
+            } else if (const auto* text = std::get_if<std::string>(&value)) {
+                const auto bytes = std::as_bytes(std::span(*text));
+                static_cast<Blob*>(storage)->assign(bytes.begin(), bytes.end());
+                stored = true;
+            }
+            break;
+    }
+    if (!stored) {
+        return std::unexpected(member_error(column, "does not fit its row member"));
+    }
+    return {};
+}
+
+// Whether the client can fetch a column of this type into the member without losing its meaning.
+bool member_accepts(detail::MemberKind kind, const MYSQL_FIELD& field) noexcept {
+    using detail::MemberKind;
+    const auto decode = detail::decode_kind(field);
+    const bool integer = decode == FieldDecode::signed_integer || decode == FieldDecode::unsigned_integer;
+    switch (kind) {
+        case MemberKind::signed_integer:
+        case MemberKind::unsigned_integer:
+        case MemberKind::boolean:
+            return integer;
+        case MemberKind::floating:
+            return integer || decode == FieldDecode::floating || field.type == MYSQL_TYPE_NEWDECIMAL ||
+                   field.type == MYSQL_TYPE_DECIMAL;
+        case MemberKind::text:
+            return decode != FieldDecode::blob;
+        case MemberKind::blob:
+            return decode == FieldDecode::blob || decode == FieldDecode::text;
+    }
+    return false;
+}
+
+enum_field_types member_buffer_type(const detail::MemberBinding& member) noexcept {
+    using detail::MemberKind;
+    switch (member.kind) {
+        case MemberKind::boolean:
+            return MYSQL_TYPE_TINY;
+        case MemberKind::signed_integer:
+        case MemberKind::unsigned_integer:
+            return member.size == 1 ? MYSQL_TYPE_TINY
+                 : member.size == 2 ? MYSQL_TYPE_SHORT
+                 : member.size == 4 ? MYSQL_TYPE_LONG
+                                    : MYSQL_TYPE_LONGLONG;
+        case MemberKind::floating:
+            return member.size == sizeof(float) ? MYSQL_TYPE_FLOAT : MYSQL_TYPE_DOUBLE;
+        case MemberKind::text:
+            return MYSQL_TYPE_STRING;
+        case MemberKind::blob:
+            return MYSQL_TYPE_BLOB;
+    }
+    return MYSQL_TYPE_NULL;
+}
+
+// Frees the statement's pending result set, discarding rows a stopped stream left unread.
+struct StmtResultGuard {
+    MYSQL_STMT* stmt;
+
+    ~StmtResultGuard() {
+        (void)mysql_stmt_free_result(stmt);
+    }
+};
 
+class Statement final : public PreparedStatement {
+public:
+    Statement(StmtHandle stmt, std::string sql, std::size_t hash)
+        : stmt_(std::move(stmt)), sql_(std::move(sql)), hash_(hash) {}
+
+    [[nodiscard]] const std::string& sql() const noexcept {
+        return sql_;
+    }
+
+    [[nodiscard]] bool matches(std::string_view sql, std::size_t hash) const noexcept {
+        return hash_ == hash && sql_ == sql;
+    }
+
+    [[nodiscard]] bool pinned() const noexcept {
+        return pinned_;
+    }
+
+    void pin() noexcept {
+        pinned_ = true;
+    }
+
+    [[nodiscard]] Expected<Result> query_views(std::span<const ValueView> values) override {
+        if (auto executed = bind_views_and_execute(values); !executed) {
+            return std::unexpected(executed.error());
+        }
         return fetch_result();
     }
 
-    [[nodiscard]] Expected<ExecuteResult> execute(std::vector<Value> values) {
-        if (auto bound = bind(std::move(values)); !bound) {
-            return std::unexpected(bound.error());
+    [[nodiscard]] Expected<ExecuteResult> execute_views(std::span<const ValueView> values) override {
+        if (auto executed = bind_views_and_execute(values); !executed) {
+            return std::unexpected(executed.error());
+        }
+        return ExecuteResult{
+            .affected_rows = mysql_affected_to_u64(mysql_stmt_affected_rows(stmt_.get())),
+            .last_insert_id = static_cast<std::uint64_t>(mysql_stmt_insert_id(stmt_.get()))
+        };
+    }
+
+    // Rows are read from the socket one at a time. Before each fetch the result binds are pointed
+    // at the members of a new row, so fixed-size values land in place; text and blob members are
+    // filled up to their current capacity and re-read at full length when they do not fit.
+    [[nodiscard]] Expected<void> query_into(std::span<const ValueView> values, const detail::RowTarget& target) override {
+        using detail::MemberKind;
+        if (auto executed = bind_views_and_execute(values); !executed) {
+            return executed;
         }
+        MetadataHandle metadata(mysql_stmt_result_metadata(stmt_.get()));
+        if (!metadata) {
+            return std::unexpected(make_error(ErrorCode::type_mismatch, Operation::fetch, "statement returned no result set"));
+        }
+        StmtResultGuard guard{stmt_.get()};
+        auto mapped = member_columns(metadata.get(), target);
+        if (!mapped) {
+            return std::unexpected(mapped.error());
+        }
+        const auto& columns = **mapped;
+        const MYSQL_FIELD* fields = mysql_fetch_fields(metadata.get());
+        const auto members = target.members;
+
+        // Unmapped columns keep MYSQL_TYPE_NULL and are skipped by the fetch.
+        std::vector<MYSQL_BIND> binds(mysql_num_fields(metadata.get()));
+        for (auto& bind : binds) {
+            std::memset(&bind, 0, sizeof(MYSQL_BIND));
+            bind.buffer_type = MYSQL_TYPE_NULL;
+        }
+        auto& lengths = result_lengths_;
+        lengths.assign(members.size(), 0);
+        std::vector<BoolSlot> nulls(members.size());
+        std::vector<BoolSlot> errors(members.size());
+        std::vector<signed char> flags(members.size());
+        std::vector<void*> storage(members.size());
+        for (std::size_t index = 0; index < members.size(); ++index) {
+            auto& bind = binds[columns[index]];
+            bind.buffer_type = member_buffer_type(members[index]);
+            bind.is_unsigned = members[index].kind == MemberKind::unsigned_integer;
+            bind.length = &lengths[index];
+            bind.is_null = &nulls[index].value;
+            bind.error = &errors[index].value;
+        }
+
+        const auto fail = [&](DbError error) -> Expected<void> {
+            target.discard(target.rows);
+            return std::unexpected(std::move(error));
+        };
+        std::uint64_t bytes = 0;
+        while (true) {
+            void* row = target.append(target.rows);
+            for (std::size_t index = 0; index < members.size(); ++index) {
+                auto& bind = binds[columns[index]];
+                storage[index] = members[index].storage(row);
+                if (members[index].kind == MemberKind::boolean) {
+                    // A bool may only hold 0 or 1, so TINYINT values go through a byte.
+                    bind.buffer = &flags[index];
+                } else if (members[index].kind == MemberKind::text) {
+                    auto& text = *static_cast<std::string*>(storage[index]);
+                    text.resize(text.capacity());
+                    bind.buffer = text.data();
+                    bind.buffer_length = static_cast<unsigned long>(text.size());
+                } else if (members[index].kind == MemberKind::blob) {
+                    auto& blob = *static_cast<Blob*>(storage[index]);
+                    blob.resize(blob.capacity());
+                    bind.buffer = blob.data();
+                    bind.buffer_length = static_cast<unsigned long>(blob.size());
+                } else {
+                    bind.buffer = storage[index];
+                }
+            }
+            if (!binds.empty() && mysql_stmt_bind_result(stmt_.get(), binds.data()) != mysql_success) {
+                return fail(make_stmt_error(ErrorCode::result_bind_failed, Operation::fetch, stmt_.get(),
+                                            "failed to bind result buffers"));
+            }
 
-        if (mysql_stmt_execute(stmt_.get()) != mysql_success) {
-            return std::unexpected(make_stmt_error(ErrorCode::execute_failed, Operation::execute, stmt_.get(),
-                                                  "failed to execute statement"));
+            const auto fetch_status = mysql_stmt_fetch(stmt_.get());
+            if (fetch_status == MYSQL_NO_DATA) {
+                target.discard(target.rows);
+                if (target.fetched_bytes != nullptr) {
+                    *target.fetched_bytes += bytes;
+                }
+                return {};
+            }
+            if (fetch_status == 1) {
+                return fail(make_stmt_error(ErrorCode::result_fetch_failed, Operation::fetch, stmt_.get(),
+                                            "failed to fetch result row"));
+            }
+            for (std::size_t index = 0; index < members.size(); ++index) {
+                const auto column = columns[index];
+                const auto kind = members[index].kind;
+                if (nulls[index].value) {
+                    if (members[index].clear == nullptr) {
+                        return fail(member_error(detail::field_name(fields[column]), "is NULL; use a std::optional member"));
+                    }
+                    members[index].clear(row);
+                } else if (kind == MemberKind::text || kind == MemberKind::blob) {
+                    bytes += lengths[index];
+                    const bool truncated = lengths[index] > binds[column].buffer_length;
+                    void* data = nullptr;
+                    if (kind == MemberKind::text) {
+                        auto& text = *static_cast<std::string*>(storage[index]);
+                        text.resize(lengths[index]);
+                        data = text.data();
+                    } else {
+                        auto& blob = *static_cast<Blob*>(storage[index]);
+                        blob.resize(lengths[index]);
+                        data = blob.data();
+                    }
+                    if (truncated) {
+                        binds[column].buffer = data;
+                        binds[column].buffer_length = lengths[index];
+                        if (mysql_stmt_fetch_column(stmt_.get(), &binds[column], static_cast<unsigned int>(column), 0) !=
+                            mysql_success) {
+                            return fail(make_stmt_error(ErrorCode::result_fetch_failed, Operation::fetch, stmt_.get(),
+                                                        "failed to fetch truncated column"));
+                        }
+                    }
+                } else if (errors[index].value) {
+                    return fail(member_error(detail::field_name(fields[column]), "does not fit its row member"));
+                } else {
+                    // Fixed-size values count 8 bytes, as payload_bytes() counts them.
+                    bytes += 8;
+                    if (kind == MemberKind::boolean) {
+                        *static_cast<bool*>(storage[index]) = flags[index] != 0;
+                    }
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] Expected<Result> query(std::vector<Value> values) override {
+        if (auto executed = bind_and_execute(std::move(values)); !executed) {
+            return std::unexpected(executed.error());
+        }
+        return fetch_result();
+    }
+
+    [[nodiscard]] Expected<ExecuteResult> execute(std::vector<Value> values) override {
+        if (auto executed = bind_and_execute(std::move(values)); !executed) {
+            return std::unexpected(executed.error());
         }
 
         return ExecuteResult{
@@ -323,11 +773,123 @@ public:
         };
     }
 
+    [[nodiscard]] Expected<void> stream(std::vector<Value> values, RowSink& sink) override {
+        if (auto executed = bind_and_execute(std::move(values)); !executed) {
+            return executed;
+        }
+
+        MetadataHandle metadata(mysql_stmt_result_metadata(stmt_.get()));
+        if (!metadata) {
+            return sink.begin({});
+        }
+
+        // Rows are read from the socket by mysql_stmt_fetch rather than stored client side.
+        StmtResultGuard guard{stmt_.get()};
+        ResultBuffers result(result_lengths_);
+        if (auto bound = result.bind(stmt_.get(), metadata.get(), false); !bound) {
+            return bound;
+        }
+        if (auto begun = sink.begin(result.columns); !begun) {
+            return begun;
+        }
+
+        std::vector<ValueView> views(result.columns.size());
+        while (true) {
+            auto fetched = result.fetch(stmt_.get());
+            if (!fetched) {
+                return std::unexpected(fetched.error());
+            }
+            if (!*fetched) {
+                return {};
+            }
+            for (std::size_t index = 0; index < views.size(); ++index) {
+                views[index] = result.null_storage[index].value
+                    ? ValueView{nullptr}
+                    : detail::decode_binary_view(result.decode_kinds[index], result.buffers[index].data(),
+                                                 result.lengths[index]);
+            }
+            if (auto accepted = sink.row(views); !accepted) {
+                return accepted;
+            }
+        }
+    }
+
 private:
+    // Parameter count up to which views are bound from a fixed-size array on the stack.
+    static constexpr std::size_t inline_params = 16;
+
     StmtHandle stmt_;
     std::string sql_;
+    std::size_t hash_;
+    // Pinned statements are never evicted from the connection's cache.
+    bool pinned_ = false;
     std::vector<BoundParam> params_;
     std::vector<MYSQL_BIND> bind_params_;
+    // Result lengths, kept for the statement's lifetime; see ResultBuffers.
+    std::vector<unsigned long> result_lengths_;
+    // Column index per member for each query_into() row type, checked against the metadata once.
+    std::vector<std::pair<const void*, std::vector<std::size_t>>> layouts_;
+
+    [[nodiscard]] Expected<const std::vector<std::size_t>*> member_columns(MYSQL_RES* metadata,
+                                                                         const detail::RowTarget& target) {
+        if (const auto known = std::ranges::find(layouts_, target.type, &decltype(layouts_)::value_type::first);
+            known != layouts_.end()) {
+            return &known->second;
+        }
+        const auto field_count = mysql_num_fields(metadata);
+        const MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+        auto columns = map_members(target, field_count, [fields](std::size_t index) {
+            return std::string_view(fields[index].name == nullptr ? "" : fields[index].name);
+        });
+        if (!columns) {
+            return std::unexpected(columns.error());
+        }
+        for (std::size_t index = 0; index < columns->size(); ++index) {
+            const auto& field = fields[(*columns)[index]];
+            if (!member_accepts(target.members[index].kind, field)) {
+                return std::unexpected(member_error(detail::field_name(field), "has a type its row member cannot hold"));
+            }
+        }
+        return &layouts_.emplace_back(target.type, std::move(*columns)).second;
+    }
+
+    [[nodiscard]] Expected<void> bind_views_and_execute(std::span<const ValueView> values) {
+        if (values.size() > inline_params) {
+            return bind_and_execute(to_values(values));
+        }
+        if (values.size() != mysql_stmt_param_count(stmt_.get())) {
+            return std::unexpected(make_error(ErrorCode::invalid_argument, Operation::bind,
+                                             "statement parameter count differs from its descriptor"));
+        }
+
+        // The client reads the lengths during the execute, so both arrays live until it returns.
+        std::array<MYSQL_BIND, inline_params> binds;
+        std::array<unsigned long, inline_params> lengths{};
+        for (std::size_t index = 0; index < values.size(); ++index) {
+            detail::bind_view(binds[index], values[index], lengths[index]);
+        }
+        if (!values.empty() && mysql_stmt_bind_param(stmt_.get(), binds.data()) != mysql_success) {
+            return std::unexpected(make_stmt_error(ErrorCode::bind_failed, Operation::bind, stmt_.get(),
+                                                  "failed to bind statement parameters"));
+        }
+        if (mysql_stmt_execute(stmt_.get()) != mysql_success) {
+            return std::unexpected(make_stmt_error(ErrorCode::execute_failed, Operation::execute, stmt_.get(),
+                                                  "failed to execute statement"));
+        }
+        return {};
+    }
+
+    [[nodiscard]] Expected<void> bind_and_execute(std::vector<Value> values) {
+        if (auto bound = bind(std::move(values)); !bound) {
+            return bound;
+        }
+
+        if (mysql_stmt_execute(stmt_.get()) != mysql_success) {
+            return std::unexpected(make_stmt_error(ErrorCode::execute_failed, Operation::execute, stmt_.get(),
+                                                  "failed to execute statement"));
+        }
+        return {};
+    }
 
     [[nodiscard]] Expected<void> bind(std::vector<Value> values) {
         const auto expected_count = mysql_stmt_param_count(stmt_.get());
@@ -371,128 +933,195 @@ private:
                                                   "failed to store statement result"));
         }
 
-        const auto field_count = mysql_num_fields(metadata.get());
-        MYSQL_FIELD* fields = mysql_fetch_fields(metadata.get());
-
-        std::vector<Column> columns;
-        columns.reserve(field_count);
-        std::vector<FieldDecode> decode_kinds;
-        decode_kinds.reserve(field_count);
-
-        for (unsigned int index = 0; index < field_count; ++index) {
-            columns.push_back(Column{
-                .name = field_name(fields[index]),
-                .type = column_type_from_field(fields[index]),
-                .nullable = (fields[index].flags & NOT_NULL_FLAG) == 0,
-                .unsigned_value = (fields[index].flags & UNSIGNED_FLAG) != 0
-            });
-            decode_kinds.push_back(decode_kind(fields[index]));
-        }
-
-        std::vector<MYSQL_BIND> result_binds(field_count);
-        std::vector<std::vector<unsigned char>> buffers(field_count);
-        std::vector<unsigned long> lengths(field_count);
-        std::vector<BoolSlot> null_storage(field_count);
-        std::vector<BoolSlot> error_storage(field_count);
-
-        for (unsigned int index = 0; index < field_count; ++index) {
-            std::memset(&result_binds[index], 0, sizeof(MYSQL_BIND));
-
-            auto buffer_size = std::max<unsigned long>(fields[index].max_length, fields[index].length);
-            buffer_size = std::max<unsigned long>(buffer_size, 1);
-            if (decode_kinds[index] == FieldDecode::signed_integer || decode_kinds[index] == FieldDecode::unsigned_integer) {
-                buffer_size = sizeof(std::uint64_t);
-                result_binds[index].buffer_type = MYSQL_TYPE_LONGLONG;
-                result_binds[index].is_unsigned = decode_kinds[index] == FieldDecode::unsigned_integer;
-            } else if (decode_kinds[index] == FieldDecode::floating) {
-                buffer_size = sizeof(double);
-                result_binds[index].buffer_type = MYSQL_TYPE_DOUBLE;
-            } else {
-                result_binds[index].buffer_type = MYSQL_TYPE_STRING;
-            }
-
-            buffers[index].resize(buffer_size);
-            result_binds[index].buffer = buffers[index].data();
-            result_binds[index].buffer_length = static_cast<unsigned long>(buffers[index].size());
-            result_binds[index].length = &lengths[index];
-            result_binds[index].is_null = &null_storage[index].value;
-            result_binds[index].error = &error_storage[index].value;
-        }
-
-        if (field_count > 0 && mysql_stmt_bind_result(stmt_.get(), result_binds.data()) != mysql_success) {
-            return std::unexpected(make_stmt_error(ErrorCode::result_bind_failed, Operation::fetch, stmt_.get(),
-                                                  "failed to bind result buffers"));
+        ResultBuffers result(result_lengths_);
+        if (auto bound = result.bind(stmt_.get(), metadata.get(), true); !bound) {
+            return std::unexpected(bound.error());
         }
 
+        const auto field_count = result.columns.size();
         std::vector<Result::RowStorage> rows;
         while (true) {
-            const auto fetch_status = mysql_stmt_fetch(stmt_.get());
-            if (fetch_status == MYSQL_NO_DATA) {
-                break;
+            auto fetched = result.fetch(stmt_.get());
+            if (!fetched) {
+                return std::unexpected(fetched.error());
             }
-            if (fetch_status == 1) {
-                return std::unexpected(make_stmt_error(ErrorCode::result_fetch_failed, Operation::fetch, stmt_.get(),
-                                                      "failed to fetch result row"));
-            }
-            if (fetch_status == MYSQL_DATA_TRUNCATED) {
-                for (unsigned int index = 0; index < field_count; ++index) {
-                    if (error_storage[index].value && lengths[index] > buffers[index].size()) {
-                        buffers[index].resize(lengths[index]);
-                        result_binds[index].buffer = buffers[index].data();
-                        result_binds[index].buffer_length = static_cast<unsigned long>(buffers[index].size());
-                        if (mysql_stmt_fetch_column(stmt_.get(), &result_binds[index], index, 0) != mysql_success) {
-                            return std::unexpected(make_stmt_error(ErrorCode::result_fetch_failed, Operation::fetch,
-                                                                  stmt_.get(), "failed to fetch truncated column"));
-                        }
-                    }
-                }
+            if (!*fetched) {
+                break;
             }
 
             Result::RowStorage row;
             row.reserve(field_count);
-            for (unsigned int index = 0; index < field_count; ++index) {
-                if (null_storage[index].value) {
+            for (std::size_t index = 0; index < field_count; ++index) {
+                if (result.null_storage[index].value) {
                     row.emplace_back(nullptr);
                     continue;
                 }
-
-                switch (decode_kinds[index]) {
-                    case FieldDecode::signed_integer:
-                        row.emplace_back(*reinterpret_cast<std::int64_t*>(buffers[index].data()));
-                        break;
-                    case FieldDecode::unsigned_integer:
-                        row.emplace_back(*reinterpret_cast<std::uint64_t*>(buffers[index].data()));
-                        break;
-                    case FieldDecode::floating:
-                        row.emplace_back(*reinterpret_cast<double*>(buffers[index].data()));
-                        break;
-                    case FieldDecode::blob: {
-                        Blob blob;
-                        blob.reserve(lengths[index]);
-                        for (unsigned long byte_index = 0; byte_index < lengths[index]; ++byte_index) {
-                            blob.push_back(static_cast<std::byte>(buffers[index][byte_index]));
-                        }
-                        row.emplace_back(std::move(blob));
-                        break;
-                    }
-                    case FieldDecode::text:
-                        row.emplace_back(std::string(reinterpret_cast<char*>(buffers[index].data()), lengths[index]));
-                        break;
-                }
+                row.push_back(detail::decode_binary_value(result.decode_kinds[index], result.buffers[index].data(),
+                                                          result.lengths[index]));
             }
             rows.push_back(std::move(row));
         }
 
         mysql_stmt_free_result(stmt_.get());
-        return Result(std::move(columns), std::move(rows));
+        return Result(std::move(result.columns), std::move(rows));
+    }
+};
+
+mysql_protocol_type mysql_protocol(Transport transport) noexcept {
+    switch (transport) {
+        case Transport::tcp: return MYSQL_PROTOCOL_TCP;
+        case Transport::unix_socket: return MYSQL_PROTOCOL_SOCKET;
+        case Transport::named_pipe: return MYSQL_PROTOCOL_PIPE;
+        case Transport::shared_memory: return MYSQL_PROTOCOL_MEMORY;
+        case Transport::automatic: break;
+    }
+    return MYSQL_PROTOCOL_DEFAULT;
+}
+
+// The client library has no options for socket buffers; the session socket is reachable only
+// through NET::fd.
+Expected<void> tune_socket(MYSQL* mysql, const ConnectionConfig& config) {
+    if (config.socket_send_buffer == 0 && config.socket_receive_buffer == 0 && !config.verify_tcp_nodelay) {
+        return {};
+    }
+    const auto fd = mysql->net.fd;
+    const auto socket_error = [](std::string message) {
+        return std::unexpected(make_error(ErrorCode::connection_failed, Operation::connect, std::move(message)));
+    };
+    const auto set_option = [fd](int level, int name, int value) {
+        return ::setsockopt(fd, level, name, reinterpret_cast<const char*>(&value), sizeof(value)) == 0;
+    };
+
+    sockaddr_storage address{};
+    socklen_t address_length = sizeof(address);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_length) != 0) {
+        return socket_error("session socket is not available for tuning");
+    }
+    if (config.socket_send_buffer != 0 && !set_option(SOL_SOCKET, SO_SNDBUF, config.socket_send_buffer)) {
+        return socket_error("failed to set SO_SNDBUF");
+    }
+    if (config.socket_receive_buffer != 0 && !set_option(SOL_SOCKET, SO_RCVBUF, config.socket_receive_buffer)) {
+        return socket_error("failed to set SO_RCVBUF");
+    }
+    if (config.verify_tcp_nodelay && (address.ss_family == AF_INET || address.ss_family == AF_INET6)) {
+        int nodelay = 0;
+        socklen_t nodelay_length = sizeof(nodelay);
+        if (::getsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char*>(&nodelay), &nodelay_length) != 0) {
+            return socket_error("failed to read TCP_NODELAY");
+        }
+        if (nodelay == 0 && !set_option(IPPROTO_TCP, TCP_NODELAY, 1)) {
+            return socket_error("failed to set TCP_NODELAY");
+        }
+    }
+    return {};
+}
+
+Expected<void> set_compression(MYSQL* mysql, const ConnectionConfig& config) {
+    if (config.compression == Compression::none) {
+        return {};
+    }
+#ifdef MYSQLW_HAS_COMPRESSION_ALGORITHMS
+    const char* algorithm = config.compression == Compression::zstd ? "zstd" : "zlib";
+    if (mysql_options(mysql, MYSQL_OPT_COMPRESSION_ALGORITHMS, algorithm) != mysql_success) {
+        return std::unexpected(make_error(ErrorCode::connection_failed, Operation::connect,
+                                         std::string("failed to enable ") + algorithm + " compression"));
+    }
+    if (config.compression == Compression::zstd && config.zstd_compression_level != 0) {
+        const auto level = config.zstd_compression_level;
+        if (mysql_options(mysql, MYSQL_OPT_ZSTD_COMPRESSION_LEVEL, &level) != mysql_success) {
+            return std::unexpected(make_error(ErrorCode::invalid_argument, Operation::connect,
+                                             "failed to set the zstd compression level"));
+        }
+    }
+#else
+    if (config.compression == Compression::zstd) {
+        return std::unexpected(make_error(ErrorCode::invalid_argument, Operation::connect,
+                                         "zstd compression needs a MySQL 8.0.18 or later client library"));
+    }
+    if (mysql_options(mysql, MYSQL_OPT_COMPRESS, nullptr) != mysql_success) {
+        return std::unexpected(make_error(ErrorCode::connection_failed, Operation::connect,
+                                         "failed to enable zlib compression"));
+    }
+#endif
+    return {};
+}
+
+mysql_ssl_mode mysql_tls_mode(TlsMode mode) noexcept {
+    switch (mode) {
+        case TlsMode::disabled: return SSL_MODE_DISABLED;
+        case TlsMode::required: return SSL_MODE_REQUIRED;
+        case TlsMode::verify_ca: return SSL_MODE_VERIFY_CA;
+        case TlsMode::verify_identity: return SSL_MODE_VERIFY_IDENTITY;
+        case TlsMode::preferred: break;
+    }
+    return SSL_MODE_PREFERRED;
+}
+
+Expected<void> set_tls(MYSQL* mysql, const ConnectionConfig& config) {
+    const auto mode = static_cast<unsigned int>(mysql_tls_mode(config.tls_mode));
+    if (mysql_options(mysql, MYSQL_OPT_SSL_MODE, &mode) != mysql_success) {
+        return std::unexpected(make_error(ErrorCode::connection_failed, Operation::connect, "failed to set the TLS mode"));
     }
+    if (config.tls_mode == TlsMode::disabled) {
+        return {};
+    }
+    const std::pair<mysql_option, const std::string*> settings[] = {
+        {MYSQL_OPT_SSL_CA, &config.tls_ca},
+        {MYSQL_OPT_SSL_CAPATH, &config.tls_ca_path},
+        {MYSQL_OPT_SSL_CERT, &config.tls_cert},
+        {MYSQL_OPT_SSL_KEY, &config.tls_key},
+        {MYSQL_OPT_SSL_CIPHER, &config.tls_cipher},
+        {MYSQL_OPT_TLS_CIPHERSUITES, &config.tls_ciphersuites},
+        {MYSQL_OPT_TLS_VERSION, &config.tls_version}
+    };
+    for (const auto& [option, value] : settings) {
+        if (!value->empty() && mysql_options(mysql, option, value->c_str()) != mysql_success) {
+            return std::unexpected(make_error(ErrorCode::invalid_argument, Operation::connect,
+                                             "invalid TLS option '" + *value + "'"));
+        }
+    }
+    return {};
+}
+
+// The newest TLS session seen by one pool's connections, as the PEM text returned by
+// mysql_get_ssl_session_data. Sessions expire on the server; a connection that offers a stale
+// one just performs a full handshake and replaces it.
+class TlsSessionCache {
+public:
+    [[nodiscard]] std::string load() const {
+        std::lock_guard lock(mutex_);
+        return session_;
+    }
+
+    void store(std::string session) {
+        std::lock_guard lock(mutex_);
+        session_ = std::move(session);
+    }
+
+    std::atomic<std::uint64_t> full_handshakes{0};
+    std::atomic<std::uint64_t> resumed_sessions{0};
+
+private:
+    std::string session_;
+    mutable std::mutex mutex_;
 };
 
-class Connection {
+// The init batch adds its own separators, and a statement that brought one too would leave an
+// empty statement in the batch, which the server rejects.
+std::string_view without_terminator(std::string_view statement) noexcept {
+    while (!statement.empty() && (statement.back() == ';' || statement.back() == ' ' || statement.back() == '\t' ||
+                                  statement.back() == '\n' || statement.back() == '\r')) {
+        statement.remove_suffix(1);
+    }
+    return statement;
+}
+
+class MysqlConnection final : public Connection {
 public:
-    explicit Connection(ConnectionConfig config) : config_(std::move(config)) {}
+    explicit MysqlConnection(ConnectionConfig config, std::shared_ptr<TlsSessionCache> tls_sessions = nullptr)
+        : config_(std::move(config)), tls_sessions_(std::move(tls_sessions)) {}
 
-    [[nodiscard]] Expected<void> connect() {
+    [[nodiscard]] Expected<void> connect() override {
         MysqlHandle mysql(mysql_init(nullptr));
         if (!mysql) {
             return std::unexpected(make_error(ErrorCode::mysql_init_failed, Operation::connect,
@@ -506,9 +1135,32 @@ public:
         mysql_options(mysql.get(), MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
         mysql_options(mysql.get(), MYSQL_OPT_READ_TIMEOUT, &read_timeout);
         mysql_options(mysql.get(), MYSQL_OPT_WRITE_TIMEOUT, &write_timeout);
+        if (config_.transport != Transport::automatic) {
+            const auto protocol = static_cast<unsigned int>(mysql_protocol(config_.transport));
+            mysql_options(mysql.get(), MYSQL_OPT_PROTOCOL, &protocol);
+        }
+        if (config_.net_buffer_length != 0) {
+            const auto length = static_cast<unsigned long>(config_.net_buffer_length);
+            mysql_options(mysql.get(), MYSQL_OPT_NET_BUFFER_LENGTH, &length);
+        }
+        if (auto compressed = set_compression(mysql.get(), config_); !compressed) {
+            return compressed;
+        }
+        if (auto secured = set_tls(mysql.get(), config_); !secured) {
+            return secured;
+        }
+#ifdef MYSQLW_HAS_TLS_SESSION_REUSE
+        if (reuses_tls_sessions()) {
+            if (const auto session = tls_sessions_->load(); !session.empty()) {
+                mysql_options(mysql.get(), MYSQL_OPT_SSL_SESSION_DATA, session.c_str());
+            }
+        }
+#endif
 
         if (mysql_real_connect(mysql.get(), config_.host.c_str(), config_.user.c_str(), config_.password.c_str(),
-                               config_.database.c_str(), config_.port, nullptr, 0) == nullptr) {
+                               config_.database.c_str(), config_.port,
+                               config_.unix_socket.empty() ? nullptr : config_.unix_socket.c_str(),
+                               config_.init_statements.size() > 1 ? CLIENT_MULTI_STATEMENTS : 0) == nullptr) {
             return std::unexpected(make_mysql_error(ErrorCode::connection_failed, Operation::connect, mysql.get(),
                                                    "failed to connect to MySQL"));
         }
@@ -518,11 +1170,17 @@ public:
                                                    "failed to set MySQL charset"));
         }
 
+        if (auto tuned = tune_socket(mysql.get(), config_); !tuned) {
+            return tuned;
+        }
+        record_tls_session(mysql.get());
+
+        statements_.clear();
         mysql_ = std::move(mysql);
         return {};
     }
 
-    [[nodiscard]] Expected<void> ping() {
+    [[nodiscard]] Expected<void> ping() override {
         std::lock_guard lock(mutex_);
         if (!mysql_) {
             return std::unexpected(make_error(ErrorCode::connection_lost, Operation::ping, "connection is not open"));
@@ -534,7 +1192,7 @@ public:
         return {};
     }
 
-    [[nodiscard]] Expected<Result> query(std::string_view sql) {
+    [[nodiscard]] Expected<Result> query(std::string_view sql) override {
         std::lock_guard lock(mutex_);
         if (!mysql_) {
             return std::unexpected(make_error(ErrorCode::connection_lost, Operation::query, "connection is not open"));
@@ -561,13 +1219,8 @@ public:
         decode_kinds.reserve(field_count);
 
         for (unsigned int index = 0; index < field_count; ++index) {
-            columns.push_back(Column{
-                .name = field_name(fields[index]),
-                .type = column_type_from_field(fields[index]),
-                .nullable = (fields[index].flags & NOT_NULL_FLAG) == 0,
-                .unsigned_value = (fields[index].flags & UNSIGNED_FLAG) != 0
-            });
-            decode_kinds.push_back(decode_kind(fields[index]));
+            columns.push_back(detail::make_column(fields[index]));
+            decode_kinds.push_back(detail::decode_kind(fields[index]));
         }
 
         std::vector<Result::RowStorage> rows;
@@ -575,41 +1228,10 @@ public:
         while ((mysql_row = mysql_fetch_row(result.get())) != nullptr) {
             unsigned long* lengths = mysql_fetch_lengths(result.get());
             Result::RowStorage row;
-            row.reserve(field_count);
-            for (unsigned int index = 0; index < field_count; ++index) {
-                if (mysql_row[index] == nullptr) {
-                    row.emplace_back(nullptr);
-                    continue;
-                }
-
-                const std::string_view cell(mysql_row[index], lengths[index]);
-                try {
-                    switch (decode_kinds[index]) {
-                        case FieldDecode::signed_integer:
-                            row.emplace_back(static_cast<std::int64_t>(std::stoll(std::string(cell))));
-                            break;
-                        case FieldDecode::unsigned_integer:
-                            row.emplace_back(static_cast<std::uint64_t>(std::stoull(std::string(cell))));
-                            break;
-                        case FieldDecode::floating:
-                            row.emplace_back(std::stod(std::string(cell)));
-                            break;
-                        case FieldDecode::blob: {
-                            Blob blob;
-                            blob.reserve(cell.size());
-                            for (unsigned char byte : cell) {
-                                blob.push_back(static_cast<std::byte>(byte));
-                            }
-                            row.emplace_back(std::move(blob));
-                            break;
-                        }
-                        case FieldDecode::text:
-                            row.emplace_back(std::string(cell));
-                            break;
-                    }
-                } catch (const std::exception& ex) {
-                    return std::unexpected(make_error(ErrorCode::result_fetch_failed, Operation::fetch, ex.what()));
-                }
+            try {
+                detail::decode_text_row(decode_kinds, mysql_row, lengths, row);
+            } catch (const std::exception& ex) {
+                return std::unexpected(make_error(ErrorCode::result_fetch_failed, Operation::fetch, ex.what()));
             }
             rows.push_back(std::move(row));
         }
@@ -617,7 +1239,66 @@ public:
         return Result(std::move(columns), std::move(rows));
     }
 
-    [[nodiscard]] Expected<ExecuteResult> execute(std::string_view sql) {
+    [[nodiscard]] Expected<void> stream(std::string_view sql, RowSink& sink) override {
+        std::lock_guard lock(mutex_);
+        if (!mysql_) {
+            return std::unexpected(make_error(ErrorCode::connection_lost, Operation::query, "connection is not open"));
+        }
+        if (mysql_real_query(mysql_.get(), sql.data(), static_cast<unsigned long>(sql.size())) != mysql_success) {
+            return std::unexpected(make_mysql_error(ErrorCode::execute_failed, Operation::query, mysql_.get(),
+                                                   "query failed"));
+        }
+
+        // Unbuffered: each row is decoded straight out of the network buffer. Freeing the handle
+        // early drains whatever a stopped sink left unread.
+        MetadataHandle result(mysql_use_result(mysql_.get()));
+        if (!result) {
+            if (mysql_field_count(mysql_.get()) == 0) {
+                return sink.begin({});
+            }
+            return std::unexpected(make_mysql_error(ErrorCode::result_metadata_failed, Operation::fetch, mysql_.get(),
+                                                   "failed to read query result"));
+        }
+
+        const auto field_count = mysql_num_fields(result.get());
+        MYSQL_FIELD* fields = mysql_fetch_fields(result.get());
+        std::vector<Column> columns;
+        columns.reserve(field_count);
+        std::vector<FieldDecode> decode_kinds;
+        decode_kinds.reserve(field_count);
+        for (unsigned int index = 0; index < field_count; ++index) {
+            columns.push_back(detail::make_column(fields[index]));
+            decode_kinds.push_back(detail::decode_kind(fields[index]));
+        }
+        if (auto begun = sink.begin(columns); !begun) {
+            return begun;
+        }
+
+        std::vector<ValueView> views(field_count);
+        MYSQL_ROW mysql_row = nullptr;
+        while ((mysql_row = mysql_fetch_row(result.get())) != nullptr) {
+            const unsigned long* lengths = mysql_fetch_lengths(result.get());
+            try {
+                for (unsigned int index = 0; index < field_count; ++index) {
+                    views[index] = mysql_row[index] == nullptr
+                        ? ValueView{nullptr}
+                        : detail::decode_text_view(decode_kinds[index], std::string_view(mysql_row[index], lengths[index]));
+                }
+            } catch (const std::exception& ex) {
+                return std::unexpected(make_error(ErrorCode::result_fetch_failed, Operation::fetch, ex.what()));
+            }
+            if (auto accepted = sink.row(views); !accepted) {
+                return accepted;
+            }
+        }
+        if (mysql_errno(mysql_.get()) != 0) {
+            return std::unexpected(make_mysql_error(ErrorCode::result_fetch_failed, Operation::fetch, mysql_.get(),
+                                                   "failed to fetch result row"));
+        }
+        return {};
+    }
+
+    [[nodiscard]] Expected<ExecuteResult> execute(std::string_view sql) override {
         std::lock_guard lock(mutex_);
         if (!mysql_) {
             return std::unexpected(make_error(ErrorCode::connection_lost, Operation::execute, "connection is not open"));
@@ -632,12 +1313,92 @@ public:
         };
     }
 
-    [[nodiscard]] Expected<Statement> prepare(std::string_view sql) {
+    // Sends the statements as one batch; the connection was opened with multi-statement support
+    // for it, which is switched off again before the connection is used.
+    [[nodiscard]] Expected<void> initialize_session(std::span<const std::string> statements) override {
+        if (statements.size() < 2) {
+            return Connection::initialize_session(statements);
+        }
+        std::lock_guard lock(mutex_);
+        if (!mysql_) {
+            return std::unexpected(make_error(ErrorCode::connection_lost, Operation::execute, "connection is not open"));
+        }
+        std::string batch;
+        for (const auto& statement : statements) {
+            batch += without_terminator(statement);
+            batch += ';';
+        }
+        if (mysql_real_query(mysql_.get(), batch.data(), static_cast<unsigned long>(batch.size())) != mysql_success) {
+            return std::unexpected(make_mysql_error(ErrorCode::execute_failed, Operation::execute, mysql_.get(),
+                                                   "init statement failed"));
+        }
+        // Each statement leaves one result; an error ends the batch.
+        for (std::size_t index = 0;; ++index) {
+            MetadataHandle discarded(mysql_store_result(mysql_.get()));
+            if (index < statements.size()) {
+                track_session_set(statements[index], true);
+            }
+            const auto next = mysql_next_result(mysql_.get());
+            if (next > 0) {
+                return std::unexpected(make_mysql_error(ErrorCode::execute_failed, Operation::execute, mysql_.get(),
+                                                       "init statement failed"));
+            }
+            if (next < 0) {
+                break;
+            }
+        }
+        if (mysql_set_server_option(mysql_.get(), MYSQL_OPTION_MULTI_STATEMENTS_OFF) != mysql_success) {
+            return std::unexpected(make_mysql_error(ErrorCode::execute_failed, Operation::execute, mysql_.get(),
+                                                   "failed to disable multi-statements"));
+        }
+        return {};
+    }
+
+    [[nodiscard]] Expected<PreparedStatement*> prepare(std::string_view sql) override {
+        return prepare_with_hash(sql, detail::sql_hash(sql));
+    }
+
+    [[nodiscard]] Expected<PreparedStatement*> prepare_with_hash(std::string_view sql, std::size_t hash) override {
+        return prepare_cached(sql, hash, false);
+    }
+
+    [[nodiscard]] Expected<PreparedStatement*> prepare_pinned(std::string_view sql) override {
+        return prepare_cached(sql, detail::sql_hash(sql), true);
+    }
+
+    [[nodiscard]] Expected<std::string> escape(std::string_view value) override {
+        std::lock_guard lock(mutex_);
+        if (!mysql_) {
+            return std::unexpected(make_error(ErrorCode::connection_lost, Operation::query, "connection is not open"));
+        }
+        std::string output;
+        output.resize(value.size() * 2 + 1);
+        const auto escaped_length = mysql_real_escape_string(mysql_.get(), output.data(), value.data(),
+                                                            static_cast<unsigned long>(value.size()));
+        output.resize(escaped_length);
+        return output;
+    }
+
+private:
+    [[nodiscard]] Expected<PreparedStatement*> prepare_cached(std::string_view sql, std::size_t hash, bool pin) {
         std::lock_guard lock(mutex_);
         if (!mysql_) {
             return std::unexpected(make_error(ErrorCode::connection_lost, Operation::prepare, "connection is not open"));
         }
 
+        // Reuse a statement already prepared on this session, keeping the cache in LRU order.
+        // Hashes are compared first, so a miss rarely compares SQL text.
+        if (const auto cached = std::ranges::find_if(statements_, [&](const Statement& statement) {
+                return statement.matches(sql, hash);
+            });
+            cached != statements_.end()) {
+            statements_.splice(statements_.begin(), statements_, cached);
+            if (pin) {
+                statements_.front().pin();
+            }
+            return &statements_.front();
+        }
+
         StmtHandle stmt(mysql_stmt_init(mysql_.get()));
         if (!stmt) {
             return std::unexpected(make_mysql_error(ErrorCode::statement_init_failed, Operation::prepare, mysql_.get(),
@@ -650,63 +1411,93 @@ public:
                                                   "failed to prepare statement"));
         }
 
-        return Statement(std::move(stmt), sql_text);
+        // The least recently used statement that is not pinned makes room.
+        if (statements_.size() >= std::max<std::size_t>(config_.statement_cache_size, 1)) {
+            const auto victim = std::ranges::find_if(statements_.rbegin(), statements_.rend(),
+                                                     [](const Statement& statement) { return !statement.pinned(); });
+            if (victim != statements_.rend()) {
+                statements_.erase(std::next(victim).base());
+            }
+        }
+        statements_.emplace_front(std::move(stmt), sql_text, hash);
+        if (pin) {
+            statements_.front().pin();
+        }
+        return &statements_.front();
     }
 
-    [[nodiscard]] Expected<void> begin_transaction() {
-        auto result = execute("START TRANSACTION");
-        if (!result) {
-            return std::unexpected(result.error());
-        }
-        in_transaction_.store(true, std::memory_order_release);
-        return {};
+    [[nodiscard]] bool reuses_tls_sessions() const noexcept {
+        return tls_sessions_ && config_.tls_session_reuse && config_.tls_mode != TlsMode::disabled;
     }
 
-    [[nodiscard]] Expected<void> commit() {
-        auto result = execute("COMMIT");
-        if (!result) {
-            return std::unexpected(result.error());
+    void record_tls_session(MYSQL* mysql) {
+        if (!tls_sessions_ || mysql_get_ssl_cipher(mysql) == nullptr) {
+            return;
         }
-        in_transaction_.store(false, std::memory_order_release);
-        return {};
+#ifdef MYSQLW_HAS_TLS_SESSION_REUSE
+        if (mysql_get_ssl_session_reused(mysql)) {
+            tls_sessions_->resumed_sessions.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (reuses_tls_sessions()) {
+            unsigned int length = 0;
+            if (void* session = mysql_get_ssl_session_data(mysql, 0, &length); session != nullptr) {
+                tls_sessions_->store(std::string(static_cast<const char*>(session), length));
+                mysql_free_ssl_session_data(mysql, session);
+            }
+        }
+#endif
+        tls_sessions_->full_handshakes.fetch_add(1, std::memory_order_relaxed);
     }
 
-    [[nodiscard]] Expected<void> rollback() {
-        auto result = execute("ROLLBACK");
-        if (!result) {
-            return std::unexpected(result.error());
-        }
-        in_transaction_.store(false, std::memory_order_release);
-        return {};
+    ConnectionConfig config_;
+    std::shared_ptr<TlsSessionCache> tls_sessions_;
+    MysqlHandle mysql_;
+    // Most recently used first. Declared after mysql_ so statement handles are closed before
+    // their connection.
+    std::list<Statement> statements_;
+    mutable std::mutex mutex_;
+};
+
+// SQL registered with Database::register_statement, in registration order. Entries are never
+// removed and connections prepare them pinned, so a connection's coverage is the number of
+// leading entries it has prepared.
+class StatementRegistry {
+public:
+    [[nodiscard]] std::vector<std::string> snapshot() const {
+        std::lock_guard lock(mutex_);
+        return statements_;
     }
 
-    [[nodiscard]] bool in_transaction() const noexcept {
-        return in_transaction_.load(std::memory_order_acquire);
+    [[nodiscard]] std::size_t size() const {
+        std::lock_guard lock(mutex_);
+        return statements_.size();
     }
 
-    [[nodiscard]] Expected<std::string> escape(std::string_view value) {
+    [[nodiscard]] bool contains(std::string_view sql) const {
         std::lock_guard lock(mutex_);
-        if (!mysql_) {
-            return std::unexpected(make_error(ErrorCode::connection_lost, Operation::query, "connection is not open"));
+        return std::find(statements_.begin(), statements_.end(), sql) != statements_.end();
+    }
+
+    // False when sql is already registered.
+    bool add(std::string sql) {
+        std::lock_guard lock(mutex_);
+        if (std::find(statements_.begin(), statements_.end(), sql) != statements_.end()) {
+            return false;
         }
-        std::string output;
-        output.resize(value.size() * 2 + 1);
-        const auto escaped_length = mysql_real_escape_string(mysql_.get(), output.data(), value.data(),
-                                                            static_cast<unsigned long>(value.size()));
-        output.resize(escaped_length);
-        return output;
+        statements_.push_back(std::move(sql));
+        return true;
     }
 
 private:
-    ConnectionConfig config_;
-    MysqlHandle mysql_;
+    std::vector<std::string> statements_;
     mutable std::mutex mutex_;
-    std::atomic_bool in_transaction_{false};
 };
 
 class ConnectionPoolImpl {
 public:
-    explicit ConnectionPoolImpl(ConnectionConfig config) : config_(std::move(config)) {
+    ConnectionPoolImpl(ConnectionConfig config, ConnectionFactory factory, std::shared_ptr<const StatementRegistry> registry)
+        : config_(std::move(config)), factory_(std::move(factory)), registry_(std::move(registry)) {
         if (config_.max_pool_size == 0) {
             config_.max_pool_size = 1;
         }
@@ -722,6 +1513,7 @@ public:
             if (!created) {
                 return std::unexpected(created.error());
             }
+            prepared_registry_[created->get()] = catch_up(**created, {});
             idle_.push(std::move(*created));
         }
         return {};
@@ -731,7 +1523,7 @@ public:
         std::unique_lock lock(mutex_);
         const auto deadline = std::chrono::steady_clock::now() + config_.acquire_timeout;
 
-        while (idle_.empty() && active_connections_ >= config_.max_pool_size && !stopped_) {
+        while (idle_.empty() && active_connections_ + opening_connections_ >= config_.max_pool_size && !stopped_) {
             if (cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
                 return std::unexpected(make_error(ErrorCode::pool_timeout, Operation::query,
                                                  "timed out waiting for a MySQL connection"));
@@ -763,12 +1555,89 @@ public:
                 release(std::move(connection));
                 return std::unexpected(replacement.error());
             }
+            {
+                std::lock_guard relock(mutex_);
+                prepared_registry_.erase(connection.get());
+            }
             connection = std::move(*replacement);
         }
 
         return ConnectionLease(std::move(connection), this);
     }
 
+    // Opens one connection toward target idle-or-leased connections and adds it to the idle queue.
+    // Returns false once the pool holds target connections or is stopped.
+    [[nodiscard]] Expected<bool> warm_one(std::size_t target) {
+        {
+            std::lock_guard lock(mutex_);
+            if (stopped_ || idle_.size() + active_connections_ + opening_connections_ >= std::min(target, config_.max_pool_size)) {
+                return false;
+            }
+            ++opening_connections_;
+        }
+        auto created = create_connection_unlocked();
+        const auto covered = created ? catch_up(**created, {}) : RegistryCoverage{};
+        {
+            std::lock_guard lock(mutex_);
+            --opening_connections_;
+            if (created && !stopped_) {
+                prepared_registry_[created->get()] = covered;
+                idle_.push(std::move(*created));
+            }
+        }
+        cv_.notify_one();
+        if (!created) {
+            return std::unexpected(created.error());
+        }
+        return true;
+    }
+
+    // Prepares the registry entries each idle connection is missing. The connections count as
+    // leased meanwhile, so callers do not pick them up half prepared.
+    void catch_up_idle() {
+        std::vector<std::pair<std::shared_ptr<Connection>, RegistryCoverage>> taken;
+        {
+            std::lock_guard lock(mutex_);
+            while (!idle_.empty()) {
+                auto connection = std::move(idle_.front());
+                idle_.pop();
+                const auto found = prepared_registry_.find(connection.get());
+                taken.emplace_back(std::move(connection), found == prepared_registry_.end() ? RegistryCoverage{} : found->second);
+            }
+            active_connections_ += taken.size();
+        }
+        for (auto& [connection, covered] : taken) {
+            covered = catch_up(*connection, covered);
+        }
+        {
+            std::lock_guard lock(mutex_);
+            for (auto& [connection, covered] : taken) {
+                if (stopped_) {
+                    prepared_registry_.erase(connection.get());
+                    continue;
+                }
+                prepared_registry_[connection.get()] = covered;
+                idle_.push(std::move(connection));
+            }
+            active_connections_ -= taken.size();
+        }
+        cv_.notify_all();
+    }
+
+    [[nodiscard]] std::size_t covered_connections() const {
+        const auto registered = registry_->size();
+        std::lock_guard lock(mutex_);
+        if (registered == 0) {
+            return idle_.size() + active_connections_;
+        }
+        return static_cast<std::size_t>(std::count_if(prepared_registry_.begin(), prepared_registry_.end(),
+            [registered](const auto& entry) { return entry.second.prepared >= registered; }));
+    }
+
+    [[nodiscard]] std::uint64_t registry_prepare_failures() const noexcept {
+        return registry_prepare_failures_.load(std::memory_order_relaxed);
+    }
+
     void release(std::shared_ptr<Connection> connection) noexcept {
         if (!connection) {
             return;
@@ -778,10 +1647,31 @@ public:
             (void)connection->rollback();
         }
 
+        // Connections opened on the request path, including replacements for ones that failed
+        // their ping, catch up with the registry here rather than on a later request.
+        std::optional<RegistryCoverage> caught_up;
+        if (const auto registered = registry_->size(); registered > 0) {
+            RegistryCoverage coverage;
+            {
+                std::lock_guard lock(mutex_);
+                if (const auto found = prepared_registry_.find(connection.get()); found != prepared_registry_.end()) {
+                    coverage = found->second;
+                }
+            }
+            if (coverage.attempted < registered) {
+                caught_up = catch_up(*connection, coverage);
+            }
+        }
+
         {
             std::lock_guard lock(mutex_);
             if (!stopped_ && idle_.size() < config_.max_pool_size) {
+                if (caught_up) {
+                    prepared_registry_[connection.get()] = *caught_up;
+                }
                 idle_.push(std::move(connection));
+            } else {
+                prepared_registry_.erase(connection.get());
             }
             if (active_connections_ > 0) {
                 --active_connections_;
@@ -796,6 +1686,7 @@ public:
             stopped_ = true;
             std::queue<std::shared_ptr<Connection>> empty;
             idle_.swap(empty);
+            prepared_registry_.clear();
         }
         cv_.notify_all();
     }
@@ -812,45 +1703,357 @@ public:
     }
 
 private:
+    // Leading registry entries prepared on a connection, and the registry size when it last
+    // tried, so a failed prepare is retried only once more statements are registered.
+    struct RegistryCoverage {
+        std::size_t prepared = 0;
+        std::size_t attempted = 0;
+    };
+
     ConnectionConfig config_;
+    ConnectionFactory factory_;
+    std::shared_ptr<const StatementRegistry> registry_;
     std::queue<std::shared_ptr<Connection>> idle_;
+    // Connections opened on the request path are absent until they are released.
+    std::unordered_map<const Connection*, RegistryCoverage> prepared_registry_;
+    std::atomic<std::uint64_t> registry_prepare_failures_{0};
     mutable std::mutex mutex_;
     std::condition_variable cv_;
     bool stopped_ = false;
     std::size_t active_connections_ = 0;
+    // Connects in progress on the warm-up thread; they count toward max_pool_size.
+    std::size_t opening_connections_ = 0;
     std::atomic_size_t created_connections_{0};
     std::atomic_size_t failed_connections_{0};
 
+    // Prepares and pins the registry entries after the ones already covered, stopping at the
+    // first failure.
+    RegistryCoverage catch_up(Connection& connection, RegistryCoverage coverage) {
+        const auto statements = registry_->snapshot();
+        for (; coverage.prepared < statements.size(); ++coverage.prepared) {
+            if (!connection.prepare_pinned(statements[coverage.prepared])) {
+                registry_prepare_failures_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        coverage.attempted = statements.size();
+        return coverage;
+    }
+
     [[nodiscard]] Expected<std::shared_ptr<Connection>> create_connection_locked() {
-        auto connection = std::make_shared<Connection>(config_);
+        return create_connection_unlocked();
+    }
+
+    [[nodiscard]] Expected<std::shared_ptr<Connection>> create_connection_unlocked() {
+        std::shared_ptr<Connection> connection = factory_(config_);
+        if (!connection) {
+            failed_connections_.fetch_add(1, std::memory_order_relaxed);
+            return std::unexpected(make_error(ErrorCode::connection_failed, Operation::connect,
+                                             "connection factory returned no connection"));
+        }
         if (auto connected = connection->connect(); !connected) {
             failed_connections_.fetch_add(1, std::memory_order_relaxed);
             return std::unexpected(connected.error());
         }
+        if (!config_.init_statements.empty()) {
+            if (auto initialized = connection->initialize_session(config_.init_statements); !initialized) {
+                failed_connections_.fetch_add(1, std::memory_order_relaxed);
+                return std::unexpected(initialized.error());
+            }
+        }
         created_connections_.fetch_add(1, std::memory_order_relaxed);
         return connection;
     }
+};
 
-    [[nodiscard]] Expected<std::shared_ptr<Connection>> create_connection_unlocked() {
-        auto connection = std::make_shared<Connection>(config_);
-        if (auto connected = connection->connect(); !connected) {
-            failed_connections_.fetch_add(1, std::memory_order_relaxed);
-            return std::unexpected(connected.error());
+ConnectionLease::~ConnectionLease() {
+    reset();
+}
+
+void ConnectionLease::reset() noexcept {
+    if (pool_ != nullptr && connection_) {
+        pool_->release(std::move(connection_));
+    }
+    pool_ = nullptr;
+}
+
+// Session variables that keep a value until the next SET, so setting one to the value it already
+// has does nothing. One-shot variables such as insert_id or timestamp are consumed or reread by
+// later statements and are never followed.
+constexpr std::array<std::string_view, 36> idempotent_session_variables{
+    "autocommit", "big_tables", "character_set_client", "character_set_connection", "character_set_results",
+    "collation_connection", "default_week_format", "div_precision_increment", "explicit_defaults_for_timestamp",
+    "foreign_key_checks", "group_concat_max_len", "innodb_lock_wait_timeout", "innodb_strict_mode",
+    "interactive_timeout", "join_buffer_size", "lc_time_names", "lock_wait_timeout", "long_query_time",
+    "max_execution_time", "max_heap_table_size", "max_join_size", "net_read_timeout", "net_write_timeout",
+    "optimizer_switch", "sort_buffer_size", "sql_big_selects", "sql_mode", "sql_notes", "sql_safe_updates",
+    "sql_select_limit", "sql_warnings", "time_zone", "tmp_table_size", "transaction_isolation",
+    "unique_checks", "wait_timeout"};
+
+static_assert(std::ranges::is_sorted(idempotent_session_variables));
+
+bool idempotent_session_variable(std::string_view name) noexcept {
+    return std::ranges::binary_search(idempotent_session_variables, name);
+}
+
+struct SessionAssignment {
+    std::string name;
+    // Normalized literal, or nullopt for a DEFAULT value or a variable outside the session scope.
+    std::optional<std::string> value;
+};
+
+// Reads the "SET name = literal, ..." statements the session variable cache follows.
+class SetParser {
+public:
+    explicit SetParser(std::string_view sql) noexcept : sql_(sql) {}
+
+    [[nodiscard]] bool keyword(std::string_view word) noexcept {
+        skip_space();
+        if (sql_.size() - pos_ < word.size() || (sql_.size() - pos_ > word.size() && identifier_char(sql_[pos_ + word.size()]))) {
+            return false;
+        }
+        for (std::size_t index = 0; index < word.size(); ++index) {
+            if (lower(sql_[pos_ + index]) != lower(word[index])) {
+                return false;
+            }
+        }
+        pos_ += word.size();
+        return true;
+    }
+
+    // nullopt when the statement is a SET this parser does not follow.
+    [[nodiscard]] std::optional<std::vector<SessionAssignment>> assignments() {
+        std::vector<SessionAssignment> parsed;
+        do {
+            bool session = true;
+            if (keyword("GLOBAL") || keyword("PERSIST") || keyword("PERSIST_ONLY")) {
+                session = false;
+            } else if (!keyword("SESSION")) {
+                (void)keyword("LOCAL");
+            }
+            skip_space();
+            auto name = identifier();
+            if (name.empty() && sql_.substr(pos_).starts_with("@@")) {
+                pos_ += 2;
+                name = identifier();
+                if (pos_ < sql_.size() && sql_[pos_] == '.') {
+                    session = name == "session" || name == "local";
+                    ++pos_;
+                    name = identifier();
+                }
+            }
+            skip_space();
+            if (name.empty() || pos_ == sql_.size()) {
+                return std::nullopt;
+            }
+            if (sql_[pos_] == ':') {
+                ++pos_;
+            }
+            if (pos_ == sql_.size() || sql_[pos_] != '=') {
+                return std::nullopt;
+            }
+            ++pos_;
+            auto value = literal();
+            if (!value) {
+                return std::nullopt;
+            }
+            parsed.push_back(SessionAssignment{
+                .name = std::move(name),
+                .value = session && *value != "default" ? std::move(value) : std::nullopt
+            });
+            skip_space();
+        } while (pos_ < sql_.size() && sql_[pos_++] == ',');
+        skip_space();
+        if (pos_ < sql_.size() && !(sql_[pos_] == ';' && (++pos_, skip_space(), pos_ == sql_.size()))) {
+            return std::nullopt;
+        }
+        return parsed;
+    }
+
+private:
+    std::string_view sql_;
+    std::size_t pos_ = 0;
+
+    static char lower(char c) noexcept {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static bool identifier_char(char c) noexcept {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$';
+    }
+
+    void skip_space() noexcept {
+        while (pos_ < sql_.size() && (sql_[pos_] == ' ' || sql_[pos_] == '\t' || sql_[pos_] == '\n' || sql_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    std::string identifier() {
+        std::string name;
+        while (pos_ < sql_.size() && identifier_char(sql_[pos_])) {
+            name += lower(sql_[pos_++]);
+        }
+        return name;
+    }
+
+    // A quoted string without escapes, kept with its quotes, or a lowercased bare word or number.
+    std::optional<std::string> literal() {
+        skip_space();
+        if (pos_ == sql_.size()) {
+            return std::nullopt;
+        }
+        if (const auto quote = sql_[pos_]; quote == '\'' || quote == '"') {
+            const auto end = sql_.find(quote, pos_ + 1);
+            if (end == std::string_view::npos || sql_.substr(pos_ + 1, end - pos_ - 1).find('\\') != std::string_view::npos ||
+                (end + 1 < sql_.size() && sql_[end + 1] == quote)) {
+                return std::nullopt;
+            }
+            auto text = "'" + std::string(sql_.substr(pos_ + 1, end - pos_ - 1)) + "'";
+            pos_ = end + 1;
+            return text;
+        }
+        std::string word;
+        while (pos_ < sql_.size() && (identifier_char(sql_[pos_]) || sql_[pos_] == '.' || sql_[pos_] == '-' || sql_[pos_] == '+')) {
+            word += lower(sql_[pos_++]);
+        }
+        if (word.empty()) {
+            return std::nullopt;
+        }
+        return word;
+    }
+};
+
+Expected<PreparedStatement*> prepare_counted(Connection& connection, StatementKey key, ClientMetrics& metrics) {
+    auto statement = connection.prepare_with_hash(key.sql, key.hash);
+    if (!statement) {
+        metrics.prepare_failures.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        metrics.prepared_statements.fetch_add(1, std::memory_order_relaxed);
+    }
+    return statement;
+}
+
+Expected<PreparedStatement*> prepare_counted(Connection& connection, std::string_view sql, ClientMetrics& metrics) {
+    return prepare_counted(connection, StatementKey{.sql = sql, .hash = detail::sql_hash(sql)}, metrics);
+}
+
+// Descriptor calls: always prepared, with the parameters bound from views.
+Expected<Result> run_query(Connection& connection, StatementKey key, std::span<const ValueView> values,
+                           ClientMetrics& metrics) {
+    const auto started = std::chrono::steady_clock::now();
+    auto statement = prepare_counted(connection, key, metrics);
+    auto result = statement ? (*statement)->query_views(values) : std::unexpected(statement.error());
+    metrics.query_latency.record(std::chrono::steady_clock::now() - started);
+    connection.track_session_set(key.sql, false);
+    return result;
+}
+
+Expected<ExecuteResult> run_execute(Connection& connection, StatementKey key, std::span<const ValueView> values,
+                                    ClientMetrics& metrics) {
+    const auto started = std::chrono::steady_clock::now();
+    auto statement = prepare_counted(connection, key, metrics);
+    auto result = statement ? (*statement)->execute_views(values) : std::unexpected(statement.error());
+    metrics.execute_latency.record(std::chrono::steady_clock::now() - started);
+    connection.track_session_set(key.sql, false);
+    return result;
+}
+
+Expected<void> run_query_into(Connection& connection, std::string_view sql, std::span<const ValueView> values,
+                              const detail::RowTarget& target, ClientMetrics& metrics) {
+    const auto started = std::chrono::steady_clock::now();
+    auto statement = prepare_counted(connection, sql, metrics);
+    auto result = statement ? (*statement)->query_into(values, target) : std::unexpected(statement.error());
+    metrics.query_latency.record(std::chrono::steady_clock::now() - started);
+    connection.track_session_set(sql, false);
+    return result;
+}
+
+Expected<Result> run_query(Connection& connection, std::string_view sql, std::vector<Value> values,
+                           ClientMetrics& metrics) {
+    const bool text = values.empty();
+    if (text && connection.redundant_session_set(sql)) {
+        metrics.skipped_session_sets.fetch_add(1, std::memory_order_relaxed);
+        return Result{};
+    }
+    const auto started = std::chrono::steady_clock::now();
+    auto result = [&]() -> Expected<Result> {
+        if (text) {
+            return connection.query(sql);
+        }
+        auto statement = prepare_counted(connection, sql, metrics);
+        if (!statement) {
+            return std::unexpected(statement.error());
         }
-        created_connections_.fetch_add(1, std::memory_order_relaxed);
-        return connection;
-    }
-};
+        return (*statement)->query(std::move(values));
+    }();
+    metrics.query_latency.record(std::chrono::steady_clock::now() - started);
+    connection.track_session_set(sql, text && result.has_value());
+    return result;
+}
 
-ConnectionLease::~ConnectionLease() {
-    reset();
+Expected<void> run_stream(Connection& connection, std::string_view sql, RowSink& sink, std::vector<Value> values,
+                          ClientMetrics& metrics) {
+    const auto started = std::chrono::steady_clock::now();
+    auto result = [&]() -> Expected<void> {
+        if (values.empty()) {
+            return connection.stream(sql, sink);
+        }
+        auto statement = prepare_counted(connection, sql, metrics);
+        if (!statement) {
+            return std::unexpected(statement.error());
+        }
+        return (*statement)->stream(std::move(values), sink);
+    }();
+    metrics.query_latency.record(std::chrono::steady_clock::now() - started);
+    connection.track_session_set(sql, false);
+    return result;
 }
 
-void ConnectionLease::reset() noexcept {
-    if (pool_ != nullptr && connection_) {
-        pool_->release(std::move(connection_));
+Expected<ExecuteResult> run_execute(Connection& connection, std::string_view sql, std::vector<Value> values,
+                                    ClientMetrics& metrics) {
+    const bool text = values.empty();
+    if (text && connection.redundant_session_set(sql)) {
+        metrics.skipped_session_sets.fetch_add(1, std::memory_order_relaxed);
+        return ExecuteResult{};
     }
-    pool_ = nullptr;
+    const auto started = std::chrono::steady_clock::now();
+    auto result = [&]() -> Expected<ExecuteResult> {
+        if (text) {
+            return connection.execute(sql);
+        }
+        auto statement = prepare_counted(connection, sql, metrics);
+        if (!statement) {
+            return std::unexpected(statement.error());
+        }
+        return (*statement)->execute(std::move(values));
+    }();
+    metrics.execute_latency.record(std::chrono::steady_clock::now() - started);
+    connection.track_session_set(sql, text && result.has_value());
+    return result;
+}
+
+// Runs one call and, when a recorder is attached, appends it to the traffic log. issued is the
+// caller-visible start (submission time for async calls); run receives the parameters.
+template <typename T, typename Run>
+Expected<T> record_call(TrafficRecorder* recorder, TrafficApi api, std::uint64_t session, std::string_view sql,
+                        std::vector<Value> values, std::optional<std::chrono::steady_clock::time_point> issued,
+                        Run&& run) {
+    if (recorder == nullptr) {
+        return run(std::move(values));
+    }
+    const auto started = issued.value_or(std::chrono::steady_clock::now());
+    auto params = values;
+    auto result = run(std::move(values));
+    recorder->append(TrafficRecord{
+        .timestamp = started - recorder->started(),
+        .duration = std::chrono::steady_clock::now() - started,
+        .api = api,
+        .ok = result.has_value(),
+        .session = session,
+        .sql = std::string(sql),
+        .params = std::move(params)
+    });
+    return result;
 }
 
 struct Task {
@@ -868,6 +2071,168 @@ DbError cancelled_error() {
 
 } // namespace
 
+double LatencyHistogram::quantile(double q) const noexcept {
+    if (count == 0) {
+        return 0.0;
+    }
+    const auto rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(count);
+    std::uint64_t seen = 0;
+    for (std::size_t index = 0; index < bucket_counts.size(); ++index) {
+        const auto in_bucket = bucket_counts[index];
+        if (in_bucket != 0 && static_cast<double>(seen + in_bucket) >= rank) {
+            if (index == bucket_bounds.size()) {
+                return bucket_bounds.back();
+            }
+            const auto lower = index == 0 ? 0.0 : bucket_bounds[index - 1];
+            const auto fraction = (rank - static_cast<double>(seen)) / static_cast<double>(in_bucket);
+            return lower + (bucket_bounds[index] - lower) * fraction;
+        }
+        seen += in_bucket;
+    }
+    return bucket_bounds.back();
+}
+
+Expected<void> PreparedStatement::stream(std::vector<Value> values, RowSink& sink) {
+    auto result = query(std::move(values));
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    return stream_result(*result, sink);
+}
+
+Expected<Result> PreparedStatement::query_views(std::span<const ValueView> values) {
+    return query(to_values(values));
+}
+
+Expected<ExecuteResult> PreparedStatement::execute_views(std::span<const ValueView> values) {
+    return execute(to_values(values));
+}
+
+Expected<void> PreparedStatement::query_into(std::span<const ValueView> values, const detail::RowTarget& target) {
+    auto result = query(to_values(values));
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    const auto result_columns = result->columns();
+    auto columns = map_members(target, result_columns.size(), [result_columns](std::size_t index) {
+        return std::string_view(result_columns[index].name);
+    });
+    if (!columns) {
+        return std::unexpected(columns.error());
+    }
+    for (std::size_t row_index = 0; row_index < result->row_count(); ++row_index) {
+        const auto source = result->row(row_index);
+        void* row = target.append(target.rows);
+        for (std::size_t index = 0; index < columns->size(); ++index) {
+            const auto column = (*columns)[index];
+            if (auto assigned = assign_member(target.members[index], row, source.at(column), result_columns[column].name);
+                !assigned) {
+                target.discard(target.rows);
+                return assigned;
+            }
+            if (target.fetched_bytes != nullptr) {
+                *target.fetched_bytes += payload_bytes(source.view(column));
+            }
+        }
+    }
+    return {};
+}
+
+Expected<PreparedStatement*> Connection::prepare_with_hash(std::string_view sql, std::size_t) {
+    return prepare(sql);
+}
+
+Expected<PreparedStatement*> Connection::prepare_pinned(std::string_view sql) {
+    return prepare(sql);
+}
+
+Expected<void> Connection::stream(std::string_view sql, RowSink& sink) {
+    auto result = query(sql);
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    return stream_result(*result, sink);
+}
+
+Expected<void> Connection::initialize_session(std::span<const std::string> statements) {
+    for (const auto& statement : statements) {
+        auto result = execute(statement);
+        track_session_set(statement, result.has_value());
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+    }
+    return {};
+}
+
+Expected<void> Connection::begin_transaction() {
+    auto result = execute("START TRANSACTION");
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    in_transaction_.store(true, std::memory_order_release);
+    return {};
+}
+
+Expected<void> Connection::commit() {
+    auto result = execute("COMMIT");
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    in_transaction_.store(false, std::memory_order_release);
+    return {};
+}
+
+Expected<void> Connection::rollback() {
+    auto result = execute("ROLLBACK");
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    in_transaction_.store(false, std::memory_order_release);
+    return {};
+}
+
+bool Connection::in_transaction() const noexcept {
+    return in_transaction_.load(std::memory_order_acquire);
+}
+
+bool Connection::redundant_session_set(std::string_view sql) const {
+    if (session_variables_.empty()) {
+        return false;
+    }
+    SetParser parser(sql);
+    if (!parser.keyword("SET")) {
+        return false;
+    }
+    const auto assignments = parser.assignments();
+    if (!assignments || assignments->empty()) {
+        return false;
+    }
+    return std::ranges::all_of(*assignments, [this](const SessionAssignment& assignment) {
+        const auto known = session_variables_.find(assignment.name);
+        return assignment.value && known != session_variables_.end() && known->second == *assignment.value;
+    });
+}
+
+void Connection::track_session_set(std::string_view sql, bool applied) {
+    SetParser parser(sql);
+    if (!parser.keyword("SET")) {
+        return;
+    }
+    auto assignments = parser.assignments();
+    if (!assignments) {
+        session_variables_.clear();
+        return;
+    }
+    for (auto& assignment : *assignments) {
+        if (applied && assignment.value && idempotent_session_variable(assignment.name)) {
+            session_variables_.insert_or_assign(std::move(assignment.name), std::move(*assignment.value));
+        } else {
+            session_variables_.erase(assignment.name);
+        }
+    }
+}
+
 DbException::DbException(DbError error) : std::runtime_error(error.message), error_(std::move(error)) {}
 
 const DbError& DbException::error() const noexcept {
@@ -880,11 +2245,11 @@ Result::Result(std::vector<Column> columns, std::vector<RowStorage> rows)
 }
 
 bool Result::empty() const noexcept {
-    return rows_.empty();
+    return row_count() == 0;
 }
 
 std::size_t Result::row_count() const noexcept {
-    return rows_.size();
+    return snapshot_ ? snapshot_->row_count() : rows_.size();
 }
 
 std::size_t Result::column_count() const noexcept {
@@ -896,7 +2261,7 @@ std::span<const Column> Result::columns() const noexcept {
 }
 
 RowView Result::row(std::size_t index) const {
-    if (index >= rows_.size()) {
+    if (index >= row_count()) {
         throw std::out_of_range("row index out of range");
     }
     return RowView(this, index);
@@ -914,6 +2279,10 @@ std::size_t Result::column_index(std::string_view name) const {
     return found->second;
 }
 
+const std::vector<Result::RowStorage>& Result::row_storage() const {
+    return snapshot_ ? snapshot_->rows() : rows_;
+}
+
 void Result::rebuild_index() {
     column_index_.clear();
     column_index_.reserve(columns_.size());
@@ -925,10 +2294,10 @@ void Result::rebuild_index() {
 RowView::RowView(const Result* result, std::size_t row_index) noexcept : result_(result), row_index_(row_index) {}
 
 const Value& RowView::at(std::size_t column_index) const {
-    if (result_ == nullptr || row_index_ >= result_->rows_.size()) {
+    if (result_ == nullptr || row_index_ >= result_->row_count()) {
         throw std::out_of_range("row view is invalid");
     }
-    const auto& row = result_->rows_[row_index_];
+    const auto& row = result_->row_storage()[row_index_];
     if (column_index >= row.size()) {
         throw std::out_of_range("column index out of range");
     }
@@ -944,20 +2313,62 @@ const Value& RowView::operator[](std::string_view column_name) const {
 }
 
 std::span<const Value> RowView::values() const {
-    if (result_ == nullptr || row_index_ >= result_->rows_.size()) {
+    if (result_ == nullptr || row_index_ >= result_->row_count()) {
+        throw std::out_of_range("row view is invalid");
+    }
+    return result_->row_storage()[row_index_];
+}
+
+ValueView RowView::view(std::size_t column_index) const {
+    if (result_ == nullptr || row_index_ >= result_->row_count()) {
         throw std::out_of_range("row view is invalid");
     }
-    return result_->rows_[row_index_];
+    if (result_->snapshot_) {
+        if (column_index >= result_->columns_.size()) {
+            throw std::out_of_range("column index out of range");
+        }
+        return result_->snapshot_->view(row_index_, column_index);
+    }
+    const auto& row = result_->rows_[row_index_];
+    if (column_index >= row.size()) {
+        throw std::out_of_range("column index out of range");
+    }
+    return view_of(row[column_index]);
+}
+
+ValueView RowView::view(std::string_view column_name) const {
+    return view(result_->column_index(column_name));
 }
 
 class Database::Impl {
 public:
-    explicit Impl(ConnectionConfig config) : config_(std::move(config)) {
+    Impl(ConnectionConfig config, ConnectionFactory factory) : config_(std::move(config)) {
         if (config_.worker_count == 0) {
             config_.worker_count = std::max<std::size_t>(1, std::thread::hardware_concurrency());
         }
-        pool_ = std::make_unique<ConnectionPoolImpl>(config_);
-        if (auto initialized = pool_->initialize(); !initialized) {
+        if (!factory) {
+            // Every pool of this database shares one TLS session cache.
+            factory = [tls_sessions = tls_sessions_](const ConnectionConfig& connection_config)
+                -> std::unique_ptr<Connection> {
+                return std::make_unique<MysqlConnection>(connection_config, tls_sessions);
+            };
+        }
+        endpoint_ = config_.host + ':' + std::to_string(config_.port);
+        if (config_.compression != Compression::none && config_.compressed_pool_size != 0) {
+            // The compressed pool opens its connections on first use.
+            auto compressed = config_;
+            compressed.initial_pool_size = 0;
+            compressed.max_pool_size = config_.compressed_pool_size;
+            compressed_pool_ = std::make_unique<ConnectionPoolImpl>(std::move(compressed), factory, registry_);
+            auto uncompressed = config_;
+            uncompressed.compression = Compression::none;
+            pool_ = std::make_unique<ConnectionPoolImpl>(std::move(uncompressed), std::move(factory), registry_);
+        } else {
+            pool_ = std::make_unique<ConnectionPoolImpl>(config_, std::move(factory), registry_);
+        }
+        if (config_.lazy_connect) {
+            start_warmup();
+        } else if (auto initialized = pool_->initialize(); !initialized) {
             init_error_ = initialized.error();
         }
         start_workers();
@@ -970,44 +2381,128 @@ public:
     Impl(const Impl&) = delete;
     Impl& operator=(const Impl&) = delete;
 
-    [[nodiscard]] Expected<Result> query(std::string_view sql, std::vector<Value> values) {
+    [[nodiscard]] Expected<Result> query(std::string_view sql, std::vector<Value> values,
+                                         TrafficApi api = TrafficApi::query,
+                                         std::optional<std::chrono::steady_clock::time_point> issued = std::nullopt) {
+        const auto recorder = this->recorder();
+        return record_call<Result>(recorder.get(), api, 0, sql, std::move(values), issued,
+                                   [&](std::vector<Value> params) -> Expected<Result> {
+            if (init_error_) {
+                return std::unexpected(*init_error_);
+            }
+            const bool compressed = route_compressed(sql);
+            auto lease = acquire(compressed);
+            if (!lease) {
+                return std::unexpected(lease.error());
+            }
+            auto result = run_query(**lease, sql, std::move(params), metrics_);
+            if (result && config_.compression != Compression::none) {
+                record_result_bytes(sql, compressed, payload_bytes(*result));
+            }
+            return result;
+        });
+    }
+
+    [[nodiscard]] Expected<ExecuteResult> execute(std::string_view sql, std::vector<Value> values,
+                                                  TrafficApi api = TrafficApi::execute,
+                                                  std::optional<std::chrono::steady_clock::time_point> issued = std::nullopt) {
+        const auto recorder = this->recorder();
+        return record_call<ExecuteResult>(recorder.get(), api, 0, sql, std::move(values), issued,
+                                          [&](std::vector<Value> params) -> Expected<ExecuteResult> {
+            if (init_error_) {
+                return std::unexpected(*init_error_);
+            }
+            auto lease = acquire();
+            if (!lease) {
+                return std::unexpected(lease.error());
+            }
+            return run_execute(**lease, sql, std::move(params), metrics_);
+        });
+    }
+
+    [[nodiscard]] Expected<Result> query(StatementKey key, std::span<const ValueView> values) {
+        if (recorder()) {
+            return query(key.sql, to_values(values));
+        }
         if (init_error_) {
             return std::unexpected(*init_error_);
         }
-        auto lease = pool_->acquire();
+        const bool compressed = route_compressed(key);
+        auto lease = acquire(compressed);
         if (!lease) {
             return std::unexpected(lease.error());
         }
-
-        if (values.empty()) {
-            return (*lease)->query(sql);
-        }
-
-        auto statement = (*lease)->prepare(sql);
-        if (!statement) {
-            return std::unexpected(statement.error());
+        auto result = run_query(**lease, key, values, metrics_);
+        if (result && config_.compression != Compression::none) {
+            record_result_bytes(key.sql, compressed, payload_bytes(*result));
         }
-        return statement->query(std::move(values));
+        return result;
     }
 
-    [[nodiscard]] Expected<ExecuteResult> execute(std::string_view sql, std::vector<Value> values) {
+    [[nodiscard]] Expected<ExecuteResult> execute(StatementKey key, std::span<const ValueView> values) {
+        if (recorder()) {
+            return execute(key.sql, to_values(values));
+        }
         if (init_error_) {
             return std::unexpected(*init_error_);
         }
-        auto lease = pool_->acquire();
+        auto lease = acquire();
         if (!lease) {
             return std::unexpected(lease.error());
         }
+        return run_execute(**lease, key, values, metrics_);
+    }
 
-        if (values.empty()) {
-            return (*lease)->execute(sql);
-        }
+    [[nodiscard]] Expected<void> query_into(std::string_view sql, std::span<const ValueView> values,
+                                            const detail::RowTarget& target) {
+        const auto recorder = this->recorder();
+        return record_call<void>(recorder.get(), TrafficApi::query, 0, sql,
+                                 recorder ? to_values(values) : std::vector<Value>{}, std::nullopt,
+                                 [&](std::vector<Value>) -> Expected<void> {
+            if (init_error_) {
+                return std::unexpected(*init_error_);
+            }
+            const bool compressed = route_compressed(sql);
+            auto lease = acquire(compressed);
+            if (!lease) {
+                return std::unexpected(lease.error());
+            }
+            if (config_.compression == Compression::none) {
+                return run_query_into(**lease, sql, values, target, metrics_);
+            }
+            auto counted = target;
+            std::uint64_t bytes = 0;
+            counted.fetched_bytes = &bytes;
+            auto fetched = run_query_into(**lease, sql, values, counted, metrics_);
+            if (fetched) {
+                record_result_bytes(sql, compressed, bytes);
+            }
+            return fetched;
+        });
+    }
 
-        auto statement = (*lease)->prepare(sql);
-        if (!statement) {
-            return std::unexpected(statement.error());
-        }
-        return statement->execute(std::move(values));
+    [[nodiscard]] Expected<void> stream(std::string_view sql, RowSink& sink, std::vector<Value> values) {
+        const auto recorder = this->recorder();
+        return record_call<void>(recorder.get(), TrafficApi::stream, 0, sql, std::move(values), std::nullopt,
+                                 [&](std::vector<Value> params) -> Expected<void> {
+            if (init_error_) {
+                return std::unexpected(*init_error_);
+            }
+            const bool compressed = route_compressed(sql);
+            auto lease = acquire(compressed);
+            if (!lease) {
+                return std::unexpected(lease.error());
+            }
+            if (config_.compression == Compression::none) {
+                return run_stream(**lease, sql, sink, std::move(params), metrics_);
+            }
+            CountingSink counting(sink);
+            auto streamed = run_stream(**lease, sql, counting, std::move(params), metrics_);
+            if (streamed) {
+                record_result_bytes(sql, compressed, counting.bytes());
+            }
+            return streamed;
+        });
     }
 
     [[nodiscard]] Expected<Transaction> begin_transaction();
@@ -1016,15 +2511,131 @@ public:
         if (init_error_) {
             return std::unexpected(*init_error_);
         }
-        auto lease = pool_->acquire();
+        auto lease = acquire();
         if (!lease) {
             return std::unexpected(lease.error());
         }
         return (*lease)->escape(value);
     }
 
+    [[nodiscard]] Expected<void> register_statement(std::string sql) {
+        if (sql.empty()) {
+            return std::unexpected(make_error(ErrorCode::invalid_argument, Operation::prepare,
+                                             "cannot register an empty statement"));
+        }
+        if (registry_->contains(sql)) {
+            return {};
+        }
+        if (registry_->size() + 1 >= config_.statement_cache_size) {
+            return std::unexpected(make_error(ErrorCode::invalid_argument, Operation::prepare,
+                "registered statements must leave one statement_cache_size slot for other statements"));
+        }
+        if (init_error_) {
+            return std::unexpected(*init_error_);
+        }
+        {
+            auto lease = acquire();
+            if (!lease) {
+                return std::unexpected(lease.error());
+            }
+            if (auto prepared = prepare_counted(**lease, sql, metrics_); !prepared) {
+                return std::unexpected(prepared.error());
+            }
+        }
+        if (registry_->add(std::move(sql))) {
+            pool_->catch_up_idle();
+            if (compressed_pool_) {
+                compressed_pool_->catch_up_idle();
+            }
+        }
+        return {};
+    }
+
     [[nodiscard]] PoolStats stats() const {
-        return pool_->stats(queued_tasks_.load(std::memory_order_relaxed));
+        auto stats = pool_->stats(queued_tasks_.load(std::memory_order_relaxed));
+        if (compressed_pool_) {
+            const auto compressed = compressed_pool_->stats(0);
+            stats.idle_connections += compressed.idle_connections;
+            stats.active_connections += compressed.active_connections;
+            stats.created_connections += compressed.created_connections;
+            stats.failed_connections += compressed.failed_connections;
+        }
+        return stats;
+    }
+
+    [[nodiscard]] Metrics metrics() const {
+        return Metrics{
+            .pool = stats(),
+            .executor = ExecutorStats{
+                .worker_count = config_.worker_count,
+                .queued_tasks = queued_tasks_.load(std::memory_order_relaxed),
+                .submitted_tasks = metrics_.submitted_tasks.load(std::memory_order_relaxed),
+                .completed_tasks = metrics_.completed_tasks.load(std::memory_order_relaxed),
+                .cancelled_tasks = metrics_.cancelled_tasks.load(std::memory_order_relaxed)
+            },
+            .statements = StatementStats{
+                .prepared_statements = metrics_.prepared_statements.load(std::memory_order_relaxed),
+                .prepare_failures = metrics_.prepare_failures.load(std::memory_order_relaxed),
+                .registered_statements = registry_->size(),
+                .covered_connections = pool_->covered_connections() +
+                                       (compressed_pool_ ? compressed_pool_->covered_connections() : 0),
+                .registry_prepare_failures = pool_->registry_prepare_failures() +
+                                             (compressed_pool_ ? compressed_pool_->registry_prepare_failures() : 0),
+                .skipped_session_sets = metrics_.skipped_session_sets.load(std::memory_order_relaxed)
+            },
+            .compression = CompressionStats{
+                .compressed_queries = metrics_.compressed_queries.load(std::memory_order_relaxed),
+                .uncompressed_queries = metrics_.uncompressed_queries.load(std::memory_order_relaxed),
+                .compressed_result_bytes = metrics_.compressed_result_bytes.load(std::memory_order_relaxed),
+                .uncompressed_result_bytes = metrics_.uncompressed_result_bytes.load(std::memory_order_relaxed)
+            },
+            .tls = TlsStats{
+                .full_handshakes = tls_sessions_->full_handshakes.load(std::memory_order_relaxed),
+                .resumed_sessions = tls_sessions_->resumed_sessions.load(std::memory_order_relaxed)
+            },
+            .acquire_latency = metrics_.acquire_latency.snapshot(),
+            .query_latency = metrics_.query_latency.snapshot(),
+            .execute_latency = metrics_.execute_latency.snapshot()
+        };
+    }
+
+    [[nodiscard]] MetricsSource metrics_source() const {
+        return MetricsSource{
+            .database = config_.database,
+            .endpoint = endpoint_,
+            .metrics = metrics()
+        };
+    }
+
+    [[nodiscard]] Expected<void> start_recording(const std::string& path) {
+        auto opened = TrafficRecorder::open(path);
+        if (!opened) {
+            return std::unexpected(opened.error());
+        }
+        std::shared_ptr<TrafficRecorder> recorder = std::move(*opened);
+        std::lock_guard lock(recorder_mutex_);
+        recorder_ = std::move(recorder);
+        recording_.store(true, std::memory_order_release);
+        return {};
+    }
+
+    [[nodiscard]] Expected<void> stop_recording() {
+        std::shared_ptr<TrafficRecorder> recorder;
+        {
+            std::lock_guard lock(recorder_mutex_);
+            recording_.store(false, std::memory_order_release);
+            recorder = std::move(recorder_);
+        }
+        // Calls still in flight keep their own reference and append before the file closes.
+        return recorder ? recorder->flush() : Expected<void>{};
+    }
+
+    [[nodiscard]] std::shared_ptr<TrafficRecorder> recorder() const {
+        if (!recording_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        std::lock_guard lock(recorder_mutex_);
+        return recorder_;
     }
 
     template <typename T>
@@ -1040,6 +2651,7 @@ public:
                 return future;
             }
             queued_tasks_.fetch_add(1, std::memory_order_relaxed);
+            metrics_.submitted_tasks.fetch_add(1, std::memory_order_relaxed);
             tasks_.push_back(Task{
         .run = [promise, work = std::move(work)](std::stop_token stop_token) mutable {
                     if (stop_token.stop_requested()) {
@@ -1068,6 +2680,7 @@ public:
                 auto task = std::move(tasks_.front());
                 tasks_.pop_front();
                 queued_tasks_.fetch_sub(1, std::memory_order_relaxed);
+                metrics_.cancelled_tasks.fetch_add(1, std::memory_order_relaxed);
                 if (task.cancel) {
                     task.cancel(cancelled_error());
                 }
@@ -1075,21 +2688,39 @@ public:
         }
         task_cv_.notify_all();
         workers_.clear();
+        // Waits for a connect in progress, at most connect_timeout.
+        warmup_ = {};
         if (pool_) {
             pool_->stop();
         }
+        if (compressed_pool_) {
+            compressed_pool_->stop();
+        }
     }
 
 private:
     ConnectionConfig config_;
+    std::string endpoint_;
     std::unique_ptr<ConnectionPoolImpl> pool_;
+    std::unique_ptr<ConnectionPoolImpl> compressed_pool_;
+    std::shared_ptr<TlsSessionCache> tls_sessions_ = std::make_shared<TlsSessionCache>();
+    std::shared_ptr<StatementRegistry> registry_ = std::make_shared<StatementRegistry>();
+    // SQL whose last result reached compress_result_threshold; only used with compressed_pool_.
+    std::unordered_set<std::string, StringHash, StringEqual> large_results_;
+    mutable std::mutex large_results_mutex_;
     std::optional<DbError> init_error_;
+    ClientMetrics metrics_;
     std::vector<std::jthread> workers_;
+    std::jthread warmup_;
     std::deque<Task> tasks_;
     mutable std::mutex task_mutex_;
     std::condition_variable_any task_cv_;
     bool stopped_ = false;
     std::atomic_size_t queued_tasks_{0};
+    std::atomic_bool recording_{false};
+    mutable std::mutex recorder_mutex_;
+    std::shared_ptr<TrafficRecorder> recorder_;
+    std::atomic<std::uint64_t> next_session_{1};
 
     void start_workers() {
         workers_.reserve(config_.worker_count);
@@ -1110,17 +2741,80 @@ private:
                     if (task.run) {
                         task.run(stop_token);
                     }
+                    metrics_.completed_tasks.fetch_add(1, std::memory_order_relaxed);
                 }
             });
         }
     }
 
+    void start_warmup() {
+        warmup_ = std::jthread([this](std::stop_token stop_token) {
+            std::mutex mutex;
+            std::condition_variable_any sleeper;
+            auto delay = config_.warmup_retry_delay;
+            while (!stop_token.stop_requested()) {
+                auto warmed = pool_->warm_one(config_.initial_pool_size);
+                if (warmed) {
+                    if (!*warmed) {
+                        return;
+                    }
+                    delay = config_.warmup_retry_delay;
+                    continue;
+                }
+                std::unique_lock lock(mutex);
+                sleeper.wait_for(lock, stop_token, delay, [] { return false; });
+                delay = std::min(delay * 2, config_.warmup_retry_max_delay);
+            }
+        });
+    }
+
+    [[nodiscard]] bool route_compressed(std::string_view sql) const {
+        return route_compressed(StatementKey{.sql = sql, .hash = detail::sql_hash(sql)});
+    }
+
+    [[nodiscard]] bool route_compressed(const StatementKey& key) const {
+        if (!compressed_pool_) {
+            return config_.compression != Compression::none;
+        }
+        std::lock_guard lock(large_results_mutex_);
+        return large_results_.find(key) != large_results_.end();
+    }
+
+    void record_result_bytes(std::string_view sql, bool compressed, std::uint64_t bytes) {
+        (compressed ? metrics_.compressed_queries : metrics_.uncompressed_queries).fetch_add(1, std::memory_order_relaxed);
+        (compressed ? metrics_.compressed_result_bytes : metrics_.uncompressed_result_bytes)
+            .fetch_add(bytes, std::memory_order_relaxed);
+        if (!compressed_pool_ || (bytes >= config_.compress_result_threshold) == compressed) {
+            return;
+        }
+        // A query moves between the pools when its result size crosses the threshold. The set is
+        // bounded so ad hoc SQL cannot grow it without limit.
+        constexpr std::size_t max_large_results = 4096;
+        std::lock_guard lock(large_results_mutex_);
+        if (compressed) {
+            if (const auto found = large_results_.find(sql); found != large_results_.end()) {
+                large_results_.erase(found);
+            }
+        } else if (large_results_.size() < max_large_results) {
+            large_results_.emplace(sql);
+        }
+    }
+
+    [[nodiscard]] Expected<ConnectionLease> acquire(bool compressed = false) {
+        const auto started = std::chrono::steady_clock::now();
+        auto lease = compressed && compressed_pool_ ? compressed_pool_->acquire() : pool_->acquire();
+        metrics_.acquire_latency.record(std::chrono::steady_clock::now() - started);
+        return lease;
+    }
+
     friend class Transaction::Impl;
 };
 
 class Transaction::Impl {
 public:
-    explicit Impl(ConnectionLease lease) noexcept : lease_(std::move(lease)) {}
+    Impl(ConnectionLease lease, ClientMetrics& metrics, std::shared_ptr<TrafficRecorder> recorder,
+         std::uint64_t session) noexcept
+        : lease_(std::move(lease)), metrics_(&metrics), recorder_(std::move(recorder)), session_(session) {}
 
     ~Impl() {
         if (active_) {
@@ -1136,15 +2830,10 @@ public:
             return std::unexpected(make_error(ErrorCode::transaction_failed, Operation::query,
                                              "transaction is not active"));
         }
-
-        if (values.empty()) {
-            return lease_->query(sql);
-        }
-        auto statement = lease_->prepare(sql);
-        if (!statement) {
-            return std::unexpected(statement.error());
-        }
-        return statement->query(std::move(values));
+        return record_call<Result>(recorder_.get(), TrafficApi::transaction_query, session_, sql, std::move(values),
+                                   std::nullopt, [&](std::vector<Value> params) {
+            return run_query(*lease_, sql, std::move(params), *metrics_);
+        });
     }
 
     [[nodiscard]] Expected<ExecuteResult> execute(std::string_view sql, std::vector<Value> values) {
@@ -1152,15 +2841,10 @@ public:
             return std::unexpected(make_error(ErrorCode::transaction_failed, Operation::execute,
                                              "transaction is not active"));
         }
-
-        if (values.empty()) {
-            return lease_->execute(sql);
-        }
-        auto statement = lease_->prepare(sql);
-        if (!statement) {
-            return std::unexpected(statement.error());
-        }
-        return statement->execute(std::move(values));
+        return record_call<ExecuteResult>(recorder_.get(), TrafficApi::transaction_execute, session_, sql,
+                                          std::move(values), std::nullopt, [&](std::vector<Value> params) {
+            return run_execute(*lease_, sql, std::move(params), *metrics_);
+        });
     }
 
     [[nodiscard]] Expected<void> commit() {
@@ -1168,7 +2852,8 @@ public:
             return std::unexpected(make_error(ErrorCode::transaction_failed, Operation::commit,
                                              "transaction is not active"));
         }
-        auto result = lease_->commit();
+        auto result = record_call<void>(recorder_.get(), TrafficApi::transaction_commit, session_, "COMMIT", {},
+                                        std::nullopt, [&](std::vector<Value>) { return lease_->commit(); });
         if (!result) {
             return std::unexpected(result.error());
         }
@@ -1182,7 +2867,8 @@ public:
             return std::unexpected(make_error(ErrorCode::transaction_failed, Operation::rollback,
                                              "transaction is not active"));
         }
-        auto result = lease_->rollback();
+        auto result = record_call<void>(recorder_.get(), TrafficApi::transaction_rollback, session_, "ROLLBACK", {},
+                                        std::nullopt, [&](std::vector<Value>) { return lease_->rollback(); });
         active_ = false;
         lease_.reset();
         if (!result) {
@@ -1197,25 +2883,36 @@ public:
 
 private:
     ConnectionLease lease_;
+    ClientMetrics* metrics_ = nullptr;
+    std::shared_ptr<TrafficRecorder> recorder_;
+    std::uint64_t session_ = 0;
     bool active_ = true;
 };
 
 Expected<Transaction> Database::Impl::begin_transaction() {
-    if (init_error_) {
-        return std::unexpected(*init_error_);
-    }
-    auto lease = pool_->acquire();
-    if (!lease) {
-        return std::unexpected(lease.error());
-    }
-    auto begun = (*lease)->begin_transaction();
-    if (!begun) {
-        return std::unexpected(begun.error());
-    }
-    return Transaction(std::make_unique<Transaction::Impl>(std::move(*lease)));
+    auto recorder = this->recorder();
+    const auto session = recorder ? next_session_.fetch_add(1, std::memory_order_relaxed) : 0;
+    return record_call<Transaction>(recorder.get(), TrafficApi::transaction_begin, session, "START TRANSACTION", {},
+                                    std::nullopt, [&](std::vector<Value>) -> Expected<Transaction> {
+        if (init_error_) {
+            return std::unexpected(*init_error_);
+        }
+        auto lease = acquire();
+        if (!lease) {
+            return std::unexpected(lease.error());
+        }
+        auto begun = (*lease)->begin_transaction();
+        if (!begun) {
+            return std::unexpected(begun.error());
+        }
+        return Transaction(std::make_unique<Transaction::Impl>(std::move(*lease), metrics_, recorder, session));
+    });
 }
 
-Database::Database(ConnectionConfig config) : impl_(std::make_unique<Impl>(std::move(config))) {}
+Database::Database(ConnectionConfig config) : impl_(std::make_unique<Impl>(std::move(config), ConnectionFactory{})) {}
+
+Database::Database(ConnectionConfig config, ConnectionFactory connection_factory)
+    : impl_(std::make_unique<Impl>(std::move(config), std::move(connection_factory))) {}
 
 Database::~Database() = default;
 
@@ -1231,6 +2928,10 @@ Expected<ExecuteResult> Database::execute(std::string_view sql) {
     return impl_->execute(sql, {});
 }
 
+Expected<void> Database::stream(std::string_view sql, RowSink& sink) {
+    return impl_->stream(sql, sink, {});
+}
+
 std::future<Expected<Result>> Database::query_async(std::string sql) {
     return submit_query_with_values(*this, std::move(sql), {});
 }
@@ -1247,10 +2948,30 @@ Expected<std::string> Database::escape(std::string_view value) {
     return impl_->escape(value);
 }
 
+Expected<void> Database::register_statement(std::string sql) {
+    return impl_->register_statement(std::move(sql));
+}
+
 PoolStats Database::stats() const {
     return impl_->stats();
 }
 
+Metrics Database::metrics() const {
+    return impl_->metrics();
+}
+
+MetricsSource Database::metrics_source() const {
+    return impl_->metrics_source();
+}
+
+Expected<void> Database::start_recording(const std::string& path) {
+    return impl_->start_recording(path);
+}
+
+Expected<void> Database::stop_recording() {
+    return impl_->stop_recording();
+}
+
 Result Database::query_or_throw(std::string_view sql) {
     auto result = query(sql);
     if (!result) {
@@ -1321,9 +3042,27 @@ Expected<ExecuteResult> execute_with_values(Database& database, std::string_view
     return database.impl_->execute(sql, std::move(values));
 }
 
+Expected<Result> query_with_views(Database& database, StatementKey key, std::span<const ValueView> values) {
+    return database.impl_->query(key, values);
+}
+
+Expected<ExecuteResult> execute_with_views(Database& database, StatementKey key, std::span<const ValueView> values) {
+    return database.impl_->execute(key, values);
+}
+
+Expected<void> query_into_with_views(Database& database, std::string_view sql, std::span<const ValueView> values,
+                                     const detail::RowTarget& target) {
+    return database.impl_->query_into(sql, values, target);
+}
+
+Expected<void> stream_with_values(Database& database, std::string_view sql, RowSink& sink, std::vector<Value> values) {
+    return database.impl_->stream(sql, sink, std::move(values));
+}
+
 std::future<Expected<Result>> submit_query_with_values(Database& database, std::string sql, std::vector<Value> values) {
-    return database.impl_->submit<Result>([&database, sql = std::move(sql), values = std::move(values)]() mutable {
-        return database.impl_->query(sql, std::move(values));
+    return database.impl_->submit<Result>([&database, sql = std::move(sql), values = std::move(values),
+                                           issued = std::chrono::steady_clock::now()]() mutable {
+        return database.impl_->query(sql, std::move(values), TrafficApi::query_async, issued);
     });
 }
 
@@ -1332,8 +3071,8 @@ std::future<Expected<ExecuteResult>> submit_execute_with_values(
     std::string sql,
     std::vector<Value> values) {
     return database.impl_->submit<ExecuteResult>(
-        [&database, sql = std::move(sql), values = std::move(values)]() mutable {
-            return database.impl_->execute(sql, std::move(values));
+        [&database, sql = std::move(sql), values = std::move(values), issued = std::chrono::steady_clock::now()]() mutable {
+            return database.impl_->execute(sql, std::move(values), TrafficApi::execute_async, issued);
         });
 }
 
@@ -1353,6 +3092,55 @@ Expected<ExecuteResult> transaction_execute_with_values(Transaction& tx, std::st
     return tx.impl_->execute(sql, std::move(values));
 }
 
+ValueView view_of(const Value& value) noexcept {
+    return std::visit([](const auto& stored) -> ValueView {
+        using T = std::decay_t<decltype(stored)>;
+        if constexpr (std::same_as<T, std::string>) {
+            return std::string_view(stored);
+        } else if constexpr (std::same_as<T, Blob>) {
+            return std::span<const std::byte>(stored);
+        } else {
+            return stored;
+        }
+    }, value);
+}
+
+Value to_value(const ValueView& view) {
+    return std::visit([](const auto& stored) -> Value {
+        using T = std::decay_t<decltype(stored)>;
+        if constexpr (std::same_as<T, std::string_view>) {
+            return std::string(stored);
+        } else if constexpr (std::same_as<T, std::span<const std::byte>>) {
+            return Blob(stored.begin(), stored.end());
+        } else {
+            return stored;
+        }
+    }, view);
+}
+
+Expected<void> stream_result(const Result& result, RowSink& sink) {
+    if (auto begun = sink.begin(result.columns()); !begun) {
+        return begun;
+    }
+    std::vector<ValueView> views(result.column_count());
+    for (std::size_t row = 0; row < result.row_count(); ++row) {
+        if (result.snapshot_) {
+            // Mapped snapshots are read in place rather than decoded into Values first.
+            for (std::size_t column = 0; column < views.size(); ++column) {
+                views[column] = result.snapshot_->view(row, column);
+            }
+        } else {
+            const auto& values = result.rows_[row];
+            views.resize(values.size());
+            std::transform(values.begin(), values.end(), views.begin(), [](const Value& value) { return view_of(value); });
+        }
+        if (auto accepted = sink.row(views); !accepted) {
+            return accepted;
+        }
+    }
+    return {};
+}
+
 std::string_view to_string(ErrorCode code) noexcept {
     switch (code) {
         case ErrorCode::ok: return "ok";
@@ -1374,6 +3162,7 @@ std::string_view to_string(ErrorCode code) noexcept {
         case ErrorCode::invalid_argument: return "invalid_argument";
         case ErrorCode::type_mismatch: return "type_mismatch";
         case ErrorCode::transaction_failed: return "transaction_failed";
+        case ErrorCode::io_failed: return "io_failed";
     }
     return "unknown";
 }
@@ -1393,6 +3182,14 @@ std::string_view to_string(Operation operation) noexcept {
         case Operation::rollback: return "rollback";
         case Operation::async_submit: return "async_submit";
         case Operation::async_cancelled: return "async_cancelled";
+        case Operation::traffic_log: return "traffic_log";
+        case Operation::export_data: return "export_data";
+        case Operation::snapshot: return "snapshot";
+        case Operation::shared_cache: return "shared_cache";
+        case Operation::transform: return "transform";
+        case Operation::scan: return "scan";
+        case Operation::paginate: return "paginate";
+        case Operation::chunked_dml: return "chunked_dml";
     }
     return "unknown";
 }
@@ -0,0 +1,198 @@
+#include "mysqlwrapper/openmetrics.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+
+namespace mysqlw {
+namespace {
+
+// Bucket bounds spelled the way OpenMetrics expects canonical `le` label values.
+constexpr std::array<std::string_view, LatencyHistogram::bucket_bounds.size()> bucket_labels{
+    "1e-05", "2.5e-05", "5e-05", "0.0001", "0.00025", "0.0005", "0.001", "0.0025", "0.005",
+    "0.01", "0.025", "0.05", "0.1", "0.25", "0.5", "1.0", "2.5", "5.0"};
+
+void append_number(std::string& out, std::uint64_t value) {
+    char buffer[24];
+    const auto converted = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, converted.ptr);
+}
+
+void append_number(std::string& out, double value) {
+    char buffer[32];
+    const auto converted = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, converted.ptr);
+}
+
+void append_label_value(std::string& out, std::string_view value) {
+    for (const char character : value) {
+        switch (character) {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '"':
+                out += "\\\"";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            default:
+                out += character;
+                break;
+        }
+    }
+}
+
+void append_sample_name(std::string& out, std::string_view family, std::string_view suffix) {
+    out += family;
+    out += suffix;
+}
+
+void append_labels(std::string& out, const MetricsSource& source, std::string_view le = {}) {
+    out += "{database=\"";
+    append_label_value(out, source.database);
+    out += "\",endpoint=\"";
+    append_label_value(out, source.endpoint);
+    if (!le.empty()) {
+        out += "\",le=\"";
+        out += le;
+    }
+    out += "\"} ";
+}
+
+void append_header(std::string& out, std::string_view family, std::string_view type, std::string_view help) {
+    out += "# TYPE ";
+    out += family;
+    out += ' ';
+    out += type;
+    out += "\n# HELP ";
+    out += family;
+    out += ' ';
+    out += help;
+    out += '\n';
+}
+
+template <typename Getter>
+void write_gauge(std::string& out, std::span<const MetricsSource> sources, std::string_view family,
+                 std::string_view help, Getter getter) {
+    append_header(out, family, "gauge", help);
+    for (const auto& source : sources) {
+        out += family;
+        append_labels(out, source);
+        append_number(out, static_cast<std::uint64_t>(getter(source.metrics)));
+        out += '\n';
+    }
+}
+
+template <typename Getter>
+void write_counter(std::string& out, std::span<const MetricsSource> sources, std::string_view family,
+                   std::string_view help, Getter getter) {
+    append_header(out, family, "counter", help);
+    for (const auto& source : sources) {
+        append_sample_name(out, family, "_total");
+        append_labels(out, source);
+        append_number(out, static_cast<std::uint64_t>(getter(source.metrics)));
+        out += '\n';
+    }
+}
+
+void write_histogram(std::string& out, std::span<const MetricsSource> sources, std::string_view family,
+                     std::string_view help, LatencyHistogram Metrics::*member) {
+    append_header(out, family, "histogram", help);
+    out += "# UNIT ";
+    out += family;
+    out += " seconds\n";
+    for (const auto& source : sources) {
+        const auto& histogram = source.metrics.*member;
+        std::uint64_t cumulative = 0;
+        for (std::size_t index = 0; index < bucket_labels.size(); ++index) {
+            cumulative += histogram.bucket_counts[index];
+            append_sample_name(out, family, "_bucket");
+            append_labels(out, source, bucket_labels[index]);
+            append_number(out, cumulative);
+            out += '\n';
+        }
+        append_sample_name(out, family, "_bucket");
+        append_labels(out, source, "+Inf");
+        append_number(out, histogram.count);
+        out += '\n';
+        append_sample_name(out, family, "_count");
+        append_labels(out, source);
+        append_number(out, histogram.count);
+        out += '\n';
+        append_sample_name(out, family, "_sum");
+        append_labels(out, source);
+        append_number(out, histogram.sum_seconds);
+        out += '\n';
+    }
+}
+
+} // namespace
+
+void write_openmetrics(std::string& out, std::span<const MetricsSource> sources) {
+    out.clear();
+
+    write_gauge(out, sources, "mysqlw_pool_idle_connections", "Idle connections held by the pool.",
+                [](const Metrics& metrics) { return metrics.pool.idle_connections; });
+    write_gauge(out, sources, "mysqlw_pool_active_connections", "Connections currently leased from the pool.",
+                [](const Metrics& metrics) { return metrics.pool.active_connections; });
+    write_counter(out, sources, "mysqlw_pool_connections_created", "Physical connections opened.",
+                  [](const Metrics& metrics) { return metrics.pool.created_connections; });
+    write_counter(out, sources, "mysqlw_pool_connection_failures", "Physical connection attempts that failed.",
+                  [](const Metrics& metrics) { return metrics.pool.failed_connections; });
+    write_histogram(out, sources, "mysqlw_pool_acquire_seconds", "Time spent waiting for a pooled connection.",
+                    &Metrics::acquire_latency);
+
+    write_gauge(out, sources, "mysqlw_executor_workers", "Async executor worker threads.",
+                [](const Metrics& metrics) { return metrics.executor.worker_count; });
+    write_gauge(out, sources, "mysqlw_executor_queued_tasks", "Async tasks waiting for a worker.",
+                [](const Metrics& metrics) { return metrics.executor.queued_tasks; });
+    write_counter(out, sources, "mysqlw_executor_tasks_submitted", "Async tasks accepted by the executor.",
+                  [](const Metrics& metrics) { return metrics.executor.submitted_tasks; });
+    write_counter(out, sources, "mysqlw_executor_tasks_completed", "Async tasks run to completion.",
+                  [](const Metrics& metrics) { return metrics.executor.completed_tasks; });
+    write_counter(out, sources, "mysqlw_executor_tasks_cancelled", "Async tasks cancelled before running.",
+                  [](const Metrics& metrics) { return metrics.executor.cancelled_tasks; });
+
+    write_counter(out, sources, "mysqlw_statements_prepared", "Server-side statements prepared.",
+                  [](const Metrics& metrics) { return metrics.statements.prepared_statements; });
+    write_counter(out, sources, "mysqlw_statement_prepare_failures", "Statement prepares that failed.",
+                  [](const Metrics& metrics) { return metrics.statements.prepare_failures; });
+    write_gauge(out, sources, "mysqlw_statements_registered", "Hot statements in the statement registry.",
+                [](const Metrics& metrics) { return metrics.statements.registered_statements; });
+    write_gauge(out, sources, "mysqlw_statement_registry_covered_connections",
+                "Pooled connections with every registered statement prepared.",
+                [](const Metrics& metrics) { return metrics.statements.covered_connections; });
+    write_counter(out, sources, "mysqlw_statement_registry_prepare_failures",
+                  "Registered statement prepares that failed on a pooled connection.",
+                  [](const Metrics& metrics) { return metrics.statements.registry_prepare_failures; });
+    write_counter(out, sources, "mysqlw_session_sets_skipped",
+                  "SET statements skipped because the session already had those values.",
+                  [](const Metrics& metrics) { return metrics.statements.skipped_session_sets; });
+
+    write_counter(out, sources, "mysqlw_compressed_queries", "Queries answered over compressed connections.",
+                  [](const Metrics& metrics) { return metrics.compression.compressed_queries; });
+    write_counter(out, sources, "mysqlw_uncompressed_queries", "Queries answered over uncompressed connections.",
+                  [](const Metrics& metrics) { return metrics.compression.uncompressed_queries; });
+    write_counter(out, sources, "mysqlw_compressed_result_bytes", "Decoded result bytes read over compressed connections.",
+                  [](const Metrics& metrics) { return metrics.compression.compressed_result_bytes; });
+    write_counter(out, sources, "mysqlw_uncompressed_result_bytes", "Result bytes read over uncompressed connections.",
+                  [](const Metrics& metrics) { return metrics.compression.uncompressed_result_bytes; });
+    write_counter(out, sources, "mysqlw_tls_full_handshakes", "TLS connections opened with a full handshake.",
+                  [](const Metrics& metrics) { return metrics.tls.full_handshakes; });
+    write_counter(out, sources, "mysqlw_tls_sessions_resumed", "TLS connections that resumed an earlier session.",
+                  [](const Metrics& metrics) { return metrics.tls.resumed_sessions; });
+
+    write_histogram(out, sources, "mysqlw_query_seconds", "Query latency excluding pool acquire.",
+                    &Metrics::query_latency);
+    write_histogram(out, sources, "mysqlw_execute_seconds", "Execute latency excluding pool acquire.",
+                    &Metrics::execute_latency);
+
+    out += "# EOF\n";
+}
+
+void write_openmetrics(std::string& out, const MetricsSource& source) {
+    write_openmetrics(out, std::span<const MetricsSource>(&source, 1));
+}
+
+} // namespace mysqlw
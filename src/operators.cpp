@@ -0,0 +1,869 @@
+#include "mysqlwrapper/operators.hpp"
+
+#include "mysqlwrapper/columnar.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+namespace mysqlw {
+namespace {
+
+DbError transform_error(ErrorCode code, std::string message) {
+    return DbError{
+        .code = code,
+        .operation = Operation::transform,
+        .message = std::move(message)
+    };
+}
+
+bool is_numeric(ColumnType type) noexcept {
+    return type == ColumnType::signed_integer || type == ColumnType::unsigned_integer || type == ColumnType::floating;
+}
+
+bool valid(const ColumnBuffer& buffer, std::size_t row) noexcept {
+    return buffer.null_count == 0 || (buffer.validity[row / 8] >> (row % 8) & 1U) != 0;
+}
+
+std::string_view bytes_at(const ColumnBuffer& buffer, std::size_t row) noexcept {
+    return std::string_view(buffer.bytes).substr(static_cast<std::size_t>(buffer.offsets[row]),
+                                                 static_cast<std::size_t>(buffer.offsets[row + 1] - buffer.offsets[row]));
+}
+
+bool bool_at(const ColumnBuffer& buffer, std::size_t row) noexcept {
+    return (buffer.bool_bits[row / 8] >> (row % 8) & 1U) != 0;
+}
+
+template <typename T>
+int three_way(T left, T right) noexcept {
+    return left < right ? -1 : (right < left ? 1 : 0);
+}
+
+// Orders two cells of one column; NULL sorts first and equals NULL.
+int compare_cells(const ColumnBuffer& buffer, std::size_t left, std::size_t right) noexcept {
+    const bool left_valid = valid(buffer, left);
+    const bool right_valid = valid(buffer, right);
+    if (!left_valid || !right_valid) {
+        return static_cast<int>(left_valid) - static_cast<int>(right_valid);
+    }
+    switch (buffer.column.type) {
+        case ColumnType::null: return 0;
+        case ColumnType::signed_integer: return three_way(buffer.int64_values[left], buffer.int64_values[right]);
+        case ColumnType::unsigned_integer: return three_way(buffer.uint64_values[left], buffer.uint64_values[right]);
+        case ColumnType::floating: return three_way(buffer.double_values[left], buffer.double_values[right]);
+        case ColumnType::text:
+        case ColumnType::blob: return bytes_at(buffer, left).compare(bytes_at(buffer, right));
+        case ColumnType::boolean: return three_way(bool_at(buffer, left), bool_at(buffer, right));
+    }
+    return 0;
+}
+
+Expected<ColumnarResult> columnar(const Result& input) {
+    return ColumnarResult::from_result(input);
+}
+
+// Copies the given rows of every column into a new Result with the input's metadata.
+Result gather(const Result& input, const ColumnarResult& data, std::span<const std::size_t> rows) {
+    std::vector<Result::RowStorage> output(rows.size());
+    const auto columns = data.columns();
+    for (std::size_t index = 0; index < rows.size(); ++index) {
+        auto& row = output[index];
+        row.reserve(columns.size());
+        for (const auto& buffer : columns) {
+            row.push_back(to_value(buffer.value(rows[index])));
+        }
+    }
+    return Result(std::vector<Column>(input.columns().begin(), input.columns().end()), std::move(output));
+}
+
+// The filter kernels below are branch-free loops over one typed column that narrow a byte mask,
+// written so compilers vectorize them.
+template <typename T, typename K, typename Compare>
+void narrow(const T* values, std::size_t rows, K constant, Compare compare, std::uint8_t* keep) noexcept {
+    for (std::size_t row = 0; row < rows; ++row) {
+        keep[row] &= static_cast<std::uint8_t>(compare(static_cast<K>(values[row]), constant));
+    }
+}
+
+template <typename T, typename K>
+void narrow(const T* values, std::size_t rows, K constant, CompareOp op, std::uint8_t* keep) noexcept {
+    switch (op) {
+        case CompareOp::equal: narrow(values, rows, constant, std::equal_to<K>{}, keep); break;
+        case CompareOp::not_equal: narrow(values, rows, constant, std::not_equal_to<K>{}, keep); break;
+        case CompareOp::less: narrow(values, rows, constant, std::less<K>{}, keep); break;
+        case CompareOp::less_equal: narrow(values, rows, constant, std::less_equal<K>{}, keep); break;
+        case CompareOp::greater: narrow(values, rows, constant, std::greater<K>{}, keep); break;
+        case CompareOp::greater_equal: narrow(values, rows, constant, std::greater_equal<K>{}, keep); break;
+        case CompareOp::is_null:
+        case CompareOp::is_not_null: break;
+    }
+}
+
+bool holds(int order, CompareOp op) noexcept {
+    switch (op) {
+        case CompareOp::equal: return order == 0;
+        case CompareOp::not_equal: return order != 0;
+        case CompareOp::less: return order < 0;
+        case CompareOp::less_equal: return order <= 0;
+        case CompareOp::greater: return order > 0;
+        case CompareOp::greater_equal: return order >= 0;
+        case CompareOp::is_null:
+        case CompareOp::is_not_null: return false;
+    }
+    return false;
+}
+
+void keep_valid(const ColumnBuffer& buffer, std::size_t rows, bool want_valid, std::uint8_t* keep) noexcept {
+    if (buffer.null_count == 0) {
+        if (!want_valid) {
+            std::memset(keep, 0, rows);
+        }
+        return;
+    }
+    for (std::size_t row = 0; row < rows; ++row) {
+        const auto bit = static_cast<std::uint8_t>(buffer.validity[row / 8] >> (row % 8) & 1U);
+        keep[row] &= want_valid ? bit : static_cast<std::uint8_t>(bit ^ 1U);
+    }
+}
+
+// Integers against a constant of the other signedness that lies outside the column's range are
+// decided by sign alone.
+void narrow_constant(bool column_is_smaller, CompareOp op, std::size_t rows, std::uint8_t* keep) noexcept {
+    if (!holds(column_is_smaller ? -1 : 1, op)) {
+        std::memset(keep, 0, rows);
+    }
+}
+
+Expected<void> apply_predicate(const ColumnBuffer& buffer, std::size_t rows, const Predicate& predicate,
+                               std::uint8_t* keep) {
+    const auto op = predicate.op;
+    if (op == CompareOp::is_null || op == CompareOp::is_not_null) {
+        keep_valid(buffer, rows, op == CompareOp::is_not_null, keep);
+        return {};
+    }
+    if (std::holds_alternative<std::nullptr_t>(predicate.value) || buffer.column.type == ColumnType::null) {
+        std::memset(keep, 0, rows);
+        return {};
+    }
+
+    const auto& value = predicate.value;
+    const auto mismatch = [&buffer] {
+        return std::unexpected(transform_error(ErrorCode::type_mismatch,
+            "predicate value does not match the type of column '" + buffer.column.name + "'"));
+    };
+    const auto* signed_value = std::get_if<std::int64_t>(&value);
+    const auto* unsigned_value = std::get_if<std::uint64_t>(&value);
+    const auto* double_value = std::get_if<double>(&value);
+    const bool numeric_value = signed_value != nullptr || unsigned_value != nullptr || double_value != nullptr;
+
+    switch (buffer.column.type) {
+        case ColumnType::null:
+            break;
+        case ColumnType::signed_integer: {
+            const auto* values = buffer.int64_values.data();
+            if (signed_value != nullptr) {
+                narrow(values, rows, *signed_value, op, keep);
+            } else if (unsigned_value != nullptr) {
+                if (*unsigned_value > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+                    narrow_constant(true, op, rows, keep);
+                } else {
+                    narrow(values, rows, static_cast<std::int64_t>(*unsigned_value), op, keep);
+                }
+            } else if (double_value != nullptr) {
+                narrow(values, rows, *double_value, op, keep);
+            } else {
+                return mismatch();
+            }
+            break;
+        }
+        case ColumnType::unsigned_integer: {
+            const auto* values = buffer.uint64_values.data();
+            if (unsigned_value != nullptr) {
+                narrow(values, rows, *unsigned_value, op, keep);
+            } else if (signed_value != nullptr) {
+                if (*signed_value < 0) {
+                    narrow_constant(false, op, rows, keep);
+                } else {
+                    narrow(values, rows, static_cast<std::uint64_t>(*signed_value), op, keep);
+                }
+            } else if (double_value != nullptr) {
+                narrow(values, rows, *double_value, op, keep);
+            } else {
+                return mismatch();
+            }
+            break;
+        }
+        case ColumnType::floating: {
+            if (!numeric_value) {
+                return mismatch();
+            }
+            const double constant = signed_value != nullptr ? static_cast<double>(*signed_value)
+                                    : unsigned_value != nullptr ? static_cast<double>(*unsigned_value)
+                                                                : *double_value;
+            narrow(buffer.double_values.data(), rows, constant, op, keep);
+            break;
+        }
+        case ColumnType::text:
+        case ColumnType::blob: {
+            std::string_view constant;
+            if (const auto* text = std::get_if<std::string>(&value)) {
+                constant = *text;
+            } else if (const auto* blob = std::get_if<Blob>(&value)) {
+                constant = std::string_view(reinterpret_cast<const char*>(blob->data()), blob->size());
+            } else {
+                return mismatch();
+            }
+            for (std::size_t row = 0; row < rows; ++row) {
+                keep[row] &= static_cast<std::uint8_t>(keep[row] != 0 && holds(bytes_at(buffer, row).compare(constant), op));
+            }
+            break;
+        }
+        case ColumnType::boolean: {
+            int constant = 0;
+            if (const auto* flag = std::get_if<bool>(&value)) {
+                constant = *flag ? 1 : 0;
+            } else if (signed_value != nullptr && (*signed_value == 0 || *signed_value == 1)) {
+                constant = static_cast<int>(*signed_value);
+            } else {
+                return mismatch();
+            }
+            for (std::size_t row = 0; row < rows; ++row) {
+                keep[row] &= static_cast<std::uint8_t>(holds(three_way(static_cast<int>(bool_at(buffer, row)), constant), op));
+            }
+            break;
+        }
+    }
+    // NULL cells never satisfy a comparison.
+    keep_valid(buffer, rows, true, keep);
+    return {};
+}
+
+std::uint64_t mix(std::uint64_t value) noexcept {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+// Folds one key column into every row's hash, column at a time.
+void hash_column(const ColumnBuffer& buffer, std::span<std::uint64_t> hashes) {
+    const auto rows = hashes.size();
+    switch (buffer.column.type) {
+        case ColumnType::null:
+            break;
+        case ColumnType::signed_integer:
+            for (std::size_t row = 0; row < rows; ++row) {
+                hashes[row] = mix(hashes[row] ^ static_cast<std::uint64_t>(buffer.int64_values[row]));
+            }
+            break;
+        case ColumnType::unsigned_integer:
+            for (std::size_t row = 0; row < rows; ++row) {
+                hashes[row] = mix(hashes[row] ^ buffer.uint64_values[row]);
+            }
+            break;
+        case ColumnType::floating:
+            for (std::size_t row = 0; row < rows; ++row) {
+                // +0.0 and -0.0 compare equal, so they must hash equal.
+                const double value = buffer.double_values[row] == 0.0 ? 0.0 : buffer.double_values[row];
+                std::uint64_t bits = 0;
+                std::memcpy(&bits, &value, sizeof(bits));
+                hashes[row] = mix(hashes[row] ^ bits);
+            }
+            break;
+        case ColumnType::text:
+        case ColumnType::blob: {
+            const std::hash<std::string_view> hasher;
+            for (std::size_t row = 0; row < rows; ++row) {
+                hashes[row] = mix(hashes[row] ^ hasher(bytes_at(buffer, row)));
+            }
+            break;
+        }
+        case ColumnType::boolean:
+            for (std::size_t row = 0; row < rows; ++row) {
+                hashes[row] = mix(hashes[row] ^ static_cast<std::uint64_t>(bool_at(buffer, row)));
+            }
+            break;
+    }
+    if (buffer.null_count != 0) {
+        for (std::size_t row = 0; row < rows; ++row) {
+            if (!valid(buffer, row)) {
+                hashes[row] = mix(hashes[row] ^ 0x9e3779b97f4a7c15ULL);
+            }
+        }
+    }
+}
+
+std::string_view function_name(AggregateFunction function) noexcept {
+    switch (function) {
+        case AggregateFunction::count: return "count";
+        case AggregateFunction::sum: return "sum";
+        case AggregateFunction::min: return "min";
+        case AggregateFunction::max: return "max";
+    }
+    return "aggregate";
+}
+
+// Per-group state of one aggregate, filled a column at a time.
+struct AggregateState {
+    AggregateFunction function = AggregateFunction::count;
+    const ColumnBuffer* buffer = nullptr;
+    Column column;
+    std::vector<std::int64_t> counts;
+    std::vector<std::int64_t> signed_sums;
+    std::vector<std::uint64_t> unsigned_sums;
+    std::vector<double> double_sums;
+    std::vector<std::size_t> chosen_rows;
+};
+
+constexpr auto no_row = std::numeric_limits<std::size_t>::max();
+
+Expected<AggregateState> prepare_aggregate(std::span<const Column> columns, const ColumnarResult& data,
+                                           const Aggregate& aggregate, std::size_t groups) {
+    AggregateState state;
+    state.function = aggregate.function;
+    std::string source = "*";
+    if (aggregate.column) {
+        auto index = aggregate.column->resolve(columns);
+        if (!index) {
+            return std::unexpected(index.error());
+        }
+        state.buffer = &data.column(*index);
+        source = state.buffer->column.name;
+    } else if (aggregate.function != AggregateFunction::count) {
+        return std::unexpected(transform_error(ErrorCode::invalid_argument,
+            std::string(function_name(aggregate.function)) + "() needs a column"));
+    }
+    auto name = aggregate.name.empty() ? std::string(function_name(aggregate.function)) + "(" + source + ")" : aggregate.name;
+
+    switch (aggregate.function) {
+        case AggregateFunction::count:
+            state.column = Column{.name = std::move(name), .type = ColumnType::signed_integer, .nullable = false};
+            state.counts.assign(groups, 0);
+            break;
+        case AggregateFunction::sum: {
+            const auto type = state.buffer->column.type;
+            if (!is_numeric(type) && type != ColumnType::boolean) {
+                return std::unexpected(transform_error(ErrorCode::type_mismatch,
+                    "sum() needs a numeric column, not '" + source + "'"));
+            }
+            state.column = Column{
+                .name = std::move(name),
+                .type = type == ColumnType::boolean ? ColumnType::signed_integer : type,
+                .unsigned_value = type == ColumnType::unsigned_integer
+            };
+            state.counts.assign(groups, 0);
+            state.signed_sums.assign(type == ColumnType::signed_integer || type == ColumnType::boolean ? groups : 0, 0);
+            state.unsigned_sums.assign(type == ColumnType::unsigned_integer ? groups : 0, 0);
+            state.double_sums.assign(type == ColumnType::floating ? groups : 0, 0.0);
+            break;
+        }
+        case AggregateFunction::min:
+        case AggregateFunction::max:
+            state.column = state.buffer->column;
+            state.column.name = std::move(name);
+            state.column.nullable = true;
+            state.chosen_rows.assign(groups, no_row);
+            break;
+    }
+    return state;
+}
+
+DbError overflow_error(const AggregateState& state) {
+    return transform_error(ErrorCode::invalid_argument, "'" + state.column.name + "' overflows its column type");
+}
+
+Expected<void> accumulate(AggregateState& state, std::span<const std::size_t> group_of) {
+    const auto* buffer = state.buffer;
+    const auto rows = group_of.size();
+    if (buffer == nullptr) {
+        for (std::size_t row = 0; row < rows; ++row) {
+            ++state.counts[group_of[row]];
+        }
+        return {};
+    }
+
+    for (std::size_t row = 0; row < rows; ++row) {
+        if (!valid(*buffer, row)) {
+            continue;
+        }
+        const auto group = group_of[row];
+        switch (state.function) {
+            case AggregateFunction::count:
+                ++state.counts[group];
+                break;
+            case AggregateFunction::sum: {
+                ++state.counts[group];
+                if (!state.double_sums.empty()) {
+                    state.double_sums[group] += buffer->double_values[row];
+                } else if (!state.unsigned_sums.empty()) {
+                    auto& sum = state.unsigned_sums[group];
+                    const auto value = buffer->uint64_values[row];
+                    if (value > std::numeric_limits<std::uint64_t>::max() - sum) {
+                        return std::unexpected(overflow_error(state));
+                    }
+                    sum += value;
+                } else {
+                    auto& sum = state.signed_sums[group];
+                    const std::int64_t value = buffer->column.type == ColumnType::boolean
+                                                   ? static_cast<std::int64_t>(bool_at(*buffer, row))
+                                                   : buffer->int64_values[row];
+                    if ((value > 0 && sum > std::numeric_limits<std::int64_t>::max() - value) ||
+                        (value < 0 && sum < std::numeric_limits<std::int64_t>::min() - value)) {
+                        return std::unexpected(overflow_error(state));
+                    }
+                    sum += value;
+                }
+                break;
+            }
+            case AggregateFunction::min:
+            case AggregateFunction::max: {
+                auto& chosen = state.chosen_rows[group];
+                const int wanted = state.function == AggregateFunction::min ? -1 : 1;
+                if (chosen == no_row || compare_cells(*buffer, row, chosen) * wanted > 0) {
+                    chosen = row;
+                }
+                break;
+            }
+        }
+    }
+    return {};
+}
+
+Value aggregate_value(const AggregateState& state, std::size_t group) {
+    switch (state.function) {
+        case AggregateFunction::count:
+            return state.counts[group];
+        case AggregateFunction::sum:
+            if (state.counts[group] == 0) {
+                return nullptr;
+            }
+            if (!state.double_sums.empty()) {
+                return state.double_sums[group];
+            }
+            if (!state.unsigned_sums.empty()) {
+                return state.unsigned_sums[group];
+            }
+            return state.signed_sums[group];
+        case AggregateFunction::min:
+        case AggregateFunction::max:
+            if (state.chosen_rows[group] == no_row) {
+                return nullptr;
+            }
+            return to_value(state.buffer->value(state.chosen_rows[group]));
+    }
+    return nullptr;
+}
+
+enum class KeyFamily {
+    none,
+    integer,
+    floating,
+    bytes
+};
+
+KeyFamily key_family(ColumnType type) noexcept {
+    switch (type) {
+        case ColumnType::null: return KeyFamily::none;
+        case ColumnType::signed_integer:
+        case ColumnType::unsigned_integer:
+        case ColumnType::boolean: return KeyFamily::integer;
+        case ColumnType::floating: return KeyFamily::floating;
+        case ColumnType::text:
+        case ColumnType::blob: return KeyFamily::bytes;
+    }
+    return KeyFamily::none;
+}
+
+// Integers as (negative, two's-complement bits), which hash_column() also hashes by bits, so
+// equal keys hash equally whichever integer type holds them.
+std::pair<bool, std::uint64_t> integer_key(const ColumnBuffer& buffer, std::size_t row) noexcept {
+    switch (buffer.column.type) {
+        case ColumnType::signed_integer:
+            return {buffer.int64_values[row] < 0, static_cast<std::uint64_t>(buffer.int64_values[row])};
+        case ColumnType::unsigned_integer:
+            return {false, buffer.uint64_values[row]};
+        default:
+            return {false, static_cast<std::uint64_t>(bool_at(buffer, row))};
+    }
+}
+
+bool keys_equal(std::span<const ColumnBuffer* const> left, std::size_t left_row, std::span<const ColumnBuffer* const> right,
+                std::size_t right_row) noexcept {
+    for (std::size_t key = 0; key < left.size(); ++key) {
+        const auto& left_buffer = *left[key];
+        const auto& right_buffer = *right[key];
+        bool equal = false;
+        switch (key_family(left_buffer.column.type)) {
+            case KeyFamily::none: break;
+            case KeyFamily::integer: equal = integer_key(left_buffer, left_row) == integer_key(right_buffer, right_row); break;
+            case KeyFamily::floating: equal = left_buffer.double_values[left_row] == right_buffer.double_values[right_row]; break;
+            case KeyFamily::bytes: equal = bytes_at(left_buffer, left_row) == bytes_at(right_buffer, right_row); break;
+        }
+        if (!equal) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool has_null_key(std::span<const ColumnBuffer* const> keys, std::size_t row) noexcept {
+    return std::any_of(keys.begin(), keys.end(), [row](const ColumnBuffer* buffer) {
+        return buffer->column.type == ColumnType::null || !valid(*buffer, row);
+    });
+}
+
+struct JoinSide {
+    const Result* result = nullptr;
+    ColumnarResult data;
+    std::vector<const ColumnBuffer*> keys;
+    std::vector<std::uint64_t> hashes;
+};
+
+Expected<JoinSide> prepare_join_side(const Result& result, const std::vector<ColumnRef>& keys) {
+    auto data = columnar(result);
+    if (!data) {
+        return std::unexpected(data.error());
+    }
+    JoinSide side{.result = &result, .data = std::move(*data), .keys = {}, .hashes = {}};
+    for (const auto& key : keys) {
+        auto index = key.resolve(result.columns());
+        if (!index) {
+            return std::unexpected(index.error());
+        }
+        side.keys.push_back(&side.data.column(*index));
+    }
+    side.hashes.assign(side.data.row_count(), 0);
+    for (const auto* buffer : side.keys) {
+        hash_column(*buffer, side.hashes);
+    }
+    return side;
+}
+
+// A single non-NULL numeric key sorts (key, row) pairs instead of chasing column buffers through a
+// comparator.
+template <typename T>
+std::vector<std::size_t> sort_single(const std::vector<T>& values, bool descending) {
+    std::vector<std::pair<T, std::size_t>> keyed(values.size());
+    for (std::size_t row = 0; row < values.size(); ++row) {
+        keyed[row] = {values[row], row};
+    }
+    std::sort(keyed.begin(), keyed.end(), [descending](const auto& left, const auto& right) {
+        if (left.first != right.first) {
+            return descending ? right.first < left.first : left.first < right.first;
+        }
+        return left.second < right.second;
+    });
+    std::vector<std::size_t> order(values.size());
+    for (std::size_t row = 0; row < keyed.size(); ++row) {
+        order[row] = keyed[row].second;
+    }
+    return order;
+}
+
+} // namespace
+
+Expected<std::size_t> ColumnRef::resolve(std::span<const Column> columns) const {
+    if (const auto* index = std::get_if<std::size_t>(&ref_)) {
+        if (*index >= columns.size()) {
+            return std::unexpected(transform_error(ErrorCode::invalid_argument,
+                "column index " + std::to_string(*index) + " is out of range"));
+        }
+        return *index;
+    }
+    const auto& name = std::get<std::string>(ref_);
+    for (std::size_t index = 0; index < columns.size(); ++index) {
+        if (columns[index].name == name) {
+            return index;
+        }
+    }
+    return std::unexpected(transform_error(ErrorCode::invalid_argument, "unknown column '" + name + "'"));
+}
+
+Expected<Result> filter(const Result& input, const std::vector<Predicate>& predicates) {
+    auto data = columnar(input);
+    if (!data) {
+        return std::unexpected(data.error());
+    }
+    const auto rows = data->row_count();
+    std::vector<std::uint8_t> keep(rows, 1);
+    for (const auto& predicate : predicates) {
+        auto index = predicate.column.resolve(input.columns());
+        if (!index) {
+            return std::unexpected(index.error());
+        }
+        if (auto applied = apply_predicate(data->column(*index), rows, predicate, keep.data()); !applied) {
+            return std::unexpected(applied.error());
+        }
+    }
+
+    std::vector<std::size_t> selected;
+    selected.reserve(static_cast<std::size_t>(std::count(keep.begin(), keep.end(), std::uint8_t{1})));
+    for (std::size_t row = 0; row < rows; ++row) {
+        if (keep[row] != 0) {
+            selected.push_back(row);
+        }
+    }
+    return gather(input, *data, selected);
+}
+
+Expected<Result> sort_by(const Result& input, const std::vector<SortKey>& keys) {
+    auto data = columnar(input);
+    if (!data) {
+        return std::unexpected(data.error());
+    }
+    std::vector<std::pair<const ColumnBuffer*, bool>> resolved;
+    resolved.reserve(keys.size());
+    for (const auto& key : keys) {
+        auto index = key.column.resolve(input.columns());
+        if (!index) {
+            return std::unexpected(index.error());
+        }
+        resolved.emplace_back(&data->column(*index), key.descending);
+    }
+
+    std::vector<std::size_t> order;
+    if (resolved.size() == 1 && resolved.front().first->null_count == 0 && is_numeric(resolved.front().first->column.type)) {
+        const auto& [buffer, descending] = resolved.front();
+        switch (buffer->column.type) {
+            case ColumnType::signed_integer: order = sort_single(buffer->int64_values, descending); break;
+            case ColumnType::unsigned_integer: order = sort_single(buffer->uint64_values, descending); break;
+            default: order = sort_single(buffer->double_values, descending); break;
+        }
+    } else {
+        order.resize(data->row_count());
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::stable_sort(order.begin(), order.end(), [&resolved](std::size_t left, std::size_t right) {
+            for (const auto& [buffer, descending] : resolved) {
+                if (const auto order = compare_cells(*buffer, left, right); order != 0) {
+                    return descending ? order > 0 : order < 0;
+                }
+            }
+            return false;
+        });
+    }
+    return gather(input, *data, order);
+}
+
+Expected<Result> group_by(const Result& input, const std::vector<ColumnRef>& keys, const std::vector<Aggregate>& aggregates) {
+    auto data = columnar(input);
+    if (!data) {
+        return std::unexpected(data.error());
+    }
+    const auto rows = data->row_count();
+    std::vector<const ColumnBuffer*> key_buffers;
+    std::vector<Column> columns;
+    for (const auto& key : keys) {
+        auto index = key.resolve(input.columns());
+        if (!index) {
+            return std::unexpected(index.error());
+        }
+        key_buffers.push_back(&data->column(*index));
+        columns.push_back(input.columns()[*index]);
+    }
+
+    // Rows are assigned to groups through a flat open-addressing table of group ids, probed
+    // linearly and checked against each group's first row.
+    std::vector<std::size_t> group_of(rows, 0);
+    std::vector<std::size_t> first_rows;
+    if (key_buffers.empty()) {
+        first_rows.push_back(no_row);
+    } else {
+        if (rows >= std::numeric_limits<std::uint32_t>::max()) {
+            return std::unexpected(transform_error(ErrorCode::invalid_argument, "too many rows to group"));
+        }
+        std::vector<std::uint64_t> hashes(rows, 0);
+        for (const auto* buffer : key_buffers) {
+            hash_column(*buffer, hashes);
+        }
+        constexpr auto empty = std::numeric_limits<std::uint32_t>::max();
+        const auto capacity = std::bit_ceil(std::max<std::size_t>(16, rows * 2));
+        std::vector<std::uint32_t> table(capacity, empty);
+        std::vector<std::uint64_t> group_hashes;
+        const auto same_keys = [&key_buffers](std::size_t left, std::size_t right) {
+            return std::all_of(key_buffers.begin(), key_buffers.end(),
+                               [left, right](const ColumnBuffer* buffer) { return compare_cells(*buffer, left, right) == 0; });
+        };
+        for (std::size_t row = 0; row < rows; ++row) {
+            const auto hash = hashes[row];
+            for (auto slot = hash & (capacity - 1);; slot = (slot + 1) & (capacity - 1)) {
+                const auto group = table[slot];
+                if (group == empty) {
+                    table[slot] = static_cast<std::uint32_t>(first_rows.size());
+                    group_of[row] = first_rows.size();
+                    first_rows.push_back(row);
+                    group_hashes.push_back(hash);
+                    break;
+                }
+                if (group_hashes[group] == hash && same_keys(first_rows[group], row)) {
+                    group_of[row] = group;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<AggregateState> states;
+    states.reserve(aggregates.size());
+    for (const auto& aggregate : aggregates) {
+        auto state = prepare_aggregate(input.columns(), *data, aggregate, first_rows.size());
+        if (!state) {
+            return std::unexpected(state.error());
+        }
+        if (auto accumulated = accumulate(*state, group_of); !accumulated) {
+            return std::unexpected(accumulated.error());
+        }
+        columns.push_back(state->column);
+        states.push_back(std::move(*state));
+    }
+
+    std::vector<Result::RowStorage> output(first_rows.size());
+    for (std::size_t group = 0; group < first_rows.size(); ++group) {
+        auto& row = output[group];
+        row.reserve(columns.size());
+        for (const auto* buffer : key_buffers) {
+            row.push_back(to_value(buffer->value(first_rows[group])));
+        }
+        for (const auto& state : states) {
+            row.push_back(aggregate_value(state, group));
+        }
+    }
+    return Result(std::move(columns), std::move(output));
+}
+
+Expected<Result> hash_join(const Result& left, const Result& right, const std::vector<ColumnRef>& left_keys,
+                           const std::vector<ColumnRef>& right_keys, const JoinOptions& options) {
+    if (left_keys.empty() || left_keys.size() != right_keys.size()) {
+        return std::unexpected(transform_error(ErrorCode::invalid_argument, "hash_join needs matching, non-empty key lists"));
+    }
+    auto left_side = prepare_join_side(left, left_keys);
+    if (!left_side) {
+        return std::unexpected(left_side.error());
+    }
+    auto right_side = prepare_join_side(right, right_keys);
+    if (!right_side) {
+        return std::unexpected(right_side.error());
+    }
+    for (std::size_t key = 0; key < left_keys.size(); ++key) {
+        const auto left_family = key_family(left_side->keys[key]->column.type);
+        const auto right_family = key_family(right_side->keys[key]->column.type);
+        if (left_family != right_family && left_family != KeyFamily::none && right_family != KeyFamily::none) {
+            return std::unexpected(transform_error(ErrorCode::type_mismatch,
+                "cannot join '" + left_side->keys[key]->column.name + "' with '" + right_side->keys[key]->column.name + "'"));
+        }
+    }
+
+    const bool build_left = left.row_count() < right.row_count();
+    const auto& build = build_left ? *left_side : *right_side;
+    const auto& probe = build_left ? *right_side : *left_side;
+    const auto build_rows = build.data.row_count();
+    if (build_rows >= std::numeric_limits<std::uint32_t>::max()) {
+        return std::unexpected(transform_error(ErrorCode::invalid_argument, "too many rows to join"));
+    }
+
+    // heads is a flat open-addressing table holding the first build row of each distinct key;
+    // next chains the build rows that share it, in input order.
+    constexpr auto empty = std::numeric_limits<std::uint32_t>::max();
+    const auto capacity = std::bit_ceil(std::max<std::size_t>(16, build_rows * 2));
+    std::vector<std::uint32_t> heads(capacity, empty);
+    std::vector<std::uint32_t> next(build_rows, empty);
+    for (auto row = build_rows; row-- > 0;) {
+        if (has_null_key(build.keys, row)) {
+            continue;
+        }
+        for (auto slot = build.hashes[row] & (capacity - 1);; slot = (slot + 1) & (capacity - 1)) {
+            const auto head = heads[slot];
+            if (head == empty) {
+                heads[slot] = static_cast<std::uint32_t>(row);
+                break;
+            }
+            if (build.hashes[head] == build.hashes[row] && keys_equal(build.keys, head, build.keys, row)) {
+                next[row] = head;
+                heads[slot] = static_cast<std::uint32_t>(row);
+                break;
+            }
+        }
+    }
+
+    const bool left_join = options.kind == JoinKind::left;
+    std::vector<std::pair<std::size_t, std::size_t>> pairs;
+    std::vector<std::uint8_t> matched(left_join && build_left ? build_rows : 0, 0);
+    for (std::size_t row = 0; row < probe.data.row_count(); ++row) {
+        bool found = false;
+        if (!has_null_key(probe.keys, row)) {
+            const auto hash = probe.hashes[row];
+            for (auto slot = hash & (capacity - 1); heads[slot] != empty; slot = (slot + 1) & (capacity - 1)) {
+                const auto head = heads[slot];
+                if (build.hashes[head] != hash || !keys_equal(build.keys, head, probe.keys, row)) {
+                    continue;
+                }
+                for (auto match = head; match != empty; match = next[match]) {
+                    pairs.emplace_back(build_left ? match : row, build_left ? row : match);
+                    if (!matched.empty()) {
+                        matched[match] = 1;
+                    }
+                }
+                found = true;
+                break;
+            }
+        }
+        if (!found && left_join && !build_left) {
+            pairs.emplace_back(row, no_row);
+        }
+    }
+    if (!matched.empty()) {
+        // Probing the right input produced the pairs in right-row order; regroup them by left row
+        // so each unmatched left row keeps its place, as when the left input is probed.
+        std::vector<std::size_t> offsets(build_rows + 1, 0);
+        for (const auto& pair : pairs) {
+            ++offsets[pair.first + 1];
+        }
+        for (std::size_t row = 0; row < build_rows; ++row) {
+            offsets[row + 1] += matched[row] == 0 ? 1 : 0;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<std::pair<std::size_t, std::size_t>> ordered(offsets.back());
+        for (std::size_t row = 0; row < build_rows; ++row) {
+            if (matched[row] == 0) {
+                ordered[offsets[row]++] = {row, no_row};
+            }
+        }
+        for (const auto& pair : pairs) {
+            ordered[offsets[pair.first]++] = pair;
+        }
+        pairs = std::move(ordered);
+    }
+
+    std::vector<Column> columns(left.columns().begin(), left.columns().end());
+    for (auto column : right.columns()) {
+        if (std::any_of(left.columns().begin(), left.columns().end(),
+                        [&column](const Column& existing) { return existing.name == column.name; })) {
+            column.name = options.right_prefix + column.name;
+        }
+        column.nullable = column.nullable || left_join;
+        columns.push_back(std::move(column));
+    }
+
+    const auto left_buffers = left_side->data.columns();
+    const auto right_buffers = right_side->data.columns();
+    std::vector<Result::RowStorage> output(pairs.size());
+    for (std::size_t index = 0; index < pairs.size(); ++index) {
+        const auto [left_row, right_row] = pairs[index];
+        auto& row = output[index];
+        row.reserve(columns.size());
+        for (const auto& buffer : left_buffers) {
+            row.push_back(to_value(buffer.value(left_row)));
+        }
+        for (const auto& buffer : right_buffers) {
+            row.push_back(right_row == no_row ? Value{nullptr} : to_value(buffer.value(right_row)));
+        }
+    }
+    return Result(std::move(columns), std::move(output));
+}
+
+} // namespace mysqlw
@@ -0,0 +1,612 @@
+#include "mysqlwrapper/shared_cache.hpp"
+
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mysqlw {
+namespace {
+
+DbError cache_error(ErrorCode code, std::string message) {
+    return DbError{
+        .code = code,
+        .operation = Operation::shared_cache,
+        .message = std::move(message)
+    };
+}
+
+} // namespace
+
+#ifndef _WIN32
+
+namespace {
+
+DbError errno_error(std::string_view prefix, const std::string& name) {
+    return cache_error(ErrorCode::io_failed, std::string(prefix) + " " + name + ": " + std::strerror(errno));
+}
+
+constexpr std::uint64_t index_magic = 0x3130584449434d57; // "MWCIDX01"
+constexpr std::uint64_t index_version = 3;
+constexpr std::uint64_t claimed = std::uint64_t{1} << 63;
+constexpr std::size_t probe_limit = 16;
+// A writer that has not published this long after taking its id is treated as abandoned.
+constexpr std::int64_t abandoned_claim_ns = 5'000'000'000;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::int64_t>::is_always_lock_free,
+              "the shared index needs address-free atomics");
+
+struct IndexHeader {
+    std::atomic<std::uint64_t> ready;
+    std::uint64_t version;
+    std::uint64_t slot_count;
+    std::uint64_t capacity_bytes;
+    std::atomic<std::uint64_t> next_id;
+};
+
+// entry is 0 when empty, an id while published, and id | claimed while a writer fills in the
+// other fields. Entry ids are never reused, so entry doubles as the slot's sequence number: the
+// fields read between two loads that return the same id, or before a successful
+// compare-and-swap on it, belong to that id. Ids are never behind the clock, so a claimed
+// entry also says when its writer started, whoever held the slot before.
+//
+// bytes is the size of whatever the slot holds, published or claimed. The capacity is charged
+// through the slots rather than a shared counter, so a writer that dies between claiming and
+// publishing cannot leak any of it.
+struct Slot {
+    std::atomic<std::uint64_t> entry;
+    std::atomic<std::uint64_t> key_hash;
+    std::atomic<std::int64_t> expires;
+    std::atomic<std::uint64_t> bytes;
+};
+
+std::int64_t now_ns() noexcept {
+    // CLOCK_MONOTONIC on POSIX, which every process on the host shares.
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::size_t align8(std::size_t size) noexcept {
+    return (size + 7) & ~std::size_t{7};
+}
+
+std::uint64_t hash_key(std::string_view key) noexcept {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const auto character : key) {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::string encode_key(std::string_view sql, std::span<const Value> params) {
+    std::string key;
+    put<std::uint64_t>(key, sql.size());
+    key.append(sql);
+    for (const auto& param : params) {
+        key.push_back(static_cast<char>(param.index()));
+        std::visit([&key](const auto& value) {
+            using T = std::decay_t<decltype(value)>;
+            if constexpr (std::same_as<T, std::string> || std::same_as<T, Blob>) {
+                put<std::uint64_t>(key, value.size());
+                key.append(reinterpret_cast<const char*>(value.data()), value.size());
+            } else if constexpr (std::same_as<T, bool>) {
+                key.push_back(value ? '\1' : '\0');
+            } else if constexpr (!std::same_as<T, std::nullptr_t>) {
+                put<T>(key, value);
+            }
+        }, param);
+    }
+    return key;
+}
+
+bool valid_name(std::string_view name) noexcept {
+    return name.size() > 1 && name.size() <= 200 && name.front() == '/' && name.find('/', 1) == std::string_view::npos;
+}
+
+std::string entry_name(std::string_view index_name, std::uint64_t id) {
+    return std::string(index_name) + "." + std::to_string(id);
+}
+
+struct Mapping {
+    void* address = MAP_FAILED;
+    std::size_t size = 0;
+
+    Mapping() = default;
+    Mapping(void* mapped, std::size_t length) noexcept : address(mapped), size(length) {}
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+    ~Mapping() {
+        if (address != MAP_FAILED) {
+            ::munmap(address, size);
+        }
+    }
+};
+
+Expected<std::shared_ptr<Mapping>> map_object(const std::string& name, int flags, std::size_t minimum_size) {
+    const int fd = ::shm_open(name.c_str(), flags, 0600);
+    if (fd < 0) {
+        return std::unexpected(errno_error("cannot open shared memory", name));
+    }
+    struct stat status {};
+    if (::fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < minimum_size) {
+        ::close(fd);
+        return std::unexpected(cache_error(ErrorCode::io_failed, "shared memory " + name + " is truncated"));
+    }
+    const auto size = static_cast<std::size_t>(status.st_size);
+    const int protection = (flags & O_ACCMODE) == O_RDWR ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* address = ::mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+    auto error = address == MAP_FAILED ? errno_error("cannot map shared memory", name) : DbError{};
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        return std::unexpected(std::move(error));
+    }
+    return std::make_shared<Mapping>(address, size);
+}
+
+} // namespace
+
+class SharedResultCache::Impl {
+public:
+    Impl(SharedCacheOptions options, std::shared_ptr<Mapping> index)
+        : options_(std::move(options)),
+          index_(std::move(index)),
+          header_(static_cast<IndexHeader*>(index_->address)),
+          slots_(reinterpret_cast<Slot*>(header_ + 1)),
+          mask_(header_->slot_count - 1) {}
+
+    std::shared_ptr<const detail::ResultSnapshot> find(std::string_view sql, std::span<const Value> params) {
+        const auto key = encode_key(sql, params);
+        const auto hash = hash_key(key);
+        const auto now = now_ns();
+        for (std::size_t probe = 0; probe < probe_limit; ++probe) {
+            auto& slot = slots_[(hash + probe) & mask_];
+            const auto id = slot.entry.load(std::memory_order_acquire);
+            if (id == 0 || (id & claimed) != 0) {
+                continue;
+            }
+            const auto key_hash = slot.key_hash.load(std::memory_order_relaxed);
+            const auto expires = slot.expires.load(std::memory_order_relaxed);
+            // Pairs with the fence in claim(): if the slot was reused while the fields were read,
+            // entry no longer holds id.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.entry.load(std::memory_order_relaxed) != id || key_hash != hash || expires <= now) {
+                continue;
+            }
+            if (auto snapshot = open_entry(id, key)) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return snapshot;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Expected<void> insert(std::string_view sql, std::span<const Value> params, const Result& result,
+                          std::chrono::milliseconds ttl) {
+        auto encoded = detail::encode_snapshot(result);
+        if (!encoded) {
+            return std::unexpected(encoded.error());
+        }
+        const auto key = encode_key(sql, params);
+        const auto hash = hash_key(key);
+        const auto size = sizeof(std::uint64_t) + align8(key.size()) + encoded->size();
+        if (size > header_->capacity_bytes) {
+            return std::unexpected(cache_error(ErrorCode::invalid_argument,
+                "result of " + std::to_string(size) + " bytes exceeds the shared cache capacity"));
+        }
+
+        const auto id = next_id();
+        const auto name = entry_name(options_.name, id);
+        if (auto written = write_entry(name, key, *encoded, size); !written) {
+            return written;
+        }
+
+        Slot* target = claim(hash, id, size);
+        if (target == nullptr) {
+            ::shm_unlink(name.c_str());
+            return std::unexpected(cache_error(ErrorCode::io_failed, "no free shared cache slot"));
+        }
+        if (!make_room(*target)) {
+            auto observed = id | claimed;
+            (void)target->entry.compare_exchange_strong(observed, 0, std::memory_order_acq_rel);
+            ::shm_unlink(name.c_str());
+            return std::unexpected(cache_error(ErrorCode::io_failed, "shared cache is full"));
+        }
+        const auto lifetime = ttl > std::chrono::milliseconds::zero() ? ttl : options_.ttl;
+        target->key_hash.store(hash, std::memory_order_relaxed);
+        target->expires.store(now_ns() + std::chrono::duration_cast<std::chrono::nanoseconds>(lifetime).count(),
+                              std::memory_order_relaxed);
+        // Publishing fails if the claim was taken over as abandoned; the object is then ours alone.
+        if (auto observed = id | claimed;
+            !target->entry.compare_exchange_strong(observed, id, std::memory_order_release, std::memory_order_relaxed)) {
+            ::shm_unlink(name.c_str());
+            return std::unexpected(cache_error(ErrorCode::io_failed, "shared cache slot was taken over"));
+        }
+        inserts_.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+
+    SharedCacheStats stats() const {
+        return SharedCacheStats{
+            .hits = hits_.load(std::memory_order_relaxed),
+            .misses = misses_.load(std::memory_order_relaxed),
+            .inserts = inserts_.load(std::memory_order_relaxed),
+            .evictions = evictions_.load(std::memory_order_relaxed),
+            .used_bytes = used_bytes(),
+            .capacity_bytes = header_->capacity_bytes
+        };
+    }
+
+private:
+    struct OpenedEntry {
+        std::string key;
+        std::shared_ptr<const detail::ResultSnapshot> snapshot;
+    };
+
+    SharedCacheOptions options_;
+    std::shared_ptr<Mapping> index_;
+    IndexHeader* header_;
+    Slot* slots_;
+    std::uint64_t mask_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> inserts_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    // Entries this process has already mapped and validated, so a hit costs no system calls.
+    std::mutex opened_mutex_;
+    std::unordered_map<std::uint64_t, OpenedEntry> opened_;
+    std::size_t sweep_at_ = 64;
+
+    std::shared_ptr<const detail::ResultSnapshot> open_entry(std::uint64_t id, const std::string& key) {
+        std::lock_guard lock(opened_mutex_);
+        if (const auto found = opened_.find(id); found != opened_.end()) {
+            return found->second.key == key ? found->second.snapshot : nullptr;
+        }
+
+        // Evicted between the index lookup and here; that is a miss.
+        auto mapping = map_object(entry_name(options_.name, id), O_RDONLY, sizeof(std::uint64_t));
+        if (!mapping) {
+            return nullptr;
+        }
+        const auto* bytes = static_cast<const std::byte*>((*mapping)->address);
+        const auto size = (*mapping)->size;
+        std::uint64_t key_length = 0;
+        std::memcpy(&key_length, bytes, sizeof(key_length));
+        if (key_length > size - sizeof(key_length)) {
+            return nullptr;
+        }
+        auto entry_key = std::string(reinterpret_cast<const char*>(bytes + sizeof(key_length)), key_length);
+        const auto offset = sizeof(key_length) + align8(key_length);
+        if (offset > size) {
+            return nullptr;
+        }
+        const auto data = std::span<const std::byte>(bytes + offset, size - offset);
+        auto snapshot = detail::ResultSnapshot::open(std::shared_ptr<const void>(*mapping, bytes), data);
+        if (!snapshot) {
+            return nullptr;
+        }
+
+        if (opened_.size() >= sweep_at_) {
+            sweep_opened();
+        }
+        auto stored = opened_.emplace(id, OpenedEntry{.key = std::move(entry_key), .snapshot = std::move(*snapshot)}).first;
+        return stored->second.key == key ? stored->second.snapshot : nullptr;
+    }
+
+    // Drops mappings of entries that are no longer in the index. Results already handed out keep
+    // their own reference.
+    void sweep_opened() {
+        std::erase_if(opened_, [this](const auto& opened) {
+            const auto hash = hash_key(opened.second.key);
+            for (std::size_t probe = 0; probe < probe_limit; ++probe) {
+                if (slots_[(hash + probe) & mask_].entry.load(std::memory_order_relaxed) == opened.first) {
+                    return false;
+                }
+            }
+            return true;
+        });
+        sweep_at_ = std::max<std::size_t>(64, opened_.size() * 2);
+    }
+
+    Expected<void> write_entry(const std::string& name, const std::string& key, const std::string& encoded,
+                               std::size_t size) {
+        const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            return std::unexpected(errno_error("cannot create shared cache entry", name));
+        }
+        void* address = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        auto error = address == MAP_FAILED ? errno_error("cannot size shared cache entry", name) : DbError{};
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            ::shm_unlink(name.c_str());
+            return std::unexpected(std::move(error));
+        }
+        auto* bytes = static_cast<char*>(address);
+        const std::uint64_t key_length = key.size();
+        std::memcpy(bytes, &key_length, sizeof(key_length));
+        std::memcpy(bytes + sizeof(key_length), key.data(), key.size());
+        std::memcpy(bytes + sizeof(key_length) + align8(key.size()), encoded.data(), encoded.size());
+        ::munmap(address, size);
+        return {};
+    }
+
+    // The clock, or one past the last id when ids run ahead of it.
+    std::uint64_t next_id() noexcept {
+        auto last = header_->next_id.load(std::memory_order_relaxed);
+        std::uint64_t id = 0;
+        do {
+            id = std::max(last + 1, static_cast<std::uint64_t>(now_ns()));
+        } while (!header_->next_id.compare_exchange_weak(last, id, std::memory_order_relaxed));
+        return id;
+    }
+
+    // Sums the slots that hold an entry. Only insert() and stats() need it, and a claimed slot
+    // counts from the moment it is claimed.
+    std::uint64_t used_bytes() const noexcept {
+        std::uint64_t used = 0;
+        for (std::uint64_t index = 0; index < header_->slot_count; ++index) {
+            if (slots_[index].entry.load(std::memory_order_relaxed) != 0) {
+                used += slots_[index].bytes.load(std::memory_order_relaxed);
+            }
+        }
+        return used;
+    }
+
+    // Takes the slot from whoever holds `observed` and unlinks that entry. Fails when another
+    // process got there first.
+    bool evict(Slot& slot, std::uint64_t observed, std::uint64_t replacement) {
+        if (!slot.entry.compare_exchange_strong(observed, replacement, std::memory_order_acq_rel)) {
+            return false;
+        }
+        if (observed != 0) {
+            ::shm_unlink(entry_name(options_.name, observed & ~claimed).c_str());
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool reclaimable(const Slot& slot, std::uint64_t entry, std::int64_t now) const noexcept {
+        if (entry == 0) {
+            return true;
+        }
+        if ((entry & claimed) != 0) {
+            return static_cast<std::int64_t>(entry & ~claimed) + abandoned_claim_ns < now;
+        }
+        return slot.expires.load(std::memory_order_relaxed) <= now;
+    }
+
+    // Claims a slot in the probe window for id: the same key first, then a free or expired slot,
+    // then the entry closest to expiry. The slot is charged size bytes from here on.
+    Slot* claim(std::uint64_t hash, std::uint64_t id, std::uint64_t size) {
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            const auto now = now_ns();
+            Slot* chosen = nullptr;
+            std::uint64_t chosen_entry = 0;
+            Slot* soonest = nullptr;
+            std::uint64_t soonest_entry = 0;
+            for (std::size_t probe = 0; probe < probe_limit && chosen == nullptr; ++probe) {
+                auto& slot = slots_[(hash + probe) & mask_];
+                const auto entry = slot.entry.load(std::memory_order_acquire);
+                const bool published = entry != 0 && (entry & claimed) == 0;
+                if ((published && slot.key_hash.load(std::memory_order_relaxed) == hash) || reclaimable(slot, entry, now)) {
+                    chosen = &slot;
+                    chosen_entry = entry;
+                } else if (published && (soonest == nullptr || slot.expires.load(std::memory_order_relaxed) <
+                                                                   soonest->expires.load(std::memory_order_relaxed))) {
+                    soonest = &slot;
+                    soonest_entry = entry;
+                }
+            }
+            if (chosen == nullptr) {
+                chosen = soonest;
+                chosen_entry = soonest_entry;
+            }
+            if (chosen == nullptr) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (evict(*chosen, chosen_entry, id | claimed)) {
+                // Pairs with the fence in find(), which rereads entry to spot these stores.
+                std::atomic_thread_fence(std::memory_order_release);
+                chosen->bytes.store(size, std::memory_order_relaxed);
+                return chosen;
+            }
+        }
+        return nullptr;
+    }
+
+    // Evicts expired entries, then the entries closest to expiry, until the index is back within
+    // capacity. keep is the caller's own claim. The candidates are collected and sorted once, so a
+    // full index costs one pass rather than a rescan per eviction.
+    bool make_room(const Slot& keep) {
+        auto used = used_bytes();
+        if (used <= header_->capacity_bytes) {
+            return true;
+        }
+        struct Candidate {
+            std::int64_t expires;
+            std::uint64_t index;
+            std::uint64_t entry;
+        };
+        std::vector<Candidate> candidates;
+        for (std::uint64_t index = 0; index < header_->slot_count; ++index) {
+            const auto& slot = slots_[index];
+            const auto entry = slot.entry.load(std::memory_order_acquire);
+            if (&slot != &keep && entry != 0 && (entry & claimed) == 0) {
+                candidates.push_back({slot.expires.load(std::memory_order_relaxed), index, entry});
+            }
+        }
+        std::ranges::sort(candidates, {}, &Candidate::expires);
+        for (const auto& candidate : candidates) {
+            auto& slot = slots_[candidate.index];
+            const auto bytes = slot.bytes.load(std::memory_order_relaxed);
+            if (evict(slot, candidate.entry, 0)) {
+                used -= std::min(used, bytes);
+                if (used <= header_->capacity_bytes) {
+                    return true;
+                }
+            }
+        }
+        return used_bytes() <= header_->capacity_bytes;
+    }
+};
+
+Expected<std::unique_ptr<SharedResultCache>> SharedResultCache::open(SharedCacheOptions options) {
+    if (!valid_name(options.name)) {
+        return std::unexpected(cache_error(ErrorCode::invalid_argument,
+            "shared cache name must start with '/' and contain no other '/': " + options.name));
+    }
+
+    const int fd = ::shm_open(options.name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+        const auto slot_count = std::bit_ceil(std::max<std::size_t>(options.slots, probe_limit));
+        const auto size = sizeof(IndexHeader) + slot_count * sizeof(Slot);
+        void* address = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        auto error = address == MAP_FAILED ? errno_error("cannot size shared cache index", options.name) : DbError{};
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            ::shm_unlink(options.name.c_str());
+            return std::unexpected(std::move(error));
+        }
+
+        auto* header = new (address) IndexHeader{};
+        header->version = index_version;
+        header->slot_count = slot_count;
+        header->capacity_bytes = options.capacity_bytes;
+        // Ids start from the clock so a recreated index never collides with objects that a
+        // previous one left mapped.
+        header->next_id.store(static_cast<std::uint64_t>(now_ns()), std::memory_order_relaxed);
+        auto* slots = reinterpret_cast<Slot*>(header + 1);
+        for (std::size_t index = 0; index < slot_count; ++index) {
+            new (&slots[index]) Slot{};
+        }
+        header->ready.store(index_magic, std::memory_order_release);
+        auto index = std::make_shared<Mapping>(address, size);
+        return std::unique_ptr<SharedResultCache>(
+            new SharedResultCache(std::make_unique<Impl>(std::move(options), std::move(index))));
+    }
+    if (errno != EEXIST) {
+        return std::unexpected(errno_error("cannot create shared cache index", options.name));
+    }
+
+    // Another process created the index; wait briefly for it to finish initialising.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (true) {
+        auto index = map_object(options.name, O_RDWR, sizeof(IndexHeader));
+        if (index) {
+            const auto* header = static_cast<const IndexHeader*>((*index)->address);
+            if (header->ready.load(std::memory_order_acquire) == index_magic) {
+                if (header->version != index_version) {
+                    return std::unexpected(cache_error(ErrorCode::io_failed,
+                        "unsupported shared cache index version " + std::to_string(header->version)));
+                }
+                if ((*index)->size < sizeof(IndexHeader) + header->slot_count * sizeof(Slot)) {
+                    return std::unexpected(cache_error(ErrorCode::io_failed, "shared cache index is truncated"));
+                }
+                return std::unique_ptr<SharedResultCache>(
+                    new SharedResultCache(std::make_unique<Impl>(std::move(options), std::move(*index))));
+            }
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return index ? std::unexpected(cache_error(ErrorCode::io_failed, "shared cache index was never initialised"))
+                         : std::unexpected(index.error());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+Expected<void> SharedResultCache::remove(const std::string& name) {
+    if (!valid_name(name)) {
+        return std::unexpected(cache_error(ErrorCode::invalid_argument, "invalid shared cache name: " + name));
+    }
+    if (auto index = map_object(name, O_RDONLY, sizeof(IndexHeader)); index) {
+        const auto* header = static_cast<const IndexHeader*>((*index)->address);
+        if (header->ready.load(std::memory_order_acquire) == index_magic &&
+            (*index)->size >= sizeof(IndexHeader) + header->slot_count * sizeof(Slot)) {
+            const auto* slots = reinterpret_cast<const Slot*>(header + 1);
+            for (std::uint64_t index_slot = 0; index_slot < header->slot_count; ++index_slot) {
+                if (const auto entry = slots[index_slot].entry.load(std::memory_order_acquire); entry != 0) {
+                    ::shm_unlink(entry_name(name, entry & ~claimed).c_str());
+                }
+            }
+        }
+    }
+    if (::shm_unlink(name.c_str()) != 0 && errno != ENOENT) {
+        return std::unexpected(errno_error("cannot remove shared cache index", name));
+    }
+    return {};
+}
+
+std::optional<Result> SharedResultCache::find(std::string_view sql, std::span<const Value> params) {
+    if (auto snapshot = impl_->find(sql, params)) {
+        return Result(std::move(snapshot));
+    }
+    return std::nullopt;
+}
+
+Expected<void> SharedResultCache::insert(std::string_view sql, std::span<const Value> params, const Result& result,
+                                         std::chrono::milliseconds ttl) {
+    return impl_->insert(sql, params, result, ttl);
+}
+
+SharedCacheStats SharedResultCache::stats() const {
+    return impl_->stats();
+}
+
+#else
+
+// Windows has no POSIX shared memory; open() reports that and no instance is ever created.
+class SharedResultCache::Impl {};
+
+Expected<std::unique_ptr<SharedResultCache>> SharedResultCache::open(SharedCacheOptions) {
+    return std::unexpected(cache_error(ErrorCode::invalid_argument, "the shared result cache requires POSIX shared memory"));
+}
+
+Expected<void> SharedResultCache::remove(const std::string&) {
+    return std::unexpected(cache_error(ErrorCode::invalid_argument, "the shared result cache requires POSIX shared memory"));
+}
+
+std::optional<Result> SharedResultCache::find(std::string_view, std::span<const Value>) {
+    return std::nullopt;
+}
+
+Expected<void> SharedResultCache::insert(std::string_view, std::span<const Value>, const Result&, std::chrono::milliseconds) {
+    return std::unexpected(cache_error(ErrorCode::invalid_argument, "the shared result cache requires POSIX shared memory"));
+}
+
+SharedCacheStats SharedResultCache::stats() const {
+    return {};
+}
+
+#endif
+
+SharedResultCache::SharedResultCache(std::unique_ptr<Impl> impl) noexcept : impl_(std::move(impl)) {}
+
+SharedResultCache::~SharedResultCache() = default;
+
+} // namespace mysqlw
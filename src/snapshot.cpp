@@ -0,0 +1,422 @@
+#include "snapshot.hpp"
+
+#include "mysqlwrapper/columnar.hpp"
+
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Snapshot layout, version 1. Integers are little-endian and every section starts on an 8-byte
+// boundary, so a mapping is readable without copying.
+//
+//   header (32 bytes)
+//     char[8] magic "MWRSLT\0\1"   u32 version   u32 byte-order tag 0x01020304
+//     u64 row_count                u32 column_count   u32 reserved
+//   column directory (64 bytes per column)
+//     u8 type   u8 nullable   u8 unsigned   u8 reserved   u32 name_length
+//     u64 name_offset   u64 null_count   u64 validity_offset   u64 values_offset
+//     u64 values_size   u64 offsets_offset   u64 reserved
+//   sections, referenced by absolute offset
+//     validity: one bit per row, least significant bit first, set when not NULL; present only
+//               when null_count > 0
+//     values:   int64 / uint64 / double per row, one bit per row for booleans, the concatenated
+//               bytes for text and blobs, nothing for the null type
+//     offsets:  row_count + 1 u64 offsets into values, for text and blobs only
+//
+// Readers reject other versions. A writer that changes the layout bumps the version.
+
+namespace mysqlw {
+namespace detail {
+namespace {
+
+constexpr std::string_view snapshot_magic{"MWRSLT\0\1", 8};
+constexpr std::uint32_t snapshot_version = 1;
+constexpr std::uint32_t byte_order_tag = 0x01020304;
+constexpr std::size_t header_size = 32;
+constexpr std::size_t entry_size = 64;
+
+DbError snapshot_error(std::string message) {
+    return DbError{
+        .code = ErrorCode::io_failed,
+        .operation = Operation::snapshot,
+        .message = std::move(message)
+    };
+}
+
+DbError errno_error(std::string_view prefix, const std::string& path) {
+    return snapshot_error(std::string(prefix) + " " + path + ": " + std::strerror(errno));
+}
+
+template <typename T>
+void store(std::string& out, std::size_t offset, T value) {
+    std::memcpy(out.data() + offset, &value, sizeof(value));
+}
+
+template <typename T>
+T load(const std::byte* data, std::size_t index = 0) noexcept {
+    T value;
+    std::memcpy(&value, data + index * sizeof(T), sizeof(value));
+    return value;
+}
+
+std::uint64_t append_section(std::string& out, const void* data, std::size_t size) {
+    out.resize((out.size() + 7) & ~std::size_t{7}, '\0');
+    const auto offset = out.size();
+    out.append(static_cast<const char*>(data), size);
+    return offset;
+}
+
+std::uint64_t append_bits(std::string& out, std::vector<std::uint8_t> bits, std::size_t rows) {
+    bits.resize((rows + 7) / 8, 0);
+    return append_section(out, bits.data(), bits.size());
+}
+
+bool in_bounds(std::size_t size, std::uint64_t offset, std::uint64_t length) noexcept {
+    return offset <= size && length <= size - offset;
+}
+
+bool bit_set(const std::byte* bits, std::size_t index) noexcept {
+    return (std::to_integer<unsigned>(bits[index / 8]) >> (index % 8) & 1U) != 0;
+}
+
+} // namespace
+
+Expected<std::string> encode_snapshot(const Result& result) {
+    if constexpr (std::endian::native != std::endian::little) {
+        return std::unexpected(snapshot_error("snapshots are only supported on little-endian hosts"));
+    }
+
+    auto columnar = ColumnarResult::from_result(result);
+    if (!columnar) {
+        return std::unexpected(columnar.error());
+    }
+    const auto rows = columnar->row_count();
+    const auto columns = columnar->columns();
+
+    std::string out(header_size + entry_size * columns.size(), '\0');
+    out.replace(0, snapshot_magic.size(), snapshot_magic);
+    store<std::uint32_t>(out, 8, snapshot_version);
+    store<std::uint32_t>(out, 12, byte_order_tag);
+    store<std::uint64_t>(out, 16, rows);
+    store<std::uint32_t>(out, 24, static_cast<std::uint32_t>(columns.size()));
+
+    for (std::size_t index = 0; index < columns.size(); ++index) {
+        const auto& buffer = columns[index];
+        const auto name_offset = append_section(out, buffer.column.name.data(), buffer.column.name.size());
+        const auto validity_offset = buffer.null_count != 0 ? append_bits(out, buffer.validity, rows) : 0;
+
+        std::uint64_t values_offset = 0;
+        std::uint64_t values_size = 0;
+        std::uint64_t offsets_offset = 0;
+        switch (buffer.column.type) {
+            case ColumnType::null:
+                break;
+            case ColumnType::signed_integer:
+                values_size = rows * sizeof(std::int64_t);
+                values_offset = append_section(out, buffer.int64_values.data(), values_size);
+                break;
+            case ColumnType::unsigned_integer:
+                values_size = rows * sizeof(std::uint64_t);
+                values_offset = append_section(out, buffer.uint64_values.data(), values_size);
+                break;
+            case ColumnType::floating:
+                values_size = rows * sizeof(double);
+                values_offset = append_section(out, buffer.double_values.data(), values_size);
+                break;
+            case ColumnType::boolean:
+                values_size = (rows + 7) / 8;
+                values_offset = append_bits(out, buffer.bool_bits, rows);
+                break;
+            case ColumnType::text:
+            case ColumnType::blob: {
+                values_size = buffer.bytes.size();
+                values_offset = append_section(out, buffer.bytes.data(), values_size);
+                std::vector<std::uint64_t> offsets(buffer.offsets.begin(), buffer.offsets.end());
+                offsets.resize(rows + 1, values_size);
+                offsets_offset = append_section(out, offsets.data(), offsets.size() * sizeof(std::uint64_t));
+                break;
+            }
+        }
+
+        const auto entry = header_size + entry_size * index;
+        out[entry] = static_cast<char>(buffer.column.type);
+        out[entry + 1] = buffer.column.nullable ? '\1' : '\0';
+        out[entry + 2] = buffer.column.unsigned_value ? '\1' : '\0';
+        store<std::uint32_t>(out, entry + 4, static_cast<std::uint32_t>(buffer.column.name.size()));
+        store<std::uint64_t>(out, entry + 8, name_offset);
+        store<std::uint64_t>(out, entry + 16, buffer.null_count);
+        store<std::uint64_t>(out, entry + 24, validity_offset);
+        store<std::uint64_t>(out, entry + 32, values_offset);
+        store<std::uint64_t>(out, entry + 40, values_size);
+        store<std::uint64_t>(out, entry + 48, offsets_offset);
+    }
+    return out;
+}
+
+Expected<std::shared_ptr<const ResultSnapshot>> ResultSnapshot::open(std::shared_ptr<const void> owner,
+                                                                     std::span<const std::byte> bytes) {
+    if constexpr (std::endian::native != std::endian::little) {
+        return std::unexpected(snapshot_error("snapshots are only supported on little-endian hosts"));
+    }
+    const auto size = bytes.size();
+    const auto* data = bytes.data();
+    if (size < header_size || std::memcmp(data, snapshot_magic.data(), snapshot_magic.size()) != 0) {
+        return std::unexpected(snapshot_error("not a result snapshot"));
+    }
+    if (const auto version = load<std::uint32_t>(data + 8); version != snapshot_version) {
+        return std::unexpected(snapshot_error("unsupported snapshot version " + std::to_string(version)));
+    }
+    if (load<std::uint32_t>(data + 12) != byte_order_tag) {
+        return std::unexpected(snapshot_error("snapshot byte order does not match this host"));
+    }
+    const auto rows = load<std::uint64_t>(data + 16);
+    const auto column_count = load<std::uint32_t>(data + 24);
+    if (column_count > (size - header_size) / entry_size) {
+        return std::unexpected(snapshot_error("snapshot column directory is truncated"));
+    }
+
+    std::shared_ptr<ResultSnapshot> snapshot(new ResultSnapshot());
+    snapshot->row_count_ = static_cast<std::size_t>(rows);
+    snapshot->columns_.reserve(column_count);
+    snapshot->mapped_.reserve(column_count);
+    const auto bitmap_size = rows / 8 + (rows % 8 != 0 ? 1 : 0);
+    // Set once a column stores something per row, which bounds rows by the size checks below.
+    bool rows_backed = false;
+
+    for (std::size_t index = 0; index < column_count; ++index) {
+        const auto* entry = data + header_size + entry_size * index;
+        const auto type = std::to_integer<std::uint8_t>(entry[0]);
+        const auto name_length = load<std::uint32_t>(entry + 4);
+        const auto name_offset = load<std::uint64_t>(entry + 8);
+        const auto null_count = load<std::uint64_t>(entry + 16);
+        const auto validity_offset = load<std::uint64_t>(entry + 24);
+        const auto values_offset = load<std::uint64_t>(entry + 32);
+        const auto values_size = load<std::uint64_t>(entry + 40);
+        const auto offsets_offset = load<std::uint64_t>(entry + 48);
+
+        const auto corrupt = [index](std::string_view what) {
+            return std::unexpected(snapshot_error("snapshot column " + std::to_string(index) + " has " + std::string(what)));
+        };
+        if (type > static_cast<std::uint8_t>(ColumnType::boolean)) {
+            return corrupt("an unknown type");
+        }
+        if (!in_bounds(size, name_offset, name_length)) {
+            return corrupt("a truncated name");
+        }
+        if (null_count > rows || (null_count != 0 && !in_bounds(size, validity_offset, bitmap_size))) {
+            return corrupt("a truncated validity bitmap");
+        }
+
+        MappedColumn mapped{
+            .type = static_cast<ColumnType>(type),
+            .validity = null_count != 0 ? data + validity_offset : nullptr,
+            .values = data + values_offset
+        };
+        std::uint64_t expected_values = values_size;
+        switch (mapped.type) {
+            case ColumnType::null:
+                expected_values = 0;
+                break;
+            case ColumnType::signed_integer:
+            case ColumnType::unsigned_integer:
+            case ColumnType::floating:
+                expected_values = rows > size / 8 ? size + 1 : rows * 8;
+                break;
+            case ColumnType::boolean:
+                expected_values = bitmap_size;
+                break;
+            case ColumnType::text:
+            case ColumnType::blob: {
+                if (rows >= size / 8 || !in_bounds(size, offsets_offset, (rows + 1) * 8)) {
+                    return corrupt("truncated offsets");
+                }
+                mapped.offsets = data + offsets_offset;
+                // Offsets are checked once here so view() can slice without bounds checks.
+                std::uint64_t previous = 0;
+                for (std::size_t row = 0; row <= rows; ++row) {
+                    const auto offset = load<std::uint64_t>(mapped.offsets, row);
+                    if (offset < previous || (row == 0 && offset != 0)) {
+                        return corrupt("decreasing offsets");
+                    }
+                    previous = offset;
+                }
+                if (previous != values_size) {
+                    return corrupt("offsets past its values");
+                }
+                break;
+            }
+        }
+        if (values_size != expected_values || !in_bounds(size, values_offset, values_size)) {
+            return corrupt("truncated values");
+        }
+        rows_backed = rows_backed || null_count != 0 || mapped.type != ColumnType::null;
+
+        snapshot->columns_.push_back(Column{
+            .name = std::string(reinterpret_cast<const char*>(data + name_offset), name_length),
+            .type = mapped.type,
+            .nullable = std::to_integer<std::uint8_t>(entry[1]) != 0,
+            .unsigned_value = std::to_integer<std::uint8_t>(entry[2]) != 0
+        });
+        snapshot->mapped_.push_back(mapped);
+    }
+    // Without per-row data nothing else limits row_count, and rows() allocates for each row.
+    if (!rows_backed && rows > size) {
+        return std::unexpected(snapshot_error("snapshot row count exceeds its size"));
+    }
+    snapshot->owner_ = std::move(owner);
+    return snapshot;
+}
+
+std::size_t ResultSnapshot::row_count() const noexcept {
+    return row_count_;
+}
+
+const std::vector<Column>& ResultSnapshot::columns() const noexcept {
+    return columns_;
+}
+
+ValueView ResultSnapshot::view(std::size_t row, std::size_t column) const noexcept {
+    const auto& mapped = mapped_[column];
+    if (mapped.validity != nullptr && !bit_set(mapped.validity, row)) {
+        return nullptr;
+    }
+    switch (mapped.type) {
+        case ColumnType::null:
+            return nullptr;
+        case ColumnType::signed_integer:
+            return load<std::int64_t>(mapped.values, row);
+        case ColumnType::unsigned_integer:
+            return load<std::uint64_t>(mapped.values, row);
+        case ColumnType::floating:
+            return load<double>(mapped.values, row);
+        case ColumnType::boolean:
+            return bit_set(mapped.values, row);
+        case ColumnType::text:
+        case ColumnType::blob: {
+            const auto begin = load<std::uint64_t>(mapped.offsets, row);
+            const auto length = static_cast<std::size_t>(load<std::uint64_t>(mapped.offsets, row + 1) - begin);
+            if (mapped.type == ColumnType::text) {
+                return std::string_view(reinterpret_cast<const char*>(mapped.values) + begin, length);
+            }
+            return std::span<const std::byte>(mapped.values + begin, length);
+        }
+    }
+    return nullptr;
+}
+
+const std::vector<Result::RowStorage>& ResultSnapshot::rows() const {
+    std::call_once(decode_once_, [this] {
+        rows_.reserve(row_count_);
+        for (std::size_t row = 0; row < row_count_; ++row) {
+            auto& values = rows_.emplace_back();
+            values.reserve(columns_.size());
+            for (std::size_t column = 0; column < columns_.size(); ++column) {
+                values.push_back(to_value(view(row, column)));
+            }
+        }
+    });
+    return rows_;
+}
+
+} // namespace detail
+
+Result::Result(std::shared_ptr<const detail::ResultSnapshot> snapshot)
+    : columns_(snapshot->columns()), snapshot_(std::move(snapshot)) {
+    rebuild_index();
+}
+
+Expected<void> Result::save(const std::string& path) const {
+    auto encoded = detail::encode_snapshot(*this);
+    if (!encoded) {
+        return std::unexpected(encoded.error());
+    }
+
+    // Written beside the target and renamed over it, so processes that mapped the previous file
+    // keep reading it unchanged.
+    const auto temporary = path + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        return std::unexpected(detail::errno_error("cannot create snapshot", temporary));
+    }
+    const bool written = std::fwrite(encoded->data(), 1, encoded->size(), file) == encoded->size();
+    const bool closed = std::fclose(file) == 0;
+    std::error_code error;
+    if (!written || !closed) {
+        std::filesystem::remove(temporary, error);
+        return std::unexpected(detail::snapshot_error("cannot write snapshot " + temporary));
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        return std::unexpected(detail::snapshot_error("cannot replace snapshot " + path + ": " + error.message()));
+    }
+    return {};
+}
+
+Expected<Result> Result::map(const std::string& path) {
+    std::shared_ptr<const void> owner;
+    std::span<const std::byte> bytes;
+#ifdef _WIN32
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return std::unexpected(detail::errno_error("cannot open snapshot", path));
+    }
+    auto contents = std::make_shared<std::string>();
+    char chunk[64 * 1024];
+    for (std::size_t read = 0; (read = std::fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+        contents->append(chunk, read);
+    }
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed) {
+        return std::unexpected(detail::snapshot_error("cannot read snapshot " + path));
+    }
+    bytes = std::as_bytes(std::span<const char>(*contents));
+    owner = std::move(contents);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::unexpected(detail::errno_error("cannot open snapshot", path));
+    }
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+        auto error = detail::errno_error("cannot stat snapshot", path);
+        ::close(fd);
+        return std::unexpected(std::move(error));
+    }
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return std::unexpected(detail::snapshot_error("not a result snapshot: " + path));
+    }
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    auto map_error = address == MAP_FAILED ? detail::errno_error("cannot map snapshot", path) : DbError{};
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        return std::unexpected(std::move(map_error));
+    }
+    owner = std::shared_ptr<const void>(address, [size](const void* mapped) { ::munmap(const_cast<void*>(mapped), size); });
+    bytes = std::span<const std::byte>(static_cast<const std::byte*>(address), size);
+#endif
+
+    auto snapshot = detail::ResultSnapshot::open(std::move(owner), bytes);
+    if (!snapshot) {
+        return std::unexpected(snapshot.error());
+    }
+    return Result(std::move(*snapshot));
+}
+
+} // namespace mysqlw
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace mysqlw::detail {
+
+// Encodes result in the snapshot format read by ResultSnapshot; see snapshot.cpp for the layout.
+[[nodiscard]] Expected<std::string> encode_snapshot(const Result& result);
+
+// A validated, read-only view of an encoded snapshot. Cells are read straight from the encoded
+// bytes, which `owner` keeps alive (a file mapping, a shared-memory segment, a string).
+class ResultSnapshot {
+public:
+    [[nodiscard]] static Expected<std::shared_ptr<const ResultSnapshot>> open(std::shared_ptr<const void> owner,
+                                                                              std::span<const std::byte> bytes);
+
+    [[nodiscard]] std::size_t row_count() const noexcept;
+    [[nodiscard]] const std::vector<Column>& columns() const noexcept;
+    [[nodiscard]] ValueView view(std::size_t row, std::size_t column) const noexcept;
+
+    // Owned rows for RowView::at() and values(), decoded once on first use.
+    [[nodiscard]] const std::vector<Result::RowStorage>& rows() const;
+
+private:
+    struct MappedColumn {
+        ColumnType type = ColumnType::null;
+        const std::byte* validity = nullptr;
+        const std::byte* values = nullptr;
+        const std::byte* offsets = nullptr;
+    };
+
+    ResultSnapshot() = default;
+
+    std::shared_ptr<const void> owner_;
+    std::size_t row_count_ = 0;
+    std::vector<Column> columns_;
+    std::vector<MappedColumn> mapped_;
+    mutable std::once_flag decode_once_;
+    mutable std::vector<Result::RowStorage> rows_;
+};
+
+} // namespace mysqlw::detail
@@ -0,0 +1,263 @@
+#include "mysqlwrapper/table_scan.hpp"
+
+#include "identifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <future>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace mysqlw {
+namespace {
+
+DbError scan_error(ErrorCode code, std::string message) {
+    return DbError{
+        .code = code,
+        .operation = Operation::scan,
+        .message = std::move(message)
+    };
+}
+
+Expected<std::optional<std::int64_t>> key_value(const Value& value, std::string_view what) {
+    if (std::holds_alternative<std::nullptr_t>(value)) {
+        return std::nullopt;
+    }
+    if (const auto* signed_value = std::get_if<std::int64_t>(&value)) {
+        return *signed_value;
+    }
+    if (const auto* unsigned_value = std::get_if<std::uint64_t>(&value);
+        unsigned_value != nullptr && *unsigned_value <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+        return static_cast<std::int64_t>(*unsigned_value);
+    }
+    return std::unexpected(scan_error(ErrorCode::type_mismatch, std::string(what) + " is not a 64-bit integer key"));
+}
+
+std::int64_t add_offset(std::int64_t base, std::uint64_t offset) noexcept {
+    return static_cast<std::int64_t>(static_cast<std::uint64_t>(base) + offset);
+}
+
+struct Sample {
+    // Rows read from the sample point and the key offset of the last one.
+    std::uint64_t count = 0;
+    std::uint64_t last_offset = 0;
+};
+
+// Splits [first, last] into chunk start keys of roughly equal estimated row counts. Sample i
+// was read from the start of segment i; its density is extrapolated across the segment, and a
+// sample that ran off the end of the table caps the segment at what it saw.
+std::vector<std::int64_t> chunk_starts(std::int64_t first, const std::vector<std::uint64_t>& segment_begin,
+                                       const std::vector<Sample>& samples, std::size_t sample_rows, std::size_t chunks) {
+    const auto segments = samples.size();
+    std::vector<long double> estimated(segments, 0.0L);
+    long double total = 0.0L;
+    for (std::size_t segment = 0; segment < segments; ++segment) {
+        const auto& sample = samples[segment];
+        if (sample.count == 0) {
+            continue;
+        }
+        const auto width = static_cast<long double>(segment_begin[segment + 1] - segment_begin[segment]);
+        const auto observed = static_cast<long double>(sample.last_offset - segment_begin[segment]) + 1.0L;
+        auto rows = static_cast<long double>(sample.count) * width / observed;
+        if (sample.count < sample_rows) {
+            rows = std::min(rows, static_cast<long double>(sample.count));
+        }
+        estimated[segment] = rows;
+        total += rows;
+    }
+
+    std::vector<std::int64_t> starts{first};
+    if (total <= 0.0L) {
+        return starts;
+    }
+    const auto target = total / static_cast<long double>(chunks);
+    long double cumulative = 0.0L;
+    std::size_t segment = 0;
+    for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+        const auto goal = target * static_cast<long double>(chunk);
+        while (segment < segments && cumulative + estimated[segment] < goal) {
+            cumulative += estimated[segment];
+            ++segment;
+        }
+        if (segment == segments) {
+            break;
+        }
+        const auto width = static_cast<long double>(segment_begin[segment + 1] - segment_begin[segment]);
+        const auto offset = static_cast<long double>(segment_begin[segment]) +
+                            std::ceil((goal - cumulative) / estimated[segment] * width);
+        const auto cut = static_cast<std::uint64_t>(std::min(offset, static_cast<long double>(segment_begin.back() - 1)));
+        if (cut > static_cast<std::uint64_t>(starts.back() - first)) {
+            starts.push_back(add_offset(first, cut));
+        }
+    }
+    return starts;
+}
+
+} // namespace
+
+Expected<ScanStats> scan_table(Database& database, const ScanOptions& options, const ChunkConsumer& consumer) {
+    if (options.table.empty() || options.key.empty() || options.parallelism == 0 || options.sample_points == 0 ||
+        options.sample_rows == 0) {
+        return std::unexpected(scan_error(ErrorCode::invalid_argument,
+            "scan_table needs a table, a key, and non-zero parallelism and sampling"));
+    }
+    const auto started = std::chrono::steady_clock::now();
+    const auto table = detail::quote_qualified(options.table);
+    const auto key = detail::quote_identifier(options.key);
+    const auto filter = options.where.empty() ? std::string() : " AND (" + options.where + ")";
+    ScanStats stats;
+
+    auto bounds = database.query("SELECT MIN(" + key + "), MAX(" + key + ") FROM " + table +
+                                 (options.where.empty() ? std::string() : " WHERE (" + options.where + ")"));
+    if (!bounds) {
+        return std::unexpected(bounds.error());
+    }
+    if (bounds->empty() || bounds->column_count() < 2) {
+        return std::unexpected(scan_error(ErrorCode::result_fetch_failed, "key bounds query returned no row"));
+    }
+    auto first = key_value(bounds->row(0).at(std::size_t{0}), "MIN(" + options.key + ")");
+    auto last = key_value(bounds->row(0).at(std::size_t{1}), "MAX(" + options.key + ")");
+    if (!first || !last) {
+        return std::unexpected(!first ? first.error() : last.error());
+    }
+    if (!*first || !*last) {
+        stats.elapsed = std::chrono::steady_clock::now() - started;
+        return stats;
+    }
+
+    // Sample the key density: from evenly spaced points, count the next sample_rows keys and see
+    // how far they reach.
+    const auto span = static_cast<std::uint64_t>(**last) - static_cast<std::uint64_t>(**first);
+    const auto segments = static_cast<std::size_t>(
+        std::min<long double>(static_cast<long double>(options.sample_points), static_cast<long double>(span) + 1.0L));
+    std::vector<std::uint64_t> segment_begin(segments + 1);
+    for (std::size_t segment = 0; segment < segments; ++segment) {
+        segment_begin[segment] = static_cast<std::uint64_t>(
+            (static_cast<long double>(span) + 1.0L) * static_cast<long double>(segment) / static_cast<long double>(segments));
+    }
+    // One past the last offset; for a full 64-bit key range this wraps, which no real table hits.
+    segment_begin[segments] = span + 1;
+
+    const auto sample_sql = "SELECT COUNT(*), MAX(" + key + ") FROM (SELECT " + key + " FROM " + table + " WHERE " + key +
+                            " >= ?" + filter + " ORDER BY " + key + " LIMIT " + std::to_string(options.sample_rows) +
+                            ") AS key_sample";
+    std::vector<std::future<Expected<Result>>> pending;
+    pending.reserve(segments);
+    for (std::size_t segment = 0; segment < segments; ++segment) {
+        pending.push_back(database.query_async(sample_sql, add_offset(**first, segment_begin[segment])));
+    }
+    std::vector<Sample> samples(segments);
+    for (std::size_t segment = 0; segment < segments; ++segment) {
+        auto sampled = pending[segment].get();
+        ++stats.sample_queries;
+        if (!sampled) {
+            return std::unexpected(sampled.error());
+        }
+        if (sampled->empty() || sampled->column_count() < 2) {
+            continue;
+        }
+        auto count = key_value(sampled->row(0).at(std::size_t{0}), "sample COUNT(*)");
+        auto reached = key_value(sampled->row(0).at(std::size_t{1}), "sample MAX(" + options.key + ")");
+        if (!count || !reached) {
+            return std::unexpected(!count ? count.error() : reached.error());
+        }
+        if (*count && *reached && **count > 0) {
+            samples[segment] = Sample{
+                .count = static_cast<std::uint64_t>(**count),
+                .last_offset = static_cast<std::uint64_t>(**reached) - static_cast<std::uint64_t>(**first)
+            };
+        }
+    }
+
+    const auto wanted_chunks = options.chunks != 0 ? options.chunks : options.parallelism * 4;
+    const auto starts = chunk_starts(**first, segment_begin, samples, options.sample_rows, wanted_chunks);
+    const auto chunk_count = starts.size();
+    const auto chunk_last = [&](std::size_t index) { return index + 1 < chunk_count ? starts[index + 1] - 1 : **last; };
+    const auto chunk_sql = "SELECT " + options.columns + " FROM " + table + " WHERE " + key + " >= ? AND " + key +
+                           " <= ?" + filter + " ORDER BY " + key;
+
+    // Workers claim chunks in key order and stop claiming once window chunks are ahead of the
+    // consumer. The chunk the ordered consumer needs next is always claimed first, so the window
+    // cannot stall it.
+    const auto window = options.parallelism * 2;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<std::size_t, Expected<Result>> completed;
+    std::size_t next_claim = 0;
+    std::size_t delivered = 0;
+    bool stopping = false;
+
+    const auto work = [&] {
+        while (true) {
+            std::size_t index = 0;
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] { return stopping || next_claim >= chunk_count || next_claim - delivered < window; });
+                if (stopping || next_claim >= chunk_count) {
+                    return;
+                }
+                index = next_claim++;
+            }
+            auto rows = database.query(chunk_sql, starts[index], chunk_last(index));
+            {
+                std::lock_guard lock(mutex);
+                completed.emplace(index, std::move(rows));
+            }
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    // Declared after workers so it runs first on every exit path, releasing them to be joined.
+    struct StopOnExit {
+        std::mutex& mutex;
+        std::condition_variable& changed;
+        bool& stopping;
+        ~StopOnExit() {
+            {
+                std::lock_guard lock(mutex);
+                stopping = true;
+            }
+            changed.notify_all();
+        }
+    };
+    const auto thread_count = std::min(options.parallelism, chunk_count);
+    workers.reserve(thread_count);
+    for (std::size_t thread = 0; thread < thread_count; ++thread) {
+        workers.emplace_back(work);
+    }
+    StopOnExit stop_on_exit{mutex, changed, stopping};
+
+    for (std::size_t count = 0; count < chunk_count; ++count) {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [&] { return options.ordered ? completed.contains(count) : !completed.empty(); });
+        auto node = completed.extract(options.ordered ? completed.find(count) : completed.begin());
+        ++delivered;
+        lock.unlock();
+        changed.notify_all();
+
+        if (!node.mapped()) {
+            return std::unexpected(node.mapped().error());
+        }
+        ScanChunk chunk{
+            .index = node.key(),
+            .first_key = starts[node.key()],
+            .last_key = chunk_last(node.key()),
+            .rows = std::move(*node.mapped())
+        };
+        stats.rows += chunk.rows.row_count();
+        ++stats.chunks;
+        if (auto consumed = consumer(chunk); !consumed) {
+            return std::unexpected(consumed.error());
+        }
+    }
+    stats.elapsed = std::chrono::steady_clock::now() - started;
+    return stats;
+}
+
+} // namespace mysqlw
@@ -0,0 +1,379 @@
+#include "mysqlwrapper/traffic_log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace mysqlw {
+namespace {
+
+constexpr std::string_view log_magic{"MWTRAFC\x01", 8};
+constexpr std::size_t flush_threshold = 64 * 1024;
+// Text and blob lengths come from the file, so their buffers grow by at most this much per read.
+constexpr std::size_t read_chunk = 64 * 1024;
+
+enum class ParamTag : std::uint8_t {
+    null,
+    signed_integer,
+    unsigned_integer,
+    floating,
+    text,
+    blob,
+    boolean
+};
+
+DbError io_error(std::string message) {
+    return DbError{
+        .code = ErrorCode::io_failed,
+        .operation = Operation::traffic_log,
+        .message = std::move(message)
+    };
+}
+
+DbError errno_error(std::string_view prefix, const std::string& path) {
+    return io_error(std::string(prefix) + " " + path + ": " + std::strerror(errno));
+}
+
+std::uint64_t zigzag(std::int64_t value) noexcept {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value) noexcept {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+void put_varint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void put_bytes(std::string& out, const void* data, std::size_t size) {
+    put_varint(out, size);
+    out.append(static_cast<const char*>(data), size);
+}
+
+void put_param(std::string& out, const Value& value) {
+    std::visit([&out](const auto& stored) {
+        using T = std::decay_t<decltype(stored)>;
+        if constexpr (std::same_as<T, std::nullptr_t>) {
+            out.push_back(static_cast<char>(ParamTag::null));
+        } else if constexpr (std::same_as<T, std::int64_t>) {
+            out.push_back(static_cast<char>(ParamTag::signed_integer));
+            put_varint(out, zigzag(stored));
+        } else if constexpr (std::same_as<T, std::uint64_t>) {
+            out.push_back(static_cast<char>(ParamTag::unsigned_integer));
+            put_varint(out, stored);
+        } else if constexpr (std::same_as<T, double>) {
+            out.push_back(static_cast<char>(ParamTag::floating));
+            const auto bits = std::bit_cast<std::uint64_t>(stored);
+            for (int shift = 0; shift < 64; shift += 8) {
+                out.push_back(static_cast<char>((bits >> shift) & 0xff));
+            }
+        } else if constexpr (std::same_as<T, std::string>) {
+            out.push_back(static_cast<char>(ParamTag::text));
+            put_bytes(out, stored.data(), stored.size());
+        } else if constexpr (std::same_as<T, Blob>) {
+            out.push_back(static_cast<char>(ParamTag::blob));
+            put_bytes(out, stored.data(), stored.size());
+        } else {
+            out.push_back(static_cast<char>(ParamTag::boolean));
+            out.push_back(stored ? '\1' : '\0');
+        }
+    }, value);
+}
+
+class FileInput {
+public:
+    explicit FileInput(std::FILE* file) noexcept : file_(file) {}
+
+    // Each reader returns false at end of file or on a short read.
+    bool byte(std::uint8_t& value) {
+        const int read = std::fgetc(file_);
+        if (read == EOF) {
+            return false;
+        }
+        value = static_cast<std::uint8_t>(read);
+        return true;
+    }
+
+    bool varint(std::uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::uint8_t next = 0;
+            if (!byte(next)) {
+                return false;
+            }
+            value |= static_cast<std::uint64_t>(next & 0x7f) << shift;
+            if ((next & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool bytes(std::string& out) {
+        std::uint64_t size = 0;
+        if (!varint(size)) {
+            return false;
+        }
+        // A corrupt length ends in a short read rather than one huge allocation.
+        out.clear();
+        while (out.size() < size) {
+            const auto offset = out.size();
+            const auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(size - offset, read_chunk));
+            out.resize(offset + chunk);
+            if (std::fread(out.data() + offset, 1, chunk, file_) != chunk) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::FILE* file_;
+};
+
+bool read_param(FileInput& input, Value& value) {
+    std::uint8_t tag = 0;
+    if (!input.byte(tag)) {
+        return false;
+    }
+    switch (static_cast<ParamTag>(tag)) {
+        case ParamTag::null:
+            value = nullptr;
+            return true;
+        case ParamTag::signed_integer: {
+            std::uint64_t encoded = 0;
+            if (!input.varint(encoded)) {
+                return false;
+            }
+            value = unzigzag(encoded);
+            return true;
+        }
+        case ParamTag::unsigned_integer: {
+            std::uint64_t encoded = 0;
+            if (!input.varint(encoded)) {
+                return false;
+            }
+            value = encoded;
+            return true;
+        }
+        case ParamTag::floating: {
+            std::uint64_t bits = 0;
+            for (int shift = 0; shift < 64; shift += 8) {
+                std::uint8_t next = 0;
+                if (!input.byte(next)) {
+                    return false;
+                }
+                bits |= static_cast<std::uint64_t>(next) << shift;
+            }
+            value = std::bit_cast<double>(bits);
+            return true;
+        }
+        case ParamTag::text: {
+            std::string text;
+            if (!input.bytes(text)) {
+                return false;
+            }
+            value = std::move(text);
+            return true;
+        }
+        case ParamTag::blob: {
+            std::string bytes;
+            if (!input.bytes(bytes)) {
+                return false;
+            }
+            Blob blob(bytes.size());
+            std::memcpy(blob.data(), bytes.data(), bytes.size());
+            value = std::move(blob);
+            return true;
+        }
+        case ParamTag::boolean: {
+            std::uint8_t flag = 0;
+            if (!input.byte(flag)) {
+                return false;
+            }
+            value = flag != 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+Expected<std::unique_ptr<TrafficRecorder>> TrafficRecorder::open(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return std::unexpected(errno_error("cannot open traffic log", path));
+    }
+    if (std::fwrite(log_magic.data(), 1, log_magic.size(), file) != log_magic.size()) {
+        std::fclose(file);
+        return std::unexpected(errno_error("cannot write traffic log", path));
+    }
+    return std::unique_ptr<TrafficRecorder>(new TrafficRecorder(file));
+}
+
+TrafficRecorder::TrafficRecorder(std::FILE* file) noexcept : file_(file), started_(std::chrono::steady_clock::now()) {
+    buffer_.reserve(flush_threshold * 2);
+}
+
+TrafficRecorder::~TrafficRecorder() {
+    (void)flush();
+    std::fclose(file_);
+}
+
+void TrafficRecorder::append(const TrafficRecord& record) {
+    std::lock_guard lock(mutex_);
+    if (failed_) {
+        return;
+    }
+
+    buffer_.push_back(static_cast<char>(record.api));
+    buffer_.push_back(record.ok ? '\1' : '\0');
+    put_varint(buffer_, zigzag((record.timestamp - last_timestamp_).count()));
+    last_timestamp_ = record.timestamp;
+    put_varint(buffer_, static_cast<std::uint64_t>(std::max<std::int64_t>(record.duration.count(), 0)));
+    put_varint(buffer_, record.session);
+
+    const auto [found, inserted] = statement_ids_.try_emplace(record.sql, statement_ids_.size());
+    put_varint(buffer_, (found->second << 1) | (inserted ? 1U : 0U));
+    if (inserted) {
+        put_bytes(buffer_, record.sql.data(), record.sql.size());
+    }
+
+    put_varint(buffer_, record.params.size());
+    for (const auto& param : record.params) {
+        put_param(buffer_, param);
+    }
+
+    if (buffer_.size() >= flush_threshold) {
+        failed_ = std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size();
+        buffer_.clear();
+    }
+}
+
+Expected<void> TrafficRecorder::flush() {
+    std::lock_guard lock(mutex_);
+    if (!failed_ && !buffer_.empty()) {
+        failed_ = std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size();
+        buffer_.clear();
+    }
+    if (failed_ || std::fflush(file_) != 0) {
+        failed_ = true;
+        return std::unexpected(io_error("traffic log write failed"));
+    }
+    return {};
+}
+
+Expected<TrafficLogReader> TrafficLogReader::open(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return std::unexpected(errno_error("cannot open traffic log", path));
+    }
+    char magic[8] = {};
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::string_view(magic, sizeof(magic)) != log_magic) {
+        std::fclose(file);
+        return std::unexpected(io_error("not a traffic log: " + path));
+    }
+    return TrafficLogReader(file);
+}
+
+TrafficLogReader::~TrafficLogReader() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+    }
+}
+
+TrafficLogReader::TrafficLogReader(TrafficLogReader&& other) noexcept
+    : file_(std::exchange(other.file_, nullptr)),
+      statements_(std::move(other.statements_)),
+      last_timestamp_(other.last_timestamp_) {}
+
+TrafficLogReader& TrafficLogReader::operator=(TrafficLogReader&& other) noexcept {
+    if (this != &other) {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+        }
+        file_ = std::exchange(other.file_, nullptr);
+        statements_ = std::move(other.statements_);
+        last_timestamp_ = other.last_timestamp_;
+    }
+    return *this;
+}
+
+Expected<std::optional<TrafficRecord>> TrafficLogReader::next() {
+    FileInput input(file_);
+    std::uint8_t api = 0;
+    if (file_ == nullptr || !input.byte(api)) {
+        return std::nullopt;
+    }
+
+    const auto truncated = [] { return std::unexpected(io_error("traffic log is truncated or corrupt")); };
+    if (api > static_cast<std::uint8_t>(TrafficApi::stream)) {
+        return truncated();
+    }
+
+    TrafficRecord record;
+    record.api = static_cast<TrafficApi>(api);
+    std::uint8_t ok = 0;
+    std::uint64_t timestamp_delta = 0;
+    std::uint64_t duration = 0;
+    std::uint64_t sql_ref = 0;
+    if (!input.byte(ok) || !input.varint(timestamp_delta) || !input.varint(duration) ||
+        !input.varint(record.session) || !input.varint(sql_ref)) {
+        return truncated();
+    }
+    record.ok = ok != 0;
+    last_timestamp_ += std::chrono::nanoseconds(unzigzag(timestamp_delta));
+    record.timestamp = last_timestamp_;
+    record.duration = std::chrono::nanoseconds(static_cast<std::int64_t>(duration));
+
+    const auto statement_index = sql_ref >> 1;
+    if ((sql_ref & 1) != 0) {
+        if (statement_index != statements_.size() || !input.bytes(record.sql)) {
+            return truncated();
+        }
+        statements_.push_back(record.sql);
+    } else if (statement_index < statements_.size()) {
+        record.sql = statements_[statement_index];
+    } else {
+        return truncated();
+    }
+
+    std::uint64_t param_count = 0;
+    // MySQL allows at most 65535 placeholders per statement.
+    if (!input.varint(param_count) || param_count > 65535) {
+        return truncated();
+    }
+    record.params.resize(static_cast<std::size_t>(param_count));
+    for (auto& param : record.params) {
+        if (!read_param(input, param)) {
+            return truncated();
+        }
+    }
+    return record;
+}
+
+std::string_view to_string(TrafficApi api) noexcept {
+    switch (api) {
+        case TrafficApi::query: return "query";
+        case TrafficApi::execute: return "execute";
+        case TrafficApi::query_async: return "query_async";
+        case TrafficApi::execute_async: return "execute_async";
+        case TrafficApi::transaction_begin: return "transaction_begin";
+        case TrafficApi::transaction_query: return "transaction_query";
+        case TrafficApi::transaction_execute: return "transaction_execute";
+        case TrafficApi::transaction_commit: return "transaction_commit";
+        case TrafficApi::transaction_rollback: return "transaction_rollback";
+        case TrafficApi::stream: return "stream";
+    }
+    return "unknown";
+}
+
+} // namespace mysqlw
@@ -0,0 +1,203 @@
+#include "mysqlwrapper/json.hpp"
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include "support/allocation_counter.hpp"
+#include "support/fake_connection.hpp"
+#ifndef _WIN32
+#include "support/mysql_stub_server.hpp"
+#endif
+
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace mysqlw;
+
+namespace {
+
+constexpr std::size_t iterations = 200;
+// ctest treats this exit code as "skipped" (SKIP_RETURN_CODE).
+constexpr int skip_exit_code = 77;
+
+struct Budget {
+    std::string_view name;
+    // Maximum average allocations per call; a regression above it fails the run.
+    double max_allocations;
+    std::function<void()> operation;
+};
+
+const char* env_or_null(const char* name) {
+    const char* value = std::getenv(name);
+    return value == nullptr || value[0] == '\0' ? nullptr : value;
+}
+
+std::string env_or(const char* name, std::string fallback) {
+    const char* value = env_or_null(name);
+    return value == nullptr ? std::move(fallback) : std::string(value);
+}
+
+ConnectionConfig server_config() {
+    ConnectionConfig config;
+    config.host = env_or("MYSQLWRAPPER_TEST_HOST", "127.0.0.1");
+    config.port = static_cast<std::uint16_t>(std::stoul(env_or("MYSQLWRAPPER_TEST_PORT", "3306")));
+    config.user = env_or("MYSQLWRAPPER_TEST_USER", "root");
+    config.password = env_or("MYSQLWRAPPER_TEST_PASSWORD", "mysqlwrapper");
+    config.database = env_or("MYSQLWRAPPER_TEST_DATABASE", "mysqlwrapper_test");
+    config.initial_pool_size = 1;
+    config.max_pool_size = 1;
+    config.worker_count = 1;
+    return config;
+}
+
+Result sample_result() {
+    std::vector<Result::RowStorage> rows;
+    for (std::int64_t id = 0; id < 16; ++id) {
+        rows.push_back(Result::RowStorage{id, std::string("name"), 0.5 * static_cast<double>(id)});
+    }
+    return Result(
+        {
+            Column{.name = "id", .type = ColumnType::signed_integer, .nullable = false},
+            Column{.name = "name", .type = ColumnType::text},
+            Column{.name = "score", .type = ColumnType::floating}
+        },
+        std::move(rows));
+}
+
+void require(bool ok, std::string_view operation) {
+    if (!ok) {
+        std::cerr << operation << " failed\n";
+        std::abort();
+    }
+}
+
+// Budgets are per call and include the backend: against the fake that is one prepared statement
+// per parameterised call; against a server only the wrapper's own C++ allocations are counted
+// because libmysqlclient allocates with malloc.
+std::vector<Budget> budgets(Database& database, const Result& result, bool server) {
+    return {
+        {"query/text", server ? 7.0 : 1.0, [&] { require(database.query("SELECT 1").has_value(), "query"); }},
+        {"query/prepared", server ? 16.0 : 3.0, [&] {
+            require(database.query("SELECT ?", 1).has_value(), "prepared query");
+        }},
+        {"execute/text", 1.0, [&] { require(database.execute("DO 1").has_value(), "execute"); }},
+        {"execute/prepared", server ? 4.0 : 3.0, [&] {
+            require(database.execute("DO ?", 1).has_value(), "prepared execute");
+        }},
+        {"query_async/text", server ? 13.0 : 7.0, [&] {
+            require(database.query_async("SELECT 1").get().has_value(), "async query");
+        }},
+        {"transaction/execute", server ? 6.0 : 4.0, [&] {
+            require(database.transaction([](Transaction& tx) { return tx.execute("DO ?", 1); }).has_value(),
+                    "transaction");
+        }},
+        {"result/by_index", 0.0, [&] {
+            std::int64_t sum = 0;
+            for (std::size_t row = 0; row < result.row_count(); ++row) {
+                sum += std::get<std::int64_t>(result[row].at(0));
+            }
+            require(sum > 0, "result access");
+        }},
+        {"result/by_name", 0.0, [&] {
+            double sum = 0;
+            for (std::size_t row = 0; row < result.row_count(); ++row) {
+                sum += std::get<double>(result[row]["score"]);
+            }
+            require(sum > 0, "result access");
+        }},
+        {"result/get_as_string", 0.0, [&] {
+            std::size_t length = 0;
+            for (std::size_t row = 0; row < result.row_count(); ++row) {
+                length += get_or_throw<std::string>(result[row]["name"]).size();
+            }
+            require(length > 0, "result access");
+        }},
+        {"write_json/reused_buffer", 0.0, [&] {
+            static std::string json;
+            write_json(json, result);
+            require(json.size() > 2, "write_json");
+        }}
+    };
+}
+
+bool run_budgets(std::string_view backend, Database& database, bool server) {
+    const auto result = sample_result();
+    bool within_budget = true;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "allocations per call (" << backend << ", " << iterations << " iterations)\n";
+    for (const auto& budget : budgets(database, result, server)) {
+        const auto measured = testing::measure_allocations(iterations, budget.operation);
+        const bool ok = measured.allocations <= budget.max_allocations;
+        within_budget = within_budget && ok;
+        std::cout << "  " << std::left << std::setw(24) << budget.name << std::right << std::setw(8)
+                  << measured.allocations << " allocs " << std::setw(10) << measured.bytes << " bytes  budget "
+                  << budget.max_allocations << (ok ? "" : "  OVER BUDGET") << '\n';
+    }
+    return within_budget;
+}
+
+#ifndef _WIN32
+// Checks the server budgets with the real client against the wire-protocol stub. The stub's
+// threads are left out of the counts, as a remote server's work would be.
+int run_stub_budgets() {
+    testing::StubServer server(testing::StubServerOptions{.on_thread_start = [] { testing::count_current_thread(false); }});
+    const auto one = Result({Column{.name = "1", .type = ColumnType::signed_integer}}, {Result::RowStorage{std::int64_t{1}}});
+    server.script("SELECT 1", testing::StubResponse{.body = one});
+    server.script("SELECT ?", testing::StubResponse{.body = one});
+
+    auto config = server.connection_config();
+    config.initial_pool_size = 1;
+    config.max_pool_size = 1;
+    config.worker_count = 1;
+    Database database(config);
+    auto probe = database.execute("DO 0");
+    if (!probe && server.stats().connections == 0) {
+        // The client library never reached the socket (for example a stubbed libmysqlclient).
+        std::cout << "mysqlwrapper stub allocation tests skipped: " << probe.error().message << '\n';
+        return skip_exit_code;
+    }
+    require(probe.has_value(), "stub probe");
+    if (!run_budgets("stub", database, true)) {
+        std::cerr << "mysqlwrapper allocation budgets exceeded\n";
+        return 1;
+    }
+    std::cout << "mysqlwrapper stub allocation tests passed\n";
+    return 0;
+}
+#endif
+
+} // namespace
+
+// With --stub, runs only the server budgets against the in-process stub server.
+int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv) {
+#ifndef _WIN32
+    if (argc > 1 && std::string_view(argv[1]) == "--stub") {
+        return run_stub_budgets();
+    }
+#endif
+    bool ok = true;
+    {
+        ConnectionConfig config;
+        config.initial_pool_size = 1;
+        config.max_pool_size = 1;
+        config.worker_count = 1;
+        Database database(config, testing::make_fake_connection_factory(std::make_shared<testing::FakeBackend>()));
+        ok = run_budgets("fake", database, false) && ok;
+    }
+
+    if (env_or_null("MYSQLWRAPPER_RUN_INTEGRATION") != nullptr) {
+        Database database(server_config());
+        ok = run_budgets("server", database, true) && ok;
+    }
+
+    if (!ok) {
+        std::cerr << "mysqlwrapper allocation budgets exceeded\n";
+        return 1;
+    }
+    std::cout << "mysqlwrapper allocation tests passed\n";
+}
@@ -178,6 +178,31 @@ void test_escape(Database& db) {
     assert(escaped->find("\\'") != std::string::npos);
 }
 
+void test_tls_session_reuse() {
+    auto config = integration_config();
+    config.tls_mode = TlsMode::required;
+    config.initial_pool_size = 1;
+    config.max_pool_size = 4;
+    config.worker_count = 4;
+    Database db(config);
+
+    auto cipher = require_result(db.query("SHOW SESSION STATUS LIKE 'Ssl_cipher'"), "tls cipher");
+    assert(cipher.row_count() == 1 && !get_or_throw<std::string>(cipher[0]["Value"]).empty());
+
+    // Concurrent sleeps force the pool to open more connections, which resume the first session.
+    std::vector<std::future<Expected<Result>>> pending;
+    for (int index = 0; index < 4; ++index) {
+        pending.push_back(db.query_async("SELECT SLEEP(0.2)"));
+    }
+    for (auto& future : pending) {
+        require_result(future.get(), "tls sleep");
+    }
+    const auto tls = db.metrics().tls;
+    assert(tls.full_handshakes >= 1);
+    assert(tls.full_handshakes + tls.resumed_sessions == db.stats().created_connections);
+    assert(tls.resumed_sessions >= 1);
+}
+
 } // namespace
 
 int main() {
@@ -192,6 +217,7 @@ int main() {
     test_transaction_commit_and_rollback(db);
     test_async_queries(db);
     test_escape(db);
+    test_tls_session_reuse();
 
     std::cout << "mysqlwrapper integration tests passed\n";
 }
@@ -0,0 +1,385 @@
+#include "mysqlwrapper/columnar.hpp"
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include "support/mysql_stub_server.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace mysqlw;
+
+namespace {
+
+// ctest treats this exit code as "skipped" (SKIP_RETURN_CODE).
+constexpr int skip_exit_code = 77;
+
+Result user_rows() {
+    return Result(
+        {
+            Column{.name = "id", .type = ColumnType::signed_integer, .nullable = false},
+            Column{.name = "name", .type = ColumnType::text},
+            Column{.name = "score", .type = ColumnType::floating},
+            Column{.name = "payload", .type = ColumnType::blob}
+        },
+        {
+            Result::RowStorage{std::int64_t{1}, std::string("Ada"), 9.5, Blob{std::byte{0x01}, std::byte{0x02}}},
+            Result::RowStorage{std::int64_t{2}, nullptr, 7.25, Blob{}}
+        });
+}
+
+struct UserRecord {
+    std::int64_t id;
+    std::optional<std::string> name;
+    double score;
+    Blob payload;
+};
+
+struct UserScore {
+    float score;
+    std::int32_t id;
+    static constexpr std::array<std::string_view, 2> column_names{"score", "id"};
+};
+
+struct UserIdName {
+    std::int64_t id;
+    std::string name;
+};
+
+struct UserName {
+    std::string name;
+    static constexpr std::array<std::string_view, 1> column_names{"name"};
+};
+
+struct Document {
+    std::int64_t id;
+    std::string title;
+    Blob body;
+};
+
+struct DocumentId {
+    std::uint16_t id;
+    static constexpr std::array<std::string_view, 1> column_names{"id"};
+};
+
+void test_text_and_prepared_queries(testing::StubServer& server, Database& database) {
+    server.script("SELECT id, name, score, payload FROM users", testing::StubResponse{.body = user_rows()});
+
+    auto text = database.query("SELECT id, name, score, payload FROM users");
+    assert(text);
+    assert(text->row_count() == 2);
+    assert(get_or_throw<std::int64_t>((*text)[0]["id"]) == 1);
+    assert(get_or_throw<std::string>((*text)[0]["name"]) == "Ada");
+    assert(get_or_throw<double>((*text)[1]["score"]) == 7.25);
+    assert(get_or_throw<Blob>((*text)[0]["payload"]).size() == 2);
+    assert((*text)[1]["name"].index() == 0);
+
+    std::vector<Value> seen;
+    server.set_handler([&seen](std::string_view sql, std::span<const Value> params) -> std::optional<testing::StubResponse> {
+        if (sql != "SELECT id, name, score, payload FROM users WHERE id = ? AND name = ?") {
+            return std::nullopt;
+        }
+        seen.assign(params.begin(), params.end());
+        return testing::StubResponse{.body = user_rows()};
+    });
+
+    auto prepared = database.query("SELECT id, name, score, payload FROM users WHERE id = ? AND name = ?", 1, "Ada");
+    assert(prepared);
+    assert(prepared->row_count() == 2);
+    assert(get_or_throw<std::int64_t>((*prepared)[1]["id"]) == 2);
+    assert(get_or_throw<double>((*prepared)[0]["score"]) == 9.5);
+    assert(seen.size() == 2);
+    assert(get_or_throw<std::int64_t>(seen[0]) == 1);
+    assert(get_or_throw<std::string>(seen[1]) == "Ada");
+
+    // Repeating the statement reuses the handle prepared on each pooled connection.
+    server.reset_stats();
+    for (int repeat = 0; repeat < 8; ++repeat) {
+        assert(database.query("SELECT id, name, score, payload FROM users WHERE id = ? AND name = ?", 1, "Ada"));
+    }
+    assert(server.stats().executes == 8);
+    assert(server.stats().prepares < 8);
+
+    // A descriptor binds its arguments in place and shares the cached statement.
+    using FindUser = StatementDescriptor<"SELECT id, name, score, payload FROM users WHERE id = ? AND name = ?",
+                                         std::int64_t, std::string_view>;
+    const std::string name = "Grace";
+    for (int repeat = 0; repeat < 4; ++repeat) {
+        auto described = database.query(FindUser{}, 2, name);
+        assert(described);
+        assert(described->row_count() == 2);
+    }
+    assert(server.stats().executes == 12);
+    assert(server.stats().prepares < 12);
+    assert(get_or_throw<std::int64_t>(seen[0]) == 2);
+    assert(get_or_throw<std::string>(seen[1]) == "Grace");
+
+    // query_into() fetches straight into the members, by position or by column name.
+    auto records = database.query_into<UserRecord>(FindUser::sql, 2, "Grace");
+    assert(records);
+    assert(records->size() == 2);
+    assert((*records)[0].id == 1 && (*records)[0].name == "Ada" && (*records)[0].score == 9.5);
+    assert((*records)[0].payload.size() == 2 && (*records)[0].payload[1] == std::byte{0x02});
+    assert((*records)[1].id == 2 && !(*records)[1].name && (*records)[1].payload.empty());
+
+    auto scores = database.query_into<UserScore>(FindUser::sql, 2, "Grace");
+    assert(scores && scores->size() == 2 && (*scores)[1].id == 2 && (*scores)[1].score == 7.25F);
+
+    auto mismatch = database.query_into<UserIdName>(FindUser::sql, 2, "Grace");
+    assert(!mismatch && mismatch.error().code == ErrorCode::type_mismatch);
+    auto null_name = database.query_into<UserName>(FindUser::sql, 2, "Grace");
+    assert(!null_name && null_name.error().code == ErrorCode::type_mismatch);
+    server.set_handler({});
+}
+
+void test_execute_and_errors(testing::StubServer& server, Database& database) {
+    server.script("UPDATE users SET name = 'x'",
+                  testing::StubResponse{.body = ExecuteResult{.affected_rows = 3, .last_insert_id = 0}});
+    server.script("INSERT INTO users (name) VALUES (?)",
+                  testing::StubResponse{.body = ExecuteResult{.affected_rows = 1, .last_insert_id = 42}});
+    server.script("SELECT * FROM missing", testing::StubResponse{.body = DbError{
+        .mysql_errno = 1146, .sql_state = "42S02", .message = "Table 'stub.missing' doesn't exist"}});
+
+    auto updated = database.execute("UPDATE users SET name = 'x'");
+    assert(updated);
+    assert(updated->affected_rows == 3);
+
+    auto inserted = database.execute("INSERT INTO users (name) VALUES (?)", "Grace");
+    assert(inserted);
+    assert(inserted->last_insert_id == 42);
+
+    auto missing = database.query("SELECT * FROM missing");
+    assert(!missing);
+    assert(missing.error().code == ErrorCode::execute_failed);
+    assert(missing.error().mysql_errno == 1146);
+    assert(missing.error().sql_state == "42S02");
+
+    auto committed = database.transaction([](Transaction& tx) { return tx.execute("UPDATE users SET name = 'x'"); });
+    assert(committed);
+    assert(committed->affected_rows == 3);
+}
+
+void test_round_trips_and_delay(testing::StubServer& server, Database& database) {
+    server.script("SELECT 1", testing::StubResponse{
+        .body = Result({Column{.name = "1", .type = ColumnType::signed_integer}}, {Result::RowStorage{std::int64_t{1}}}),
+        .delay = std::chrono::milliseconds{20}});
+
+    server.reset_stats();
+    const auto started = std::chrono::steady_clock::now();
+    auto selected = database.query("SELECT 1");
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    assert(selected);
+    assert(elapsed >= std::chrono::milliseconds{20});
+
+    const auto stats = server.stats();
+    assert(stats.queries >= 1);
+    assert(stats.prepares == 0);
+    assert(stats.round_trips() >= 1);
+}
+
+void test_streamed_columnar(testing::StubServer& server, Database& database) {
+    auto rows = user_rows();
+    // Longer than the initial streaming buffer, so the prepared path re-fetches the column. The
+    // rows after it must land in the grown buffer, not the one it replaced.
+    const std::string long_name(100 * 1024, 'n');
+    std::vector<Result::RowStorage> storage;
+    for (std::size_t index = 0; index < rows.row_count(); ++index) {
+        const auto values = rows[index].values();
+        storage.emplace_back(values.begin(), values.end());
+    }
+    storage.push_back(Result::RowStorage{std::int64_t{3}, long_name, 1.0, Blob{}});
+    storage.push_back(Result::RowStorage{std::int64_t{4}, std::string("abc"), 2.0, Blob{}});
+    storage.push_back(Result::RowStorage{std::int64_t{5}, std::string("xyz"), 3.0, Blob{}});
+    const Result long_rows(std::vector<Column>(rows.columns().begin(), rows.columns().end()), std::move(storage));
+    server.set_handler([&long_rows](std::string_view sql, std::span<const Value>) -> std::optional<testing::StubResponse> {
+        if (!sql.starts_with("SELECT id, name, score, payload FROM users")) {
+            return std::nullopt;
+        }
+        return testing::StubResponse{.body = long_rows};
+    });
+
+    for (const bool prepared : {false, true}) {
+        auto columnar = prepared ? query_columnar(database, "SELECT id, name, score, payload FROM users WHERE id > ?", 0)
+                                 : query_columnar(database, "SELECT id, name, score, payload FROM users");
+        assert(columnar);
+        assert(columnar->row_count() == 5);
+        assert(columnar->column("id").int64_values[2] == 3);
+        assert(columnar->column("name").is_null(1));
+        assert(std::get<std::string_view>(columnar->column("name").value(2)) == long_name);
+        assert(std::get<std::string_view>(columnar->column("name").value(3)) == "abc");
+        assert(std::get<std::string_view>(columnar->column("name").value(4)) == "xyz");
+        assert(columnar->column("id").int64_values[4] == 5);
+        assert(columnar->column("score").double_values[0] == 9.5);
+        assert(std::get<std::span<const std::byte>>(columnar->column("payload").value(0)).size() == 2);
+    }
+
+    // A sink that stops early must leave the connection usable for the next call.
+    struct FirstRowOnly final : RowSink {
+        Expected<void> begin(std::span<const Column>) override { return {}; }
+        Expected<void> row(std::span<const ValueView>) override {
+            return std::unexpected(DbError{.code = ErrorCode::invalid_argument, .message = "enough"});
+        }
+    } stop_early;
+    for (const bool prepared : {false, true}) {
+        auto stopped = prepared ? database.stream("SELECT id, name, score, payload FROM users WHERE id > ?", stop_early, 0)
+                                : database.stream("SELECT id, name, score, payload FROM users", stop_early);
+        assert(!stopped && stopped.error().message == "enough");
+        assert(database.query("SELECT id, name, score, payload FROM users"));
+    }
+    server.set_handler({});
+}
+
+void test_cached_statement_reexecute(testing::StubServer& server) {
+    // With one connection every call reuses the same statement handle, and the client writes
+    // through the result lengths bound by the previous fetch when it executes again. That write
+    // comes from the uninstrumented client library, so freed storage shows up as allocator
+    // corruption here rather than as an ASan report; the test also runs under xmake's asan mode.
+    auto config = server.connection_config();
+    config.initial_pool_size = 1;
+    config.max_pool_size = 1;
+    Database single(config);
+
+    const std::string sql = "SELECT id, name, score, payload FROM users WHERE id > ?";
+    server.set_handler([&sql](std::string_view text, std::span<const Value>) -> std::optional<testing::StubResponse> {
+        if (text != sql) {
+            return std::nullopt;
+        }
+        return testing::StubResponse{.body = user_rows()};
+    });
+
+    server.reset_stats();
+    for (int repeat = 0; repeat < 16; ++repeat) {
+        auto rows = single.query(sql, repeat);
+        assert(rows);
+        assert(rows->row_count() == 2);
+        assert(get_or_throw<std::string>((*rows)[0]["name"]) == "Ada");
+        assert(get_or_throw<Blob>((*rows)[0]["payload"]).size() == 2);
+    }
+    assert(server.stats().prepares == 1);
+    assert(server.stats().executes == 16);
+    server.set_handler({});
+}
+
+void test_registered_statement_pinned(testing::StubServer& server) {
+    auto config = server.connection_config();
+    config.initial_pool_size = 1;
+    config.max_pool_size = 1;
+    config.statement_cache_size = 2;
+    Database single(config);
+
+    // One prepare validates the statement and pins it on the only connection.
+    server.reset_stats();
+    assert(single.register_statement("UPDATE users SET seen = 1 WHERE id = ?"));
+    assert(server.stats().prepares == 1);
+
+    // Ad-hoc statements cycle through the remaining slot without evicting it.
+    for (int index = 0; index < 3; ++index) {
+        assert(single.execute("UPDATE users SET score = " + std::to_string(index) + " WHERE id = ?", 1));
+    }
+    assert(server.stats().prepares == 4);
+    assert(single.execute("UPDATE users SET seen = 1 WHERE id = ?", 1));
+    assert(server.stats().prepares == 4);
+    assert(single.metrics().statements.covered_connections == 1);
+}
+
+void test_init_statements(testing::StubServer& server) {
+    // The batch separates the statements itself, so their own terminators must not leave an
+    // empty statement behind.
+    auto config = server.connection_config();
+    config.initial_pool_size = 1;
+    config.max_pool_size = 1;
+    config.init_statements = {"SET time_zone = '+00:00';", "SET sql_mode = 'STRICT_ALL_TABLES' ; "};
+    Database database(config);
+    server.reset_stats();
+    assert(database.execute("SET time_zone = '+00:00'"));
+    assert(server.stats().queries == 0);
+    assert(database.metrics().statements.skipped_session_sets == 1);
+}
+
+void test_query_into_fetch(testing::StubServer& server, Database& database) {
+    // Each new member starts with only its small-string capacity, so longer values are re-read
+    // at full length with mysql_stmt_fetch_column.
+    const std::string title(300, 't');
+    const Blob body(4096, std::byte{0x5a});
+    const std::string sql = "SELECT id, title, body FROM documents WHERE id > ?";
+    Value last_body = Blob{};
+    server.set_handler([&](std::string_view text, std::span<const Value>) -> std::optional<testing::StubResponse> {
+        if (text != sql) {
+            return std::nullopt;
+        }
+        return testing::StubResponse{.body = Result(
+            {
+                Column{.name = "id", .type = ColumnType::signed_integer, .nullable = false},
+                Column{.name = "title", .type = ColumnType::text},
+                Column{.name = "body", .type = ColumnType::blob}
+            },
+            {
+                Result::RowStorage{std::int64_t{1}, std::string("short"), Blob{std::byte{0x01}}},
+                Result::RowStorage{std::int64_t{2}, title, body},
+                Result::RowStorage{std::int64_t{70000}, std::string(16, 'y'), last_body}
+            })};
+    });
+
+    auto documents = database.query_into<Document>(sql, 0);
+    assert(documents && documents->size() == 3);
+    assert((*documents)[0].title == "short" && (*documents)[0].body.size() == 1);
+    assert((*documents)[1].title == title && (*documents)[1].body == body);
+    assert((*documents)[2].id == 70000 && (*documents)[2].title == std::string(16, 'y') && (*documents)[2].body.empty());
+
+    // 70000 does not fit a uint16_t member.
+    auto ids = database.query_into<DocumentId>(sql, 0);
+    assert(!ids && ids.error().code == ErrorCode::type_mismatch);
+
+    // A NULL cannot go into a member that is not std::optional.
+    last_body = nullptr;
+    documents = database.query_into<Document>(sql, 0);
+    assert(!documents && documents.error().code == ErrorCode::type_mismatch);
+    server.set_handler({});
+}
+
+void test_unix_socket_transport() {
+    // Kept short; sun_path holds barely a hundred bytes.
+    const auto path = "/tmp/mw" + std::to_string(::getpid() % 100000) + ".s";
+    testing::StubServer server(testing::StubServerOptions{.unix_socket_path = path});
+    server.script("SELECT 1", testing::StubResponse{
+        .body = Result({Column{.name = "1", .type = ColumnType::signed_integer}}, {Result::RowStorage{std::int64_t{1}}})});
+
+    const auto config = server.connection_config();
+    assert(config.transport == Transport::unix_socket && config.unix_socket == path);
+    Database database(config);
+    auto selected = database.query("SELECT 1");
+    assert(selected && get_or_throw<std::int64_t>((*selected)[0]["1"]) == 1);
+    assert(server.stats().connections >= 1);
+}
+
+} // namespace
+
+int main() {
+    testing::StubServer server;
+    Database database(server.connection_config());
+
+    auto probe = database.execute("DO 0");
+    if (!probe && server.stats().connections == 0) {
+        // The client library never reached the socket (for example a stubbed libmysqlclient).
+        std::cout << "mysqlwrapper stub tests skipped: " << probe.error().message << '\n';
+        return skip_exit_code;
+    }
+    assert(probe);
+
+    test_text_and_prepared_queries(server, database);
+    test_execute_and_errors(server, database);
+    test_round_trips_and_delay(server, database);
+    test_streamed_columnar(server, database);
+    test_query_into_fetch(server, database);
+    test_cached_statement_reexecute(server);
+    test_registered_statement_pinned(server);
+    test_init_statements(server);
+    test_unix_socket_transport();
+    std::cout << "mysqlwrapper stub tests passed\n";
+}
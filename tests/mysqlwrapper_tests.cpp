@@ -1,8 +1,39 @@
+#include "mysqlwrapper/chunked_dml.hpp"
+#include "mysqlwrapper/columnar.hpp"
+#include "mysqlwrapper/csv_export.hpp"
+#include "mysqlwrapper/json.hpp"
+#include "mysqlwrapper/keyset_pager.hpp"
 #include "mysqlwrapper/mysql_wrapper.hpp"
+#include "mysqlwrapper/openmetrics.hpp"
+#include "mysqlwrapper/operators.hpp"
+#include "mysqlwrapper/shared_cache.hpp"
+#include "mysqlwrapper/table_scan.hpp"
+#include "mysqlwrapper/traffic_log.hpp"
 
+#include "support/fake_connection.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace mysqlw;
 
@@ -62,7 +93,1198 @@ void test_failed_connection_returns_expected() {
     assert(status == std::future_status::ready);
     const auto async_result = future.get();
     assert(!async_result);
+
+    const auto metrics = database.metrics();
+    assert(metrics.pool.failed_connections >= 1);
+    assert(metrics.executor.worker_count == 1);
+    assert(metrics.executor.submitted_tasks == 1);
+    assert(database.metrics_source().endpoint == "127.0.0.1:1");
+}
+
+void test_openmetrics_exposition() {
+    Metrics metrics;
+    metrics.pool.idle_connections = 3;
+    metrics.pool.created_connections = 5;
+    metrics.executor.worker_count = 2;
+    metrics.query_latency.bucket_counts[0] = 2;
+    metrics.query_latency.bucket_counts.back() = 1;
+    metrics.query_latency.count = 3;
+    metrics.query_latency.sum_seconds = 7.5;
+
+    const std::array sources{
+        MetricsSource{.database = "orders", .endpoint = "db1:3306", .metrics = metrics},
+        MetricsSource{.database = "quo\"te", .endpoint = "db2:3306", .metrics = Metrics{}}
+    };
+
+    std::string out;
+    write_openmetrics(out, sources);
+    assert(out.find("# TYPE mysqlw_pool_idle_connections gauge\n") != std::string::npos);
+    assert(out.find("mysqlw_pool_idle_connections{database=\"orders\",endpoint=\"db1:3306\"} 3\n") !=
+           std::string::npos);
+    assert(out.find("mysqlw_pool_connections_created_total{database=\"orders\",endpoint=\"db1:3306\"} 5\n") !=
+           std::string::npos);
+    assert(out.find("mysqlw_query_seconds_bucket{database=\"orders\",endpoint=\"db1:3306\",le=\"1e-05\"} 2\n") !=
+           std::string::npos);
+    assert(out.find("mysqlw_query_seconds_bucket{database=\"orders\",endpoint=\"db1:3306\",le=\"5.0\"} 2\n") !=
+           std::string::npos);
+    assert(out.find("mysqlw_query_seconds_bucket{database=\"orders\",endpoint=\"db1:3306\",le=\"+Inf\"} 3\n") !=
+           std::string::npos);
+    assert(out.find("mysqlw_query_seconds_sum{database=\"orders\",endpoint=\"db1:3306\"} 7.5\n") !=
+           std::string::npos);
+    assert(out.find("database=\"quo\\\"te\"") != std::string::npos);
+    assert(out.ends_with("# EOF\n"));
+
+    const auto* data = out.data();
+    write_openmetrics(out, sources);
+    assert(out.data() == data);
+}
+
+void test_fake_connection_factory() {
+    auto config = testing::fake_pool_config(2);
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [](std::string_view sql, std::span<const Value> values) -> Expected<Result> {
+            return Result(
+                {Column{.name = "sql", .type = ColumnType::text}},
+                {Result::RowStorage{std::string(sql)}, Result::RowStorage{static_cast<std::int64_t>(values.size())}});
+        }
+    }, config);
+    assert(backend->connects == 2);
+
+    auto text = database.query("SELECT 1");
+    assert(text);
+    assert(get_or_throw<std::string>((*text)[0]["sql"]) == "SELECT 1");
+
+    auto prepared = database.query("SELECT ?", 7);
+    assert(prepared);
+    assert(get_or_throw<std::int64_t>((*prepared)[1]["sql"]) == 1);
+    assert(backend->prepares == 1);
+
+    auto committed = database.transaction([](Transaction& tx) { return tx.execute("UPDATE t SET v = ?", 1); });
+    assert(committed);
+    assert(committed->affected_rows == 1);
+    assert(backend->executes == 3);
+
+    auto async_result = database.query_async("SELECT 2").get();
+    assert(async_result);
+
+    const auto metrics = database.metrics();
+    assert(metrics.statements.prepared_statements == 2);
+    assert(metrics.query_latency.count == 3);
+    assert(metrics.acquire_latency.count == 4);
+}
+
+void test_latency_histogram_quantile() {
+    LatencyHistogram histogram;
+    histogram.bucket_counts[3] = 50;
+    histogram.bucket_counts[4] = 50;
+    histogram.count = 100;
+    assert(histogram.quantile(0.5) == LatencyHistogram::bucket_bounds[3]);
+    assert(histogram.quantile(0.99) > LatencyHistogram::bucket_bounds[3]);
+    assert(histogram.quantile(0.99) <= LatencyHistogram::bucket_bounds[4]);
+    assert(LatencyHistogram{}.quantile(0.5) == 0.0);
+}
+
+void test_traffic_recording() {
+    auto [backend, database] = testing::make_fake_database();
+
+    const auto path = (std::filesystem::temp_directory_path() / "mysqlwrapper_traffic_test.log").string();
+    assert(database.start_recording(path));
+    assert(database.query("SELECT 1"));
+    assert(database.execute("UPDATE t SET v = ? WHERE id = ?", std::string("x"), std::uint64_t{7}));
+    assert(database.query_async("SELECT ?", 2.5).get());
+    assert(database.transaction([](Transaction& tx) { return tx.execute("UPDATE t SET v = ?", nullptr); }));
+    assert(database.query("SELECT 1"));
+    std::string json;
+    JsonWriter writer(json);
+    assert(database.stream("SELECT ?", writer, 3));
+    assert(database.stop_recording());
+    assert(database.query("SELECT 2"));
+
+    auto reader = TrafficLogReader::open(path);
+    assert(reader);
+    std::vector<TrafficRecord> records;
+    while (true) {
+        auto record = reader->next();
+        assert(record);
+        if (!*record) {
+            break;
+        }
+        records.push_back(std::move(**record));
+    }
+    std::remove(path.c_str());
+
+    assert(records.size() == 8);
+    assert(records[0].api == TrafficApi::query && records[0].sql == "SELECT 1" && records[0].ok);
+    assert(records[1].api == TrafficApi::execute);
+    assert(get_or_throw<std::string>(records[1].params[0]) == "x");
+    assert(get_or_throw<std::uint64_t>(records[1].params[1]) == 7);
+    assert(records[2].api == TrafficApi::query_async);
+    assert(get_or_throw<double>(records[2].params[0]) == 2.5);
+    assert(records[3].api == TrafficApi::transaction_begin && records[3].session != 0);
+    assert(records[4].api == TrafficApi::transaction_execute && records[4].session == records[3].session);
+    assert(records[4].params[0].index() == 0);
+    assert(records[5].api == TrafficApi::transaction_commit && records[5].session == records[3].session);
+    assert(records[6].sql == "SELECT 1" && records[6].session == 0);
+    assert(records[6].timestamp >= records[0].timestamp);
+    assert(records[7].api == TrafficApi::stream && get_or_throw<std::int64_t>(records[7].params[0]) == 3);
+
+    // A record claiming a 2^40-byte SQL text is rejected after reading the bytes that exist.
+    {
+        std::ofstream corrupt(path, std::ios::binary);
+        const char record[] = {'M', 'W', 'T', 'R', 'A', 'F', 'C', '\x01', '\0', '\1', '\0', '\0', '\0', '\x01',
+                               '\x80', '\x80', '\x80', '\x80', '\x80', '\x20', 'S', 'E', 'L'};
+        corrupt.write(record, sizeof(record));
+    }
+    auto corrupt_reader = TrafficLogReader::open(path);
+    assert(corrupt_reader);
+    auto corrupt_record = corrupt_reader->next();
+    assert(!corrupt_record && corrupt_record.error().code == ErrorCode::io_failed);
+    std::remove(path.c_str());
+}
+
+void test_columnar_arrow_export() {
+    const Blob bytes{std::byte{0x00}, std::byte{0xff}};
+    Result result(
+        {
+            Column{.name = "id", .type = ColumnType::signed_integer, .nullable = false},
+            Column{.name = "count", .type = ColumnType::unsigned_integer},
+            Column{.name = "score", .type = ColumnType::floating},
+            Column{.name = "name", .type = ColumnType::text},
+            Column{.name = "payload", .type = ColumnType::blob},
+            Column{.name = "active", .type = ColumnType::boolean}
+        },
+        {
+            Result::RowStorage{std::int64_t{1}, std::uint64_t{10}, 0.5, std::string("Ada"), bytes, true},
+            Result::RowStorage{std::int64_t{2}, nullptr, std::int64_t{3}, nullptr, nullptr, false},
+            Result::RowStorage{std::int64_t{3}, std::int64_t{30}, nullptr, std::string(""), Blob{}, nullptr}
+        });
+
+    auto columnar = ColumnarResult::from_result(result);
+    assert(columnar);
+    assert(columnar->row_count() == 3 && columnar->column_count() == 6);
+    assert(columnar->column("id").null_count == 0);
+    assert(columnar->column("count").is_null(1) && columnar->column("count").uint64_values[2] == 30);
+    assert(columnar->column("score").double_values[1] == 3.0);
+    assert(std::get<std::string_view>(columnar->column("name").value(0)) == "Ada");
+    assert(columnar->column("name").offsets == (std::vector<std::int32_t>{0, 3, 3, 3}));
+    assert(std::get<bool>(columnar->column("active").value(0)));
+    assert(columnar->column("active").is_null(2));
+
+    const auto mismatched = ColumnarResult::from_result(Result(
+        {Column{.name = "id", .type = ColumnType::signed_integer}}, {Result::RowStorage{std::string("x")}}));
+    assert(!mismatched && mismatched.error().code == ErrorCode::type_mismatch);
+
+    ArrowSchema schema{};
+    ArrowArray array{};
+    assert(std::move(*columnar).export_arrow(&schema, &array));
+    assert(columnar->column_count() == 0);
+    assert(std::strcmp(schema.format, "+s") == 0 && schema.n_children == 6);
+    assert(array.length == 3 && array.n_children == 6 && array.n_buffers == 1);
+
+    const char* formats[] = {"l", "L", "g", "u", "z", "b"};
+    for (std::size_t index = 0; index < 6; ++index) {
+        assert(std::strcmp(schema.children[index]->format, formats[index]) == 0);
+    }
+    assert(std::strcmp(schema.children[3]->name, "name") == 0);
+    assert((schema.children[0]->flags & ARROW_FLAG_NULLABLE) == 0);
+    assert((schema.children[1]->flags & ARROW_FLAG_NULLABLE) != 0);
+
+    const ArrowArray& ids = *array.children[0];
+    assert(ids.null_count == 0 && ids.buffers[0] == nullptr);
+    assert(static_cast<const std::int64_t*>(ids.buffers[1])[2] == 3);
+
+    const ArrowArray& names = *array.children[3];
+    assert(names.n_buffers == 3 && names.null_count == 1);
+    assert((static_cast<const std::uint8_t*>(names.buffers[0])[0] & 0b111) == 0b101);
+    assert(std::memcmp(names.buffers[2], "Ada", 3) == 0);
+
+    // A consumer may take ownership of a child and release it after the parent.
+    ArrowArray moved = *array.children[4];
+    array.children[4]->release = nullptr;
+    array.release(&array);
+    assert(array.release == nullptr);
+    assert(static_cast<const std::int32_t*>(moved.buffers[1])[1] == 2);
+    moved.release(&moved);
+    schema.release(&schema);
+    assert(schema.release == nullptr);
+}
+
+void test_stream_to_columnar() {
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [](std::string_view, std::span<const Value> values) -> Expected<Result> {
+            std::vector<Result::RowStorage> rows;
+            for (std::int64_t id = 0; id < 4; ++id) {
+                rows.push_back(Result::RowStorage{id, values.empty() ? Value{nullptr} : values[0]});
+            }
+            return Result({Column{.name = "id", .type = ColumnType::signed_integer},
+                           Column{.name = "tag", .type = ColumnType::text}},
+                          std::move(rows));
+        }
+    });
+
+    auto text = query_columnar(database, "SELECT id, tag FROM t");
+    assert(text && text->row_count() == 4 && text->column("tag").null_count == 4);
+
+    auto prepared = query_columnar(database, "SELECT id, ? AS tag FROM t", std::string("x"));
+    assert(prepared && prepared->column("id").int64_values[3] == 3);
+    assert(std::get<std::string_view>(prepared->column("tag").value(1)) == "x");
+    assert(database.metrics().query_latency.count == 2);
+}
+
+std::string export_to_file(Database& database, const CsvOptions& options, ExportStats& stats) {
+    const auto path = (std::filesystem::temp_directory_path() / "mysqlwrapper_export_test.csv").string();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    assert(file != nullptr);
+    auto exported = export_csv(database, fileno(file), options, "SELECT * FROM export");
+    std::fclose(file);
+    assert(exported);
+    stats = *exported;
+
+    std::ifstream input(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    return contents;
+}
+
+void test_csv_export() {
+    constexpr std::int64_t row_count = 1000;
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [](std::string_view, std::span<const Value>) -> Expected<Result> {
+            std::vector<Result::RowStorage> rows;
+            rows.push_back(Result::RowStorage{std::int64_t{-1}, std::string("a,\"b\"\tc\nd\\"), 0.25,
+                                              Blob{std::byte{0xab}, std::byte{0x01}}, true});
+            rows.push_back(Result::RowStorage{std::int64_t{0}, std::string(""), nullptr, nullptr, false});
+            for (std::int64_t id = 1; id <= row_count - 2; ++id) {
+                rows.push_back(Result::RowStorage{id, std::string("row"), 1.5, Blob{}, nullptr});
+            }
+            return Result({Column{.name = "id", .type = ColumnType::signed_integer},
+                           Column{.name = "text", .type = ColumnType::text},
+                           Column{.name = "score", .type = ColumnType::floating},
+                           Column{.name = "bytes", .type = ColumnType::blob},
+                           Column{.name = "flag", .type = ColumnType::boolean}},
+                          std::move(rows));
+        }
+    });
+
+    ExportStats stats;
+    const auto csv = export_to_file(database, CsvOptions{}, stats);
+    assert(csv.starts_with("id,text,score,bytes,flag\n"
+                           "-1,\"a,\"\"b\"\"\tc\nd\\\",0.25,0xab01,1\n"
+                           "0,\"\",,,0\n"
+                           "1,row,1.5,0x,\n"));
+    assert(stats.rows == row_count && stats.bytes == csv.size() && stats.write_calls >= 1);
+
+    const auto tsv = export_to_file(database, CsvOptions{.format = CsvFormat::tsv, .header = false}, stats);
+    assert(tsv.starts_with("-1\ta,\"b\"\\tc\\nd\\\\\t0.25\t0xab01\t1\n"
+                           "0\t\t\\N\t\\N\t0\n"));
+
+    // Small blocks and batches force many writev calls and out-of-order batch completion.
+    const auto parallel = export_to_file(
+        database, CsvOptions{.block_size = 4096, .blocks_per_write = 2, .format_threads = 3, .batch_rows = 7}, stats);
+    assert(parallel == csv);
+    assert(stats.rows == row_count && stats.write_calls > 1);
+    assert(stats.megabytes_per_second() > 0.0);
+}
+
+void test_json_serialization() {
+    Result result(
+        {
+            Column{.name = "id", .type = ColumnType::signed_integer},
+            Column{.name = "na\"me", .type = ColumnType::text},
+            Column{.name = "score", .type = ColumnType::floating},
+            Column{.name = "bytes", .type = ColumnType::blob},
+            Column{.name = "flag", .type = ColumnType::boolean}
+        },
+        {
+            Result::RowStorage{std::int64_t{-7}, std::string("plain text longer than sixteen bytes \"q\" \\ \n\x01 \xc3\xa9"),
+                               0.1, Blob{std::byte{'M'}, std::byte{'a'}}, true},
+            Result::RowStorage{std::int64_t{18}, nullptr, std::numeric_limits<double>::infinity(), Blob{}, nullptr}
+        });
+
+    const std::string expected_objects =
+        "[{\"id\":-7,\"na\\\"me\":\"plain text longer than sixteen bytes \\\"q\\\" \\\\ \\n\\u0001 \xc3\xa9\","
+        "\"score\":0.1,\"bytes\":\"TWE=\",\"flag\":true},"
+        "{\"id\":18,\"na\\\"me\":null,\"score\":null,\"bytes\":\"\",\"flag\":null}]";
+    std::string out = "stale";
+    write_json(out, result);
+    assert(out == expected_objects);
+
+    auto columnar = ColumnarResult::from_result(result);
+    assert(columnar);
+    write_json(out, *columnar);
+    assert(out == expected_objects);
+
+    write_json(out, *columnar, JsonOptions{.shape = JsonRowShape::arrays});
+    assert(out.starts_with("[[-7,\"plain"));
+    assert(out.ends_with("[18,null,null,\"\",null]]"));
+
+    write_json(out, Result{});
+    assert(out == "[]");
+
+    // More values than keys would write keyless members.
+    JsonWriter writer(out);
+    const Column id{.name = "id", .type = ColumnType::signed_integer};
+    assert(writer.begin(std::span(&id, 1)));
+    const ValueView values[] = {std::int64_t{1}, std::int64_t{2}};
+    auto extra = writer.row(values);
+    assert(!extra && extra.error().code == ErrorCode::invalid_argument);
+}
+
+void test_result_snapshot() {
+    Result result(
+        {
+            Column{.name = "id", .type = ColumnType::signed_integer, .nullable = false},
+            Column{.name = "name", .type = ColumnType::text},
+            Column{.name = "score", .type = ColumnType::floating},
+            Column{.name = "bytes", .type = ColumnType::blob},
+            Column{.name = "flag", .type = ColumnType::boolean},
+            Column{.name = "total", .type = ColumnType::unsigned_integer, .unsigned_value = true}
+        },
+        {
+            Result::RowStorage{std::int64_t{1}, std::string("Ada"), 2.5, Blob{std::byte{0}, std::byte{0xff}}, true,
+                               std::uint64_t{18446744073709551615ULL}},
+            Result::RowStorage{std::int64_t{2}, nullptr, nullptr, Blob{}, false, nullptr},
+            Result::RowStorage{std::int64_t{3}, std::string(), -1.0, nullptr, nullptr, std::uint64_t{7}}
+        });
+
+    const auto path = (std::filesystem::temp_directory_path() / "mysqlwrapper_snapshot_test.bin").string();
+    assert(result.save(path));
+
+    auto mapped = Result::map(path);
+    assert(mapped);
+    assert(mapped->row_count() == 3);
+    assert(mapped->column_count() == 6);
+    assert(mapped->columns()[0].nullable == false);
+    assert(mapped->columns()[5].unsigned_value);
+    assert(mapped->column_index("flag") == 4);
+
+    const auto first = mapped->row(0);
+    assert(std::get<std::int64_t>(first.view(0)) == 1);
+    assert(std::get<std::string_view>(first.view("name")) == "Ada");
+    assert(std::get<double>(first.view("score")) == 2.5);
+    assert(std::get<std::span<const std::byte>>(first.view("bytes")).size() == 2);
+    assert(std::get<bool>(first.view("flag")));
+    assert(std::get<std::uint64_t>(first.view("total")) == 18446744073709551615ULL);
+    assert(std::holds_alternative<std::nullptr_t>(mapped->row(1).view("name")));
+    assert(std::get<std::string_view>(mapped->row(2).view("name")).empty());
+    assert(std::holds_alternative<std::nullptr_t>(mapped->row(2).view("flag")));
+
+    // Owned access decodes the rows once and matches the original.
+    for (std::size_t row = 0; row < result.row_count(); ++row) {
+        for (std::size_t column = 0; column < result.column_count(); ++column) {
+            assert(mapped->row(row).at(column) == result.row(row).at(column));
+        }
+    }
+    std::string from_original;
+    std::string from_mapped;
+    write_json(from_original, result);
+    write_json(from_mapped, *mapped);
+    assert(from_original == from_mapped);
+
+    // The mapping outlives the file being replaced.
+    auto copy = *mapped;
+    assert(Result({Column{.name = "id", .type = ColumnType::signed_integer}}, {}).save(path));
+    assert(std::get<std::string_view>(copy.row(0).view("name")) == "Ada");
+    auto replaced = Result::map(path);
+    assert(replaced && replaced->empty() && replaced->column_count() == 1);
+
+    {
+        std::ofstream corrupt(path, std::ios::binary | std::ios::trunc);
+        corrupt << "MWRSLT";
+    }
+    auto rejected = Result::map(path);
+    assert(!rejected);
+    assert(rejected.error().code == ErrorCode::io_failed);
+    assert(rejected.error().operation == Operation::snapshot);
+    assert(!Result::map(path + ".missing"));
+
+    // A row count that no column backs with data is bounded by the file size.
+    const auto patch_and_map = [&path](const Result& source, std::uint64_t rows, bool clear_null_count) {
+        assert(source.save(path));
+        std::string bytes;
+        {
+            std::ifstream in(path, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        std::memcpy(bytes.data() + 16, &rows, sizeof(rows));
+        if (clear_null_count) {
+            std::memset(bytes.data() + 32 + 16, 0, sizeof(std::uint64_t));
+        }
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+        return Result::map(path);
+    };
+    const Result no_columns({}, {});
+    const Result only_nulls({Column{.name = "n", .type = ColumnType::null}}, {Result::RowStorage{nullptr}});
+    assert(patch_and_map(no_columns, 4, false));
+    assert(!patch_and_map(no_columns, std::uint64_t{1} << 60, false));
+    auto nulls = patch_and_map(only_nulls, 1, false);
+    assert(nulls && nulls->row_count() == 1);
+    assert(!patch_and_map(only_nulls, 1 << 20, false));
+    auto huge = patch_and_map(only_nulls, std::uint64_t{1} << 60, true);
+    assert(!huge && huge.error().operation == Operation::snapshot);
+    std::filesystem::remove(path);
+}
+
+void test_result_operators() {
+    const Result orders(
+        {
+            Column{.name = "region", .type = ColumnType::text},
+            Column{.name = "qty", .type = ColumnType::signed_integer},
+            Column{.name = "price", .type = ColumnType::floating},
+            Column{.name = "id", .type = ColumnType::unsigned_integer, .unsigned_value = true}
+        },
+        {
+            Result::RowStorage{std::string("eu"), std::int64_t{3}, 2.5, std::uint64_t{1}},
+            Result::RowStorage{std::string("us"), std::int64_t{-1}, nullptr, std::uint64_t{2}},
+            Result::RowStorage{nullptr, std::int64_t{7}, 1.0, std::uint64_t{3}},
+            Result::RowStorage{std::string("eu"), nullptr, 4.0, std::uint64_t{4}},
+            Result::RowStorage{std::string("us"), std::int64_t{5}, 3.0, std::uint64_t{5}}
+        });
+    const auto ids = [](const Result& result) {
+        std::vector<std::uint64_t> values;
+        for (std::size_t row = 0; row < result.row_count(); ++row) {
+            values.push_back(get_or_throw<std::uint64_t>(result.row(row)["id"]));
+        }
+        return values;
+    };
+
+    auto positive = filter(orders, {Predicate{.column = "qty", .op = CompareOp::greater, .value = std::int64_t{0}}});
+    assert(positive && ids(*positive) == (std::vector<std::uint64_t>{1, 3, 5}));
+    assert(positive->columns()[3].unsigned_value);
+
+    // NULL cells fail comparisons, including not_equal, and a NULL constant matches nothing.
+    auto not_eu = filter(orders, {Predicate{.column = "region", .op = CompareOp::not_equal, .value = std::string("eu")}});
+    assert(not_eu && ids(*not_eu) == (std::vector<std::uint64_t>{2, 5}));
+    auto null_constant = filter(orders, {Predicate{.column = "qty", .op = CompareOp::equal, .value = nullptr}});
+    assert(null_constant && null_constant->empty());
+    auto missing = filter(orders, {Predicate{.column = 1, .op = CompareOp::is_null}});
+    assert(missing && ids(*missing) == (std::vector<std::uint64_t>{4}));
+
+    auto combined = filter(orders, {Predicate{.column = "price", .op = CompareOp::less, .value = std::int64_t{3}},
+                                    Predicate{.column = "id", .op = CompareOp::greater, .value = std::int64_t{-5}}});
+    assert(combined && ids(*combined) == (std::vector<std::uint64_t>{1, 3}));
+    auto huge = filter(orders, {Predicate{.column = "qty", .op = CompareOp::less, .value = std::numeric_limits<std::uint64_t>::max()}});
+    assert(huge && huge->row_count() == 4);
+
+    auto mismatch = filter(orders, {Predicate{.column = "qty", .op = CompareOp::equal, .value = std::string("3")}});
+    assert(!mismatch && mismatch.error().code == ErrorCode::type_mismatch);
+    auto unknown = filter(orders, {Predicate{.column = "nope", .op = CompareOp::is_null}});
+    assert(!unknown && unknown.error().operation == Operation::transform);
+
+    auto by_qty = sort_by(orders, {SortKey{.column = "qty"}});
+    assert(by_qty && ids(*by_qty) == (std::vector<std::uint64_t>{4, 2, 1, 5, 3}));
+    auto by_price_desc = sort_by(orders, {SortKey{.column = "price", .descending = true}});
+    assert(by_price_desc && ids(*by_price_desc) == (std::vector<std::uint64_t>{4, 5, 1, 3, 2}));
+    auto by_region_then_id = sort_by(orders, {SortKey{.column = "region"}, SortKey{.column = "id", .descending = true}});
+    assert(by_region_then_id && ids(*by_region_then_id) == (std::vector<std::uint64_t>{3, 4, 1, 5, 2}));
+    auto by_id_desc = sort_by(orders, {SortKey{.column = "id", .descending = true}});
+    assert(by_id_desc && ids(*by_id_desc) == (std::vector<std::uint64_t>{5, 4, 3, 2, 1}));
+
+    auto grouped = group_by(orders, {"region"},
+                            {Aggregate{},
+                             Aggregate{.function = AggregateFunction::count, .column = ColumnRef("qty")},
+                             Aggregate{.function = AggregateFunction::sum, .column = ColumnRef("qty"), .name = "total"},
+                             Aggregate{.function = AggregateFunction::min, .column = ColumnRef("price")},
+                             Aggregate{.function = AggregateFunction::max, .column = ColumnRef("price")}});
+    assert(grouped && grouped->row_count() == 3 && grouped->column_count() == 6);
+    assert(grouped->columns()[1].name == "count(*)" && grouped->columns()[3].name == "total");
+    assert(grouped->columns()[4].name == "min(price)");
+    const auto eu = grouped->row(0);
+    assert(get_or_throw<std::string>(eu["region"]) == "eu");
+    assert(get_or_throw<std::int64_t>(eu["count(*)"]) == 2);
+    assert(get_or_throw<std::int64_t>(eu["count(qty)"]) == 1);
+    assert(get_or_throw<std::int64_t>(eu["total"]) == 3);
+    assert(get_or_throw<double>(eu["max(price)"]) == 4.0);
+    const auto us = grouped->row(1);
+    assert(get_or_throw<std::int64_t>(us["total"]) == 4);
+    assert(get_or_throw<double>(us["min(price)"]) == 3.0);
+    const auto no_region = grouped->row(2);
+    assert(std::holds_alternative<std::nullptr_t>(no_region["region"]));
+    assert(get_or_throw<std::int64_t>(no_region["count(*)"]) == 1);
+
+    auto none = filter(orders, {Predicate{.column = "id", .op = CompareOp::is_null}});
+    assert(none && none->empty());
+    auto totals = group_by(*none, {},
+                           {Aggregate{}, Aggregate{.function = AggregateFunction::sum, .column = ColumnRef("price")}});
+    assert(totals && totals->row_count() == 1);
+    assert(get_or_throw<std::int64_t>(totals->row(0)["count(*)"]) == 0);
+    assert(std::holds_alternative<std::nullptr_t>(totals->row(0)["sum(price)"]));
+
+    const Result big({Column{.name = "v", .type = ColumnType::signed_integer}},
+                     {Result::RowStorage{std::numeric_limits<std::int64_t>::max()}, Result::RowStorage{std::int64_t{1}}});
+    auto overflow = group_by(big, {}, {Aggregate{.function = AggregateFunction::sum, .column = ColumnRef(0)}});
+    assert(!overflow && overflow.error().code == ErrorCode::invalid_argument);
+    auto text_sum = group_by(orders, {}, {Aggregate{.function = AggregateFunction::sum, .column = ColumnRef("region")}});
+    assert(!text_sum && text_sum.error().code == ErrorCode::type_mismatch);
+}
+
+void test_hash_join() {
+    const Result users(
+        {Column{.name = "id", .type = ColumnType::signed_integer}, Column{.name = "name", .type = ColumnType::text}},
+        {
+            Result::RowStorage{std::int64_t{1}, std::string("ada")},
+            Result::RowStorage{std::int64_t{2}, std::string("bob")},
+            Result::RowStorage{nullptr, std::string("ghost")},
+            Result::RowStorage{std::int64_t{3}, std::string("cy")}
+        });
+    const Result orders(
+        {
+            Column{.name = "user_id", .type = ColumnType::unsigned_integer, .nullable = false, .unsigned_value = true},
+            Column{.name = "name", .type = ColumnType::text},
+            Column{.name = "amount", .type = ColumnType::floating}
+        },
+        {
+            Result::RowStorage{std::uint64_t{2}, std::string("pen"), 1.5},
+            Result::RowStorage{std::uint64_t{1}, std::string("ink"), 2.0},
+            Result::RowStorage{std::uint64_t{2}, std::string("pad"), 3.0},
+            Result::RowStorage{std::uint64_t{9}, std::string("cap"), 4.0},
+            Result::RowStorage{std::uint64_t{1}, std::string("nib"), 5.0}
+        });
+
+    // users is smaller, so it is the build side and rows follow the orders being probed.
+    auto inner = hash_join(users, orders, {"id"}, {"user_id"});
+    assert(inner && inner->row_count() == 4 && inner->column_count() == 5);
+    assert(inner->columns()[3].name == "right.name");
+    std::vector<std::string> pairs;
+    for (std::size_t row = 0; row < inner->row_count(); ++row) {
+        pairs.push_back(get_or_throw<std::string>(inner->row(row)["name"]) + ":" +
+                        get_or_throw<std::string>(inner->row(row)["right.name"]));
+    }
+    assert(pairs == (std::vector<std::string>{"bob:pen", "ada:ink", "bob:pad", "ada:nib"}));
+
+    // A left join building over users still follows the users, keeping the unmatched ones,
+    // including the NULL key, in place with NULL order columns.
+    auto left = hash_join(users, orders, {"id"}, {ColumnRef(0)}, {.kind = JoinKind::left, .right_prefix = "o_"});
+    assert(left && left->row_count() == 4 + 2);
+    assert(left->columns()[3].name == "o_name" && left->columns()[2].nullable);
+    pairs.clear();
+    for (std::size_t row = 0; row < left->row_count(); ++row) {
+        const auto order = left->row(row)["o_name"];
+        pairs.push_back(get_or_throw<std::string>(left->row(row)["name"]) + ":" +
+                        (std::holds_alternative<std::nullptr_t>(order) ? "-" : get_or_throw<std::string>(order)));
+    }
+    assert(pairs == (std::vector<std::string>{"ada:ink", "ada:nib", "bob:pen", "bob:pad", "ghost:-", "cy:-"}));
+    assert(std::holds_alternative<std::nullptr_t>(left->row(4)["amount"]));
+
+    // With the left side larger it is probed, so unmatched left rows stay in place.
+    auto orders_left = hash_join(orders, users, {"user_id"}, {"id"}, {.kind = JoinKind::left});
+    assert(orders_left && orders_left->row_count() == 5);
+    assert(get_or_throw<std::string>(orders_left->row(3)["name"]) == "cap");
+    assert(std::holds_alternative<std::nullptr_t>(orders_left->row(3)["right.name"]));
+    assert(get_or_throw<std::string>(orders_left->row(4)["right.name"]) == "ada");
+
+    auto composite = hash_join(orders, orders, {"user_id", "name"}, {"user_id", "name"});
+    assert(composite && composite->row_count() == orders.row_count());
+
+    auto mismatch = hash_join(users, orders, {"id"}, {"amount"});
+    assert(!mismatch && mismatch.error().code == ErrorCode::type_mismatch);
+    auto unbalanced = hash_join(users, orders, {"id"}, {});
+    assert(!unbalanced && unbalanced.error().code == ErrorCode::invalid_argument);
+}
+
+void test_chunked_dml() {
+    // orders(id, created) with created == id; the run deletes every row created before 61.
+    std::set<std::int64_t> rows;
+    for (std::int64_t id = 1; id <= 100; ++id) {
+        rows.insert(id);
+    }
+    std::vector<std::string> deletes;
+    int status_checks = 0;
+    const auto matching = [&rows](std::span<const Value> values, bool bounded) {
+        // Parameters are [after,] last, cutoff: the range, then the caller's where_params.
+        const auto after = bounded ? std::get<std::int64_t>(values[0]) : std::numeric_limits<std::int64_t>::min();
+        const auto last = std::get<std::int64_t>(values[bounded ? 1 : 0]);
+        const auto cutoff = std::get<std::int64_t>(values[bounded ? 2 : 1]);
+        std::vector<std::int64_t> ids;
+        for (const auto id : rows) {
+            if (id > after && id <= last && id < cutoff) {
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    };
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [&](std::string_view sql, std::span<const Value> values) -> Expected<Result> {
+            const Column id_column{.name = "id", .type = ColumnType::signed_integer};
+            if (sql.starts_with("SHOW GLOBAL STATUS")) {
+                return Result({Column{.name = "Variable_name"}, Column{.name = "Value"}},
+                              {Result::RowStorage{std::string("Threads_running"), std::string(++status_checks == 1 ? "40" : "3")}});
+            }
+            if (sql.starts_with("SELECT MAX(")) {
+                const auto cutoff = std::get<std::int64_t>(values[0]);
+                const auto below = rows.lower_bound(cutoff);
+                return Result({id_column}, {Result::RowStorage{below == rows.begin() ? Value{nullptr} : Value{*std::prev(below)}}});
+            }
+            const auto ids = matching(values.first(values.size() - 1), sql.find("` > ?") != std::string_view::npos);
+            const auto offset = static_cast<std::size_t>(std::get<std::int64_t>(values.back()));
+            if (offset >= ids.size()) {
+                return Result({id_column}, {});
+            }
+            return Result({id_column}, {Result::RowStorage{ids[offset]}});
+        },
+        .on_execute = [&](std::string_view sql, std::span<const Value> values) -> Expected<ExecuteResult> {
+            if (!sql.starts_with("DELETE")) {
+                return ExecuteResult{};
+            }
+            deletes.emplace_back(sql);
+            const auto ids = matching(values, sql.find("` > ?") != std::string_view::npos);
+            for (const auto id : ids) {
+                rows.erase(id);
+            }
+            return ExecuteResult{.affected_rows = ids.size()};
+        }
+    });
+
+    ChunkedDmlOptions options{
+        .table = "orders",
+        .key = "id",
+        .where = "created < ?",
+        .where_params = {std::int64_t{61}},
+        .chunk_size = 8,
+        .min_chunk_size = 4,
+        .max_chunk_size = 8,
+        .max_threads_running = 16,
+        .throttle_interval = std::chrono::milliseconds{1}
+    };
+    std::vector<DmlProgress> events;
+    auto stats = run_chunked_dml(database, options, [&](const DmlProgress& progress) -> Expected<void> {
+        events.push_back(progress);
+        return {};
+    });
+    assert(stats);
+    assert(stats->affected_rows == 60 && stats->chunks == 8 && stats->last_key == 60);
+    assert(rows.size() == 40 && *rows.begin() == 61);
+    assert(stats->throttle_events == 1 && stats->throttled >= std::chrono::milliseconds{1});
+    assert(events.size() == 9);
+    assert(events[0].event == DmlEvent::throttle && events[0].throttle == ThrottleReason::threads_running);
+    assert(events[0].observed == 40);
+    assert(events[1].event == DmlEvent::chunk && events[1].affected_rows == 8 && events[1].last_key == 8);
+    assert(events.back().affected_rows == 60 && events.back().rows_per_second > 0.0);
+    assert(deletes.front() == "DELETE FROM `orders` WHERE `id` <= ? AND (created < ?)");
+    assert(deletes.back() == "DELETE FROM `orders` WHERE `id` > ? AND `id` <= ? AND (created < ?)");
+
+    // Nothing is left below the cutoff, so a resumed run does no work.
+    options.start_after = 60;
+    auto resumed = run_chunked_dml(database, options);
+    assert(resumed && resumed->chunks == 0);
+
+    options.where_params = {std::int64_t{81}};
+    options.start_after.reset();
+    auto stopped = run_chunked_dml(database, options, [](const DmlProgress& progress) -> Expected<void> {
+        if (progress.event == DmlEvent::chunk) {
+            return std::unexpected(DbError{.code = ErrorCode::invalid_argument, .message = "paused"});
+        }
+        return {};
+    });
+    assert(!stopped && stopped.error().message == "paused" && rows.size() == 32);
+
+    options.kind = DmlKind::update;
+    auto missing_set = run_chunked_dml(database, options);
+    assert(!missing_set && missing_set.error().code == ErrorCode::invalid_argument);
+    assert(missing_set.error().operation == Operation::chunked_dml);
+}
+
+void test_keyset_pager() {
+    static_assert(std::ranges::input_range<KeysetPager>);
+
+    std::vector<std::string> statements;
+    std::mutex statements_mutex;
+    auto config = testing::fake_pool_config(2);
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [&](std::string_view sql, std::span<const Value> values) -> Expected<Result> {
+            {
+                std::lock_guard lock(statements_mutex);
+                statements.emplace_back(sql);
+            }
+            const auto after = values.empty() ? std::int64_t{0} : std::get<std::int64_t>(values[0]);
+            std::vector<Result::RowStorage> rows;
+            for (auto id = after + 1; id <= std::min<std::int64_t>(after + 10, 25); ++id) {
+                rows.push_back(Result::RowStorage{id, "user-" + std::to_string(id)});
+            }
+            return Result({Column{.name = "id", .type = ColumnType::signed_integer},
+                           Column{.name = "name", .type = ColumnType::text}},
+                          std::move(rows));
+        }
+    }, config);
+
+    auto pager = KeysetPager::open(database, {.query = "SELECT id, name FROM users", .key = "id", .where = "active = 1",
+                                              .page_size = 10});
+    assert(pager);
+    std::int64_t expected = 1;
+    for (const RowView row : *pager) {
+        assert(get_or_throw<std::int64_t>(row["id"]) == expected);
+        assert(get_or_throw<std::string>(row["name"]) == "user-" + std::to_string(expected));
+        ++expected;
+    }
+    assert(expected == 26 && pager->pages() == 3 && !pager->error());
+    assert(statements.size() == 3);
+    assert(statements[0] == "SELECT id, name FROM users WHERE (active = 1) ORDER BY `id` LIMIT 10");
+    assert(statements[1] == "SELECT id, name FROM users WHERE `id` > ? AND (active = 1) ORDER BY `id` LIMIT 10");
+
+    // A full last page costs one extra, empty fetch.
+    auto resumed = KeysetPager::open(database, {.query = "SELECT id, name FROM users", .key = "id",
+                                                .page_size = 10, .after = Value{std::int64_t{5}}, .prefetch = false});
+    assert(resumed);
+    auto first = resumed->next_page();
+    assert(first && *first && (*first)->row_count() == 10);
+    assert(get_or_throw<std::int64_t>((*first)->row(0)["id"]) == 6);
+    auto second = resumed->next_page();
+    assert(second && *second && (*second)->row_count() == 10);
+    auto exhausted = resumed->next_page();
+    assert(exhausted && !*exhausted && resumed->pages() == 2);
+
+    auto unkeyed = KeysetPager::open(database, {.query = "SELECT id, name FROM users", .key = "user_id", .page_size = 10});
+    assert(unkeyed);
+    std::size_t seen = 0;
+    for (const RowView row : *unkeyed) {
+        (void)row;
+        ++seen;
+    }
+    assert(seen == 0 && unkeyed->error() && unkeyed->error()->code == ErrorCode::invalid_argument);
+    assert(unkeyed->error()->operation == Operation::paginate);
+
+    assert(!KeysetPager::open(database, {.query = "SELECT id FROM users", .key = "id", .page_size = 0}));
+}
+
+void test_parallel_table_scan() {
+    // A dense run of keys followed by a sparse tail, so evenly spaced key ranges would be badly
+    // skewed.
+    std::vector<std::int64_t> keys;
+    for (std::int64_t key = 1; key <= 1000; ++key) {
+        keys.push_back(key);
+    }
+    for (std::int64_t key = 5000; key <= 10000; key += 50) {
+        keys.push_back(key);
+    }
+    auto config = testing::fake_pool_config(4);
+    config.worker_count = 2;
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [&keys](std::string_view sql, std::span<const Value> values) -> Expected<Result> {
+            const auto integer = [](const Value& value) { return std::get<std::int64_t>(value); };
+            if (sql.starts_with("SELECT MIN(")) {
+                return Result({Column{.name = "lo", .type = ColumnType::signed_integer},
+                               Column{.name = "hi", .type = ColumnType::signed_integer}},
+                              {Result::RowStorage{keys.front(), keys.back()}});
+            }
+            const auto from = std::ranges::lower_bound(keys, integer(values[0]));
+            if (sql.find("key_sample") != std::string_view::npos) {
+                const auto count = std::min<std::ptrdiff_t>(keys.end() - from, 100);
+                return Result({Column{.name = "n", .type = ColumnType::signed_integer},
+                               Column{.name = "reach", .type = ColumnType::signed_integer}},
+                              {Result::RowStorage{std::int64_t{count}, count == 0 ? Value{nullptr} : Value{*(from + count - 1)}}});
+            }
+            assert(sql == "SELECT `id` FROM `shop`.`orders` WHERE `id` >= ? AND `id` <= ? ORDER BY `id`");
+            std::vector<Result::RowStorage> rows;
+            for (auto key = from; key != keys.end() && *key <= integer(values[1]); ++key) {
+                rows.push_back(Result::RowStorage{*key});
+            }
+            return Result({Column{.name = "id", .type = ColumnType::signed_integer}}, std::move(rows));
+        }
+    }, config);
+
+    ScanOptions options{.table = "shop.orders", .key = "id", .columns = "`id`", .parallelism = 3, .sample_points = 16,
+                        .sample_rows = 100};
+    std::vector<std::int64_t> seen;
+    std::size_t expected_index = 0;
+    std::size_t largest = 0;
+    auto ordered = scan_table(database, options, [&](ScanChunk& chunk) -> Expected<void> {
+        assert(chunk.index == expected_index++);
+        largest = std::max(largest, chunk.rows.row_count());
+        for (std::size_t row = 0; row < chunk.rows.row_count(); ++row) {
+            const auto key = get_or_throw<std::int64_t>(chunk.rows[row]["id"]);
+            assert(key >= chunk.first_key && key <= chunk.last_key);
+            seen.push_back(key);
+        }
+        return {};
+    });
+    assert(ordered);
+    assert(seen == keys);
+    assert(ordered->rows == keys.size() && ordered->chunks == expected_index && ordered->sample_queries == 16);
+    assert(ordered->chunks > 1 && largest <= keys.size() / 4);
+
+    seen.clear();
+    options.ordered = false;
+    auto unordered = scan_table(database, options, [&](ScanChunk& chunk) -> Expected<void> {
+        for (std::size_t row = 0; row < chunk.rows.row_count(); ++row) {
+            seen.push_back(get_or_throw<std::int64_t>(chunk.rows[row]["id"]));
+        }
+        return {};
+    });
+    assert(unordered && unordered->chunks == ordered->chunks);
+    std::ranges::sort(seen);
+    assert(seen == keys);
+
+    std::size_t consumed = 0;
+    auto stopped = scan_table(database, options, [&](ScanChunk&) -> Expected<void> {
+        if (++consumed == 2) {
+            return std::unexpected(DbError{.code = ErrorCode::invalid_argument, .message = "enough"});
+        }
+        return {};
+    });
+    assert(!stopped && stopped.error().message == "enough" && consumed == 2);
+
+    options.parallelism = 0;
+    auto rejected = scan_table(database, options, [](ScanChunk&) -> Expected<void> { return {}; });
+    assert(!rejected && rejected.error().code == ErrorCode::invalid_argument && rejected.error().operation == Operation::scan);
+}
+
+struct ReportBody {
+    std::string body;
+};
+
+void test_compressed_sub_pool() {
+    auto backend = std::make_shared<testing::FakeBackend>(testing::FakeBackendOptions{
+        .on_query = [](std::string_view sql, std::span<const Value>) -> Expected<Result> {
+            if (sql == "SELECT report") {
+                return Result({Column{.name = "body", .type = ColumnType::text}}, {Result::RowStorage{std::string(1000, 'x')}});
+            }
+            return Result({Column{.name = "n", .type = ColumnType::signed_integer}}, {Result::RowStorage{std::int64_t{1}}});
+        }
+    });
+    auto fake_factory = testing::make_fake_connection_factory(backend);
+    std::atomic<int> compressed_connects{0};
+    ConnectionConfig config;
+    config.initial_pool_size = 1;
+    config.max_pool_size = 2;
+    config.worker_count = 1;
+    config.compression = Compression::zstd;
+    config.zstd_compression_level = 1;
+    config.compressed_pool_size = 1;
+    config.compress_result_threshold = 100;
+    Database database(config, [&](const ConnectionConfig& connection_config) {
+        if (connection_config.compression != Compression::none) {
+            ++compressed_connects;
+        }
+        return fake_factory(connection_config);
+    });
+    assert(compressed_connects == 0);
+
+    // The first large result is read uncompressed; after that the query runs on the compressed pool.
+    for (int round = 0; round < 3; ++round) {
+        auto report = database.query("SELECT report");
+        assert(report && get_or_throw<std::string>((*report)[0]["body"]).size() == 1000);
+        auto small = database.query("SELECT small");
+        assert(small && get_or_throw<std::int64_t>((*small)[0]["n"]) == 1);
+    }
+    assert(compressed_connects == 1);
+    assert(database.execute("DELETE FROM sessions"));
+    assert(compressed_connects == 1);
+
+    // query_into() results are counted the same way.
+    auto bodies = database.query_into<ReportBody>("SELECT report");
+    assert(bodies && bodies->size() == 1 && (*bodies)[0].body.size() == 1000);
+
+    const auto stats = database.metrics().compression;
+    assert(stats.compressed_queries == 3);
+    assert(stats.uncompressed_queries == 4);
+    assert(stats.compressed_result_bytes == 3000);
+    assert(stats.uncompressed_result_bytes == 1000 + 3 * 8);
+    assert(database.stats().created_connections == 2);
+}
+
+void test_lazy_connect() {
+    auto backend = std::make_shared<testing::FakeBackend>(testing::FakeBackendOptions{
+        .connect_latency = std::chrono::milliseconds{50}
+    });
+    auto fake_factory = testing::make_fake_connection_factory(backend);
+    std::atomic<int> attempts{0};
+    ConnectionConfig config;
+    config.initial_pool_size = 3;
+    config.max_pool_size = 4;
+    config.worker_count = 1;
+    config.lazy_connect = true;
+    config.warmup_retry_delay = std::chrono::milliseconds{1};
+    config.warmup_retry_max_delay = std::chrono::milliseconds{4};
+
+    const auto started = std::chrono::steady_clock::now();
+    // The first two connects fail, as against a server that is still starting.
+    Database database(config, [&](const ConnectionConfig& connection_config) -> std::unique_ptr<Connection> {
+        return attempts++ < 2 ? nullptr : fake_factory(connection_config);
+    });
+    assert(std::chrono::steady_clock::now() - started < std::chrono::milliseconds{50});
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (database.stats().failed_connections < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    auto answer = database.query("SELECT 1");
+    assert(answer);
+    while (database.stats().idle_connections < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    const auto stats = database.stats();
+    assert(stats.idle_connections == 3);
+    assert(stats.created_connections == 3);
+    assert(stats.failed_connections == 2);
+    assert(backend->connects == 3);
+}
+
+void test_statement_registry() {
+    auto config = testing::fake_pool_config(2);
+    config.max_pool_size = 4;
+    config.statement_cache_size = 4;
+    auto [backend, database] = testing::make_fake_database({}, config);
+    assert(database.metrics().statements.covered_connections == 2);
+
+    // One prepare validates the statement, then each idle connection prepares it.
+    assert(database.register_statement("SELECT name FROM users WHERE id = ?"));
+    assert(backend->prepares == 3);
+    assert(database.register_statement("SELECT name FROM users WHERE id = ?"));
+    assert(backend->prepares == 3);
+    assert(database.register_statement("UPDATE users SET seen = NOW() WHERE id = ?"));
+    assert(backend->prepares == 6);
+    auto empty = database.register_statement("");
+    assert(!empty && empty.error().code == ErrorCode::invalid_argument);
+
+    // A connection opened on the request path catches up when it is released.
+    {
+        auto first = database.begin_transaction();
+        auto second = database.begin_transaction();
+        assert(first && second);
+        assert(database.query("SELECT 1"));
+    }
+    assert(backend->connects == 3);
+    assert(backend->prepares == 6 + 2);
+    auto statements = database.metrics().statements;
+    assert(statements.registered_statements == 2);
+    assert(statements.covered_connections == 3);
+
+    assert(database.register_statement("DELETE FROM sessions WHERE id = ?"));
+    assert(backend->prepares == 6 + 2 + 1 + 3);
+    statements = database.metrics().statements;
+    assert(statements.registered_statements == 3);
+    assert(statements.covered_connections == 3);
+    assert(statements.registry_prepare_failures == 0);
+
+    auto full = database.register_statement("SELECT 4");
+    assert(!full && full.error().code == ErrorCode::invalid_argument && full.error().operation == Operation::prepare);
+}
+
+void test_session_init_and_set_cache() {
+    auto config = testing::fake_pool_config();
+    config.init_statements = {"SET SESSION time_zone = '+00:00'", "SET sql_mode = 'STRICT_ALL_TABLES'"};
+    auto [backend, database] = testing::make_fake_database({}, config);
+    assert(backend->connects == 1);
+    assert(backend->executes == 2);
+
+    // Values the session already has are not sent again.
+    assert(database.execute("SET SESSION time_zone = '+00:00'"));
+    assert(database.execute("set @@session.sql_mode='STRICT_ALL_TABLES', time_zone = '+00:00';"));
+    assert(backend->executes == 2);
+    assert(database.metrics().statements.skipped_session_sets == 2);
+
+    assert(database.execute("SET time_zone = 'UTC'"));
+    assert(database.execute("SET time_zone = 'UTC'"));
+    assert(backend->executes == 3);
+    assert(database.execute("SET GLOBAL time_zone = 'UTC'"));
+    assert(backend->executes == 4);
+
+    // insert_id is consumed by the next insert, so setting it again is never redundant.
+    assert(database.execute("SET insert_id = 5"));
+    assert(database.execute("SET insert_id = 5"));
+    assert(database.execute("SET time_zone = 'UTC', insert_id = 5"));
+    assert(backend->executes == 7);
+
+    // Statements the cache cannot follow forget everything it knew.
+    assert(database.execute("SET NAMES utf8mb4"));
+    assert(database.execute("SET sql_mode = 'STRICT_ALL_TABLES'"));
+    assert(backend->executes == 9);
+    assert(database.metrics().statements.skipped_session_sets == 3);
+}
+
+void test_statement_descriptors() {
+    static_assert(detail::count_placeholders("SELECT ? FROM t WHERE a = '?' AND `b?` = ? -- ?\n AND c = ? /* ? */") == 3);
+    static_assert(detail::count_placeholders("SELECT 'it\\'s ?', ?") == 1);
+    static_assert(detail::count_placeholders("SELECT ? --\t?\n, ? --?") == 3);
+    static_assert(detail::count_placeholders("SELECT 1--?\n") == 1);
+    static_assert(detail::count_placeholders("SELECT ? /*!80000 , ? */ /*! , ? */ /*+ ? */") == 3);
+    using FindUser = StatementDescriptor<"SELECT name FROM users WHERE id = ? AND region = ?", std::int64_t,
+                                         std::optional<std::string_view>>;
+    static_assert(FindUser::parameter_count == 2);
+    static_assert(FindUser::key.hash == detail::sql_hash("SELECT name FROM users WHERE id = ? AND region = ?"));
+    using Touch = StatementDescriptor<"UPDATE users SET seen = NOW()">;
+
+    std::vector<Value> seen;
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [&seen](std::string_view sql, std::span<const Value> values) -> Expected<Result> {
+            assert(sql == FindUser::sql);
+            seen.assign(values.begin(), values.end());
+            return Result{};
+        }
+    });
+
+    const std::string region = "eu";
+    assert(database.query(FindUser{}, 7, region));
+    assert(seen.size() == 2 && get_or_throw<std::int64_t>(seen[0]) == 7 && get_or_throw<std::string>(seen[1]) == "eu");
+    assert(database.query(FindUser{}, 8u, std::nullopt));
+    assert(get_or_throw<std::int64_t>(seen[0]) == 8 && std::holds_alternative<std::nullptr_t>(seen[1]));
+
+    // A descriptor is prepared even without parameters.
+    assert(database.execute(Touch{}));
+    assert(backend->executes == 1 && backend->prepares == 3);
+    assert(database.metrics().statements.prepared_statements == 3);
+}
+
+struct Order {
+    std::int64_t id;
+    std::optional<std::string> note;
+    double total;
+    bool paid;
+};
+static_assert(detail::member_count<Order>() == 4);
+
+struct OrderTotal {
+    std::uint16_t id;
+    float total;
+    static constexpr std::array<std::string_view, 2> column_names{"total", "id"};
+};
+
+void test_query_into() {
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [](std::string_view, std::span<const Value> values) -> Expected<Result> {
+            assert(values.size() == 1 && get_or_throw<std::string>(values[0]) == "open");
+            return Result(
+                {Column{.name = "id", .type = ColumnType::signed_integer}, Column{.name = "note"},
+                 Column{.name = "total", .type = ColumnType::floating}, Column{.name = "paid", .type = ColumnType::boolean}},
+                {Result::RowStorage{std::int64_t{1}, std::string("rush"), 12.5, true},
+                 Result::RowStorage{std::int64_t{70000}, nullptr, 3.0, std::int64_t{0}}});
+        }
+    });
+
+    const std::string status = "open";
+    auto orders = database.query_into<Order>("SELECT id, note, total, paid FROM orders WHERE status = ?", status);
+    assert(orders && orders->size() == 2);
+    assert((*orders)[0].id == 1 && (*orders)[0].note == "rush" && (*orders)[0].total == 12.5 && (*orders)[0].paid);
+    assert((*orders)[1].id == 70000 && !(*orders)[1].note && !(*orders)[1].paid);
+    assert(backend->prepares == 1);
+
+    // 70000 does not fit a uint16_t member.
+    auto totals = database.query_into<OrderTotal>("SELECT id, note, total, paid FROM orders WHERE status = ?", "open");
+    assert(!totals && totals.error().code == ErrorCode::type_mismatch);
+}
+
+#ifndef _WIN32
+void test_shared_result_cache() {
+    const auto name = "/mysqlwrapper-test-" + std::to_string(::getpid());
+    const auto small_name = name + "-small";
+    (void)SharedResultCache::remove(name);
+    (void)SharedResultCache::remove(small_name);
+
+    auto writer = SharedResultCache::open({.name = name, .slots = 64});
+    assert(writer);
+    auto reader = SharedResultCache::open({.name = name});
+    assert(reader);
+
+    const std::array<Value, 2> params{Value{std::int64_t{7}}, Value{std::string("eu")}};
+    const Result reference(
+        {Column{.name = "code", .type = ColumnType::text}, Column{.name = "rate", .type = ColumnType::floating}},
+        {Result::RowStorage{std::string("EUR"), 1.0}, Result::RowStorage{std::string("GBP"), nullptr}});
+    assert(!(*reader)->find("SELECT code, rate FROM fx WHERE id = ? AND region = ?", params));
+    assert((*writer)->insert("SELECT code, rate FROM fx WHERE id = ? AND region = ?", params, reference));
+
+    auto hit = (*reader)->find("SELECT code, rate FROM fx WHERE id = ? AND region = ?", params);
+    assert(hit && hit->row_count() == 2);
+    assert(std::get<std::string_view>(hit->row(1).view("code")) == "GBP");
+    assert(get_or_throw<double>(hit->row(0)["rate"]) == 1.0);
+    const std::array<Value, 2> other_params{Value{std::int64_t{7}}, Value{std::string("us")}};
+    assert(!(*reader)->find("SELECT code, rate FROM fx WHERE id = ? AND region = ?", other_params));
+    assert((*reader)->stats().hits == 1 && (*reader)->stats().misses == 2);
+
+    // Another process sees the entry in place.
+    const auto child = ::fork();
+    if (child == 0) {
+        auto attached = SharedResultCache::open({.name = name});
+        const bool found = attached && (*attached)->find("SELECT code, rate FROM fx WHERE id = ? AND region = ?", params);
+        ::_exit(found ? 0 : 1);
+    }
+    int status = 0;
+    assert(::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    assert((*writer)->insert("SELECT 1", {}, reference, std::chrono::milliseconds(1)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    assert(!(*reader)->find("SELECT 1"));
+
+    // The memory cap evicts the entries closest to expiry, and results already handed out stay
+    // readable after their entry is unlinked.
+    auto small = SharedResultCache::open({.name = small_name, .capacity_bytes = 2048, .slots = 16});
+    assert(small);
+    assert((*small)->insert("SELECT 0", {}, reference));
+    auto evicted = (*small)->find("SELECT 0");
+    assert(evicted);
+    for (int index = 1; index < 20; ++index) {
+        assert((*small)->insert("SELECT " + std::to_string(index), {}, reference));
+    }
+    const auto stats = (*small)->stats();
+    assert(stats.used_bytes <= stats.capacity_bytes);
+    assert(stats.evictions > 0);
+    assert(!(*small)->find("SELECT 0"));
+    assert((*small)->find("SELECT 19"));
+    // Replacing an entry charges the capacity once.
+    const auto used = (*small)->stats().used_bytes;
+    for (int round = 0; round < 5; ++round) {
+        assert((*small)->insert("SELECT 19", {}, reference));
+    }
+    assert((*small)->stats().used_bytes == used);
+    assert(std::get<std::string_view>(evicted->row(0).view("code")) == "EUR");
+
+    const Result oversized({Column{.name = "v", .type = ColumnType::text}},
+                           {Result::RowStorage{std::string(4096, 'x')}});
+    auto rejected = (*small)->insert("SELECT big", {}, oversized);
+    assert(!rejected && rejected.error().code == ErrorCode::invalid_argument);
+    assert(rejected.error().operation == Operation::shared_cache);
+
+    std::atomic<int> queries{0};
+    auto [backend, database] = testing::make_fake_database({
+        .on_query = [&queries](std::string_view, std::span<const Value>) -> Expected<Result> {
+            ++queries;
+            return Result({Column{.name = "n", .type = ColumnType::signed_integer}}, {Result::RowStorage{std::int64_t{42}}});
+        }
+    });
+    for (int round = 0; round < 3; ++round) {
+        auto answer = (*reader)->query(database, "SELECT n FROM answers WHERE id = ?", 1);
+        assert(answer && get_or_throw<std::int64_t>((*answer)[0]["n"]) == 42);
+    }
+    assert(queries == 1);
+
+    // Writers racing for the same slots never leave an object that remove() cannot find. Each
+    // round starts from a fresh index so the writers meet on slots that were never used.
+    const auto race_name = name + "-race";
+    for (int round = 0; round < 100; ++round) {
+        (void)SharedResultCache::remove(race_name);
+        auto race = SharedResultCache::open({.name = race_name, .capacity_bytes = 4096, .slots = 16});
+        assert(race);
+        std::atomic<int> waiting{4};
+        std::vector<std::thread> writers;
+        for (int writer_index = 0; writer_index < 4; ++writer_index) {
+            writers.emplace_back([&race_name, &reference, &waiting] {
+                auto racer = SharedResultCache::open({.name = race_name});
+                assert(racer);
+                for (--waiting; waiting > 0;) {
+                    std::this_thread::yield();
+                }
+                for (int index = 0; index < 4; ++index) {
+                    (void)(*racer)->insert("SELECT " + std::to_string(index), {}, reference);
+                }
+            });
+        }
+        for (auto& thread : writers) {
+            thread.join();
+        }
+        assert(SharedResultCache::remove(race_name));
+        if (std::filesystem::is_directory("/dev/shm")) {
+            const auto prefix = race_name.substr(1) + ".";
+            for (const auto& object : std::filesystem::directory_iterator("/dev/shm")) {
+                assert(!object.path().filename().string().starts_with(prefix));
+            }
+        }
+    }
+
+    assert(SharedResultCache::remove(name));
+    assert(SharedResultCache::remove(small_name));
+    assert(std::get<std::string_view>(hit->row(0).view("code")) == "EUR");
+    assert(!SharedResultCache::open({.name = "no-leading-slash"}));
 }
+#endif
 
 } // namespace
 
@@ -70,5 +1292,28 @@ int main() {
     test_result_layout();
     test_type_mismatch();
     test_failed_connection_returns_expected();
+    test_openmetrics_exposition();
+    test_fake_connection_factory();
+    test_latency_histogram_quantile();
+    test_traffic_recording();
+    test_columnar_arrow_export();
+    test_stream_to_columnar();
+    test_csv_export();
+    test_json_serialization();
+    test_result_snapshot();
+    test_result_operators();
+    test_hash_join();
+    test_chunked_dml();
+    test_keyset_pager();
+    test_parallel_table_scan();
+    test_compressed_sub_pool();
+    test_lazy_connect();
+    test_statement_registry();
+    test_session_init_and_set_cache();
+    test_statement_descriptors();
+    test_query_into();
+#ifndef _WIN32
+    test_shared_result_cache();
+#endif
     std::cout << "mysqlwrapper tests passed\n";
 }
@@ -0,0 +1,136 @@
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace mysqlw::testing {
+namespace {
+
+std::atomic<std::uint64_t> allocation_count{0};
+std::atomic<std::uint64_t> deallocation_count{0};
+std::atomic<std::uint64_t> allocated_bytes{0};
+thread_local bool thread_counted = true;
+
+void* counted_allocate(std::size_t size, std::size_t alignment) noexcept {
+    if (thread_counted) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void* counted_allocate_or_throw(std::size_t size, std::size_t alignment) {
+    void* pointer = counted_allocate(size, alignment);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void counted_free(void* pointer) noexcept {
+    if (pointer != nullptr) {
+        if (thread_counted) {
+            deallocation_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::free(pointer);
+    }
+}
+
+} // namespace
+
+AllocationStats allocation_stats() noexcept {
+    return AllocationStats{
+        .allocations = allocation_count.load(std::memory_order_relaxed),
+        .deallocations = deallocation_count.load(std::memory_order_relaxed),
+        .bytes = allocated_bytes.load(std::memory_order_relaxed)
+    };
+}
+
+void count_current_thread(bool counted) noexcept {
+    thread_counted = counted;
+}
+
+} // namespace mysqlw::testing
+
+using mysqlw::testing::counted_allocate;
+using mysqlw::testing::counted_allocate_or_throw;
+using mysqlw::testing::counted_free;
+
+void* operator new(std::size_t size) {
+    return counted_allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+    return counted_allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    counted_free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    counted_free(pointer);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mysqlw::testing {
+
+// Process-wide totals from the replacement global operator new/delete in allocation_counter.cpp.
+// That file replaces the allocator for the whole program, so it is compiled only into the
+// executables that measure allocations rather than into mysqlwrapper_test_support. Allocations
+// made with malloc, such as those inside libmysqlclient, are not counted.
+struct AllocationStats {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+    std::uint64_t bytes = 0;
+
+    [[nodiscard]] AllocationStats operator-(const AllocationStats& before) const noexcept {
+        return AllocationStats{
+            .allocations = allocations - before.allocations,
+            .deallocations = deallocations - before.deallocations,
+            .bytes = bytes - before.bytes
+        };
+    }
+};
+
+[[nodiscard]] AllocationStats allocation_stats() noexcept;
+
+// Stops or resumes counting the calling thread's allocations; threads start out counted.
+void count_current_thread(bool counted) noexcept;
+
+struct AllocationsPerOperation {
+    double allocations = 0.0;
+    double bytes = 0.0;
+};
+
+// Runs fn once to warm caches, then iterations more times, and returns the average per call.
+// Counts include every thread, so async work done by executor workers is attributed to the call.
+template <typename Fn>
+AllocationsPerOperation measure_allocations(std::size_t iterations, Fn&& fn) {
+    fn();
+    const auto before = allocation_stats();
+    for (std::size_t index = 0; index < iterations; ++index) {
+        fn();
+    }
+    const auto delta = allocation_stats() - before;
+    return AllocationsPerOperation{
+        .allocations = static_cast<double>(delta.allocations) / static_cast<double>(iterations),
+        .bytes = static_cast<double>(delta.bytes) / static_cast<double>(iterations)
+    };
+}
+
+} // namespace mysqlw::testing
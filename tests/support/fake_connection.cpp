@@ -0,0 +1,141 @@
+#include "fake_connection.hpp"
+
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace mysqlw::testing {
+namespace {
+
+void simulate_latency(std::chrono::microseconds latency) {
+    if (latency.count() > 0) {
+        std::this_thread::sleep_for(latency);
+    }
+}
+
+DbError not_connected(Operation operation) {
+    return DbError{
+        .code = ErrorCode::connection_lost,
+        .operation = operation,
+        .message = "fake connection is not open"
+    };
+}
+
+} // namespace
+
+class FakeConnection::Statement final : public PreparedStatement {
+public:
+    Statement(FakeConnection& connection, std::string sql) : connection_(&connection), sql_(std::move(sql)) {}
+
+    [[nodiscard]] Expected<Result> query(std::vector<Value> values) override {
+        return connection_->run_query(sql_, values);
+    }
+
+    [[nodiscard]] Expected<ExecuteResult> execute(std::vector<Value> values) override {
+        return connection_->run_execute(sql_, values);
+    }
+
+private:
+    FakeConnection* connection_;
+    std::string sql_;
+};
+
+FakeConnection::FakeConnection(std::shared_ptr<FakeBackend> backend) : backend_(std::move(backend)) {}
+
+Expected<void> FakeConnection::connect() {
+    simulate_latency(backend_->options().connect_latency);
+    if (backend_->options().fail_connect) {
+        return std::unexpected(DbError{
+            .code = ErrorCode::connection_failed,
+            .operation = Operation::connect,
+            .message = "fake backend refuses connections"
+        });
+    }
+    backend_->connects.fetch_add(1, std::memory_order_relaxed);
+    connected_ = true;
+    return {};
+}
+
+Expected<void> FakeConnection::ping() {
+    if (!connected_) {
+        return std::unexpected(not_connected(Operation::ping));
+    }
+    simulate_latency(backend_->options().ping_latency);
+    backend_->pings.fetch_add(1, std::memory_order_relaxed);
+    return {};
+}
+
+Expected<Result> FakeConnection::query(std::string_view sql) {
+    return run_query(sql, {});
+}
+
+Expected<ExecuteResult> FakeConnection::execute(std::string_view sql) {
+    return run_execute(sql, {});
+}
+
+Expected<PreparedStatement*> FakeConnection::prepare(std::string_view sql) {
+    if (!connected_) {
+        return std::unexpected(not_connected(Operation::prepare));
+    }
+    backend_->prepares.fetch_add(1, std::memory_order_relaxed);
+    statement_ = std::make_unique<Statement>(*this, std::string(sql));
+    return statement_.get();
+}
+
+Expected<std::string> FakeConnection::escape(std::string_view value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char character : value) {
+        if (character == '\'' || character == '\\') {
+            escaped += '\\';
+        }
+        escaped += character;
+    }
+    return escaped;
+}
+
+Expected<Result> FakeConnection::run_query(std::string_view sql, std::span<const Value> values) {
+    if (!connected_) {
+        return std::unexpected(not_connected(Operation::query));
+    }
+    simulate_latency(backend_->options().query_latency);
+    backend_->queries.fetch_add(1, std::memory_order_relaxed);
+    if (backend_->options().on_query) {
+        return backend_->options().on_query(sql, values);
+    }
+    return Result{};
+}
+
+Expected<ExecuteResult> FakeConnection::run_execute(std::string_view sql, std::span<const Value> values) {
+    if (!connected_) {
+        return std::unexpected(not_connected(Operation::execute));
+    }
+    simulate_latency(backend_->options().query_latency);
+    backend_->executes.fetch_add(1, std::memory_order_relaxed);
+    if (backend_->options().on_execute) {
+        return backend_->options().on_execute(sql, values);
+    }
+    return ExecuteResult{.affected_rows = 1, .last_insert_id = 0};
+}
+
+ConnectionFactory make_fake_connection_factory(std::shared_ptr<FakeBackend> backend) {
+    return [backend = std::move(backend)](const ConnectionConfig&) -> std::unique_ptr<Connection> {
+        return std::make_unique<FakeConnection>(backend);
+    };
+}
+
+ConnectionConfig fake_pool_config(std::size_t pool_size) {
+    ConnectionConfig config;
+    config.initial_pool_size = pool_size;
+    config.max_pool_size = pool_size;
+    config.worker_count = 1;
+    return config;
+}
+
+FakeDatabase make_fake_database(FakeBackendOptions options, ConnectionConfig config) {
+    auto backend = std::make_shared<FakeBackend>(std::move(options));
+    Database database(std::move(config), make_fake_connection_factory(backend));
+    return FakeDatabase{.backend = std::move(backend), .database = std::move(database)};
+}
+
+} // namespace mysqlw::testing
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace mysqlw::testing {
+
+struct FakeBackendOptions {
+    std::chrono::microseconds connect_latency{0};
+    std::chrono::microseconds ping_latency{0};
+    std::chrono::microseconds query_latency{0};
+    bool fail_connect = false;
+
+    // Scripted responses; when unset, queries return an empty Result and executes affect one row.
+    std::function<Expected<Result>(std::string_view sql, std::span<const Value> values)> on_query;
+    std::function<Expected<ExecuteResult>(std::string_view sql, std::span<const Value> values)> on_execute;
+};
+
+// Shared state behind every FakeConnection created by one factory. Counters record simulated
+// server round trips so tests can assert on them.
+class FakeBackend {
+public:
+    explicit FakeBackend(FakeBackendOptions options = {}) : options_(std::move(options)) {}
+
+    [[nodiscard]] const FakeBackendOptions& options() const noexcept { return options_; }
+
+    std::atomic<std::uint64_t> connects{0};
+    std::atomic<std::uint64_t> pings{0};
+    std::atomic<std::uint64_t> queries{0};
+    std::atomic<std::uint64_t> executes{0};
+    std::atomic<std::uint64_t> prepares{0};
+
+private:
+    FakeBackendOptions options_;
+};
+
+class FakeConnection final : public Connection {
+public:
+    explicit FakeConnection(std::shared_ptr<FakeBackend> backend);
+
+    [[nodiscard]] Expected<void> connect() override;
+    [[nodiscard]] Expected<void> ping() override;
+    [[nodiscard]] Expected<Result> query(std::string_view sql) override;
+    [[nodiscard]] Expected<ExecuteResult> execute(std::string_view sql) override;
+    [[nodiscard]] Expected<PreparedStatement*> prepare(std::string_view sql) override;
+    [[nodiscard]] Expected<std::string> escape(std::string_view value) override;
+
+    [[nodiscard]] Expected<Result> run_query(std::string_view sql, std::span<const Value> values);
+    [[nodiscard]] Expected<ExecuteResult> run_execute(std::string_view sql, std::span<const Value> values);
+
+private:
+    class Statement;
+
+    std::shared_ptr<FakeBackend> backend_;
+    std::unique_ptr<Statement> statement_;
+    bool connected_ = false;
+};
+
+[[nodiscard]] ConnectionFactory make_fake_connection_factory(std::shared_ptr<FakeBackend> backend);
+
+// Pool settings for unit tests: pool_size connections, opened up front, and one async worker.
+[[nodiscard]] ConnectionConfig fake_pool_config(std::size_t pool_size = 1);
+
+// A Database whose connections all share one fresh FakeBackend.
+struct FakeDatabase {
+    std::shared_ptr<FakeBackend> backend;
+    Database database;
+};
+
+[[nodiscard]] FakeDatabase make_fake_database(FakeBackendOptions options = {},
+                                              ConnectionConfig config = fake_pool_config());
+
+} // namespace mysqlw::testing
@@ -0,0 +1,1104 @@
+#include "mysql_stub_server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace mysqlw::testing {
+namespace {
+
+// Protocol constants, spelled out here so the stub does not depend on the client headers.
+constexpr std::uint32_t client_long_password = 1U << 0;
+constexpr std::uint32_t client_long_flag = 1U << 2;
+constexpr std::uint32_t client_connect_with_db = 1U << 3;
+constexpr std::uint32_t client_protocol_41 = 1U << 9;
+constexpr std::uint32_t client_transactions = 1U << 13;
+constexpr std::uint32_t client_secure_connection = 1U << 15;
+constexpr std::uint32_t client_multi_statements = 1U << 16;
+constexpr std::uint32_t client_multi_results = 1U << 17;
+constexpr std::uint32_t client_ps_multi_results = 1U << 18;
+constexpr std::uint32_t client_plugin_auth = 1U << 19;
+constexpr std::uint32_t client_connect_attrs = 1U << 20;
+constexpr std::uint32_t client_plugin_auth_lenenc_data = 1U << 21;
+constexpr std::uint32_t client_deprecate_eof = 1U << 24;
+
+constexpr std::uint32_t server_capabilities =
+    client_long_password | client_long_flag | client_connect_with_db | client_protocol_41 | client_transactions |
+    client_secure_connection | client_multi_statements | client_multi_results | client_ps_multi_results |
+    client_plugin_auth | client_connect_attrs | client_plugin_auth_lenenc_data | client_deprecate_eof;
+
+constexpr std::uint16_t status_in_trans = 0x0001;
+constexpr std::uint16_t status_autocommit = 0x0002;
+constexpr std::uint16_t status_more_results = 0x0008;
+
+constexpr std::uint8_t com_quit = 0x01;
+constexpr std::uint8_t com_init_db = 0x02;
+constexpr std::uint8_t com_query = 0x03;
+constexpr std::uint8_t com_ping = 0x0e;
+constexpr std::uint8_t com_stmt_prepare = 0x16;
+constexpr std::uint8_t com_stmt_execute = 0x17;
+constexpr std::uint8_t com_stmt_send_long_data = 0x18;
+constexpr std::uint8_t com_stmt_close = 0x19;
+constexpr std::uint8_t com_stmt_reset = 0x1a;
+constexpr std::uint8_t com_set_option = 0x1b;
+
+constexpr std::uint8_t type_tiny = 1;
+constexpr std::uint8_t type_short = 2;
+constexpr std::uint8_t type_long = 3;
+constexpr std::uint8_t type_float = 4;
+constexpr std::uint8_t type_double = 5;
+constexpr std::uint8_t type_null = 6;
+constexpr std::uint8_t type_longlong = 8;
+constexpr std::uint8_t type_int24 = 9;
+constexpr std::uint8_t type_year = 13;
+constexpr std::uint8_t type_tiny_blob = 249;
+constexpr std::uint8_t type_medium_blob = 250;
+constexpr std::uint8_t type_long_blob = 251;
+constexpr std::uint8_t type_blob = 252;
+constexpr std::uint8_t type_var_string = 253;
+
+constexpr std::uint16_t flag_not_null = 1;
+constexpr std::uint16_t flag_blob = 16;
+constexpr std::uint16_t flag_unsigned = 32;
+constexpr std::uint16_t flag_binary = 128;
+
+constexpr std::uint16_t charset_binary = 63;
+constexpr std::uint16_t charset_utf8mb4 = 255;
+
+constexpr std::size_t max_packet_payload = 0xFFFFFF;
+constexpr std::string_view auth_plugin = "caching_sha2_password";
+
+class PacketBuilder {
+public:
+    void u8(std::uint8_t value) { payload_.push_back(static_cast<char>(value)); }
+
+    void u16(std::uint16_t value) { little_endian(value, 2); }
+    void u24(std::uint32_t value) { little_endian(value, 3); }
+    void u32(std::uint32_t value) { little_endian(value, 4); }
+    void u64(std::uint64_t value) { little_endian(value, 8); }
+
+    void lenenc_int(std::uint64_t value) {
+        if (value < 251) {
+            u8(static_cast<std::uint8_t>(value));
+        } else if (value < (1U << 16)) {
+            u8(0xfc);
+            u16(static_cast<std::uint16_t>(value));
+        } else if (value < (1U << 24)) {
+            u8(0xfd);
+            u24(static_cast<std::uint32_t>(value));
+        } else {
+            u8(0xfe);
+            u64(value);
+        }
+    }
+
+    void lenenc_str(std::string_view value) {
+        lenenc_int(value.size());
+        payload_ += value;
+    }
+
+    void nul_str(std::string_view value) {
+        payload_ += value;
+        payload_.push_back('\0');
+    }
+
+    void raw(std::string_view value) { payload_ += value; }
+    void zeros(std::size_t count) { payload_.append(count, '\0'); }
+
+    [[nodiscard]] std::string& payload() noexcept { return payload_; }
+
+private:
+    std::string payload_;
+
+    void little_endian(std::uint64_t value, int bytes) {
+        for (int index = 0; index < bytes; ++index) {
+            payload_.push_back(static_cast<char>((value >> (8 * index)) & 0xff));
+        }
+    }
+};
+
+class PacketReader {
+public:
+    explicit PacketReader(std::string_view payload) : payload_(payload) {}
+
+    [[nodiscard]] bool has(std::size_t count) const noexcept { return offset_ + count <= payload_.size(); }
+    [[nodiscard]] std::size_t remaining() const noexcept { return payload_.size() - offset_; }
+
+    std::uint64_t fixed(int bytes) {
+        require(static_cast<std::size_t>(bytes));
+        std::uint64_t value = 0;
+        for (int index = 0; index < bytes; ++index) {
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(payload_[offset_ + index])) << (8 * index);
+        }
+        offset_ += static_cast<std::size_t>(bytes);
+        return value;
+    }
+
+    std::uint64_t lenenc_int() {
+        const auto first = fixed(1);
+        switch (first) {
+            case 0xfc: return fixed(2);
+            case 0xfd: return fixed(3);
+            case 0xfe: return fixed(8);
+            default: return first;
+        }
+    }
+
+    std::string_view bytes(std::size_t count) {
+        require(count);
+        const auto view = payload_.substr(offset_, count);
+        offset_ += count;
+        return view;
+    }
+
+    std::string_view lenenc_str() { return bytes(static_cast<std::size_t>(lenenc_int())); }
+
+    std::string_view nul_str() {
+        const auto end = payload_.find('\0', offset_);
+        if (end == std::string_view::npos) {
+            throw std::out_of_range("unterminated string in packet");
+        }
+        const auto view = payload_.substr(offset_, end - offset_);
+        offset_ = end + 1;
+        return view;
+    }
+
+    std::string_view rest() {
+        const auto view = payload_.substr(offset_);
+        offset_ = payload_.size();
+        return view;
+    }
+
+private:
+    std::string_view payload_;
+    std::size_t offset_ = 0;
+
+    void require(std::size_t count) const {
+        if (!has(count)) {
+            throw std::out_of_range("truncated packet");
+        }
+    }
+};
+
+std::size_t count_placeholders(std::string_view sql) {
+    std::size_t count = 0;
+    char quote = '\0';
+    for (std::size_t index = 0; index < sql.size(); ++index) {
+        const char character = sql[index];
+        if (quote != '\0') {
+            if (character == '\\') {
+                ++index;
+            } else if (character == quote) {
+                quote = '\0';
+            }
+        } else if (character == '\'' || character == '"' || character == '`') {
+            quote = character;
+        } else if (character == '?') {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::vector<std::string_view> split_statements(std::string_view sql) {
+    std::vector<std::string_view> statements;
+    char quote = '\0';
+    std::size_t start = 0;
+    for (std::size_t index = 0; index <= sql.size(); ++index) {
+        const char character = index < sql.size() ? sql[index] : ';';
+        if (quote != '\0') {
+            if (character == '\\') {
+                ++index;
+            } else if (character == quote) {
+                quote = '\0';
+            }
+            continue;
+        }
+        if (character == '\'' || character == '"' || character == '`') {
+            quote = character;
+        } else if (character == ';') {
+            auto statement = sql.substr(start, index - start);
+            const auto first = statement.find_first_not_of(" \t\r\n");
+            if (first != std::string_view::npos) {
+                const auto last = statement.find_last_not_of(" \t\r\n");
+                statements.push_back(statement.substr(first, last - first + 1));
+            } else if (index < sql.size()) {
+                // As on the server, only the final terminator may be followed by nothing.
+                statements.emplace_back();
+            }
+            start = index + 1;
+        }
+    }
+    return statements;
+}
+
+bool starts_with_keyword(std::string_view sql, std::string_view keyword) {
+    if (sql.size() < keyword.size()) {
+        return false;
+    }
+    for (std::size_t index = 0; index < keyword.size(); ++index) {
+        const auto lhs = static_cast<char>(std::toupper(static_cast<unsigned char>(sql[index])));
+        if (lhs != keyword[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::uint8_t wire_type(ColumnType type) {
+    switch (type) {
+        case ColumnType::null: return type_null;
+        case ColumnType::signed_integer:
+        case ColumnType::unsigned_integer: return type_longlong;
+        case ColumnType::floating: return type_double;
+        case ColumnType::text: return type_var_string;
+        case ColumnType::blob: return type_blob;
+        case ColumnType::boolean: return type_tiny;
+    }
+    return type_var_string;
+}
+
+std::string text_value(const Value& value) {
+    return std::visit([](const auto& stored) -> std::string {
+        using T = std::decay_t<decltype(stored)>;
+        if constexpr (std::same_as<T, std::nullptr_t>) {
+            return {};
+        } else if constexpr (std::same_as<T, std::string>) {
+            return stored;
+        } else if constexpr (std::same_as<T, Blob>) {
+            return std::string(reinterpret_cast<const char*>(stored.data()), stored.size());
+        } else if constexpr (std::same_as<T, bool>) {
+            return stored ? "1" : "0";
+        } else {
+            char buffer[32];
+            const auto converted = std::to_chars(buffer, buffer + sizeof(buffer), stored);
+            return std::string(buffer, converted.ptr);
+        }
+    }, value);
+}
+
+template <typename T>
+T numeric_value(const Value& value) {
+    return std::visit([](const auto& stored) -> T {
+        using Stored = std::decay_t<decltype(stored)>;
+        if constexpr (std::same_as<Stored, std::int64_t> || std::same_as<Stored, std::uint64_t> ||
+                      std::same_as<Stored, double> || std::same_as<Stored, bool>) {
+            return static_cast<T>(stored);
+        } else {
+            return T{};
+        }
+    }, value);
+}
+
+void write_column_definition(PacketBuilder& packet, const Column& column) {
+    packet.lenenc_str("def");
+    packet.lenenc_str("stub");
+    packet.lenenc_str("stub");
+    packet.lenenc_str("stub");
+    packet.lenenc_str(column.name);
+    packet.lenenc_str(column.name);
+    packet.lenenc_int(0x0c);
+
+    const auto type = wire_type(column.type);
+    const bool binary = column.type != ColumnType::text;
+    std::uint16_t flags = 0;
+    if (!column.nullable) {
+        flags |= flag_not_null;
+    }
+    if (column.unsigned_value || column.type == ColumnType::unsigned_integer) {
+        flags |= flag_unsigned;
+    }
+    if (column.type == ColumnType::blob) {
+        flags |= flag_blob | flag_binary;
+    }
+
+    packet.u16(binary ? charset_binary : charset_utf8mb4);
+    packet.u32(type == type_var_string || type == type_blob ? 65535 : 21);
+    packet.u8(type);
+    packet.u16(flags);
+    packet.u8(type == type_double ? 31 : 0);
+    packet.u16(0);
+}
+
+Value read_binary_param(PacketReader& reader, std::uint8_t type, bool is_unsigned) {
+    switch (type) {
+        case type_null:
+            return nullptr;
+        case type_tiny:
+            return is_unsigned ? Value{reader.fixed(1)} : Value{static_cast<std::int64_t>(static_cast<std::int8_t>(reader.fixed(1)))};
+        case type_short:
+        case type_year:
+            return is_unsigned ? Value{reader.fixed(2)} : Value{static_cast<std::int64_t>(static_cast<std::int16_t>(reader.fixed(2)))};
+        case type_long:
+        case type_int24:
+            return is_unsigned ? Value{reader.fixed(4)} : Value{static_cast<std::int64_t>(static_cast<std::int32_t>(reader.fixed(4)))};
+        case type_longlong:
+            return is_unsigned ? Value{reader.fixed(8)} : Value{static_cast<std::int64_t>(reader.fixed(8))};
+        case type_float: {
+            const auto bits = static_cast<std::uint32_t>(reader.fixed(4));
+            float value = 0;
+            std::memcpy(&value, &bits, sizeof(value));
+            return static_cast<double>(value);
+        }
+        case type_double: {
+            const auto bits = reader.fixed(8);
+            double value = 0;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        case type_tiny_blob:
+        case type_medium_blob:
+        case type_long_blob:
+        case type_blob: {
+            const auto bytes = reader.lenenc_str();
+            Blob blob(bytes.size());
+            std::memcpy(blob.data(), bytes.data(), bytes.size());
+            return blob;
+        }
+        default:
+            return std::string(reader.lenenc_str());
+    }
+}
+
+DbError unknown_statement_error(std::uint32_t statement_id) {
+    return DbError{
+        .code = ErrorCode::execute_failed,
+        .operation = Operation::execute,
+        .mysql_errno = 1243,
+        .sql_state = "HY000",
+        .message = "Unknown prepared statement handler (" + std::to_string(statement_id) + ") given to mysqld_stmt_execute"
+    };
+}
+
+} // namespace
+
+class StubServer::Session {
+public:
+    Session(StubServer& server, int fd, std::stop_token stop_token)
+        : server_(server), fd_(fd), stop_token_(std::move(stop_token)) {}
+
+    void run() {
+        try {
+            if (!handshake()) {
+                return;
+            }
+            while (!stop_token_.stop_requested()) {
+                auto packet = read_packet();
+                if (!packet || packet->empty()) {
+                    return;
+                }
+                const bool keep_open = dispatch(*packet);
+                flush();
+                if (!keep_open) {
+                    return;
+                }
+            }
+        } catch (const std::exception&) {
+            // Malformed input or a closed socket ends the session.
+        }
+    }
+
+private:
+    struct PreparedStatement {
+        std::string sql;
+        std::size_t param_count = 0;
+        std::vector<std::pair<std::uint8_t, bool>> param_types;
+    };
+
+    StubServer& server_;
+    int fd_;
+    std::stop_token stop_token_;
+    std::uint8_t sequence_ = 0;
+    std::uint32_t client_capabilities_ = 0;
+    bool in_transaction_ = false;
+    std::uint32_t next_statement_id_ = 1;
+    std::unordered_map<std::uint32_t, PreparedStatement> statements_;
+    std::string output_;
+
+    [[nodiscard]] bool deprecate_eof() const noexcept { return (client_capabilities_ & client_deprecate_eof) != 0; }
+
+    [[nodiscard]] std::uint16_t status(bool more_results = false) const noexcept {
+        std::uint16_t flags = in_transaction_ ? status_in_trans : status_autocommit;
+        if (more_results) {
+            flags |= status_more_results;
+        }
+        return flags;
+    }
+
+    bool read_exact(char* data, std::size_t size) {
+        std::size_t done = 0;
+        while (done < size) {
+            pollfd descriptor{.fd = fd_, .events = POLLIN, .revents = 0};
+            const auto ready = ::poll(&descriptor, 1, 100);
+            if (stop_token_.stop_requested()) {
+                return false;
+            }
+            if (ready < 0 && errno != EINTR) {
+                return false;
+            }
+            if (ready <= 0) {
+                continue;
+            }
+            const auto received = ::recv(fd_, data + done, size - done, 0);
+            if (received <= 0) {
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            done += static_cast<std::size_t>(received);
+        }
+        return true;
+    }
+
+    std::optional<std::string> read_packet() {
+        std::string payload;
+        while (true) {
+            unsigned char header[4];
+            if (!read_exact(reinterpret_cast<char*>(header), sizeof(header))) {
+                return std::nullopt;
+            }
+            const std::size_t length = header[0] | (header[1] << 8) | (header[2] << 16);
+            sequence_ = static_cast<std::uint8_t>(header[3] + 1);
+            const auto offset = payload.size();
+            payload.resize(offset + length);
+            if (length > 0 && !read_exact(payload.data() + offset, length)) {
+                return std::nullopt;
+            }
+            if (length < max_packet_payload) {
+                return payload;
+            }
+        }
+    }
+
+    void write_all(std::string_view data) {
+        while (!data.empty()) {
+            const auto sent = ::send(fd_, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("stub server send failed");
+            }
+            data.remove_prefix(static_cast<std::size_t>(sent));
+        }
+    }
+
+    void send_packet(PacketBuilder& packet) { send_packet(packet.payload()); }
+
+    // Packets are buffered until the whole response is ready so a result set costs one send().
+    void send_packet(std::string_view payload) {
+        while (true) {
+            const auto chunk = std::min(payload.size(), max_packet_payload);
+            output_.push_back(static_cast<char>(chunk & 0xff));
+            output_.push_back(static_cast<char>((chunk >> 8) & 0xff));
+            output_.push_back(static_cast<char>((chunk >> 16) & 0xff));
+            output_.push_back(static_cast<char>(sequence_++));
+            output_.append(payload.substr(0, chunk));
+            payload.remove_prefix(chunk);
+            if (chunk < max_packet_payload) {
+                break;
+            }
+        }
+    }
+
+    void flush() {
+        write_all(output_);
+        output_.clear();
+    }
+
+    void send_ok(std::uint64_t affected_rows = 0, std::uint64_t last_insert_id = 0, bool more_results = false,
+                 std::uint8_t header = 0x00) {
+        PacketBuilder packet;
+        packet.u8(header);
+        packet.lenenc_int(affected_rows);
+        packet.lenenc_int(last_insert_id);
+        packet.u16(status(more_results));
+        packet.u16(0);
+        send_packet(packet);
+    }
+
+    void send_eof(bool more_results = false) {
+        PacketBuilder packet;
+        packet.u8(0xfe);
+        packet.u16(0);
+        packet.u16(status(more_results));
+        send_packet(packet);
+    }
+
+    void send_result_terminator(bool more_results) {
+        if (deprecate_eof()) {
+            send_ok(0, 0, more_results, 0xfe);
+        } else {
+            send_eof(more_results);
+        }
+    }
+
+    void send_error(const DbError& error) {
+        PacketBuilder packet;
+        packet.u8(0xff);
+        packet.u16(static_cast<std::uint16_t>(error.mysql_errno == 0 ? 1105 : error.mysql_errno));
+        packet.u8('#');
+        auto sql_state = error.sql_state.empty() ? std::string("HY000") : error.sql_state;
+        sql_state.resize(5, '0');
+        packet.raw(sql_state);
+        packet.raw(error.message);
+        send_packet(packet);
+    }
+
+    bool handshake() {
+        const auto connection_id = server_.next_connection_id_.fetch_add(1, std::memory_order_relaxed);
+        server_.counters_.connections.fetch_add(1, std::memory_order_relaxed);
+
+        PacketBuilder greeting;
+        greeting.u8(10);
+        greeting.nul_str("8.4.0-mysqlwrapper-stub");
+        greeting.u32(connection_id);
+        greeting.raw("abcdefgh");
+        greeting.u8(0);
+        greeting.u16(static_cast<std::uint16_t>(server_capabilities & 0xffff));
+        greeting.u8(static_cast<std::uint8_t>(charset_utf8mb4));
+        greeting.u16(status_autocommit);
+        greeting.u16(static_cast<std::uint16_t>(server_capabilities >> 16));
+        greeting.u8(21);
+        greeting.zeros(10);
+        greeting.raw("ijklmnopqrst");
+        greeting.u8(0);
+        greeting.nul_str(auth_plugin);
+        sequence_ = 0;
+        send_packet(greeting);
+        flush();
+
+        auto response = read_packet();
+        if (!response) {
+            return false;
+        }
+        PacketReader reader(*response);
+        client_capabilities_ = static_cast<std::uint32_t>(reader.fixed(4));
+        (void)reader.fixed(4);
+        (void)reader.fixed(1);
+        (void)reader.bytes(23);
+        (void)reader.nul_str();
+
+        std::string_view auth_response;
+        if ((client_capabilities_ & client_plugin_auth_lenenc_data) != 0) {
+            auth_response = reader.lenenc_str();
+        } else if ((client_capabilities_ & client_secure_connection) != 0) {
+            auth_response = reader.bytes(static_cast<std::size_t>(reader.fixed(1)));
+        } else {
+            auth_response = reader.nul_str();
+        }
+        if ((client_capabilities_ & client_connect_with_db) != 0 && reader.remaining() > 0) {
+            (void)reader.nul_str();
+        }
+        std::string_view client_plugin = auth_plugin;
+        if ((client_capabilities_ & client_plugin_auth) != 0 && reader.remaining() > 0) {
+            client_plugin = reader.nul_str();
+        }
+
+        // Any credentials are accepted. caching_sha2_password clients expect the fast-auth
+        // marker before the final OK when they sent a scramble.
+        if (client_plugin == auth_plugin && !auth_response.empty()) {
+            PacketBuilder fast_auth;
+            fast_auth.u8(0x01);
+            fast_auth.u8(0x03);
+            send_packet(fast_auth);
+        }
+        send_ok();
+        flush();
+        return true;
+    }
+
+    void delay(const StubResponse& response) const {
+        const auto total = server_.options_.default_delay + response.delay;
+        if (total.count() > 0) {
+            std::this_thread::sleep_for(total);
+        }
+    }
+
+    StubResponse respond_to(std::string_view sql, std::span<const Value> params) {
+        if (starts_with_keyword(sql, "START TRANSACTION") || starts_with_keyword(sql, "BEGIN")) {
+            in_transaction_ = true;
+        } else if (starts_with_keyword(sql, "COMMIT") || starts_with_keyword(sql, "ROLLBACK")) {
+            in_transaction_ = false;
+        }
+        auto response = server_.resolve(sql, params);
+        return response ? std::move(*response) : StubResponse{};
+    }
+
+    bool dispatch(const std::string& packet) {
+        const auto command = static_cast<std::uint8_t>(packet[0]);
+        const std::string_view body(packet.data() + 1, packet.size() - 1);
+        switch (command) {
+            case com_quit:
+                return false;
+            case com_query:
+                server_.counters_.queries.fetch_add(1, std::memory_order_relaxed);
+                handle_query(body);
+                return true;
+            case com_ping:
+                server_.counters_.pings.fetch_add(1, std::memory_order_relaxed);
+                delay(StubResponse{});
+                send_ok();
+                return true;
+            case com_stmt_prepare:
+                server_.counters_.prepares.fetch_add(1, std::memory_order_relaxed);
+                handle_prepare(body);
+                return true;
+            case com_stmt_execute:
+                server_.counters_.executes.fetch_add(1, std::memory_order_relaxed);
+                handle_execute(body);
+                return true;
+            case com_stmt_close: {
+                server_.counters_.closes.fetch_add(1, std::memory_order_relaxed);
+                PacketReader reader(body);
+                statements_.erase(static_cast<std::uint32_t>(reader.fixed(4)));
+                return true;
+            }
+            case com_stmt_send_long_data:
+                return true;
+            case com_set_option: {
+                // Option 0 turns multi-statements on and 1 turns them off; the reply is an EOF.
+                server_.counters_.other_commands.fetch_add(1, std::memory_order_relaxed);
+                PacketReader reader(body);
+                if (reader.fixed(2) == 0) {
+                    client_capabilities_ |= client_multi_statements;
+                } else {
+                    client_capabilities_ &= ~client_multi_statements;
+                }
+                send_eof();
+                return true;
+            }
+            case com_stmt_reset:
+            case com_init_db:
+                server_.counters_.other_commands.fetch_add(1, std::memory_order_relaxed);
+                send_ok();
+                return true;
+            default:
+                server_.counters_.other_commands.fetch_add(1, std::memory_order_relaxed);
+                send_error(DbError{.mysql_errno = 1047, .sql_state = "08S01", .message = "Unknown command"});
+                return true;
+        }
+    }
+
+    void handle_query(std::string_view sql) {
+        auto statements = (client_capabilities_ & client_multi_statements) != 0
+            ? split_statements(sql)
+            : std::vector<std::string_view>{sql};
+        if (statements.empty()) {
+            send_error(DbError{.mysql_errno = 1065, .sql_state = "42000", .message = "Query was empty"});
+            return;
+        }
+        for (std::size_t index = 0; index < statements.size(); ++index) {
+            if (statements[index].empty()) {
+                send_error(DbError{.mysql_errno = 1065, .sql_state = "42000", .message = "Query was empty"});
+                return;
+            }
+            const bool more_results = index + 1 < statements.size();
+            auto response = respond_to(statements[index], {});
+            delay(response);
+            if (auto* error = std::get_if<DbError>(&response.body)) {
+                send_error(*error);
+                return;
+            }
+            if (auto* result = std::get_if<Result>(&response.body)) {
+                send_text_result(*result, more_results);
+            } else {
+                const auto& executed = std::get<ExecuteResult>(response.body);
+                send_ok(executed.affected_rows, executed.last_insert_id, more_results);
+            }
+        }
+    }
+
+    void send_columns(std::span<const Column> columns) {
+        for (const auto& column : columns) {
+            PacketBuilder definition;
+            write_column_definition(definition, column);
+            send_packet(definition);
+        }
+        if (!deprecate_eof()) {
+            send_eof();
+        }
+    }
+
+    void send_text_result(const Result& result, bool more_results) {
+        if (result.column_count() == 0) {
+            send_ok(0, 0, more_results);
+            return;
+        }
+        PacketBuilder count;
+        count.lenenc_int(result.column_count());
+        send_packet(count);
+        send_columns(result.columns());
+
+        for (std::size_t row_index = 0; row_index < result.row_count(); ++row_index) {
+            PacketBuilder row;
+            for (const auto& value : result[row_index].values()) {
+                if (std::holds_alternative<std::nullptr_t>(value)) {
+                    row.u8(0xfb);
+                } else {
+                    row.lenenc_str(text_value(value));
+                }
+            }
+            send_packet(row);
+        }
+        send_result_terminator(more_results);
+    }
+
+    void send_binary_result(const Result& result) {
+        PacketBuilder count;
+        count.lenenc_int(result.column_count());
+        send_packet(count);
+        send_columns(result.columns());
+
+        const auto columns = result.columns();
+        const auto bitmap_size = (columns.size() + 7 + 2) / 8;
+        for (std::size_t row_index = 0; row_index < result.row_count(); ++row_index) {
+            const auto values = result[row_index].values();
+            PacketBuilder row;
+            row.u8(0x00);
+            std::string bitmap(bitmap_size, '\0');
+            for (std::size_t index = 0; index < values.size(); ++index) {
+                if (std::holds_alternative<std::nullptr_t>(values[index]) || columns[index].type == ColumnType::null) {
+                    bitmap[(index + 2) / 8] = static_cast<char>(bitmap[(index + 2) / 8] | (1 << ((index + 2) % 8)));
+                }
+            }
+            row.raw(bitmap);
+            for (std::size_t index = 0; index < values.size(); ++index) {
+                const auto& value = values[index];
+                if (std::holds_alternative<std::nullptr_t>(value) || columns[index].type == ColumnType::null) {
+                    continue;
+                }
+                switch (wire_type(columns[index].type)) {
+                    case type_longlong:
+                        if (const auto* unsigned_value = std::get_if<std::uint64_t>(&value)) {
+                            row.u64(*unsigned_value);
+                        } else {
+                            row.u64(static_cast<std::uint64_t>(numeric_value<std::int64_t>(value)));
+                        }
+                        break;
+                    case type_double: {
+                        const auto number = numeric_value<double>(value);
+                        std::uint64_t bits = 0;
+                        std::memcpy(&bits, &number, sizeof(bits));
+                        row.u64(bits);
+                        break;
+                    }
+                    case type_tiny:
+                        row.u8(static_cast<std::uint8_t>(numeric_value<std::int64_t>(value)));
+                        break;
+                    default:
+                        row.lenenc_str(text_value(value));
+                        break;
+                }
+            }
+            send_packet(row);
+        }
+        send_result_terminator(false);
+    }
+
+    void handle_prepare(std::string_view sql) {
+        const auto statement_id = next_statement_id_++;
+        PreparedStatement statement{.sql = std::string(sql), .param_count = count_placeholders(sql), .param_types = {}};
+
+        // Result metadata is announced at prepare time from the parameterless response.
+        const auto preview = server_.resolve(sql, {});
+        std::vector<Column> columns;
+        if (preview) {
+            if (const auto* error = std::get_if<DbError>(&preview->body)) {
+                delay(*preview);
+                send_error(*error);
+                return;
+            }
+            if (const auto* result = std::get_if<Result>(&preview->body)) {
+                columns.assign(result->columns().begin(), result->columns().end());
+            }
+        }
+        delay(StubResponse{});
+
+        PacketBuilder ok;
+        ok.u8(0x00);
+        ok.u32(statement_id);
+        ok.u16(static_cast<std::uint16_t>(columns.size()));
+        ok.u16(static_cast<std::uint16_t>(statement.param_count));
+        ok.u8(0);
+        ok.u16(0);
+        send_packet(ok);
+
+        if (statement.param_count > 0) {
+            std::vector<Column> params(statement.param_count, Column{.name = "?", .type = ColumnType::text});
+            send_columns(params);
+        }
+        if (!columns.empty()) {
+            send_columns(columns);
+        }
+        statements_.emplace(statement_id, std::move(statement));
+    }
+
+    void handle_execute(std::string_view body) {
+        PacketReader reader(body);
+        const auto statement_id = static_cast<std::uint32_t>(reader.fixed(4));
+        (void)reader.fixed(1);
+        (void)reader.fixed(4);
+
+        const auto found = statements_.find(statement_id);
+        if (found == statements_.end()) {
+            send_error(unknown_statement_error(statement_id));
+            return;
+        }
+        auto& statement = found->second;
+
+        std::vector<Value> params;
+        if (statement.param_count > 0) {
+            const auto null_bitmap = reader.bytes((statement.param_count + 7) / 8);
+            const auto new_params_bound = reader.fixed(1);
+            if (new_params_bound == 1) {
+                statement.param_types.clear();
+                for (std::size_t index = 0; index < statement.param_count; ++index) {
+                    const auto type = static_cast<std::uint8_t>(reader.fixed(1));
+                    const auto flags = reader.fixed(1);
+                    statement.param_types.emplace_back(type, (flags & 0x80) != 0);
+                }
+            }
+            if (statement.param_types.size() != statement.param_count) {
+                send_error(DbError{.mysql_errno = 1210, .sql_state = "HY000",
+                                   .message = "Incorrect arguments to mysqld_stmt_execute"});
+                return;
+            }
+            params.reserve(statement.param_count);
+            for (std::size_t index = 0; index < statement.param_count; ++index) {
+                const bool is_null = (static_cast<unsigned char>(null_bitmap[index / 8]) >> (index % 8)) & 1;
+                if (is_null) {
+                    params.emplace_back(nullptr);
+                } else {
+                    const auto [type, is_unsigned] = statement.param_types[index];
+                    params.push_back(read_binary_param(reader, type, is_unsigned));
+                }
+            }
+        }
+
+        auto response = respond_to(statement.sql, params);
+        delay(response);
+        if (auto* error = std::get_if<DbError>(&response.body)) {
+            send_error(*error);
+        } else if (auto* result = std::get_if<Result>(&response.body); result != nullptr && result->column_count() > 0) {
+            send_binary_result(*result);
+        } else if (result != nullptr) {
+            send_ok();
+        } else {
+            const auto& executed = std::get<ExecuteResult>(response.body);
+            send_ok(executed.affected_rows, executed.last_insert_id);
+        }
+    }
+};
+
+StubServer::StubServer(StubServerOptions options) : options_(std::move(options)) {
+    if (options_.unix_socket_path.empty()) {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) {
+            throw std::runtime_error("stub server: socket() failed");
+        }
+        const int reuse = 1;
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(listen_fd_);
+            throw std::runtime_error("stub server: bind() failed");
+        }
+        socklen_t length = sizeof(address);
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+    } else {
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) {
+            throw std::runtime_error("stub server: socket() failed");
+        }
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (options_.unix_socket_path.size() >= sizeof(address.sun_path)) {
+            ::close(listen_fd_);
+            throw std::runtime_error("stub server: unix socket path too long");
+        }
+        std::memcpy(address.sun_path, options_.unix_socket_path.c_str(), options_.unix_socket_path.size() + 1);
+        ::unlink(options_.unix_socket_path.c_str());
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(listen_fd_);
+            throw std::runtime_error("stub server: bind() failed");
+        }
+    }
+    if (::listen(listen_fd_, 128) != 0) {
+        ::close(listen_fd_);
+        throw std::runtime_error("stub server: listen() failed");
+    }
+    acceptor_ = std::jthread([this](std::stop_token stop_token) {
+        if (options_.on_thread_start) {
+            options_.on_thread_start();
+        }
+        accept_loop(std::move(stop_token));
+    });
+}
+
+StubServer::~StubServer() {
+    stop();
+}
+
+void StubServer::stop() noexcept {
+    acceptor_.request_stop();
+    if (acceptor_.joinable()) {
+        acceptor_.join();
+    }
+
+    std::vector<std::jthread> sessions;
+    {
+        std::lock_guard lock(mutex_);
+        for (const auto fd : session_fds_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        sessions.swap(sessions_);
+    }
+    sessions.clear();
+
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        if (!options_.unix_socket_path.empty()) {
+            ::unlink(options_.unix_socket_path.c_str());
+        }
+    }
+}
+
+void StubServer::accept_loop(std::stop_token stop_token) {
+    while (!stop_token.stop_requested()) {
+        pollfd descriptor{.fd = listen_fd_, .events = POLLIN, .revents = 0};
+        if (::poll(&descriptor, 1, 100) <= 0) {
+            continue;
+        }
+        const int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        if (options_.unix_socket_path.empty()) {
+            const int nodelay = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        }
+
+        std::lock_guard lock(mutex_);
+        session_fds_.push_back(fd);
+        sessions_.emplace_back([this, fd](std::stop_token session_stop) {
+            if (options_.on_thread_start) {
+                options_.on_thread_start();
+            }
+            serve(fd, std::move(session_stop));
+        });
+    }
+}
+
+void StubServer::serve(int fd, std::stop_token stop_token) {
+    Session session(*this, fd, std::move(stop_token));
+    session.run();
+
+    std::lock_guard lock(mutex_);
+    session_fds_.erase(std::remove(session_fds_.begin(), session_fds_.end(), fd), session_fds_.end());
+    ::close(fd);
+}
+
+void StubServer::script(std::string sql, StubResponse response) {
+    std::lock_guard lock(mutex_);
+    scripts_.insert_or_assign(std::move(sql), std::move(response));
+}
+
+void StubServer::set_handler(StubHandler handler) {
+    std::lock_guard lock(mutex_);
+    handler_ = std::move(handler);
+}
+
+std::optional<StubResponse> StubServer::resolve(std::string_view sql, std::span<const Value> params) const {
+    StubHandler handler;
+    {
+        std::lock_guard lock(mutex_);
+        handler = handler_;
+        if (!handler) {
+            const auto found = scripts_.find(std::string(sql));
+            if (found != scripts_.end()) {
+                return found->second;
+            }
+            return std::nullopt;
+        }
+    }
+    if (auto response = handler(sql, params)) {
+        return response;
+    }
+    std::lock_guard lock(mutex_);
+    const auto found = scripts_.find(std::string(sql));
+    if (found != scripts_.end()) {
+        return found->second;
+    }
+    return std::nullopt;
+}
+
+std::uint16_t StubServer::port() const noexcept {
+    return port_;
+}
+
+const std::string& StubServer::unix_socket_path() const noexcept {
+    return options_.unix_socket_path;
+}
+
+ConnectionConfig StubServer::connection_config() const {
+    ConnectionConfig config;
+    config.host = "127.0.0.1";
+    config.port = port_;
+    if (!options_.unix_socket_path.empty()) {
+        config.host = "localhost";
+        config.transport = Transport::unix_socket;
+        config.unix_socket = options_.unix_socket_path;
+    }
+    config.user = "stub";
+    config.password = "stub";
+    config.database = "stub";
+    config.initial_pool_size = 1;
+    config.max_pool_size = 4;
+    config.worker_count = 2;
+    config.connect_timeout = std::chrono::seconds{5};
+    config.read_timeout = std::chrono::seconds{5};
+    config.write_timeout = std::chrono::seconds{5};
+    config.acquire_timeout = std::chrono::seconds{5};
+    return config;
+}
+
+StubServerStats StubServer::stats() const noexcept {
+    return StubServerStats{
+        .connections = counters_.connections.load(std::memory_order_relaxed),
+        .queries = counters_.queries.load(std::memory_order_relaxed),
+        .prepares = counters_.prepares.load(std::memory_order_relaxed),
+        .executes = counters_.executes.load(std::memory_order_relaxed),
+        .closes = counters_.closes.load(std::memory_order_relaxed),
+        .pings = counters_.pings.load(std::memory_order_relaxed),
+        .other_commands = counters_.other_commands.load(std::memory_order_relaxed)
+    };
+}
+
+void StubServer::reset_stats() noexcept {
+    counters_.connections.store(0, std::memory_order_relaxed);
+    counters_.queries.store(0, std::memory_order_relaxed);
+    counters_.prepares.store(0, std::memory_order_relaxed);
+    counters_.executes.store(0, std::memory_order_relaxed);
+    counters_.closes.store(0, std::memory_order_relaxed);
+    counters_.pings.store(0, std::memory_order_relaxed);
+    counters_.other_commands.store(0, std::memory_order_relaxed);
+}
+
+} // namespace mysqlw::testing
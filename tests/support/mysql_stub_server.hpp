@@ -0,0 +1,115 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace mysqlw::testing {
+
+// What the stub answers for one statement: a result set, an OK packet or an ERR packet
+// (DbError::mysql_errno, sql_state and message are sent to the client).
+struct StubResponse {
+    std::variant<Result, ExecuteResult, DbError> body = ExecuteResult{};
+    std::chrono::microseconds delay{0};
+};
+
+using StubHandler = std::function<std::optional<StubResponse>(std::string_view sql, std::span<const Value> params)>;
+
+struct StubServerOptions {
+    // Listen on this Unix socket path instead of an ephemeral 127.0.0.1 TCP port.
+    std::string unix_socket_path;
+    // Added before every response, on top of StubResponse::delay.
+    std::chrono::microseconds default_delay{0};
+    // Runs first on every server thread, for example to leave the stub's own allocations out of
+    // a measurement.
+    std::function<void()> on_thread_start;
+};
+
+// Server round trips seen by the stub, one counter per protocol command.
+struct StubServerStats {
+    std::uint64_t connections = 0;
+    std::uint64_t queries = 0;
+    std::uint64_t prepares = 0;
+    std::uint64_t executes = 0;
+    std::uint64_t closes = 0;
+    std::uint64_t pings = 0;
+    std::uint64_t other_commands = 0;
+
+    [[nodiscard]] std::uint64_t round_trips() const noexcept {
+        // COM_STMT_CLOSE has no response and so is not a round trip.
+        return queries + prepares + executes + pings + other_commands;
+    }
+};
+
+// A minimal MySQL wire-protocol server for deterministic end-to-end tests and benchmarks. It
+// speaks the handshake (accepting any credentials), COM_QUERY including multi-statements,
+// COM_STMT_PREPARE/EXECUTE/CLOSE/RESET, COM_SET_OPTION, COM_PING and COM_QUIT. Responses come from the handler,
+// then from exact-match scripts, and default to an OK packet.
+class StubServer {
+public:
+    explicit StubServer(StubServerOptions options = {});
+    ~StubServer();
+
+    StubServer(const StubServer&) = delete;
+    StubServer& operator=(const StubServer&) = delete;
+
+    void script(std::string sql, StubResponse response);
+    void set_handler(StubHandler handler);
+
+    [[nodiscard]] std::uint16_t port() const noexcept;
+    [[nodiscard]] const std::string& unix_socket_path() const noexcept;
+
+    // A pool configuration that points at this server over TCP, or over its Unix socket.
+    [[nodiscard]] ConnectionConfig connection_config() const;
+
+    [[nodiscard]] StubServerStats stats() const noexcept;
+    void reset_stats() noexcept;
+
+    [[nodiscard]] std::optional<StubResponse> resolve(std::string_view sql, std::span<const Value> params) const;
+
+    void stop() noexcept;
+
+private:
+    class Session;
+
+    struct Counters {
+        std::atomic<std::uint64_t> connections{0};
+        std::atomic<std::uint64_t> queries{0};
+        std::atomic<std::uint64_t> prepares{0};
+        std::atomic<std::uint64_t> executes{0};
+        std::atomic<std::uint64_t> closes{0};
+        std::atomic<std::uint64_t> pings{0};
+        std::atomic<std::uint64_t> other_commands{0};
+    };
+
+    StubServerOptions options_;
+    int listen_fd_ = -1;
+    std::uint16_t port_ = 0;
+    std::atomic<std::uint32_t> next_connection_id_{1};
+    Counters counters_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, StubResponse> scripts_;
+    StubHandler handler_;
+    std::vector<int> session_fds_;
+    std::vector<std::jthread> sessions_;
+    std::jthread acceptor_;
+
+    void accept_loop(std::stop_token stop_token);
+    void serve(int fd, std::stop_token stop_token);
+};
+
+} // namespace mysqlw::testing
@@ -0,0 +1,409 @@
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include "support/fake_connection.hpp"
+#include "tool_support.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace mysqlw;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class OperationKind : std::size_t {
+    point_select,
+    range_scan,
+    insert,
+    transaction,
+    count
+};
+
+constexpr std::size_t operation_kinds = static_cast<std::size_t>(OperationKind::count);
+constexpr std::array<std::string_view, operation_kinds> operation_names{"point", "range", "insert", "transaction"};
+
+enum class Api {
+    sync,
+    async
+};
+
+enum class Backend {
+    mysql,
+    fake
+};
+
+struct LoadOptions {
+    std::array<unsigned, operation_kinds> mix{70, 10, 15, 5};
+    Api api = Api::sync;
+    Backend backend = Backend::mysql;
+    double rate = 0.0;
+    std::size_t concurrency = 8;
+    std::chrono::duration<double> duration{10.0};
+    std::chrono::duration<double> warmup{1.0};
+    std::uint64_t rows = 10000;
+    std::uint64_t range_rows = 100;
+    std::string table = "mysqlwrapper_loadgen";
+    std::string record_path;
+    bool setup = false;
+    std::chrono::microseconds fake_latency{100};
+    tools::ConnectionFlags connection;
+};
+
+struct OperationStats {
+    std::uint64_t operations = 0;
+    std::uint64_t errors = 0;
+    // Measured from the intended start time in open-loop runs; equal to service_time in closed-loop runs.
+    tools::LogLinearHistogram latency;
+    tools::LogLinearHistogram service_time;
+
+    void merge(const OperationStats& other) {
+        operations += other.operations;
+        errors += other.errors;
+        latency.merge(other.latency);
+        service_time.merge(other.service_time);
+    }
+};
+
+using ThreadStats = std::array<OperationStats, operation_kinds>;
+
+class Workload {
+public:
+    Workload(Database& database, const LoadOptions& options)
+        : database_(database),
+          options_(options),
+          point_sql_("SELECT id, k, v FROM `" + options.table + "` WHERE id = ?"),
+          range_sql_("SELECT id, k, v FROM `" + options.table + "` WHERE id BETWEEN ? AND ?"),
+          insert_sql_("INSERT INTO `" + options.table + "` (k, v) VALUES (?, ?)"),
+          lock_sql_("SELECT k FROM `" + options.table + "` WHERE id = ? FOR UPDATE"),
+          update_sql_("UPDATE `" + options.table + "` SET k = k + 1 WHERE id = ?") {}
+
+    bool run(OperationKind kind, std::mt19937_64& random) {
+        const auto id = static_cast<std::int64_t>(random() % options_.rows + 1);
+        switch (kind) {
+            case OperationKind::point_select:
+                return options_.api == Api::sync ? database_.query(point_sql_, id).has_value()
+                                                 : database_.query_async(point_sql_, id).get().has_value();
+            case OperationKind::range_scan: {
+                const auto last = id + static_cast<std::int64_t>(options_.range_rows) - 1;
+                return options_.api == Api::sync ? database_.query(range_sql_, id, last).has_value()
+                                                 : database_.query_async(range_sql_, id, last).get().has_value();
+            }
+            case OperationKind::insert: {
+                const auto k = static_cast<std::int64_t>(random() >> 1);
+                return options_.api == Api::sync ? database_.execute(insert_sql_, k, "loadgen").has_value()
+                                                 : database_.execute_async(insert_sql_, k, "loadgen").get().has_value();
+            }
+            case OperationKind::transaction:
+                // There is no asynchronous transaction API; both modes use Database::transaction.
+                return database_.transaction([&](Transaction& tx) -> Expected<ExecuteResult> {
+                    if (auto locked = tx.query(lock_sql_, id); !locked) {
+                        return std::unexpected(locked.error());
+                    }
+                    return tx.execute(update_sql_, id);
+                }).has_value();
+            case OperationKind::count:
+                break;
+        }
+        return false;
+    }
+
+private:
+    Database& database_;
+    const LoadOptions& options_;
+    std::string point_sql_;
+    std::string range_sql_;
+    std::string insert_sql_;
+    std::string lock_sql_;
+    std::string update_sql_;
+};
+
+class MixPicker {
+public:
+    explicit MixPicker(const std::array<unsigned, operation_kinds>& mix) {
+        unsigned total = 0;
+        for (std::size_t index = 0; index < operation_kinds; ++index) {
+            total += mix[index];
+            cumulative_[index] = total;
+        }
+        total_ = total;
+    }
+
+    OperationKind pick(std::mt19937_64& random) const {
+        const auto ticket = static_cast<unsigned>(random() % total_);
+        for (std::size_t index = 0; index < operation_kinds; ++index) {
+            if (ticket < cumulative_[index]) {
+                return static_cast<OperationKind>(index);
+            }
+        }
+        return OperationKind::point_select;
+    }
+
+private:
+    std::array<unsigned, operation_kinds> cumulative_{};
+    unsigned total_ = 1;
+};
+
+Expected<void> setup_table(Database& database, const LoadOptions& options) {
+    const auto table = "`" + options.table + "`";
+    for (const auto& statement : {
+             "DROP TABLE IF EXISTS " + table,
+             "CREATE TABLE " + table +
+                 " (id BIGINT NOT NULL AUTO_INCREMENT PRIMARY KEY, k BIGINT NOT NULL, v VARCHAR(64) NOT NULL)"}) {
+        if (auto result = database.execute(statement); !result) {
+            return std::unexpected(result.error());
+        }
+    }
+
+    constexpr std::uint64_t batch_rows = 1000;
+    for (std::uint64_t first = 1; first <= options.rows; first += batch_rows) {
+        std::string sql = "INSERT INTO " + table + " (k, v) VALUES ";
+        const auto last = std::min(options.rows, first + batch_rows - 1);
+        for (auto id = first; id <= last; ++id) {
+            sql += id == first ? "(" : ",(";
+            sql += std::to_string(id * 7919 % 1000003);
+            sql += ",'row-";
+            sql += std::to_string(id);
+            sql += "')";
+        }
+        if (auto result = database.execute(sql); !result) {
+            return std::unexpected(result.error());
+        }
+    }
+    return {};
+}
+
+// Open loop: operation i is due at start + i / rate no matter how long earlier ones took, and
+// latency is measured from that intended time so queueing behind a slow call is not hidden
+// (coordinated omission). Closed loop: each thread issues its next call when the last returns.
+ThreadStats run_load(Database& database, const LoadOptions& options) {
+    Workload workload(database, options);
+    const MixPicker picker(options.mix);
+    const bool open_loop = options.rate > 0.0;
+    const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(options.rate, 1e-9)));
+
+    const auto started = Clock::now();
+    const auto measured_from = started + std::chrono::duration_cast<Clock::duration>(options.warmup);
+    const auto deadline = measured_from + std::chrono::duration_cast<Clock::duration>(options.duration);
+    std::atomic<std::uint64_t> next_slot{0};
+
+    std::vector<ThreadStats> per_thread(options.concurrency);
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(options.concurrency);
+        for (std::size_t thread_index = 0; thread_index < options.concurrency; ++thread_index) {
+            threads.emplace_back([&, thread_index] {
+                std::mt19937_64 random(0x9e3779b97f4a7c15ULL * (thread_index + 1));
+                auto& stats = per_thread[thread_index];
+                while (true) {
+                    auto intended = Clock::now();
+                    if (open_loop) {
+                        intended = started + interval * static_cast<Clock::rep>(next_slot.fetch_add(1, std::memory_order_relaxed));
+                        if (intended >= deadline) {
+                            break;
+                        }
+                        std::this_thread::sleep_until(intended);
+                    } else if (intended >= deadline) {
+                        break;
+                    }
+
+                    const auto kind = picker.pick(random);
+                    const auto issued = Clock::now();
+                    const bool ok = workload.run(kind, random);
+                    const auto finished = Clock::now();
+                    if (intended < measured_from) {
+                        continue;
+                    }
+
+                    auto& operation = stats[static_cast<std::size_t>(kind)];
+                    ++(ok ? operation.operations : operation.errors);
+                    operation.latency.record(finished - (open_loop ? intended : issued));
+                    operation.service_time.record(finished - issued);
+                }
+            });
+        }
+    }
+
+    ThreadStats total;
+    for (const auto& stats : per_thread) {
+        for (std::size_t index = 0; index < operation_kinds; ++index) {
+            total[index].merge(stats[index]);
+        }
+    }
+    return total;
+}
+
+void print_histogram(std::string_view name, const tools::LogLinearHistogram& histogram) {
+    std::cout << '"' << name << "\": {\"p50_us\": " << tools::to_microseconds(histogram.quantile(0.50))
+              << ", \"p90_us\": " << tools::to_microseconds(histogram.quantile(0.90))
+              << ", \"p99_us\": " << tools::to_microseconds(histogram.quantile(0.99))
+              << ", \"p999_us\": " << tools::to_microseconds(histogram.quantile(0.999))
+              << ", \"max_us\": " << tools::to_microseconds(histogram.max())
+              << ", \"mean_us\": " << tools::to_microseconds(histogram.mean()) << '}';
+}
+
+void print_operation(std::string_view name, const OperationStats& stats, double seconds) {
+    const auto attempts = stats.operations + stats.errors;
+    std::cout << "    {\"operation\": \"" << name << "\", \"operations\": " << stats.operations
+              << ", \"errors\": " << stats.errors
+              << ", \"error_rate\": " << (attempts == 0 ? 0.0 : static_cast<double>(stats.errors) / static_cast<double>(attempts))
+              << ", \"ops_per_second\": " << static_cast<double>(stats.operations) / seconds << ", ";
+    print_histogram("latency", stats.latency);
+    std::cout << ", ";
+    print_histogram("service_time", stats.service_time);
+    std::cout << '}';
+}
+
+bool parse_mix(std::string_view text, std::array<unsigned, operation_kinds>& mix) {
+    mix.fill(0);
+    while (!text.empty()) {
+        const auto comma = text.find(',');
+        const auto entry = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+
+        const auto colon = entry.find(':');
+        if (colon == std::string_view::npos) {
+            return false;
+        }
+        const auto name = entry.substr(0, colon);
+        const auto found = std::find(operation_names.begin(), operation_names.end(), name);
+        if (found == operation_names.end()) {
+            return false;
+        }
+        mix[static_cast<std::size_t>(found - operation_names.begin())] =
+            static_cast<unsigned>(std::strtoul(std::string(entry.substr(colon + 1)).c_str(), nullptr, 10));
+    }
+    return std::any_of(mix.begin(), mix.end(), [](unsigned weight) { return weight > 0; });
+}
+
+[[noreturn]] void usage() {
+    std::cerr << "usage: mysqlwrapper_loadgen [--mix=point:70,range:10,insert:15,transaction:5] [--api=sync|async]\n"
+                 "       [--rate=ops_per_second | closed loop when 0] [--concurrency=n] [--duration=seconds]\n"
+                 "       [--warmup=seconds] [--rows=n] [--range-rows=n] [--table=name] [--setup]\n"
+                 "       [--record=traffic.log] [--backend=mysql|fake] [--fake-latency-us=n] "
+              << tools::ConnectionFlags::usage << '\n';
+    std::exit(2);
+}
+
+LoadOptions parse_options(int argc, char** argv) {
+    using tools::ConnectionFlags;
+
+    LoadOptions options;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view argument(argv[index]);
+        if (options.connection.parse(argument)) {
+            continue;
+        }
+        if (auto value = ConnectionFlags::flag_value(argument, "--mix=")) {
+            if (!parse_mix(*value, options.mix)) {
+                usage();
+            }
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--api=")) {
+            if (*value != "sync" && *value != "async") {
+                usage();
+            }
+            options.api = *value == "sync" ? Api::sync : Api::async;
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--backend=")) {
+            if (*value != "mysql" && *value != "fake") {
+                usage();
+            }
+            options.backend = *value == "mysql" ? Backend::mysql : Backend::fake;
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--rate=")) {
+            options.rate = std::strtod(std::string(*value).c_str(), nullptr);
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--concurrency=")) {
+            options.concurrency = std::max<std::size_t>(1, std::strtoull(std::string(*value).c_str(), nullptr, 10));
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--duration=")) {
+            options.duration = std::chrono::duration<double>(std::strtod(std::string(*value).c_str(), nullptr));
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--warmup=")) {
+            options.warmup = std::chrono::duration<double>(std::strtod(std::string(*value).c_str(), nullptr));
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--rows=")) {
+            options.rows = std::max<std::uint64_t>(1, std::strtoull(std::string(*value).c_str(), nullptr, 10));
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--range-rows=")) {
+            options.range_rows = std::max<std::uint64_t>(1, std::strtoull(std::string(*value).c_str(), nullptr, 10));
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--table=")) {
+            options.table = std::string(*value);
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--fake-latency-us=")) {
+            options.fake_latency = std::chrono::microseconds(std::strtoll(std::string(*value).c_str(), nullptr, 10));
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--record=")) {
+            options.record_path = std::string(*value);
+        } else if (argument == "--setup") {
+            options.setup = true;
+        } else {
+            usage();
+        }
+    }
+    if (options.table.find('`') != std::string::npos) {
+        usage();
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto options = parse_options(argc, argv);
+    const auto& config = options.connection.config();
+
+    std::unique_ptr<Database> database;
+    if (options.backend == Backend::fake) {
+        auto backend = std::make_shared<testing::FakeBackend>(testing::FakeBackendOptions{.query_latency = options.fake_latency});
+        database = std::make_unique<Database>(config, testing::make_fake_connection_factory(std::move(backend)));
+    } else {
+        database = std::make_unique<Database>(config);
+    }
+
+    if (options.setup && options.backend == Backend::mysql) {
+        if (auto prepared = setup_table(*database, options); !prepared) {
+            std::cerr << "setup failed: " << to_string(prepared.error().code) << ": " << prepared.error().message << '\n';
+            return 1;
+        }
+    }
+
+    if (!options.record_path.empty()) {
+        if (auto recording = database->start_recording(options.record_path); !recording) {
+            std::cerr << "cannot record: " << recording.error().message << '\n';
+            return 1;
+        }
+    }
+
+    const auto results = run_load(*database, options);
+    if (!options.record_path.empty()) {
+        (void)database->stop_recording();
+    }
+    const auto seconds = options.duration.count();
+
+    OperationStats total;
+    for (const auto& stats : results) {
+        total.merge(stats);
+    }
+
+    const auto metrics = database->metrics();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "{\n  \"library\": \"mysqlwrapper\",\n  \"api\": \"" << (options.api == Api::sync ? "sync" : "async")
+              << "\",\n  \"loop\": \"" << (options.rate > 0.0 ? "open" : "closed") << "\",\n  \"target_rate\": "
+              << options.rate << ",\n  \"concurrency\": " << options.concurrency << ",\n  \"duration_seconds\": "
+              << seconds << ",\n  \"pool_acquire_p99_us\": " << metrics.acquire_latency.quantile(0.99) * 1e6
+              << ",\n  \"operations\": [\n";
+    for (std::size_t index = 0; index < operation_kinds; ++index) {
+        if (options.mix[index] == 0) {
+            continue;
+        }
+        print_operation(operation_names[index], results[index], seconds);
+        std::cout << ",\n";
+    }
+    print_operation("total", total, seconds);
+    std::cout << "\n  ]\n}\n";
+    return total.errors == 0 ? 0 : 1;
+}
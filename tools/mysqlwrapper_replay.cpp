@@ -0,0 +1,315 @@
+#include "mysqlwrapper/mysql_wrapper.hpp"
+#include "mysqlwrapper/traffic_log.hpp"
+
+#include "support/fake_connection.hpp"
+#include "tool_support.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace mysqlw;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t api_count = static_cast<std::size_t>(TrafficApi::stream) + 1;
+
+struct ReplayOptions {
+    std::string log_path;
+    // Multiplier on the recorded pace; 2.0 replays twice as fast, 0 replays without pauses.
+    double speed = 1.0;
+    std::size_t concurrency = 16;
+    std::uint64_t limit = 0;
+    bool fake_backend = false;
+    tools::ConnectionFlags connection;
+};
+
+// A single call, or every call of one recorded transaction, which must run in order on one thread.
+struct Unit {
+    std::chrono::nanoseconds start{0};
+    std::vector<TrafficRecord> calls;
+};
+
+struct ApiStats {
+    std::uint64_t calls = 0;
+    std::uint64_t recorded_errors = 0;
+    std::uint64_t replay_errors = 0;
+    // Calls that succeeded in one run and failed in the other.
+    std::uint64_t mismatches = 0;
+    tools::LogLinearHistogram recorded;
+    tools::LogLinearHistogram replayed;
+
+    void merge(const ApiStats& other) {
+        calls += other.calls;
+        recorded_errors += other.recorded_errors;
+        replay_errors += other.replay_errors;
+        mismatches += other.mismatches;
+        recorded.merge(other.recorded);
+        replayed.merge(other.replayed);
+    }
+};
+
+struct ThreadStats {
+    std::array<ApiStats, api_count> apis;
+    std::chrono::nanoseconds max_lag{0};
+};
+
+Expected<std::vector<Unit>> load_units(const ReplayOptions& options) {
+    auto reader = TrafficLogReader::open(options.log_path);
+    if (!reader) {
+        return std::unexpected(reader.error());
+    }
+
+    std::vector<Unit> units;
+    std::map<std::uint64_t, std::size_t> open_sessions;
+    std::uint64_t loaded = 0;
+    while (options.limit == 0 || loaded < options.limit) {
+        auto record = reader->next();
+        if (!record) {
+            return std::unexpected(record.error());
+        }
+        if (!*record) {
+            break;
+        }
+        ++loaded;
+
+        auto& call = **record;
+        if (call.session == 0) {
+            units.push_back(Unit{.start = call.timestamp, .calls = {}});
+            units.back().calls.push_back(std::move(call));
+            continue;
+        }
+        auto [found, inserted] = open_sessions.try_emplace(call.session, units.size());
+        if (inserted) {
+            units.push_back(Unit{.start = call.timestamp, .calls = {}});
+        }
+        auto& unit = units[found->second];
+        unit.start = std::min(unit.start, call.timestamp);
+        const bool finished = call.api == TrafficApi::transaction_commit || call.api == TrafficApi::transaction_rollback;
+        unit.calls.push_back(std::move(call));
+        if (finished) {
+            open_sessions.erase(found);
+        }
+    }
+
+    std::stable_sort(units.begin(), units.end(), [](const Unit& lhs, const Unit& rhs) { return lhs.start < rhs.start; });
+    return units;
+}
+
+// Reads streamed rows off the connection as the original caller did, without keeping them.
+class DiscardSink final : public RowSink {
+public:
+    [[nodiscard]] Expected<void> begin(std::span<const Column>) override {
+        return {};
+    }
+
+    [[nodiscard]] Expected<void> row(std::span<const ValueView>) override {
+        return {};
+    }
+};
+
+bool run_call(Database& database, std::optional<Transaction>& transaction, const TrafficRecord& call) {
+    switch (call.api) {
+        case TrafficApi::query:
+            return query_with_values(database, call.sql, call.params).has_value();
+        case TrafficApi::execute:
+            return execute_with_values(database, call.sql, call.params).has_value();
+        case TrafficApi::query_async:
+            return submit_query_with_values(database, call.sql, call.params).get().has_value();
+        case TrafficApi::execute_async:
+            return submit_execute_with_values(database, call.sql, call.params).get().has_value();
+        case TrafficApi::transaction_begin: {
+            auto begun = database.begin_transaction();
+            if (!begun) {
+                return false;
+            }
+            transaction.emplace(std::move(*begun));
+            return true;
+        }
+        case TrafficApi::transaction_query:
+            return transaction && transaction_query_with_values(*transaction, call.sql, call.params).has_value();
+        case TrafficApi::transaction_execute:
+            return transaction && transaction_execute_with_values(*transaction, call.sql, call.params).has_value();
+        case TrafficApi::transaction_commit: {
+            const bool ok = transaction && transaction->commit().has_value();
+            transaction.reset();
+            return ok;
+        }
+        case TrafficApi::transaction_rollback: {
+            const bool ok = transaction && transaction->rollback().has_value();
+            transaction.reset();
+            return ok;
+        }
+        case TrafficApi::stream: {
+            DiscardSink sink;
+            return stream_with_values(database, call.sql, sink, call.params).has_value();
+        }
+    }
+    return false;
+}
+
+ThreadStats replay(Database& database, const std::vector<Unit>& units, const ReplayOptions& options) {
+    const auto origin = units.empty() ? std::chrono::nanoseconds{0} : units.front().start;
+    const auto replay_started = Clock::now();
+    const auto scheduled = [&](std::chrono::nanoseconds timestamp) {
+        const auto offset = std::chrono::duration<double, std::nano>((timestamp - origin).count() / options.speed);
+        return replay_started + std::chrono::duration_cast<Clock::duration>(offset);
+    };
+
+    std::atomic<std::size_t> next_unit{0};
+    std::vector<ThreadStats> per_thread(options.concurrency);
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(options.concurrency);
+        for (std::size_t thread_index = 0; thread_index < options.concurrency; ++thread_index) {
+            threads.emplace_back([&, thread_index] {
+                auto& stats = per_thread[thread_index];
+                while (true) {
+                    const auto unit_index = next_unit.fetch_add(1, std::memory_order_relaxed);
+                    if (unit_index >= units.size()) {
+                        return;
+                    }
+                    std::optional<Transaction> transaction;
+                    for (const auto& call : units[unit_index].calls) {
+                        if (options.speed > 0.0) {
+                            const auto due = scheduled(call.timestamp);
+                            std::this_thread::sleep_until(due);
+                            stats.max_lag = std::max(stats.max_lag, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due));
+                        }
+                        const auto issued = Clock::now();
+                        const bool ok = run_call(database, transaction, call);
+                        const auto elapsed = Clock::now() - issued;
+
+                        auto& api = stats.apis[static_cast<std::size_t>(call.api)];
+                        ++api.calls;
+                        api.recorded_errors += call.ok ? 0 : 1;
+                        api.replay_errors += ok ? 0 : 1;
+                        api.mismatches += ok == call.ok ? 0 : 1;
+                        api.recorded.record(call.duration);
+                        api.replayed.record(elapsed);
+                    }
+                }
+            });
+        }
+    }
+
+    ThreadStats total;
+    for (const auto& stats : per_thread) {
+        for (std::size_t index = 0; index < api_count; ++index) {
+            total.apis[index].merge(stats.apis[index]);
+        }
+        total.max_lag = std::max(total.max_lag, stats.max_lag);
+    }
+    return total;
+}
+
+void print_api(std::string_view name, const ApiStats& stats) {
+    const auto recorded_p50 = tools::to_microseconds(stats.recorded.quantile(0.50));
+    const auto replayed_p50 = tools::to_microseconds(stats.replayed.quantile(0.50));
+    std::cout << "    {\"api\": \"" << name << "\", \"calls\": " << stats.calls
+              << ", \"recorded_errors\": " << stats.recorded_errors << ", \"replay_errors\": " << stats.replay_errors
+              << ", \"mismatches\": " << stats.mismatches
+              << ", \"recorded_p50_us\": " << recorded_p50
+              << ", \"recorded_p99_us\": " << tools::to_microseconds(stats.recorded.quantile(0.99))
+              << ", \"replay_p50_us\": " << replayed_p50
+              << ", \"replay_p99_us\": " << tools::to_microseconds(stats.replayed.quantile(0.99))
+              << ", \"p50_ratio\": " << (recorded_p50 > 0.0 ? replayed_p50 / recorded_p50 : 0.0) << '}';
+}
+
+[[noreturn]] void usage() {
+    std::cerr << "usage: mysqlwrapper_replay --log=path [--speed=factor | 0 for no pauses] [--concurrency=n]\n"
+                 "       [--limit=records] [--backend=mysql|fake] "
+              << tools::ConnectionFlags::usage << '\n';
+    std::exit(2);
+}
+
+ReplayOptions parse_options(int argc, char** argv) {
+    using tools::ConnectionFlags;
+
+    ReplayOptions options;
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view argument(argv[index]);
+        if (options.connection.parse(argument)) {
+            continue;
+        }
+        if (auto value = ConnectionFlags::flag_value(argument, "--log=")) {
+            options.log_path = std::string(*value);
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--speed=")) {
+            options.speed = std::max(0.0, std::strtod(std::string(*value).c_str(), nullptr));
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--concurrency=")) {
+            options.concurrency = std::max<std::size_t>(1, std::strtoull(std::string(*value).c_str(), nullptr, 10));
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--limit=")) {
+            options.limit = std::strtoull(std::string(*value).c_str(), nullptr, 10);
+        } else if (auto value = ConnectionFlags::flag_value(argument, "--backend=")) {
+            if (*value != "mysql" && *value != "fake") {
+                usage();
+            }
+            options.fake_backend = *value == "fake";
+        } else {
+            usage();
+        }
+    }
+    if (options.log_path.empty()) {
+        usage();
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const auto options = parse_options(argc, argv);
+
+    auto units = load_units(options);
+    if (!units) {
+        std::cerr << "cannot load " << options.log_path << ": " << units.error().message << '\n';
+        return 1;
+    }
+
+    std::unique_ptr<Database> database;
+    if (options.fake_backend) {
+        database = std::make_unique<Database>(options.connection.config(),
+                                              testing::make_fake_connection_factory(std::make_shared<testing::FakeBackend>()));
+    } else {
+        database = std::make_unique<Database>(options.connection.config());
+    }
+
+    const auto started = Clock::now();
+    const auto results = replay(*database, *units, options);
+    const auto seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    ApiStats total;
+    for (const auto& stats : results.apis) {
+        total.merge(stats);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "{\n  \"library\": \"mysqlwrapper\",\n  \"log\": \"" << options.log_path << "\",\n  \"speed\": "
+              << options.speed << ",\n  \"units\": " << units->size() << ",\n  \"seconds\": " << seconds
+              << ",\n  \"max_schedule_lag_us\": " << tools::to_microseconds(results.max_lag) << ",\n  \"apis\": [\n";
+    for (std::size_t index = 0; index < api_count; ++index) {
+        if (results.apis[index].calls == 0) {
+            continue;
+        }
+        print_api(to_string(static_cast<TrafficApi>(index)), results.apis[index]);
+        std::cout << ",\n";
+    }
+    print_api("total", total);
+    std::cout << "\n  ]\n}\n";
+    return total.mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "mysqlwrapper/mysql_wrapper.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace mysqlw::tools {
+
+// Log-linear latency histogram with 64 sub-buckets per power of two of nanoseconds, so any
+// recorded value is reported within ~1.6% up to about 73 minutes. Unlike LatencyHistogram it
+// is precise enough for p99.9 and is merged per thread rather than shared.
+class LogLinearHistogram {
+public:
+    static constexpr int sub_bucket_bits = 6;
+    static constexpr std::uint64_t sub_bucket_count = 1U << sub_bucket_bits;
+    static constexpr int magnitudes = 36;
+
+    void record(std::chrono::nanoseconds latency) noexcept {
+        const auto value = static_cast<std::uint64_t>(std::max<std::int64_t>(latency.count(), 0));
+        ++counts_[std::min(index_of(value), counts_.size() - 1)];
+        ++count_;
+        max_ = std::max(max_, value);
+        sum_ += value;
+    }
+
+    void merge(const LogLinearHistogram& other) noexcept {
+        for (std::size_t index = 0; index < counts_.size(); ++index) {
+            counts_[index] += other.counts_[index];
+        }
+        count_ += other.count_;
+        max_ = std::max(max_, other.max_);
+        sum_ += other.sum_;
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return count_; }
+    [[nodiscard]] std::chrono::nanoseconds max() const noexcept { return std::chrono::nanoseconds(max_); }
+
+    [[nodiscard]] std::chrono::nanoseconds mean() const noexcept {
+        return std::chrono::nanoseconds(count_ == 0 ? 0 : sum_ / count_);
+    }
+
+    // Upper bound of the bucket holding the q-th value.
+    [[nodiscard]] std::chrono::nanoseconds quantile(double q) const noexcept {
+        if (count_ == 0) {
+            return std::chrono::nanoseconds{0};
+        }
+        const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * static_cast<double>(count_) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t index = 0; index < counts_.size(); ++index) {
+            seen += counts_[index];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds(std::min(upper_bound_of(index), max_));
+            }
+        }
+        return std::chrono::nanoseconds(max_);
+    }
+
+private:
+    std::array<std::uint64_t, (magnitudes + 1) * sub_bucket_count> counts_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t max_ = 0;
+    std::uint64_t sum_ = 0;
+
+    static std::size_t index_of(std::uint64_t value) noexcept {
+        if (value < sub_bucket_count) {
+            return static_cast<std::size_t>(value);
+        }
+        // Values in [64 << shift, 128 << shift) share one row of 64 sub-buckets.
+        const auto shift = static_cast<std::uint64_t>(std::bit_width(value)) - sub_bucket_bits - 1;
+        const auto sub_bucket = (value >> shift) - sub_bucket_count;
+        return static_cast<std::size_t>((shift + 1) * sub_bucket_count + sub_bucket);
+    }
+
+    static std::uint64_t upper_bound_of(std::size_t index) noexcept {
+        if (index < sub_bucket_count) {
+            return index;
+        }
+        const auto shift = index / sub_bucket_count - 1;
+        const auto sub_bucket = index % sub_bucket_count + sub_bucket_count;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+};
+
+inline double to_microseconds(std::chrono::nanoseconds value) noexcept {
+    return static_cast<double>(value.count()) / 1000.0;
+}
+
+// Connection flags shared by the tools: --host, --port, --user, --password, --database,
+// --pool-size and --workers, falling back to the same MYSQLWRAPPER_TEST_* variables as the integration tests.
+class ConnectionFlags {
+public:
+    ConnectionFlags() {
+        config_.host = env_or("MYSQLWRAPPER_TEST_HOST", "127.0.0.1");
+        config_.port = static_cast<std::uint16_t>(std::stoul(env_or("MYSQLWRAPPER_TEST_PORT", "3306")));
+        config_.user = env_or("MYSQLWRAPPER_TEST_USER", "root");
+        config_.password = env_or("MYSQLWRAPPER_TEST_PASSWORD", "mysqlwrapper");
+        config_.database = env_or("MYSQLWRAPPER_TEST_DATABASE", "mysqlwrapper_test");
+        config_.connect_timeout = std::chrono::seconds{5};
+        config_.acquire_timeout = std::chrono::seconds{30};
+    }
+
+    // Returns true when the argument was a connection flag.
+    bool parse(std::string_view argument) {
+        if (auto value = flag_value(argument, "--host=")) {
+            config_.host = std::string(*value);
+        } else if (auto value = flag_value(argument, "--port=")) {
+            config_.port = static_cast<std::uint16_t>(std::strtoul(std::string(*value).c_str(), nullptr, 10));
+        } else if (auto value = flag_value(argument, "--user=")) {
+            config_.user = std::string(*value);
+        } else if (auto value = flag_value(argument, "--password=")) {
+            config_.password = std::string(*value);
+        } else if (auto value = flag_value(argument, "--database=")) {
+            config_.database = std::string(*value);
+        } else if (auto value = flag_value(argument, "--pool-size=")) {
+            config_.max_pool_size = std::strtoull(std::string(*value).c_str(), nullptr, 10);
+            config_.initial_pool_size = config_.max_pool_size;
+        } else if (auto value = flag_value(argument, "--workers=")) {
+            config_.worker_count = std::strtoull(std::string(*value).c_str(), nullptr, 10);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] const ConnectionConfig& config() const noexcept { return config_; }
+    [[nodiscard]] ConnectionConfig& config() noexcept { return config_; }
+
+    static constexpr std::string_view usage =
+        "[--host=h] [--port=n] [--user=u] [--password=p] [--database=d] [--pool-size=n] [--workers=n]";
+
+    static std::optional<std::string_view> flag_value(std::string_view argument, std::string_view flag) {
+        if (!argument.starts_with(flag)) {
+            return std::nullopt;
+        }
+        return argument.substr(flag.size());
+    }
+
+private:
+    ConnectionConfig config_;
+
+    static std::string env_or(const char* name, std::string fallback) {
+        const char* value = std::getenv(name);
+        return value == nullptr || value[0] == '\0' ? std::move(fallback) : std::string(value);
+    }
+};
+
+} // namespace mysqlw::tools
@@ -19,6 +19,18 @@ option("tests")
     set_description("Build unit tests")
 option_end()
 
+option("benchmarks")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build benchmarks")
+option_end()
+
+option("tools")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build load generation tools")
+option_end()
+
 option("examples")
     set_default(false)
     set_showmenu(true)
@@ -43,22 +55,35 @@ add_requires("mysqlclient-pkgconfig", {system = true})
 
 target("mysqlwrapper")
     set_kind("$(kind)")
-    add_files("src/mysql_wrapper.cpp")
+    add_files("src/chunked_dml.cpp", "src/columnar.cpp", "src/csv_export.cpp", "src/json.cpp", "src/keyset_pager.cpp", "src/mysql_wrapper.cpp", "src/openmetrics.cpp", "src/operators.cpp", "src/shared_cache.cpp", "src/snapshot.cpp", "src/table_scan.cpp", "src/traffic_log.cpp")
     add_headerfiles("include/(mysqlwrapper/*.hpp)")
     add_includedirs("include", {public = true})
     add_packages("mysqlclient-pkgconfig")
     add_syslinks("pthread")
+    if is_plat("linux") then
+        add_syslinks("rt")
+    end
 
     if has_config("modules") then
         add_rules("c++.build.modules")
         add_files("modules/mysql.wrapper.cppm", {public = true})
     end
 
+target("mysqlwrapper_test_support")
+    set_kind("static")
+    set_default(has_config("tests") or has_config("benchmarks") or has_config("tools"))
+    add_files("tests/support/fake_connection.cpp")
+    if not is_plat("windows") then
+        add_files("tests/support/mysql_stub_server.cpp")
+    end
+    add_includedirs("tests", {public = true})
+    add_deps("mysqlwrapper")
+
 target("mysqlwrapper_tests")
     set_kind("binary")
     set_default(has_config("tests"))
     add_files("tests/mysqlwrapper_tests.cpp")
-    add_deps("mysqlwrapper")
+    add_deps("mysqlwrapper", "mysqlwrapper_test_support")
     add_tests("default")
 
 target("mysqlwrapper_integration_tests")
@@ -68,8 +93,57 @@ target("mysqlwrapper_integration_tests")
     add_deps("mysqlwrapper")
     add_tests("default")
 
+target("mysqlwrapper_alloc_tests")
+    set_kind("binary")
+    set_default(has_config("tests"))
+    add_files("tests/mysqlwrapper_alloc_tests.cpp", "tests/support/allocation_counter.cpp")
+    add_deps("mysqlwrapper", "mysqlwrapper_test_support")
+    add_tests("default")
+    if not is_plat("windows") then
+        add_tests("stub", {runargs = "--stub"})
+    end
+
+target("mysqlwrapper_stub_tests")
+    set_kind("binary")
+    set_default(has_config("tests") and not is_plat("windows"))
+    add_files("tests/mysqlwrapper_stub_tests.cpp")
+    add_deps("mysqlwrapper", "mysqlwrapper_test_support")
+    add_tests("default")
+
 target("mysqlwrapper_example")
     set_kind("binary")
     set_default(has_config("examples"))
     add_files("examples/basic.cpp")
     add_deps("mysqlwrapper")
+
+target("mysqlwrapper_bench")
+    set_kind("binary")
+    set_default(has_config("benchmarks"))
+    add_files("bench/mysqlwrapper_bench.cpp")
+    add_includedirs("src")
+    add_packages("mysqlclient-pkgconfig")
+    add_deps("mysqlwrapper")
+
+target("mysqlwrapper_pool_bench")
+    set_kind("binary")
+    set_default(has_config("benchmarks"))
+    add_files("bench/mysqlwrapper_pool_bench.cpp")
+    add_deps("mysqlwrapper", "mysqlwrapper_test_support")
+
+target("mysqlwrapper_stub_bench")
+    set_kind("binary")
+    set_default(has_config("benchmarks") and not is_plat("windows"))
+    add_files("bench/mysqlwrapper_stub_bench.cpp")
+    add_deps("mysqlwrapper", "mysqlwrapper_test_support")
+
+target("mysqlwrapper_loadgen")
+    set_kind("binary")
+    set_default(has_config("tools"))
+    add_files("tools/mysqlwrapper_loadgen.cpp")
+    add_deps("mysqlwrapper", "mysqlwrapper_test_support")
+
+target("mysqlwrapper_replay")
+    set_kind("binary")
+    set_default(has_config("tools"))
+    add_files("tools/mysqlwrapper_replay.cpp")
+    add_deps("mysqlwrapper", "mysqlwrapper_test_support")